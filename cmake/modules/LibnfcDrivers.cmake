@@ -12,6 +12,11 @@ ELSE(UNIX AND NOT APPLE)
 ENDIF(UNIX AND NOT APPLE)
 SET(LIBNFC_DRIVER_PN532_UART ON CACHE BOOL "Enable PN532 UART support (Use serial port)")
 SET(LIBNFC_DRIVER_PN53X_USB ON CACHE BOOL "Enable PN531 and PN531 USB support (Depends on libusb)")
+IF(UNIX)
+  SET(LIBNFC_DRIVER_NFCD ON CACHE BOOL "Enable support for devices shared by the nfcd daemon (Use Unix socket)")
+ELSE(UNIX)
+  SET(LIBNFC_DRIVER_NFCD OFF CACHE BOOL "Enable support for devices shared by the nfcd daemon (Use Unix socket)")
+ENDIF(UNIX)
 
 IF(LIBNFC_DRIVER_PCSC)
   FIND_PACKAGE(PCSC REQUIRED)
@@ -75,4 +80,9 @@ IF(LIBNFC_DRIVER_ACR122_USB)
   SET(USB_REQUIRED TRUE)
 ENDIF(LIBNFC_DRIVER_ACR122_USB)
 
+IF(LIBNFC_DRIVER_NFCD)
+  ADD_DEFINITIONS("-DDRIVER_NFCD_ENABLED")
+  SET(DRIVERS_SOURCES ${DRIVERS_SOURCES} "drivers/nfcd")
+ENDIF(LIBNFC_DRIVER_NFCD)
+
 INCLUDE_DIRECTORIES(${CMAKE_CURRENT_SOURCE_DIR}/libnfc/drivers)
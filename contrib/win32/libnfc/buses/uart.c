@@ -167,6 +167,13 @@ uart_receive(serial_port sp, uint8_t *pbtRx, const size_t szRx, void *abort_p, i
   DWORD dwTotalBytesReceived = 0;
   BOOL res;
 
+  if (timeout < 0) {
+    // Caller's deadline has already passed
+    return NFC_ETIMEOUT;
+  }
+  // The whole frame has to arrive within timeout, not each ReadFile() call
+  const nfc_deadline deadline = nfc_deadline_from_timeout(timeout);
+
   // XXX Put this part into uart_win32_timeouts () ?
   DWORD timeout_ms = timeout;
   COMMTIMEOUTS timeouts;
@@ -208,6 +215,19 @@ uart_receive(serial_port sp, uint8_t *pbtRx, const size_t szRx, void *abort_p, i
     if (abort_flag_p != NULL && (*abort_flag_p) && dwTotalBytesReceived == 0) {
       return NFC_EOPABORTED;
     }
+
+    if ((timeout > 0) && (((DWORD)szRx) > dwTotalBytesReceived)) {
+      // Only give the next ReadFile() what is left of the deadline
+      const int remaining = nfc_deadline_remaining(deadline);
+      if (remaining < 0) {
+        return NFC_ETIMEOUT;
+      }
+      timeouts.ReadTotalTimeoutConstant = (DWORD)remaining;
+      if (!SetCommTimeouts(((struct serial_port_windows *) sp)->hPort, &timeouts)) {
+        log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "Unable to apply new timeout settings.");
+        return NFC_EIO;
+      }
+    }
   } while (((DWORD)szRx) > dwTotalBytesReceived);
   LOG_HEX(LOG_GROUP, "RX", pbtRx, szRx);
 
@@ -240,6 +260,23 @@ uart_send(serial_port sp, const uint8_t *pbtTx, const size_t szTx, int timeout)
   return 0;
 }
 
+int
+uart_get_fd(serial_port sp)
+{
+  (void) sp;
+  // Split-phase commands are not available on Windows
+  return NFC_EDEVNOTSUPP;
+}
+
+int
+uart_receive_available(serial_port sp, uint8_t *pbtRx, const size_t szRx)
+{
+  (void) sp;
+  (void) pbtRx;
+  (void) szRx;
+  return NFC_EDEVNOTSUPP;
+}
+
 BOOL is_port_available(int nPort)
 {
   TCHAR szPort[15];
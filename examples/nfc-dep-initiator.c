@@ -43,6 +43,7 @@
 #  include "config.h"
 #endif // HAVE_CONFIG_H
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -53,6 +54,7 @@
 #include "utils/nfc-utils.h"
 
 #define MAX_FRAME_LEN 264
+#define MAX_BULK_LEN 65536
 
 static nfc_device *pnd;
 static nfc_context *context;
@@ -68,15 +70,40 @@ static void stop_dep_communication(int sig)
   }
 }
 
+static int
+bulk_transfer(const size_t szBulk)
+{
+  static uint8_t abtTx[MAX_BULK_LEN];
+  static uint8_t abtRx[MAX_BULK_LEN];
+  nfc_bulk_stats stats;
+  int res;
+
+  for (size_t n = 0; n < szBulk; n++)
+    abtTx[n] = (uint8_t) n;
+  printf("Sending %" PRIuPTR " bytes\n", szBulk);
+  if ((res = nfc_initiator_transceive_bulk(pnd, abtTx, szBulk, abtRx, sizeof(abtRx), &stats, 0)) < 0) {
+    nfc_perror(pnd, "nfc_initiator_transceive_bulk");
+    return res;
+  }
+  printf("Received %d bytes back%s\n", res, ((size_t) res == szBulk) && (0 == memcmp(abtTx, abtRx, szBulk)) ? "" : " (mismatch)");
+  printf("%" PRIuPTR " bytes in %.3f s: %u bytes/s\n", stats.szSent + stats.szReceived, stats.ui64Microseconds / 1000000.0, stats.uiBytesPerSecond);
+  return 0;
+}
+
 int
 main(int argc, const char *argv[])
 {
   nfc_target nt;
   uint8_t  abtRx[MAX_FRAME_LEN];
   uint8_t  abtTx[] = "Hello World!";
+  size_t szBulk = 0;
 
-  if (argc > 1) {
-    printf("Usage: %s\n", argv[0]);
+  if ((argc == 3) && (0 == strcmp(argv[1], "-b"))) {
+    szBulk = atoi(argv[2]);
+  }
+  if (((argc != 1) && !szBulk) || (szBulk > MAX_BULK_LEN)) {
+    printf("Usage: %s [-b bytes]\n", argv[0]);
+    printf("  -b: send bytes (up to %d) at the fastest rate and report throughput\n", MAX_BULK_LEN);
     exit(EXIT_FAILURE);
   }
 
@@ -103,6 +130,21 @@ main(int argc, const char *argv[])
     exit(EXIT_FAILURE);
   }
 
+  if (szBulk) {
+    if (nfc_initiator_select_dep_target_fastest(pnd, NULL, &nt, 3000) <= 0) {
+      nfc_perror(pnd, "nfc_initiator_select_dep_target_fastest");
+      nfc_close(pnd);
+      nfc_exit(context);
+      exit(EXIT_FAILURE);
+    }
+    print_nfc_target(&nt, false);
+    int res = bulk_transfer(szBulk);
+    nfc_initiator_deselect_target(pnd);
+    nfc_close(pnd);
+    nfc_exit(context);
+    exit((res < 0) ? EXIT_FAILURE : EXIT_SUCCESS);
+  }
+
   if (nfc_initiator_select_dep_target(pnd, NDM_PASSIVE, NBR_212, NULL, &nt, 1000) < 0) {
     nfc_perror(pnd, "nfc_initiator_select_dep_target");
     nfc_close(pnd);
@@ -43,9 +43,11 @@
 #  include "config.h"
 #endif // HAVE_CONFIG_H
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <signal.h>
+#include <string.h>
 
 #include <nfc/nfc.h>
 
@@ -67,15 +69,41 @@ static void stop_dep_communication(int sig)
   }
 }
 
+#define MAX_BULK_LEN 65536
+
+static int
+bulk_echo(void)
+{
+  static uint8_t abtBulk[MAX_BULK_LEN];
+  nfc_bulk_stats stats;
+  int res;
+
+  if ((res = nfc_target_receive_bulk(pnd, abtBulk, sizeof(abtBulk), &stats, 0)) < 0) {
+    nfc_perror(pnd, "nfc_target_receive_bulk");
+    return res;
+  }
+  printf("Received %d bytes in %.3f s: %u bytes/s\n", res, stats.ui64Microseconds / 1000000.0, stats.uiBytesPerSecond);
+  if ((res = nfc_target_send_bulk(pnd, abtBulk, res, &stats, 0)) < 0) {
+    nfc_perror(pnd, "nfc_target_send_bulk");
+    return res;
+  }
+  printf("Sent %" PRIuPTR " bytes back in %.3f s: %u bytes/s\n", stats.szSent, stats.ui64Microseconds / 1000000.0, stats.uiBytesPerSecond);
+  return 0;
+}
+
 int
 main(int argc, const char *argv[])
 {
   uint8_t  abtRx[MAX_FRAME_LEN];
   int  szRx;
   uint8_t  abtTx[] = "Hello Mars!";
+  bool bBulk = false;
 
-  if (argc > 1) {
-    printf("Usage: %s\n", argv[0]);
+  if ((argc == 2) && (0 == strcmp(argv[1], "-b"))) {
+    bBulk = true;
+  } else if (argc > 1) {
+    printf("Usage: %s [-b]\n", argv[0]);
+    printf("  -b: echo a payload of any size sent by nfc-dep-initiator -b\n");
     exit(EXIT_FAILURE);
   }
 
@@ -143,6 +171,12 @@ main(int argc, const char *argv[])
   }
 
   printf("Initiator request received. Waiting for data...\n");
+  if (bBulk) {
+    int res = bulk_echo();
+    nfc_close(pnd);
+    nfc_exit(context);
+    exit((res < 0) ? EXIT_FAILURE : EXIT_SUCCESS);
+  }
   if ((szRx = nfc_target_receive_bytes(pnd, abtRx, sizeof(abtRx), 0)) < 0) {
     nfc_perror(pnd, "nfc_target_receive_bytes");
     nfc_close(pnd);
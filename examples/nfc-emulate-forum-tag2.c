@@ -117,49 +117,6 @@ static uint8_t __nfcforum_tag2_memory_area[] = {
   0x00, 0x00, 0x00, 0x00,
 };
 
-#define READ 		0x30
-#define WRITE 		0xA2
-#define SECTOR_SELECT 	0xC2
-
-#define HALT 		0x50
-static int
-nfcforum_tag2_io(struct nfc_emulator *emulator, const uint8_t *data_in, const size_t data_in_len, uint8_t *data_out, const size_t data_out_len)
-{
-  int res = 0;
-
-  uint8_t *nfcforum_tag2_memory_area = (uint8_t *)(emulator->user_data);
-
-  printf("    In: ");
-  print_hex(data_in, data_in_len);
-
-  switch (data_in[0]) {
-    case READ:
-      if (data_out_len >= 16) {
-        memcpy(data_out, nfcforum_tag2_memory_area + (data_in[1] * 4), 16);
-        res = 16;
-      } else {
-        res = -ENOSPC;
-      }
-      break;
-    case HALT:
-      printf("HALT sent\n");
-      res = -ECONNABORTED;
-      break;
-    default:
-      printf("Unknown command: 0x%02x\n", data_in[0]);
-      res = -ENOTSUP;
-  }
-
-  if (res < 0) {
-    ERR("%s (%d)", strerror(-res), -res);
-  } else {
-    printf("    Out: ");
-    print_hex(data_out, res);
-  }
-
-  return res;
-}
-
 int
 main(int argc, char *argv[])
 {
@@ -182,27 +139,26 @@ main(int argc, char *argv[])
     }
   };
 
-  struct nfc_emulation_state_machine state_machine = {
-    .io = nfcforum_tag2_io
-  };
-
-  struct nfc_emulator emulator = {
-    .target = &nt,
-    .state_machine = &state_machine,
-    .user_data = __nfcforum_tag2_memory_area,
-  };
+  // READ answers are precomputed once, frames are answered without any callback
+  struct nfc_emulation_type2 *pet2 = nfc_emulation_type2_new(__nfcforum_tag2_memory_area, sizeof(__nfcforum_tag2_memory_area));
+  if (pet2 == NULL) {
+    ERR("Unable to create Type 2 Tag emulation");
+    exit(EXIT_FAILURE);
+  }
 
   signal(SIGINT, stop_emulation);
 
   nfc_init(&context);
   if (context == NULL) {
     ERR("Unable to init libnfc (malloc)");
+    nfc_emulation_type2_free(pet2);
     exit(EXIT_FAILURE);
   }
   pnd = nfc_open(context, NULL);
 
   if (pnd == NULL) {
     ERR("Unable to open NFC device");
+    nfc_emulation_type2_free(pet2);
     nfc_exit(context);
     exit(EXIT_FAILURE);
   }
@@ -210,13 +166,16 @@ main(int argc, char *argv[])
   printf("NFC device: %s opened\n", nfc_device_get_name(pnd));
   printf("Emulating NDEF tag now, please touch it with a second NFC device\n");
 
-  if (nfc_emulate_target(pnd, &emulator, 0) < 0) {
+  if (nfc_emulate_type2_target(pnd, &nt, pet2, 0) < 0) {
     nfc_perror(pnd, argv[0]);
+    nfc_emulation_type2_free(pet2);
     nfc_close(pnd);
     nfc_exit(context);
     exit(EXIT_FAILURE);
   }
+  printf("HALT sent\n");
 
+  nfc_emulation_type2_free(pet2);
   nfc_close(pnd);
   nfc_exit(context);
   exit(EXIT_SUCCESS);
@@ -0,0 +1,223 @@
+/*-
+ * Free/Libre Near Field Communication (NFC) library
+ *
+ * Libnfc historical contributors:
+ * Copyright (C) 2009      Roel Verdult
+ * Copyright (C) 2009-2013 Romuald Conty
+ * Copyright (C) 2010-2012 Romain Tartière
+ * Copyright (C) 2010-2013 Philippe Teuwen
+ * Copyright (C) 2012-2013 Ludovic Rousseau
+ * See AUTHORS file for a more comprehensive list of contributors.
+ * Additional contributors of this file:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1) Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  2 )Redistributions in binary form must reproduce the above copyright
+ *  notice, this list of conditions and the following disclaimer in the
+ *  documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Note that this license only applies on the examples, NFC library itself is under LGPL
+ *
+ */
+
+/**
+ * @file nfc-hpp-benchmark.cpp
+ * @brief Overhead of the C++20 coroutines of nfc.hpp against direct calls
+ *
+ * The same frame (MIFARE READ of page 0 by default) is sent to an ISO14443A
+ * target with the blocking nfc_initiator_transceive_bytes(), with the
+ * split-phase commands and a C callback, and with co_await: the wall and CPU
+ * times per frame tell what the event loop and the coroutines cost on top of
+ * the exchange itself.
+ */
+
+#include <poll.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <nfc/nfc.hpp>
+
+namespace
+{
+
+struct measure {
+  std::chrono::steady_clock::time_point wall = std::chrono::steady_clock::now();
+  std::clock_t cpu = std::clock();
+
+  void print(const char *label, const std::size_t n) const
+  {
+    const double wall_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - wall).count();
+    const double cpu_us = 1e6 * static_cast<double>(std::clock() - cpu) / CLOCKS_PER_SEC;
+    std::printf("%-12s %10.1f us/frame wall %8.2f us/frame CPU\n", label, wall_us / n, cpu_us / n);
+  }
+};
+
+uint8_t abtTx[] = { 0x30, 0x00 };
+uint8_t abtRx[264];
+
+// Event loop of a single device, until done
+bool
+run(nfc::device &dev, const bool &done)
+{
+  auto fd = dev.event_fd();
+  if (!fd) {
+    std::fprintf(stderr, "nfc_device_get_event_fd: %s\n", fd.error_code().message().c_str());
+    return false;
+  }
+  while (!done) {
+    struct pollfd pfd = { *fd, POLLIN, 0 };
+    if (poll(&pfd, 1, dev.event_timeout()) < 0)
+      return false;
+    if (!dev.process_events())
+      return false;
+  }
+  return true;
+}
+
+struct callback_state {
+  nfc_device *pnd;
+  std::size_t n;
+  std::size_t sent;
+  int res;
+  bool done;
+};
+
+void
+callback(nfc_device *pnd, int res, void *user_data)
+{
+  callback_state *s = static_cast<callback_state *>(user_data);
+  if (res < 0 || ++s->sent == s->n) {
+    s->res = res;
+    s->done = true;
+    return;
+  }
+  if ((res = nfc_initiator_transceive_bytes_submit(pnd, abtTx, sizeof(abtTx), abtRx, sizeof(abtRx), -1, &callback, s)) < 0) {
+    s->res = res;
+    s->done = true;
+  }
+}
+
+nfc::task
+coroutine(nfc::device &dev, const std::size_t n, int &res, bool &done)
+{
+  for (std::size_t i = 0; i < n; i++) {
+    auto r = co_await dev.transceive(abtTx, abtRx);
+    if (!r) {
+      res = r.error();
+      break;
+    }
+  }
+  done = true;
+}
+
+void
+print_usage(const char *progname)
+{
+  std::printf("usage: %s [-n count] [connstring]\n", progname);
+  std::printf("  -n\t number of frames sent each way (default: 1000)\n");
+}
+
+} // namespace
+
+int
+main(int argc, const char *argv[])
+{
+  std::size_t n = 1000;
+  const char *connstring = nullptr;
+
+  for (int arg = 1; arg < argc; arg++) {
+    if ((0 == std::strcmp(argv[arg], "-n")) && (arg + 1 < argc)) {
+      n = std::strtoul(argv[++arg], nullptr, 0);
+    } else if (argv[arg][0] != '-') {
+      connstring = argv[arg];
+    } else {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (n == 0) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  auto ctx = nfc::context::init();
+  if (!ctx) {
+    std::fprintf(stderr, "Unable to init libnfc (malloc)\n");
+    return EXIT_FAILURE;
+  }
+  auto dev = ctx->open(connstring);
+  if (!dev) {
+    std::fprintf(stderr, "Unable to open NFC device.\n");
+    return EXIT_FAILURE;
+  }
+  if (!dev->initiator_init()) {
+    std::fprintf(stderr, "nfc_initiator_init: %s\n", nfc_strerror(dev->get()));
+    return EXIT_FAILURE;
+  }
+  nfc_target nt;
+  const nfc_modulation nm = { NMT_ISO14443A, NBR_106 };
+  if (nfc_initiator_select_passive_target(dev->get(), nm, nullptr, 0, &nt) <= 0) {
+    std::fprintf(stderr, "No ISO14443A target found.\n");
+    return EXIT_FAILURE;
+  }
+  std::printf("NFC device: %s, %zu frames each way\n", dev->name(), n);
+
+  {
+    measure m;
+    for (std::size_t i = 0; i < n; i++) {
+      int res;
+      if ((res = nfc_initiator_transceive_bytes(dev->get(), abtTx, sizeof(abtTx), abtRx, sizeof(abtRx), -1)) < 0) {
+        std::fprintf(stderr, "nfc_initiator_transceive_bytes: %s\n", nfc::make_error_code(res).message().c_str());
+        return EXIT_FAILURE;
+      }
+    }
+    m.print("direct", n);
+  }
+
+  {
+    callback_state s = { dev->get(), n, 0, 0, false };
+    measure m;
+    int res;
+    if ((res = nfc_initiator_transceive_bytes_submit(s.pnd, abtTx, sizeof(abtTx), abtRx, sizeof(abtRx), -1, &callback, &s)) < 0) {
+      std::fprintf(stderr, "nfc_initiator_transceive_bytes_submit: %s\n", nfc::make_error_code(res).message().c_str());
+      return EXIT_FAILURE;
+    }
+    if (!run(*dev, s.done) || s.res < 0) {
+      std::fprintf(stderr, "callback: %s\n", nfc::make_error_code(s.res).message().c_str());
+      return EXIT_FAILURE;
+    }
+    m.print("callback", n);
+  }
+
+  {
+    int res = 0;
+    bool done = false;
+    measure m;
+    coroutine(*dev, n, res, done);
+    if (!run(*dev, done) || res < 0) {
+      std::fprintf(stderr, "co_await: %s\n", nfc::make_error_code(res).message().c_str());
+      return EXIT_FAILURE;
+    }
+    m.print("co_await", n);
+  }
+
+  return EXIT_SUCCESS;
+}
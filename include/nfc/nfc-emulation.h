@@ -61,7 +61,35 @@ struct nfc_emulation_state_machine {
   void *data;
 };
 
+/**
+ * @typedef nfc_emulation_stream_callback
+ * @brief Produce the next part of an answer which did not fit in \a io data_out, see nfc_emulate_target_stream()
+ */
+typedef int (*nfc_emulation_stream_callback)(struct nfc_emulator *emulator, uint8_t *data_out, const size_t data_out_len);
+
 NFC_EXPORT int    nfc_emulate_target(nfc_device *pnd, struct nfc_emulator *emulator, const int timeout);
+NFC_EXPORT int    nfc_emulate_target_stream(nfc_device *pnd, struct nfc_emulator *emulator, nfc_emulation_stream_callback stream, const int timeout);
+
+/** Size of a NFC Forum Type 2 Tag page */
+#define NFC_EMULATION_TYPE2_PAGE_LEN 4
+/** Size of a READ answer (four pages), CRC excluded */
+#define NFC_EMULATION_TYPE2_READ_LEN 16
+/** Size of a GET_VERSION answer, CRC excluded */
+#define NFC_EMULATION_TYPE2_VERSION_LEN 8
+/** Size of a READ_SIG answer, CRC excluded */
+#define NFC_EMULATION_TYPE2_SIGNATURE_LEN 32
+
+/**
+ * @struct nfc_emulation_type2
+ * @brief NFC Forum Type 2 Tag (i.e. MIFARE Ultralight) answered from precomputed frames
+ */
+struct nfc_emulation_type2;
+
+NFC_EXPORT struct nfc_emulation_type2 *nfc_emulation_type2_new(const uint8_t *pbtMemory, const size_t szMemory);
+NFC_EXPORT void   nfc_emulation_type2_free(struct nfc_emulation_type2 *pet2);
+NFC_EXPORT int    nfc_emulation_type2_set_version(struct nfc_emulation_type2 *pet2, const uint8_t *pbtVersion);
+NFC_EXPORT int    nfc_emulation_type2_set_signature(struct nfc_emulation_type2 *pet2, const uint8_t *pbtSignature);
+NFC_EXPORT int    nfc_emulate_type2_target(nfc_device *pnd, nfc_target *pnt, struct nfc_emulation_type2 *pet2, const int timeout);
 
 #ifdef __cplusplus
 }
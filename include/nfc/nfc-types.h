@@ -57,6 +57,11 @@ typedef struct nfc_device nfc_device;
  */
 typedef struct nfc_driver nfc_driver;
 
+/**
+ * NFC fleet
+ */
+typedef struct nfc_fleet nfc_fleet;
+
 /**
  * Connection string
  */
@@ -140,6 +145,14 @@ typedef enum {
   NP_FORCE_ISO14443_B,
   /** Force the chip to run at 106 kbps */
   NP_FORCE_SPEED_106,
+  /** Once an ISO14443-4 target is selected, negotiate (PPS) the highest bit
+   * rate supported by both the device and the target (see TA(1) of ATS). The
+   * target stays at its former bit rate if negotiation fails. */
+  NP_AUTO_PPS,
+  /** Learn the response time of the selected target to each kind of command
+   * and use it as timeout instead of the default one when no explicit timeout
+   * is given. Timeouts are backed off when the target misses them. */
+  NP_ADAPTIVE_TIMEOUT,
 } nfc_property;
 
 // Compiler directive, set struct alignment to 1 uint8_t for compatibility
@@ -353,6 +366,75 @@ typedef struct {
   nfc_modulation nm;
 } nfc_target;
 
+/**
+ * @typedef nfc_target_monitor_callback
+ * @brief Function invoked by nfc_device_process_events() once the monitor started by nfc_initiator_target_monitor() is over
+ *
+ * \a res is \a NFC_ETGRELEASED when the target left the field, otherwise the error of the probe.
+ */
+typedef void (*nfc_target_monitor_callback)(nfc_device *pnd, const nfc_target *pnt, int res, void *user_data);
+
+/**
+ * @typedef nfc_completion_callback
+ * @brief Function invoked by nfc_device_process_events() once a submitted command completed
+ *
+ * \a res is the value the blocking variant of the command would have returned.
+ */
+typedef void (*nfc_completion_callback)(nfc_device *pnd, int res, void *user_data);
+
+/**
+ * @enum nfc_fleet_event_type
+ * @brief NFC fleet event type enumeration
+ */
+typedef enum {
+  NFE_TARGET_ARRIVED = 1,
+  NFE_TARGET_REMOVED,
+  NFE_ERROR,
+} nfc_fleet_event_type;
+
+/**
+ * @struct nfc_fleet_event
+ * @brief Event published by a fleet worker
+ */
+typedef struct {
+  nfc_fleet_event_type nfet;
+  /** index of the reader, as returned by nfc_fleet_add_device() */
+  size_t szDevice;
+  /** target which arrived or left, for NFE_TARGET_ARRIVED and NFE_TARGET_REMOVED */
+  nfc_target nt;
+  /** libnfc's error code, for NFE_ERROR */
+  int iError;
+} nfc_fleet_event;
+
+/**
+ * @struct nfc_fleet_device_stats
+ * @brief Health statistics of a reader driven by a fleet
+ */
+typedef struct {
+  uint32_t uiPolls;
+  uint32_t uiArrivals;
+  uint32_t uiRemovals;
+  uint32_t uiErrors;
+  /** errors since the last successful operation, used to back off a failing reader */
+  uint32_t uiConsecutiveErrors;
+  /** times the worker had to wait for the event queue to drain */
+  uint32_t uiStalls;
+  int iLastError;
+} nfc_fleet_device_stats;
+
+/**
+ * @struct nfc_bulk_stats
+ * @brief Throughput achieved by a bulk transfer
+ */
+typedef struct {
+  size_t szSent;
+  size_t szReceived;
+  /** duration of the transfer, in microseconds */
+  uint64_t ui64Microseconds;
+  /** payload bytes, sent and received, per second */
+  uint32_t uiBytesPerSecond;
+} nfc_bulk_stats;
+
 // Reset struct alignment to default
 #  pragma pack()
 
@@ -88,6 +88,8 @@ NFC_EXPORT int nfc_register_driver(const nfc_driver *driver);
 /* NFC Device/Hardware manipulation */
 NFC_EXPORT nfc_device *nfc_open(nfc_context *context, const nfc_connstring connstring) ATTRIBUTE_NONNULL(1);
 NFC_EXPORT void nfc_close(nfc_device *pnd);
+NFC_EXPORT int nfc_pool_configure(nfc_context *context, const size_t szMaxDevices, const int idle_timeout);
+NFC_EXPORT void nfc_pool_sweep(nfc_context *context);
 NFC_EXPORT int nfc_abort_command(nfc_device *pnd);
 NFC_EXPORT size_t nfc_list_devices(nfc_context *context, nfc_connstring connstrings[], size_t connstrings_len) ATTRIBUTE_NONNULL(1);
 NFC_EXPORT int nfc_idle(nfc_device *pnd);
@@ -98,19 +100,57 @@ NFC_EXPORT int nfc_initiator_init_collision(nfc_device *pnd);
 NFC_EXPORT int nfc_initiator_init_secure_element(nfc_device *pnd);
 NFC_EXPORT int nfc_initiator_select_passive_target(nfc_device *pnd, const nfc_modulation nm, const uint8_t *pbtInitData, const size_t szInitData, nfc_target *pnt);
 NFC_EXPORT int nfc_initiator_list_passive_targets(nfc_device *pnd, const nfc_modulation nm, nfc_target ant[], const size_t szTargets);
+NFC_EXPORT int nfc_initiator_inventory_iso14443a(nfc_device *pnd, nfc_target ant[], const size_t szTargets);
+NFC_EXPORT int nfc_initiator_inventory_felica(nfc_device *pnd, const nfc_baud_rate nbr, const uint16_t ui16SystemCode, const uint8_t ui8TimeSlots, nfc_target ant[], const size_t szTargets);
+NFC_EXPORT int nfc_initiator_inventory_iso14443b(nfc_device *pnd, const uint8_t ui8Afi, nfc_target ant[], const size_t szTargets);
+NFC_EXPORT int nfc_initiator_inventory_iso14443b2sr(nfc_device *pnd, nfc_target ant[], const size_t szTargets);
+NFC_EXPORT int nfc_initiator_select_passive_targets(nfc_device *pnd, const nfc_modulation nm, const uint8_t *pbtInitData, const size_t szInitData, nfc_target ant[], const size_t szTargets);
 NFC_EXPORT int nfc_initiator_poll_target(nfc_device *pnd, const nfc_modulation *pnmTargetTypes, const size_t szTargetTypes, const uint8_t uiPollNr, const uint8_t uiPeriod, nfc_target *pnt);
 NFC_EXPORT int nfc_initiator_select_dep_target(nfc_device *pnd, const nfc_dep_mode ndm, const nfc_baud_rate nbr, const nfc_dep_info *pndiInitiator, nfc_target *pnt, const int timeout);
 NFC_EXPORT int nfc_initiator_poll_dep_target(nfc_device *pnd, const nfc_dep_mode ndm, const nfc_baud_rate nbr, const nfc_dep_info *pndiInitiator, nfc_target *pnt, const int timeout);
 NFC_EXPORT int nfc_initiator_deselect_target(nfc_device *pnd);
 NFC_EXPORT int nfc_initiator_transceive_bytes(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, uint8_t *pbtRx, const size_t szRx, int timeout);
+NFC_EXPORT int nfc_initiator_transceive_bytes_target(nfc_device *pnd, const size_t szTarget, const uint8_t *pbtTx, const size_t szTx, uint8_t *pbtRx, const size_t szRx, int timeout);
 NFC_EXPORT int nfc_initiator_transceive_bits(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTxBits, const uint8_t *pbtTxPar, uint8_t *pbtRx, const size_t szRx, uint8_t *pbtRxPar);
 NFC_EXPORT int nfc_initiator_transceive_bytes_timed(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, uint8_t *pbtRx, const size_t szRx, uint32_t *cycles);
 NFC_EXPORT int nfc_initiator_transceive_bits_timed(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTxBits, const uint8_t *pbtTxPar, uint8_t *pbtRx, const size_t szRx, uint8_t *pbtRxPar, uint32_t *cycles);
 NFC_EXPORT int nfc_initiator_target_is_present(nfc_device *pnd, const nfc_target *pnt);
+NFC_EXPORT int nfc_initiator_target_upgrade_bit_rate(nfc_device *pnd, nfc_target *pnt);
+NFC_EXPORT int nfc_initiator_reactivate_target(nfc_device *pnd, nfc_target *pnt);
+
+/* NFC fleet: many devices polled by worker threads */
+NFC_EXPORT nfc_fleet *nfc_fleet_new(const nfc_modulation *pnmModulations, const size_t szModulations, const size_t szMaxDevices, const size_t szWorkers, const size_t szQueue);
+NFC_EXPORT void nfc_fleet_free(nfc_fleet *pnf);
+NFC_EXPORT int nfc_fleet_add_device(nfc_fleet *pnf, nfc_device *pnd) ATTRIBUTE_NONNULL(1);
+NFC_EXPORT int nfc_fleet_set_worker_affinity(nfc_fleet *pnf, const size_t szWorker, const int iCpu) ATTRIBUTE_NONNULL(1);
+NFC_EXPORT int nfc_fleet_start(nfc_fleet *pnf) ATTRIBUTE_NONNULL(1);
+NFC_EXPORT int nfc_fleet_dequeue_events(nfc_fleet *pnf, nfc_fleet_event anfe[], const size_t szEvents, const int timeout) ATTRIBUTE_NONNULL(1);
+NFC_EXPORT int nfc_fleet_get_device_stats(nfc_fleet *pnf, const size_t szDevice, nfc_fleet_device_stats *pstats) ATTRIBUTE_NONNULL(1);
+
+/* NFC-DEP bulk transfers: payloads chained over frames, throughput reported */
+NFC_EXPORT int nfc_initiator_select_dep_target_fastest(nfc_device *pnd, const nfc_dep_info *pndiInitiator, nfc_target *pnt, const int timeout);
+NFC_EXPORT int nfc_initiator_transceive_bulk(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, uint8_t *pbtRx, const size_t szRx, nfc_bulk_stats *pstats, int timeout);
+NFC_EXPORT int nfc_target_receive_bulk(nfc_device *pnd, uint8_t *pbtRx, const size_t szRx, nfc_bulk_stats *pstats, int timeout);
+NFC_EXPORT int nfc_target_send_bulk(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, nfc_bulk_stats *pstats, int timeout);
+
+/* NFC-DEP sessions: links recently established, tried first on re-selection */
+NFC_EXPORT int nfc_initiator_dep_session_lookup(nfc_device *pnd, const uint8_t *pbtNFCID3, nfc_target *pnt);
+NFC_EXPORT void nfc_initiator_dep_session_clear(nfc_device *pnd);
+
+/* Split-phase commands: submitted, then completed from an event loop */
+NFC_EXPORT int nfc_device_get_event_fd(nfc_device *pnd);
+NFC_EXPORT int nfc_device_get_event_timeout(nfc_device *pnd);
+NFC_EXPORT int nfc_device_process_events(nfc_device *pnd);
+NFC_EXPORT int nfc_initiator_transceive_bytes_submit(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, uint8_t *pbtRx, const size_t szRx, int timeout, nfc_completion_callback cb, void *user_data);
+NFC_EXPORT int nfc_initiator_select_passive_target_submit(nfc_device *pnd, const nfc_modulation nm, const uint8_t *pbtInitData, const size_t szInitData, nfc_target *pnt, nfc_completion_callback cb, void *user_data);
+NFC_EXPORT int nfc_initiator_poll_target_submit(nfc_device *pnd, const nfc_modulation *pnmModulations, const size_t szModulations, const uint8_t uiPollNr, const uint8_t uiPeriod, nfc_target *pnt, nfc_completion_callback cb, void *user_data);
+NFC_EXPORT int nfc_initiator_target_monitor(nfc_device *pnd, const nfc_target *pnt, const int cadence, nfc_target_monitor_callback cb, void *user_data);
+NFC_EXPORT int nfc_initiator_target_monitor_stop(nfc_device *pnd);
 
 /* NFC target: act as tag (i.e. MIFARE Classic) or NFC target device. */
 NFC_EXPORT int nfc_target_init(nfc_device *pnd, nfc_target *pnt, uint8_t *pbtRx, const size_t szRx, int timeout);
 NFC_EXPORT int nfc_target_send_bytes(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, int timeout);
+NFC_EXPORT int nfc_target_send_bytes_chained(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, int timeout);
 NFC_EXPORT int nfc_target_receive_bytes(nfc_device *pnd, uint8_t *pbtRx, const size_t szRx, int timeout);
 NFC_EXPORT int nfc_target_send_bits(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTxBits, const uint8_t *pbtTxPar);
 NFC_EXPORT int nfc_target_receive_bits(nfc_device *pnd, uint8_t *pbtRx, const size_t szRx, uint8_t *pbtRxPar);
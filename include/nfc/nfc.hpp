@@ -0,0 +1,603 @@
+/*-
+ * Free/Libre Near Field Communication (NFC) library
+ *
+ * Libnfc historical contributors:
+ * Copyright (C) 2009      Roel Verdult
+ * Copyright (C) 2009-2013 Romuald Conty
+ * Copyright (C) 2010-2012 Romain Tartière
+ * Copyright (C) 2010-2013 Philippe Teuwen
+ * Copyright (C) 2012-2013 Ludovic Rousseau
+ * See AUTHORS file for a more comprehensive list of contributors.
+ * Additional contributors of this file:
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+/**
+ * @file nfc.hpp
+ * @brief C++20 wrapper of libnfc
+ *
+ * Header only: RAII owners of contexts and devices, std::span buffers and
+ * awaitable initiator operations built on the split-phase commands (see
+ * nfc_device_get_event_fd()). Errors are returned in an expected-like
+ * nfc::result<T> holding the libnfc's error code.
+ *
+ * Awaiting an operation submits it; the coroutine is resumed from
+ * nfc::device::process_events(), through the executor of the device, once
+ * the operation completed. A single thread can then serve many devices by
+ * watching their event file descriptors. Closing a device resumes the
+ * coroutines still awaiting its operations with \a NFC_EOPABORTED:
+ *
+ * @code
+ * nfc::task read_uid(nfc::device &dev) {
+ *   const nfc_modulation nm = { NMT_ISO14443A, NBR_106 };
+ *   auto nt = co_await dev.select_passive_target(nm);
+ *   ...
+ * }
+ * @endcode
+ */
+
+#ifndef _LIBNFC_HPP_
+#  define _LIBNFC_HPP_
+
+#  include <nfc/nfc.h>
+
+#  include <coroutine>
+#  include <cstddef>
+#  include <cstdint>
+#  include <exception>
+#  include <optional>
+#  include <span>
+#  include <string>
+#  include <system_error>
+#  include <utility>
+
+namespace nfc
+{
+
+/**
+ * @brief std::error_category of the libnfc's error codes (negative values)
+ */
+class error_category_impl : public std::error_category
+{
+public:
+  const char *name() const noexcept override
+  {
+    return "libnfc";
+  }
+
+  std::string message(int ev) const override
+  {
+    switch (ev) {
+      case NFC_SUCCESS:
+        return "Success";
+      case NFC_EIO:
+        return "Input / Output Error";
+      case NFC_EINVARG:
+        return "Invalid argument(s)";
+      case NFC_EDEVNOTSUPP:
+        return "Not Supported by Device";
+      case NFC_ENOTSUCHDEV:
+        return "No Such Device";
+      case NFC_EOVFLOW:
+        return "Buffer Overflow";
+      case NFC_ETIMEOUT:
+        return "Timeout";
+      case NFC_EOPABORTED:
+        return "Operation Aborted";
+      case NFC_ENOTIMPL:
+        return "Not (yet) Implemented";
+      case NFC_ETGRELEASED:
+        return "Target Released";
+      case NFC_EMFCAUTHFAIL:
+        return "Mifare Authentication Failed";
+      case NFC_ERFTRANS:
+        return "RF Transmission Error";
+      case NFC_ESOFT:
+        return "Software error";
+      case NFC_ECHIP:
+        return "Device's Internal Chip Error";
+    }
+    return "Unknown error";
+  }
+};
+
+inline const std::error_category &
+error_category() noexcept
+{
+  static const error_category_impl category;
+  return category;
+}
+
+inline std::error_code
+make_error_code(const int code) noexcept
+{
+  return std::error_code(code, error_category());
+}
+
+/**
+ * @brief Error held by a nfc::result, like std::unexpected
+ */
+struct unexpected {
+  explicit unexpected(const int code) noexcept : code(code) {}
+  int code;
+};
+
+/**
+ * @brief Value of type T or libnfc's error code, like std::expected<T, int>
+ *
+ * value() throws std::system_error when there is no value.
+ */
+template <typename T>
+class [[nodiscard]] result
+{
+public:
+  result(const T &value) : m_value(value) {}
+  result(T &&value) : m_value(std::move(value)) {}
+  result(const unexpected u) noexcept : m_code(u.code) {}
+
+  bool has_value() const noexcept
+  {
+    return m_value.has_value();
+  }
+  explicit operator bool() const noexcept
+  {
+    return has_value();
+  }
+
+  T &value() &
+  {
+    check();
+    return *m_value;
+  }
+  const T &value() const &
+  {
+    check();
+    return *m_value;
+  }
+  T &&value() &&
+  {
+    check();
+    return std::move(*m_value);
+  }
+  T &operator*() & noexcept
+  {
+    return *m_value;
+  }
+  const T &operator*() const & noexcept
+  {
+    return *m_value;
+  }
+  T *operator->() noexcept
+  {
+    return &*m_value;
+  }
+  const T *operator->() const noexcept
+  {
+    return &*m_value;
+  }
+
+  /** libnfc's error code, NFC_SUCCESS when there is a value */
+  int error() const noexcept
+  {
+    return m_code;
+  }
+  std::error_code error_code() const noexcept
+  {
+    return make_error_code(m_code);
+  }
+
+private:
+  void check() const
+  {
+    if (!has_value())
+      throw std::system_error(error_code());
+  }
+
+  std::optional<T> m_value;
+  int m_code = NFC_SUCCESS;
+};
+
+template <>
+class [[nodiscard]] result<void>
+{
+public:
+  result() noexcept = default;
+  result(const unexpected u) noexcept : m_code(u.code) {}
+
+  bool has_value() const noexcept
+  {
+    return m_code >= 0;
+  }
+  explicit operator bool() const noexcept
+  {
+    return has_value();
+  }
+  void value() const
+  {
+    if (!has_value())
+      throw std::system_error(error_code());
+  }
+  int error() const noexcept
+  {
+    return m_code;
+  }
+  std::error_code error_code() const noexcept
+  {
+    return make_error_code(m_code);
+  }
+
+private:
+  int m_code = NFC_SUCCESS;
+};
+
+/**
+ * @brief Where the coroutines awaiting operations of a device are resumed
+ *
+ * By default they are resumed right away, from process_events(); an
+ * application executor (thread pool, strand...) is plugged with
+ * make_executor().
+ */
+struct executor {
+  void (*post)(void *ctx, std::coroutine_handle<> h) = [](void *, std::coroutine_handle<> h) {
+    h.resume();
+  };
+  void *ctx = nullptr;
+};
+
+/**
+ * @brief Build an executor posting to e.post(std::coroutine_handle<>)
+ */
+template <typename E>
+executor
+make_executor(E &e) noexcept
+{
+  return executor { [](void *ctx, std::coroutine_handle<> h) { static_cast<E *>(ctx)->post(h); }, &e };
+}
+
+/**
+ * @brief Coroutine type running eagerly and detached from its caller
+ *
+ * An exception escaping the coroutine terminates the program.
+ */
+struct task {
+  struct promise_type {
+    task get_return_object() noexcept
+    {
+      return {};
+    }
+    std::suspend_never initial_suspend() noexcept
+    {
+      return {};
+    }
+    std::suspend_never final_suspend() noexcept
+    {
+      return {};
+    }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept
+    {
+      std::terminate();
+    }
+  };
+};
+
+namespace detail
+{
+
+// Operation submitted when awaited: the object lives in the coroutine frame until resumption
+class operation
+{
+public:
+  operation(nfc_device *pnd, const executor &e) noexcept : m_pnd(pnd), m_executor(e) {}
+  operation(const operation &) = delete;
+  operation &operator=(const operation &) = delete;
+
+  bool await_ready() const noexcept
+  {
+    return false;
+  }
+
+protected:
+  static void complete(nfc_device *, int res, void *user_data)
+  {
+    operation *self = static_cast<operation *>(user_data);
+    self->m_res = res;
+    self->m_executor.post(self->m_executor.ctx, self->m_handle);
+  }
+
+  // Suspends only if the submission succeeded
+  bool suspended(const std::coroutine_handle<> h, const int res) noexcept
+  {
+    m_handle = h;
+    m_res = res;
+    return res >= 0;
+  }
+
+  nfc_device *m_pnd;
+  executor m_executor;
+  std::coroutine_handle<> m_handle;
+  int m_res = 0;
+};
+
+class transceive_operation : public operation
+{
+public:
+  transceive_operation(nfc_device *pnd, const executor &e, std::span<const uint8_t> tx, std::span<uint8_t> rx, const int timeout) noexcept
+    : operation(pnd, e), m_tx(tx), m_rx(rx), m_timeout(timeout) {}
+
+  bool await_suspend(std::coroutine_handle<> h) noexcept
+  {
+    return suspended(h, nfc_initiator_transceive_bytes_submit(m_pnd, m_tx.data(), m_tx.size(), m_rx.data(), m_rx.size(), m_timeout, &complete, this));
+  }
+  result<std::size_t> await_resume() const noexcept
+  {
+    if (m_res < 0)
+      return unexpected(m_res);
+    return static_cast<std::size_t>(m_res);
+  }
+
+private:
+  std::span<const uint8_t> m_tx;
+  std::span<uint8_t> m_rx;
+  int m_timeout;
+};
+
+class target_operation : public operation
+{
+public:
+  using operation::operation;
+
+  // No target is not an error
+  result<std::optional<nfc_target>> await_resume() const noexcept
+  {
+    if (m_res < 0)
+      return unexpected(m_res);
+    if (m_res == 0)
+      return std::optional<nfc_target>();
+    return std::optional<nfc_target>(m_nt);
+  }
+
+protected:
+  nfc_target m_nt {};
+};
+
+class select_operation : public target_operation
+{
+public:
+  select_operation(nfc_device *pnd, const executor &e, const nfc_modulation nm, std::span<const uint8_t> init_data) noexcept
+    : target_operation(pnd, e), m_nm(nm), m_init_data(init_data) {}
+
+  bool await_suspend(std::coroutine_handle<> h) noexcept
+  {
+    return suspended(h, nfc_initiator_select_passive_target_submit(m_pnd, m_nm, m_init_data.empty() ? nullptr : m_init_data.data(), m_init_data.size(), &m_nt, &complete, this));
+  }
+
+private:
+  nfc_modulation m_nm;
+  std::span<const uint8_t> m_init_data;
+};
+
+class poll_operation : public target_operation
+{
+public:
+  poll_operation(nfc_device *pnd, const executor &e, std::span<const nfc_modulation> modulations, const uint8_t poll_nr, const uint8_t period) noexcept
+    : target_operation(pnd, e), m_modulations(modulations), m_poll_nr(poll_nr), m_period(period) {}
+
+  bool await_suspend(std::coroutine_handle<> h) noexcept
+  {
+    return suspended(h, nfc_initiator_poll_target_submit(m_pnd, m_modulations.data(), m_modulations.size(), m_poll_nr, m_period, &m_nt, &complete, this));
+  }
+
+private:
+  std::span<const nfc_modulation> m_modulations;
+  uint8_t m_poll_nr;
+  uint8_t m_period;
+};
+
+} // namespace detail
+
+/**
+ * @brief Owner of a nfc_device, closed on destruction
+ *
+ * The coroutines awaiting operations of the device when it is closed are
+ * resumed (through its executor) with \a NFC_EOPABORTED, before the device
+ * is released: they must not use it any more.
+ */
+class device
+{
+public:
+  device() noexcept = default;
+  explicit device(nfc_device *pnd) noexcept : m_pnd(pnd) {}
+  device(device &&other) noexcept : m_pnd(std::exchange(other.m_pnd, nullptr)), m_executor(other.m_executor) {}
+  device &operator=(device &&other) noexcept
+  {
+    if (this != &other) {
+      reset();
+      m_pnd = std::exchange(other.m_pnd, nullptr);
+      m_executor = other.m_executor;
+    }
+    return *this;
+  }
+  device(const device &) = delete;
+  device &operator=(const device &) = delete;
+  ~device()
+  {
+    reset();
+  }
+
+  nfc_device *get() const noexcept
+  {
+    return m_pnd;
+  }
+  explicit operator bool() const noexcept
+  {
+    return m_pnd != nullptr;
+  }
+  const char *name() const noexcept
+  {
+    return nfc_device_get_name(m_pnd);
+  }
+
+  /** Executor resuming the coroutines awaiting operations of this device */
+  void set_executor(const executor &e) noexcept
+  {
+    m_executor = e;
+  }
+
+  result<void> initiator_init() noexcept
+  {
+    return status(nfc_initiator_init(m_pnd));
+  }
+  result<void> abort() noexcept
+  {
+    return status(nfc_abort_command(m_pnd));
+  }
+
+  /** Blocking transceive, see nfc_initiator_transceive_bytes() */
+  result<std::size_t> transceive_bytes(std::span<const uint8_t> tx, std::span<uint8_t> rx, const int timeout = -1) noexcept
+  {
+    const int res = nfc_initiator_transceive_bytes(m_pnd, tx.data(), tx.size(), rx.data(), rx.size(), timeout);
+    if (res < 0)
+      return unexpected(res);
+    return static_cast<std::size_t>(res);
+  }
+
+  /**
+   * Awaitable transceive: \a tx is copied when submitted, the answer is
+   * written straight into \a rx.
+   */
+  detail::transceive_operation transceive(std::span<const uint8_t> tx, std::span<uint8_t> rx, const int timeout = -1) noexcept
+  {
+    return detail::transceive_operation(m_pnd, m_executor, tx, rx, timeout);
+  }
+  /** Awaitable nfc_initiator_select_passive_target() */
+  detail::select_operation select_passive_target(const nfc_modulation nm, std::span<const uint8_t> init_data = {}) noexcept
+  {
+    return detail::select_operation(m_pnd, m_executor, nm, init_data);
+  }
+  /** Awaitable nfc_initiator_poll_target(), \a modulations must outlive the awaiting */
+  detail::poll_operation poll(std::span<const nfc_modulation> modulations, const uint8_t poll_nr = 0xff, const uint8_t period = 2) noexcept
+  {
+    return detail::poll_operation(m_pnd, m_executor, modulations, poll_nr, period);
+  }
+
+  /** File descriptor to watch for input, see nfc_device_get_event_fd() */
+  result<int> event_fd() noexcept
+  {
+    const int res = nfc_device_get_event_fd(m_pnd);
+    if (res < 0)
+      return unexpected(res);
+    return res;
+  }
+  /** Timeout in milliseconds for poll(), -1 for none, see nfc_device_get_event_timeout() */
+  int event_timeout() noexcept
+  {
+    return nfc_device_get_event_timeout(m_pnd);
+  }
+  /** Resume the coroutines whose operations completed, see nfc_device_process_events() */
+  result<int> process_events() noexcept
+  {
+    const int res = nfc_device_process_events(m_pnd);
+    if (res < 0)
+      return unexpected(res);
+    return res;
+  }
+
+private:
+  static result<void> status(const int res) noexcept
+  {
+    if (res < 0)
+      return unexpected(res);
+    return {};
+  }
+  // Operations awaited from the coroutines resumed by nfc_close() are refused with NFC_EOPABORTED
+  void reset() noexcept
+  {
+    if (m_pnd)
+      nfc_close(m_pnd);
+    m_pnd = nullptr;
+  }
+
+  nfc_device *m_pnd = nullptr;
+  executor m_executor;
+};
+
+/**
+ * @brief Owner of a nfc_context, released on destruction
+ *
+ * Devices opened from a context must be destroyed before it.
+ */
+class context
+{
+public:
+  static result<context> init() noexcept
+  {
+    nfc_context *p = nullptr;
+    nfc_init(&p);
+    if (!p)
+      return unexpected(NFC_ESOFT);
+    return context(p);
+  }
+
+  context(context &&other) noexcept : m_p(std::exchange(other.m_p, nullptr)) {}
+  context &operator=(context &&other) noexcept
+  {
+    if (this != &other) {
+      reset();
+      m_p = std::exchange(other.m_p, nullptr);
+    }
+    return *this;
+  }
+  context(const context &) = delete;
+  context &operator=(const context &) = delete;
+  ~context()
+  {
+    reset();
+  }
+
+  nfc_context *get() const noexcept
+  {
+    return m_p;
+  }
+
+  /** Open a device, the default one when \a connstring is \e nullptr */
+  result<device> open(const char *connstring = nullptr) noexcept
+  {
+    nfc_device *pnd = nfc_open(m_p, connstring);
+    if (!pnd)
+      return unexpected(NFC_ENOTSUCHDEV);
+    return device(pnd);
+  }
+
+  std::size_t list_devices(std::span<nfc_connstring> connstrings) noexcept
+  {
+    return nfc_list_devices(m_p, connstrings.data(), connstrings.size());
+  }
+
+private:
+  explicit context(nfc_context *p) noexcept : m_p(p) {}
+  void reset() noexcept
+  {
+    if (m_p)
+      nfc_exit(m_p);
+    m_p = nullptr;
+  }
+
+  nfc_context *m_p = nullptr;
+};
+
+} // namespace nfc
+
+#endif // _LIBNFC_HPP_
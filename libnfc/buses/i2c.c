@@ -41,6 +41,8 @@
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+#include <linux/i2c.h>
 #include <ctype.h>
 #include <dirent.h>
 #include <errno.h>
@@ -68,10 +70,20 @@ const char *i2c_ports_device_radix[] =
 
 struct i2c_device_unix {
   int fd;             // I2C device file descriptor
+  uint16_t addr;      // Address of the I2C device on the bus
+  unsigned long funcs; // Adapter functionality mask (I2C_FUNC_*)
 };
 
 #define I2C_DATA( X ) ((struct i2c_device_unix *) X)
 
+/*
+ * Longest frame i2c_read_scatter() reads through its bounce buffer, on
+ * adapters which can not scatter it themselves: the largest PN53x extended
+ * frame (264 data bytes, 8 header bytes, DCS and postamble) with the status
+ * byte in front of it.
+ */
+#define I2C_SCATTER_BOUNCE_LEN (264 + 8 + 3)
+
 /**
  * @brief Open an I2C device
  *
@@ -99,6 +111,12 @@ i2c_open(const char *pcI2C_busName, uint32_t devAddr)
     i2c_close(id);
     return INVALID_I2C_ADDRESS ;
   }
+  id->addr = (uint16_t) devAddr;
+
+  // Combined transfers are only used when the adapter supports them
+  if (ioctl(id->fd, I2C_FUNCS, &id->funcs) < 0) {
+    id->funcs = 0;
+  }
 
   return id;
 }
@@ -147,6 +165,72 @@ i2c_read(i2c_device id, uint8_t *pbtRx, const size_t szRx)
   return res;
 }
 
+/**
+ * @brief Read a frame from the I2C device, scattering it over several buffers
+ *
+ * The whole frame is read in a single transaction (one START, one STOP), as
+ * if it had been read with i2c_read() into one contiguous buffer. When the
+ * adapter supports it, the kernel stores each chunk directly in its buffer
+ * (I2C_RDWR with I2C_M_NOSTART); otherwise the frame goes through a bounce
+ * buffer on the stack, of I2C_SCATTER_BOUNCE_LEN bytes at most.
+ *
+ * @param id I2C device.
+ * @param aiov array of buffers to fill, in frame order (empty ones are skipped)
+ * @param szIov number of buffers
+ * @return length (in bytes) of read data, or driver error code  (negative value)
+ */
+ssize_t
+i2c_read_scatter(i2c_device id, const struct iovec *aiov, const size_t szIov)
+{
+  struct i2c_msg amsg[I2C_RDWR_IOCTL_MAX_MSGS];
+  size_t szMsg = 0;
+  size_t szRx = 0;
+  ssize_t res;
+
+  for (size_t i = 0; i < szIov; i++) {
+    szRx += aiov[i].iov_len;
+  }
+
+  if (((I2C_DATA(id)->funcs & (I2C_FUNC_I2C | I2C_FUNC_NOSTART)) == (I2C_FUNC_I2C | I2C_FUNC_NOSTART)) &&
+      (szIov <= I2C_RDWR_IOCTL_MAX_MSGS)) {
+    for (size_t i = 0; i < szIov; i++) {
+      if (aiov[i].iov_len == 0)
+        continue;
+      amsg[szMsg].addr = I2C_DATA(id)->addr;
+      amsg[szMsg].flags = I2C_M_RD | (szMsg ? I2C_M_NOSTART : 0);
+      amsg[szMsg].len = (uint16_t) aiov[i].iov_len;
+      amsg[szMsg].buf = aiov[i].iov_base;
+      szMsg++;
+    }
+    if (szMsg > 0) {
+      struct i2c_rdwr_ioctl_data rdwr = { amsg, (uint32_t) szMsg };
+      if (ioctl(I2C_DATA(id)->fd, I2C_RDWR, &rdwr) < 0) {
+        log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR,
+                "Error: combined read of %d bytes failed (%s).", (int) szRx, strerror(errno));
+        return NFC_EIO;
+      }
+      return szRx;
+    }
+  }
+
+  if (szIov == 1) {
+    return i2c_read(id, aiov[0].iov_base, aiov[0].iov_len);
+  }
+
+  uint8_t abtBounce[I2C_SCATTER_BOUNCE_LEN];
+  if (szRx > sizeof(abtBounce)) {
+    return NFC_EINVARG;
+  }
+  if ((res = i2c_read(id, abtBounce, szRx)) >= 0) {
+    size_t szOffset = 0;
+    for (size_t i = 0; i < szIov; i++) {
+      memcpy(aiov[i].iov_base, abtBounce + szOffset, aiov[i].iov_len);
+      szOffset += aiov[i].iov_len;
+    }
+  }
+  return res;
+}
+
 /**
  * @brief Write a frame to I2C device containing \a pbtTx content
  *
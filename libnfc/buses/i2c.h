@@ -35,6 +35,7 @@
 #  define __NFC_BUS_I2C_H__
 
 #  include <sys/time.h>
+#  include <sys/uio.h>
 
 #  include <stdio.h>
 #  include <string.h>
@@ -53,6 +54,8 @@ void       i2c_close(const i2c_device id);
 
 ssize_t    i2c_read(i2c_device id, uint8_t *pbtRx, const size_t szRx);
 
+ssize_t    i2c_read_scatter(i2c_device id, const struct iovec *aiov, const size_t szIov);
+
 int        i2c_write(i2c_device id, const uint8_t *pbtTx, const size_t szTx);
 
 char     **i2c_list_ports(void);
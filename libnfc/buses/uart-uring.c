@@ -0,0 +1,760 @@
+/*-
+ * Free/Libre Near Field Communication (NFC) library
+ *
+ * Libnfc historical contributors:
+ * Copyright (C) 2009      Roel Verdult
+ * Copyright (C) 2009-2013 Romuald Conty
+ * Copyright (C) 2010-2012 Romain Tartière
+ * Copyright (C) 2010-2013 Philippe Teuwen
+ * Copyright (C) 2012-2013 Ludovic Rousseau
+ * See AUTHORS file for a more comprehensive list of contributors.
+ * Additional contributors of this file:
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+/**
+ * @file uart-uring.c
+ * @brief io_uring backend of the UART driver
+ *
+ * All the serial ports of the process share one io_uring, set up with the
+ * first port. Each port keeps a multishot read armed, the kernel filling the
+ * buffers the port provides (a buffer ring per port, whose group is the port
+ * slot). Whichever thread enters the ring moves the data received by every
+ * port to their staging buffers: a thread driving many readers in turn then
+ * mostly finds the answer of the next one already there, without any system
+ * call. Writes and re-armed requests are queued and submitted all together
+ * by the next io_uring_enter(), the one waiting for the completion of a
+ * write or for received bytes.
+ *
+ * Only one thread at a time waits in the kernel, the others wait for it to
+ * reap their completions.
+ *
+ * The ring is driven through the raw system calls, no library is needed.
+ * Multishot reads need Linux 6.7, the ports use select() and read() on older
+ * kernels.
+ */
+
+// syscall()
+#define _GNU_SOURCE
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include "uart-uring.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// features.h raised _XOPEN_SOURCE, let config.h (included again by log.h) define it quietly
+#undef _XOPEN_SOURCE
+
+#include <nfc/nfc.h>
+#include "nfc-internal.h"
+
+#define LOG_GROUP    NFC_LOG_GROUP_COM
+#define LOG_CATEGORY "libnfc.bus.uart"
+
+// IORING_OP_READ_MULTISHOT (Linux 6.7), missing from older headers
+#define UART_URING_OP_READ_MULTISHOT 49
+
+#define UART_URING_ENTRIES    64
+#define UART_URING_MAX_PORTS  256
+// Buffers provided to the multishot read of each port (a power of 2)
+#define UART_URING_BUFS       8
+#define UART_URING_BUF_LEN    256
+// Largest PN53x extended frame, with room for the next one
+#define UART_URING_STAGE_LEN  1024
+// Bound of the wait for a write to be done, when the caller gives none
+#define UART_URING_WRITE_TIMEOUT 1000
+
+/*
+ * user_data of the requests: tag, port slot and port (or abort poll)
+ * identifier, so that a late completion is never taken for another one
+ */
+#define UART_URING_TAG_READ      1
+#define UART_URING_TAG_WRITE     2
+#define UART_URING_TAG_CANCEL    3
+#define UART_URING_TAG_ABORT     4
+#define UART_URING_TAG(x)        ((x) & 0xff)
+#define UART_URING_SLOT(x)       (((x) >> 8) & 0xffff)
+#define UART_URING_ID(x)         ((x) >> 24)
+#define UART_URING_USER_DATA(tag, slot, id) ((uint64_t)(tag) | ((uint64_t)(slot) << 8) | ((uint64_t)(id) << 24))
+
+#define URING_LOAD(p)            __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define URING_STORE(p, v)        __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+struct uart_uring {
+  int iFd;
+  unsigned uiSlot;
+  uint64_t ui64Id;
+  // Buffers of the multishot read
+  struct io_uring_buf_ring *pBufRing;
+  size_t szBufRing;
+  uint16_t ui16BufTail;
+  uint8_t abtBufs[UART_URING_BUFS][UART_URING_BUF_LEN];
+  // Armed read and the bytes it received, not consumed yet
+  bool bReadArmed;
+  int iReadError;
+  uint8_t abtStage[UART_URING_STAGE_LEN];
+  size_t szStageStart;
+  size_t szStageEnd;
+  // Write in flight and its result
+  bool bWriting;
+  int iWriteRes;
+  // Poll of the abort file descriptor during a uart_uring_receive()
+  uint64_t ui64AbortUserData;
+  bool bAbortArmed;
+  bool bAbortFired;
+};
+
+/*
+ * The io_uring shared by the ports, and what the threads using it share
+ */
+struct uart_uring_ring {
+  int iRingFd;
+  // Submission queue
+  void *pSqRing;
+  size_t szSqRing;
+  unsigned *puiSqHead;
+  unsigned *puiSqTail;
+  unsigned *puiSqMask;
+  unsigned *puiSqArray;
+  unsigned uiSqEntries;
+  struct io_uring_sqe *pSqes;
+  size_t szSqes;
+  unsigned uiToSubmit;
+  // Completion queue, in the same mapping as the submission queue when the kernel allows it
+  void *pCqRing;
+  size_t szCqRing;
+  unsigned *puiCqHead;
+  unsigned *puiCqTail;
+  unsigned *puiCqMask;
+  struct io_uring_cqe *pCqes;
+  // Ports using the ring, by slot
+  struct uart_uring *apuuPorts[UART_URING_MAX_PORTS];
+  size_t szPorts;
+  uint64_t ui64NextId;
+  // Is a thread waiting in io_uring_enter(), the others wait for cond
+  bool bWaiting;
+  pthread_cond_t cond;
+};
+
+static struct uart_uring_ring *puurRing = NULL;
+static pthread_mutex_t uurMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Submit the queued requests, then wait for uiMinComplete completions at most timeout ms (0: forever)
+static int
+uart_uring_enter(struct uart_uring_ring *puur, const unsigned uiToSubmit, const unsigned uiMinComplete, const int timeout)
+{
+  struct io_uring_getevents_arg arg;
+  struct __kernel_timespec ts;
+  unsigned uiFlags = uiMinComplete ? IORING_ENTER_GETEVENTS : 0;
+  void *pArg = NULL;
+  size_t szArg = 0;
+  int res;
+
+  if (!uiMinComplete && !uiToSubmit)
+    return 0;
+  if (uiMinComplete && (timeout > 0)) {
+    memset(&arg, 0, sizeof(arg));
+    ts.tv_sec = timeout / 1000;
+    ts.tv_nsec = (timeout % 1000) * 1000000LL;
+    arg.ts = (uint64_t)(uintptr_t)&ts;
+    uiFlags |= IORING_ENTER_EXT_ARG;
+    pArg = &arg;
+    szArg = sizeof(arg);
+  }
+  res = (int)syscall(__NR_io_uring_enter, puur->iRingFd, uiToSubmit, uiMinComplete, uiFlags, pArg, szArg);
+  if (res < 0)
+    return ((errno == EINTR) || (errno == ETIME) || (errno == EBUSY)) ? 0 : NFC_EIO;
+  return res;
+}
+
+// Submit the queued requests without waiting, with uurMutex held
+static int
+uart_uring_submit(struct uart_uring_ring *puur)
+{
+  int res;
+
+  if ((res = uart_uring_enter(puur, puur->uiToSubmit, 0, 0)) < 0)
+    return res;
+  puur->uiToSubmit -= MIN((unsigned)res, puur->uiToSubmit);
+  return NFC_SUCCESS;
+}
+
+static struct io_uring_sqe *
+uart_uring_get_sqe(struct uart_uring_ring *puur)
+{
+  unsigned uiTail = *puur->puiSqTail;
+
+  if (uiTail - URING_LOAD(puur->puiSqHead) >= puur->uiSqEntries) {
+    if ((uart_uring_submit(puur) < 0) || (uiTail - URING_LOAD(puur->puiSqHead) >= puur->uiSqEntries))
+      return NULL;
+  }
+  const unsigned uiIndex = uiTail & *puur->puiSqMask;
+  struct io_uring_sqe *psqe = &puur->pSqes[uiIndex];
+  memset(psqe, 0, sizeof(*psqe));
+  puur->puiSqArray[uiIndex] = uiIndex;
+  URING_STORE(puur->puiSqTail, uiTail + 1);
+  puur->uiToSubmit++;
+  return psqe;
+}
+
+// Give a buffer back to the multishot read of the port
+static void
+uart_uring_recycle(struct uart_uring *puu, const uint16_t ui16Bid)
+{
+  struct io_uring_buf *pbuf = &puu->pBufRing->bufs[puu->ui16BufTail & (UART_URING_BUFS - 1)];
+
+  pbuf->addr = (uint64_t)(uintptr_t)puu->abtBufs[ui16Bid];
+  pbuf->len = UART_URING_BUF_LEN;
+  pbuf->bid = ui16Bid;
+  puu->ui16BufTail++;
+  URING_STORE(&puu->pBufRing->tail, puu->ui16BufTail);
+}
+
+static void
+uart_uring_complete_read(struct uart_uring *puu, const struct io_uring_cqe *pcqe)
+{
+  if (pcqe->flags & IORING_CQE_F_BUFFER) {
+    const uint16_t ui16Bid = (uint16_t)(pcqe->flags >> IORING_CQE_BUFFER_SHIFT);
+    if (pcqe->res > 0) {
+      if (puu->szStageStart == puu->szStageEnd) {
+        puu->szStageStart = puu->szStageEnd = 0;
+      } else if (puu->szStageEnd + pcqe->res > sizeof(puu->abtStage)) {
+        memmove(puu->abtStage, puu->abtStage + puu->szStageStart, puu->szStageEnd - puu->szStageStart);
+        puu->szStageEnd -= puu->szStageStart;
+        puu->szStageStart = 0;
+      }
+      const size_t szCopy = MIN((size_t)pcqe->res, sizeof(puu->abtStage) - puu->szStageEnd);
+      if (szCopy < (size_t)pcqe->res)
+        log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "%d bytes have been lost.", (int)(pcqe->res - szCopy));
+      memcpy(puu->abtStage + puu->szStageEnd, puu->abtBufs[ui16Bid], szCopy);
+      puu->szStageEnd += szCopy;
+    }
+    uart_uring_recycle(puu, ui16Bid);
+  }
+  if (!(pcqe->flags & IORING_CQE_F_MORE)) {
+    // The read is over: out of buffers, cancelled or failed
+    puu->bReadArmed = false;
+    if ((pcqe->res == 0) || ((pcqe->res < 0) && (pcqe->res != -ENOBUFS) && (pcqe->res != -ECANCELED) && (pcqe->res != -EAGAIN) && (pcqe->res != -EINTR))) {
+      log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "Error: %s", (pcqe->res == 0) ? "end of file" : strerror(-pcqe->res));
+      puu->iReadError = NFC_EIO;
+    }
+  }
+}
+
+static void
+uart_uring_complete(struct uart_uring_ring *puur, const struct io_uring_cqe *pcqe)
+{
+  struct uart_uring *puu = puur->apuuPorts[UART_URING_SLOT(pcqe->user_data)];
+
+  if (!puu)
+    return;
+  switch (UART_URING_TAG(pcqe->user_data)) {
+    case UART_URING_TAG_READ:
+      if (UART_URING_ID(pcqe->user_data) == puu->ui64Id)
+        uart_uring_complete_read(puu, pcqe);
+      break;
+    case UART_URING_TAG_WRITE:
+      if (UART_URING_ID(pcqe->user_data) == puu->ui64Id) {
+        puu->bWriting = false;
+        puu->iWriteRes = pcqe->res;
+      }
+      break;
+    case UART_URING_TAG_ABORT:
+      if (pcqe->user_data == puu->ui64AbortUserData) {
+        puu->bAbortArmed = false;
+        puu->bAbortFired = (pcqe->res >= 0);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+// Reap the completions posted for all the ports, without entering the kernel
+static void
+uart_uring_reap(struct uart_uring_ring *puur)
+{
+  unsigned uiHead = *puur->puiCqHead;
+  const unsigned uiTail = URING_LOAD(puur->puiCqTail);
+
+  while (uiHead != uiTail) {
+    uart_uring_complete(puur, &puur->pCqes[uiHead & *puur->puiCqMask]);
+    uiHead++;
+  }
+  URING_STORE(puur->puiCqHead, uiHead);
+}
+
+/*
+ * Wait, with uurMutex held, until bDone() holds for the port or the deadline
+ * passes. The queued requests are submitted meanwhile.
+ */
+static int
+uart_uring_wait(struct uart_uring *puu, bool (*bDone)(const struct uart_uring *puu), const nfc_deadline deadline)
+{
+  struct uart_uring_ring *puur = puurRing;
+  int res;
+
+  while (true) {
+    uart_uring_reap(puur);
+    if (bDone(puu))
+      return NFC_SUCCESS;
+    int remaining = 0;
+    if (deadline && ((remaining = nfc_deadline_remaining(deadline)) < 0))
+      return NFC_ETIMEOUT;
+    if (puur->bWaiting) {
+      // The thread in the kernel reaps for everybody
+      if ((res = uart_uring_submit(puur)) < 0)
+        return res;
+      if (deadline) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        ts.tv_sec += remaining / 1000;
+        ts.tv_nsec += (remaining % 1000) * 1000000L;
+        if (ts.tv_nsec >= 1000000000L) {
+          ts.tv_sec++;
+          ts.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&puur->cond, &uurMutex, &ts);
+      } else {
+        pthread_cond_wait(&puur->cond, &uurMutex);
+      }
+      continue;
+    }
+    // Submit everything queued and wait, in a single system call
+    const unsigned uiToSubmit = puur->uiToSubmit;
+    puur->uiToSubmit = 0;
+    puur->bWaiting = true;
+    pthread_mutex_unlock(&uurMutex);
+    res = uart_uring_enter(puur, uiToSubmit, 1, remaining);
+    pthread_mutex_lock(&uurMutex);
+    puur->bWaiting = false;
+    puur->uiToSubmit += uiToSubmit - ((res > 0) ? MIN((unsigned)res, uiToSubmit) : 0);
+    uart_uring_reap(puur);
+    pthread_cond_broadcast(&puur->cond);
+    if (res < 0)
+      return res;
+  }
+}
+
+static bool
+uart_uring_read_done(const struct uart_uring *puu)
+{
+  return !puu->bReadArmed;
+}
+
+static bool
+uart_uring_write_done(const struct uart_uring *puu)
+{
+  return !puu->bWriting;
+}
+
+static bool
+uart_uring_abort_done(const struct uart_uring *puu)
+{
+  return !puu->bAbortArmed;
+}
+
+static int
+uart_uring_arm_read(struct uart_uring *puu)
+{
+  struct io_uring_sqe *psqe;
+
+  if (puu->bReadArmed)
+    return NFC_SUCCESS;
+  if (!(psqe = uart_uring_get_sqe(puurRing)))
+    return NFC_EIO;
+  psqe->opcode = UART_URING_OP_READ_MULTISHOT;
+  psqe->fd = puu->iFd;
+  psqe->flags = IOSQE_BUFFER_SELECT;
+  psqe->buf_group = (uint16_t)puu->uiSlot;
+  psqe->user_data = UART_URING_USER_DATA(UART_URING_TAG_READ, puu->uiSlot, puu->ui64Id);
+  puu->bReadArmed = true;
+  return NFC_SUCCESS;
+}
+
+static void
+uart_uring_cancel(struct uart_uring *puu, const uint64_t ui64UserData)
+{
+  struct io_uring_sqe *psqe;
+
+  if ((psqe = uart_uring_get_sqe(puurRing))) {
+    psqe->opcode = IORING_OP_ASYNC_CANCEL;
+    psqe->addr = ui64UserData;
+    psqe->user_data = UART_URING_USER_DATA(UART_URING_TAG_CANCEL, puu->uiSlot, puu->ui64Id);
+  }
+}
+
+static void
+uart_uring_ring_free(struct uart_uring_ring *puur)
+{
+  // Closing the ring cancels the requests still pending
+  if (puur->pSqes)
+    munmap(puur->pSqes, puur->szSqes);
+  if (puur->pCqRing && (puur->pCqRing != puur->pSqRing))
+    munmap(puur->pCqRing, puur->szCqRing);
+  if (puur->pSqRing)
+    munmap(puur->pSqRing, puur->szSqRing);
+  close(puur->iRingFd);
+  pthread_cond_destroy(&puur->cond);
+  free(puur);
+}
+
+// Does the kernel provide multishot reads
+static bool
+uart_uring_ring_probe(struct uart_uring_ring *puur)
+{
+  const size_t szProbe = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+  struct io_uring_probe *pprobe;
+  bool bSupported = false;
+
+  if (!(pprobe = calloc(1, szProbe)))
+    return false;
+  if ((syscall(__NR_io_uring_register, puur->iRingFd, IORING_REGISTER_PROBE, pprobe, 256) >= 0) &&
+      (pprobe->last_op >= UART_URING_OP_READ_MULTISHOT))
+    bSupported = (pprobe->ops[UART_URING_OP_READ_MULTISHOT].flags & IO_URING_OP_SUPPORTED) != 0;
+  free(pprobe);
+  return bSupported;
+}
+
+static struct uart_uring_ring *
+uart_uring_ring_new(void)
+{
+  struct io_uring_params p;
+  struct uart_uring_ring *puur;
+  pthread_condattr_t attr;
+
+  if (!(puur = calloc(1, sizeof(*puur))))
+    return NULL;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&puur->cond, &attr);
+  pthread_condattr_destroy(&attr);
+  memset(&p, 0, sizeof(p));
+  if ((puur->iRingFd = (int)syscall(__NR_io_uring_setup, UART_URING_ENTRIES, &p)) < 0) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "io_uring unavailable (%s)", strerror(errno));
+    pthread_cond_destroy(&puur->cond);
+    free(puur);
+    return NULL;
+  }
+  if (!(p.features & IORING_FEAT_EXT_ARG) || !uart_uring_ring_probe(puur)) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "%s", "io_uring lacks timed waits or multishot reads");
+    goto error;
+  }
+
+  puur->szSqRing = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  puur->szCqRing = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if (p.features & IORING_FEAT_SINGLE_MMAP)
+    puur->szSqRing = puur->szCqRing = MAX(puur->szSqRing, puur->szCqRing);
+  puur->pSqRing = mmap(NULL, puur->szSqRing, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, puur->iRingFd, IORING_OFF_SQ_RING);
+  if (puur->pSqRing == MAP_FAILED) {
+    puur->pSqRing = NULL;
+    goto error;
+  }
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    puur->pCqRing = puur->pSqRing;
+  } else {
+    puur->pCqRing = mmap(NULL, puur->szCqRing, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, puur->iRingFd, IORING_OFF_CQ_RING);
+    if (puur->pCqRing == MAP_FAILED) {
+      puur->pCqRing = NULL;
+      goto error;
+    }
+  }
+  puur->szSqes = p.sq_entries * sizeof(struct io_uring_sqe);
+  puur->pSqes = mmap(NULL, puur->szSqes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, puur->iRingFd, IORING_OFF_SQES);
+  if (puur->pSqes == MAP_FAILED) {
+    puur->pSqes = NULL;
+    goto error;
+  }
+
+  puur->puiSqHead = (unsigned *)((uint8_t *)puur->pSqRing + p.sq_off.head);
+  puur->puiSqTail = (unsigned *)((uint8_t *)puur->pSqRing + p.sq_off.tail);
+  puur->puiSqMask = (unsigned *)((uint8_t *)puur->pSqRing + p.sq_off.ring_mask);
+  puur->puiSqArray = (unsigned *)((uint8_t *)puur->pSqRing + p.sq_off.array);
+  puur->uiSqEntries = p.sq_entries;
+  puur->puiCqHead = (unsigned *)((uint8_t *)puur->pCqRing + p.cq_off.head);
+  puur->puiCqTail = (unsigned *)((uint8_t *)puur->pCqRing + p.cq_off.tail);
+  puur->puiCqMask = (unsigned *)((uint8_t *)puur->pCqRing + p.cq_off.ring_mask);
+  puur->pCqes = (struct io_uring_cqe *)((uint8_t *)puur->pCqRing + p.cq_off.cqes);
+  return puur;
+
+error:
+  uart_uring_ring_free(puur);
+  return NULL;
+}
+
+/*
+ * Add the serial port iFd to the shared io_uring, setting it up if needed.
+ * Returns NULL if the kernel does not provide what is needed.
+ */
+struct uart_uring *
+uart_uring_new(const int iFd)
+{
+  struct uart_uring *puu = NULL;
+  struct io_uring_buf_reg reg;
+  unsigned uiSlot;
+
+  pthread_mutex_lock(&uurMutex);
+  if (!puurRing && !(puurRing = uart_uring_ring_new()))
+    goto end;
+  for (uiSlot = 0; (uiSlot < UART_URING_MAX_PORTS) && puurRing->apuuPorts[uiSlot]; uiSlot++);
+  if ((uiSlot == UART_URING_MAX_PORTS) || !(puu = calloc(1, sizeof(*puu))))
+    goto error;
+  puu->iFd = iFd;
+  puu->uiSlot = uiSlot;
+  puu->ui64Id = ++puurRing->ui64NextId;
+
+  // The buffer ring has to be page aligned
+  puu->szBufRing = UART_URING_BUFS * sizeof(struct io_uring_buf);
+  puu->pBufRing = mmap(NULL, puu->szBufRing, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (puu->pBufRing == MAP_FAILED)
+    goto error;
+  memset(&reg, 0, sizeof(reg));
+  reg.ring_addr = (uint64_t)(uintptr_t)puu->pBufRing;
+  reg.ring_entries = UART_URING_BUFS;
+  reg.bgid = (uint16_t)uiSlot;
+  if (syscall(__NR_io_uring_register, puurRing->iRingFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "Unable to provide buffers to io_uring (%s)", strerror(errno));
+    munmap(puu->pBufRing, puu->szBufRing);
+    goto error;
+  }
+  for (uint16_t n = 0; n < UART_URING_BUFS; n++)
+    uart_uring_recycle(puu, n);
+  puurRing->apuuPorts[uiSlot] = puu;
+  puurRing->szPorts++;
+  if ((uart_uring_arm_read(puu) < 0) || (uart_uring_submit(puurRing) < 0)) {
+    pthread_mutex_unlock(&uurMutex);
+    uart_uring_free(puu);
+    return NULL;
+  }
+  log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "Serial port driven by io_uring (slot %u)", uiSlot);
+  goto end;
+
+error:
+  free(puu);
+  puu = NULL;
+  if (puurRing->szPorts == 0) {
+    uart_uring_ring_free(puurRing);
+    puurRing = NULL;
+  }
+end:
+  pthread_mutex_unlock(&uurMutex);
+  return puu;
+}
+
+/*
+ * Remove the port from the shared io_uring, which is released with the last
+ * port.
+ */
+void
+uart_uring_free(struct uart_uring *puu)
+{
+  const nfc_deadline deadline = nfc_deadline_from_timeout(UART_URING_WRITE_TIMEOUT);
+  bool bBusy;
+
+  if (!puu)
+    return;
+  pthread_mutex_lock(&uurMutex);
+  if (puu->bReadArmed)
+    uart_uring_cancel(puu, UART_URING_USER_DATA(UART_URING_TAG_READ, puu->uiSlot, puu->ui64Id));
+  if (puu->bAbortArmed)
+    uart_uring_cancel(puu, puu->ui64AbortUserData);
+  uart_uring_wait(puu, uart_uring_read_done, deadline);
+  uart_uring_wait(puu, uart_uring_abort_done, deadline);
+  // The kernel may still fill the buffers of a read it did not cancel: they are then never released
+  if (!(bBusy = puu->bReadArmed)) {
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.bgid = (uint16_t)puu->uiSlot;
+    syscall(__NR_io_uring_register, puurRing->iRingFd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+    munmap(puu->pBufRing, puu->szBufRing);
+  } else {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Unable to cancel the read of the serial port.");
+  }
+  puurRing->apuuPorts[puu->uiSlot] = NULL;
+  if (--puurRing->szPorts == 0) {
+    uart_uring_ring_free(puurRing);
+    puurRing = NULL;
+  }
+  pthread_mutex_unlock(&uurMutex);
+  if (!bBusy)
+    free(puu);
+}
+
+/*
+ * Drop the bytes received so far (after tcflush() dropped the kernel's ones).
+ */
+void
+uart_uring_flush_input(struct uart_uring *puu)
+{
+  pthread_mutex_lock(&uurMutex);
+  uart_uring_reap(puurRing);
+  if (puu->szStageEnd != puu->szStageStart)
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "%d bytes have eaten.", (int)(puu->szStageEnd - puu->szStageStart));
+  puu->szStageStart = puu->szStageEnd;
+  puu->iReadError = NFC_SUCCESS;
+  pthread_mutex_unlock(&uurMutex);
+}
+
+/*
+ * Write pbtTx, along with the other queued requests, and wait for the write
+ * to be done (timeout ms at most, UART_URING_WRITE_TIMEOUT when none).
+ */
+int
+uart_uring_send(struct uart_uring *puu, const uint8_t *pbtTx, const size_t szTx, int timeout)
+{
+  const nfc_deadline deadline = nfc_deadline_from_timeout((timeout > 0) ? timeout : UART_URING_WRITE_TIMEOUT);
+  size_t szSent = 0;
+  bool bFull = false;
+  int res = NFC_SUCCESS;
+
+  pthread_mutex_lock(&uurMutex);
+  while (szSent < szTx) {
+    struct io_uring_sqe *psqe;
+    // The answer is received by a read armed beforehand
+    if ((res = uart_uring_arm_read(puu)) < 0)
+      break;
+    if (bFull) {
+      // Write once the port takes bytes again
+      if (!(psqe = uart_uring_get_sqe(puurRing))) {
+        res = NFC_EIO;
+        break;
+      }
+      psqe->opcode = IORING_OP_POLL_ADD;
+      psqe->fd = puu->iFd;
+      psqe->poll32_events = POLLOUT;
+      psqe->flags = IOSQE_IO_LINK;
+      psqe->user_data = UART_URING_USER_DATA(UART_URING_TAG_CANCEL, puu->uiSlot, puu->ui64Id);
+    }
+    if (!(psqe = uart_uring_get_sqe(puurRing))) {
+      res = NFC_EIO;
+      break;
+    }
+    psqe->opcode = IORING_OP_WRITE;
+    psqe->fd = puu->iFd;
+    psqe->off = (uint64_t) -1;
+    psqe->addr = (uint64_t)(uintptr_t)(pbtTx + szSent);
+    psqe->len = (uint32_t)(szTx - szSent);
+    psqe->user_data = UART_URING_USER_DATA(UART_URING_TAG_WRITE, puu->uiSlot, puu->ui64Id);
+    puu->bWriting = true;
+    if ((res = uart_uring_wait(puu, uart_uring_write_done, deadline)) < 0) {
+      // pbtTx must not be used once returned
+      uart_uring_cancel(puu, UART_URING_USER_DATA(UART_URING_TAG_WRITE, puu->uiSlot, puu->ui64Id));
+      uart_uring_wait(puu, uart_uring_write_done, 0);
+      break;
+    }
+    if ((puu->iWriteRes == -EAGAIN) || (puu->iWriteRes == -EINTR)) {
+      bFull = (puu->iWriteRes == -EAGAIN);
+      continue;
+    }
+    bFull = false;
+    if (puu->iWriteRes <= 0) {
+      log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "Error: %s", (puu->iWriteRes == 0) ? "nothing written" : strerror(-puu->iWriteRes));
+      res = NFC_EIO;
+      break;
+    }
+    szSent += puu->iWriteRes;
+  }
+  pthread_mutex_unlock(&uurMutex);
+  return res;
+}
+
+static bool
+uart_uring_receive_done(const struct uart_uring *puu)
+{
+  return (puu->szStageEnd != puu->szStageStart) || (puu->iReadError < 0) || puu->bAbortFired || !puu->bReadArmed;
+}
+
+/*
+ * Receive szRx bytes, see uart_receive().
+ */
+int
+uart_uring_receive(struct uart_uring *puu, uint8_t *pbtRx, const size_t szRx, const int iAbortFd, int timeout)
+{
+  const nfc_deadline deadline = nfc_deadline_from_timeout(timeout);
+  size_t szReceived = 0;
+  int res;
+
+  pthread_mutex_lock(&uurMutex);
+  puu->bAbortFired = false;
+  while (true) {
+    uart_uring_reap(puurRing);
+    const size_t szCopy = MIN(szRx - szReceived, puu->szStageEnd - puu->szStageStart);
+    memcpy(pbtRx + szReceived, puu->abtStage + puu->szStageStart, szCopy);
+    puu->szStageStart += szCopy;
+    szReceived += szCopy;
+    if (szReceived == szRx) {
+      res = NFC_SUCCESS;
+      break;
+    }
+    if ((res = puu->iReadError) < 0) {
+      puu->iReadError = NFC_SUCCESS;
+      break;
+    }
+    if (puu->bAbortFired) {
+      log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "%s", "Abort!");
+      close(iAbortFd);
+      res = NFC_EOPABORTED;
+      break;
+    }
+    if (iAbortFd && !puu->bAbortArmed) {
+      struct io_uring_sqe *psqe;
+      if (!(psqe = uart_uring_get_sqe(puurRing))) {
+        res = NFC_EIO;
+        break;
+      }
+      puu->ui64AbortUserData = UART_URING_USER_DATA(UART_URING_TAG_ABORT, puu->uiSlot, ++puurRing->ui64NextId);
+      psqe->opcode = IORING_OP_POLL_ADD;
+      psqe->fd = iAbortFd;
+      psqe->poll32_events = POLLIN;
+      psqe->user_data = puu->ui64AbortUserData;
+      puu->bAbortArmed = true;
+    }
+    if ((res = uart_uring_arm_read(puu)) < 0)
+      break;
+    if ((res = uart_uring_wait(puu, uart_uring_receive_done, (timeout > 0) ? deadline : 0)) < 0) {
+      if (res == NFC_ETIMEOUT)
+        log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "%s", "Timeout!");
+      break;
+    }
+  }
+  if (puu->bAbortArmed) {
+    // Removed along with the next submission; its completion is then ignored
+    struct io_uring_sqe *psqe;
+    if ((psqe = uart_uring_get_sqe(puurRing))) {
+      psqe->opcode = IORING_OP_POLL_REMOVE;
+      psqe->addr = puu->ui64AbortUserData;
+      psqe->user_data = UART_URING_USER_DATA(UART_URING_TAG_CANCEL, puu->uiSlot, puu->ui64Id);
+    }
+    puu->ui64AbortUserData = 0;
+    puu->bAbortArmed = false;
+  }
+  pthread_mutex_unlock(&uurMutex);
+  if (res == NFC_SUCCESS)
+    LOG_HEX(LOG_GROUP, "RX", pbtRx, szRx);
+  return res;
+}
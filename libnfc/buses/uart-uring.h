@@ -0,0 +1,49 @@
+/*-
+ * Free/Libre Near Field Communication (NFC) library
+ *
+ * Libnfc historical contributors:
+ * Copyright (C) 2009      Roel Verdult
+ * Copyright (C) 2009-2013 Romuald Conty
+ * Copyright (C) 2010-2012 Romain Tartière
+ * Copyright (C) 2010-2013 Philippe Teuwen
+ * Copyright (C) 2012-2013 Ludovic Rousseau
+ * See AUTHORS file for a more comprehensive list of contributors.
+ * Additional contributors of this file:
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+/**
+ * @file uart-uring.h
+ * @brief io_uring backend of the UART driver
+ */
+
+#ifndef __NFC_BUS_UART_URING_H__
+#  define __NFC_BUS_UART_URING_H__
+
+#  include <stdbool.h>
+#  include <stddef.h>
+#  include <stdint.h>
+
+struct uart_uring;
+
+struct uart_uring *uart_uring_new(const int iFd);
+void    uart_uring_free(struct uart_uring *puu);
+void    uart_uring_flush_input(struct uart_uring *puu);
+
+int     uart_uring_receive(struct uart_uring *puu, uint8_t *pbtRx, const size_t szRx, const int iAbortFd, int timeout);
+int     uart_uring_send(struct uart_uring *puu, const uint8_t *pbtTx, const size_t szTx, int timeout);
+
+#endif // __NFC_BUS_UART_URING_H__
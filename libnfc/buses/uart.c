@@ -54,6 +54,10 @@
 #include <nfc/nfc.h>
 #include "nfc-internal.h"
 
+#ifdef UART_IO_URING
+#  include "uart-uring.h"
+#endif
+
 #define LOG_GROUP    NFC_LOG_GROUP_COM
 #define LOG_CATEGORY "libnfc.bus.uart"
 
@@ -99,6 +103,9 @@ struct serial_port_unix {
   int 			fd; 			// Serial port file descriptor
   struct termios 	termios_backup; 	// Terminal info before using the port
   struct termios 	termios_new; 		// Terminal info during the transaction
+#ifdef UART_IO_URING
+  struct uart_uring	*uring;			// io_uring backend, NULL when unavailable
+#endif
 };
 
 #define UART_DATA( X ) ((struct serial_port_unix *) X)
@@ -112,6 +119,9 @@ uart_open(const char *pcPortName)
 
   if (sp == 0)
     return INVALID_SERIAL_PORT;
+#ifdef UART_IO_URING
+  sp->uring = NULL;
+#endif
 
   sp->fd = open(pcPortName, O_RDWR | O_NOCTTY | O_NONBLOCK);
   if (sp->fd == -1) {
@@ -138,11 +148,19 @@ uart_open(const char *pcPortName)
 
   sp->termios_new.c_cc[VMIN] = 0;     // block until n bytes are received
   sp->termios_new.c_cc[VTIME] = 0;    // block until a timer expires (n * 100 mSec.)
+#ifdef UART_IO_URING
+  // A read finding no byte must fail with EAGAIN (the port is non-blocking), not return 0, for io_uring to wait
+  sp->termios_new.c_cc[VMIN] = 1;
+#endif
 
   if (tcsetattr(sp->fd, TCSANOW, &sp->termios_new) == -1) {
     uart_close_ext(sp, true);
     return INVALID_SERIAL_PORT;
   }
+#ifdef UART_IO_URING
+  // Falls back to select() and read() when the kernel does not allow it
+  sp->uring = uart_uring_new(sp->fd);
+#endif
   return sp;
 }
 
@@ -159,6 +177,13 @@ uart_flush_input(serial_port sp, bool wait)
 
   // This line seems to produce absolutely no effect on my system (GNU/Linux 2.6.35)
   tcflush(UART_DATA(sp)->fd, TCIFLUSH);
+#ifdef UART_IO_URING
+  if (UART_DATA(sp)->uring) {
+    // The armed read already took what the kernel had
+    uart_uring_flush_input(UART_DATA(sp)->uring);
+    return;
+  }
+#endif
   // So, I wrote this byte-eater
   // Retrieve the count of the incoming bytes
   int available_bytes_count = 0;
@@ -279,6 +304,10 @@ uart_get_speed(serial_port sp)
 void
 uart_close_ext(const serial_port sp, const bool restore_termios)
 {
+#ifdef UART_IO_URING
+  if (UART_DATA(sp)->uring)
+    uart_uring_free(UART_DATA(sp)->uring);
+#endif
   if (UART_DATA(sp)->fd >= 0) {
     if (restore_termios)
       tcsetattr(UART_DATA(sp)->fd, TCSANOW, &UART_DATA(sp)->termios_backup);
@@ -296,6 +325,9 @@ uart_close(const serial_port sp)
 /**
  * @brief Receive data from UART and copy data to \a pbtRx
  *
+ * \a timeout (in ms, 0 for none) bounds the whole reception; a negative
+ * value means the caller's deadline has already passed.
+ *
  * @return 0 on success, otherwise driver error code
  */
 int
@@ -307,6 +339,18 @@ uart_receive(serial_port sp, uint8_t *pbtRx, const size_t szRx, void *abort_p, i
   const int expected_bytes_count = (int)szRx;
   int res;
   fd_set rfds;
+
+  if (timeout < 0) {
+    // Caller's deadline has already passed
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "%s", "Timeout!");
+    return NFC_ETIMEOUT;
+  }
+#ifdef UART_IO_URING
+  if (UART_DATA(sp)->uring)
+    return uart_uring_receive(UART_DATA(sp)->uring, pbtRx, szRx, iAbortFd, timeout);
+#endif
+  // The whole frame has to arrive within timeout, not each of its chunks
+  const nfc_deadline deadline = nfc_deadline_from_timeout(timeout);
   do {
 select:
     // Reset file descriptor
@@ -319,8 +363,13 @@ select:
 
     struct timeval timeout_tv;
     if (timeout > 0) {
-      timeout_tv.tv_sec = (timeout / 1000);
-      timeout_tv.tv_usec = ((timeout % 1000) * 1000);
+      const int remaining = nfc_deadline_remaining(deadline);
+      if (remaining < 0) {
+        log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "%s", "Timeout!");
+        return NFC_ETIMEOUT;
+      }
+      timeout_tv.tv_sec = (remaining / 1000);
+      timeout_tv.tv_usec = ((remaining % 1000) * 1000);
     }
 
     res = select(MAX(UART_DATA(sp)->fd, iAbortFd) + 1, &rfds, NULL, NULL, timeout ? &timeout_tv : NULL);
@@ -367,6 +416,47 @@ select:
   return NFC_SUCCESS;
 }
 
+/**
+ * @brief Get the file descriptor of the port, for an event loop to watch it
+ *
+ * The port is read with uart_receive_available() from then on: it is not
+ * driven by io_uring anymore, whose read would take the bytes before the
+ * event loop sees them.
+ *
+ * @return file descriptor, otherwise driver error code
+ */
+int
+uart_get_fd(serial_port sp)
+{
+#ifdef UART_IO_URING
+  if (UART_DATA(sp)->uring) {
+    uart_uring_free(UART_DATA(sp)->uring);
+    UART_DATA(sp)->uring = NULL;
+  }
+#endif
+  return UART_DATA(sp)->fd;
+}
+
+/**
+ * @brief Receive the bytes already there, without waiting
+ *
+ * @return count of bytes copied to \a pbtRx (0 when none), otherwise driver error code
+ */
+int
+uart_receive_available(serial_port sp, uint8_t *pbtRx, const size_t szRx)
+{
+  ssize_t res;
+
+  do {
+    res = read(UART_DATA(sp)->fd, pbtRx, szRx);
+  } while ((res < 0) && (errno == EINTR));
+  if (res < 0)
+    return ((errno == EAGAIN) || (errno == EWOULDBLOCK)) ? 0 : NFC_EIO;
+  if (res > 0)
+    LOG_HEX(LOG_GROUP, "RX", pbtRx, (size_t) res);
+  return (int) res;
+}
+
 /**
  * @brief Send \a pbtTx content to UART
  *
@@ -375,8 +465,12 @@ select:
 int
 uart_send(serial_port sp, const uint8_t *pbtTx, const size_t szTx, int timeout)
 {
-  (void) timeout;
   LOG_HEX(LOG_GROUP, "TX", pbtTx, szTx);
+#ifdef UART_IO_URING
+  if (UART_DATA(sp)->uring)
+    return uart_uring_send(UART_DATA(sp)->uring, pbtTx, szTx, timeout);
+#endif
+  (void) timeout;
   if ((int) szTx == write(UART_DATA(sp)->fd, pbtTx, szTx))
     return NFC_SUCCESS;
   else
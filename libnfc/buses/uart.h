@@ -59,6 +59,9 @@ uint32_t uart_get_speed(const serial_port sp);
 int     uart_receive(serial_port sp, uint8_t *pbtRx, const size_t szRx, void *abort_p, int timeout);
 int     uart_send(serial_port sp, const uint8_t *pbtTx, const size_t szTx, int timeout);
 
+int     uart_get_fd(serial_port sp);
+int     uart_receive_available(serial_port sp, uint8_t *pbtRx, const size_t szRx);
+
 char  **uart_list_ports(void);
 
 #endif // __NFC_BUS_UART_H__
@@ -41,39 +41,45 @@
 #define LOG_CATEGORY "libnfc.buses.usbbus"
 #define LOG_GROUP    NFC_LOG_GROUP_DRIVER
 
-int usb_prepare(void)
+int usb_prepare(const nfc_context *context)
 {
+  // libusb 0.1 keeps the bus list in globals: refresh it one thread at a time
+  static nfc_mutex usb_mutex = NFC_MUTEX_INITIALIZER;
   static bool usb_initialized = false;
+  int res = 0;
+
+  nfc_mutex_lock(&usb_mutex);
   if (!usb_initialized) {
 
 #ifdef ENVVARS
-    char *env_log_level = getenv("LIBNFC_LOG_LEVEL");
     // Set libusb debug only if asked explicitely:
     // LIBUSB_LOG_LEVEL=12288 (= NFC_LOG_PRIORITY_DEBUG * 2 ^ NFC_LOG_GROUP_LIBUSB)
-    if (env_log_level && (((atoi(env_log_level) >> (NFC_LOG_GROUP_LIBUSB * 2)) & 0x00000003) >= NFC_LOG_PRIORITY_DEBUG)) {
+    if (((context->log_level >> (NFC_LOG_GROUP_LIBUSB * 2)) & 0x00000003) >= NFC_LOG_PRIORITY_DEBUG) {
       setenv("USB_DEBUG", "255", 1);
     }
+#else
+    (void)context;
 #endif
 
     usb_init();
     usb_initialized = true;
   }
 
-  int res;
   // usb_find_busses will find all of the busses on the system. Returns the
   // number of changes since previous call to this function (total of new
   // busses and busses removed).
-  if ((res = usb_find_busses()) < 0) {
-    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "Unable to find USB busses (%s)", _usb_strerror(res));
-    return -1;
-  }
   // usb_find_devices will find all of the devices on each bus. This should be
   // called after usb_find_busses. Returns the number of changes since the
   // previous call to this function (total of new device and devices removed).
-  if ((res = usb_find_devices()) < 0) {
+  if ((res = usb_find_busses()) < 0) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "Unable to find USB busses (%s)", _usb_strerror(res));
+    res = -1;
+  } else if ((res = usb_find_devices()) < 0) {
     log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "Unable to find USB devices (%s)", _usb_strerror(res));
-    return -1;
+    res = -1;
+  } else {
+    res = 0;
   }
-  return 0;
+  nfc_mutex_unlock(&usb_mutex);
+  return res;
 }
-
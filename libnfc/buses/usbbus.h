@@ -49,6 +49,8 @@
 #include <stdbool.h>
 #include <string.h>
 
-int usb_prepare(void);
+#include <nfc/nfc-types.h>
+
+int usb_prepare(const nfc_context *context);
 
 #endif // __NFC_BUS_USB_H__
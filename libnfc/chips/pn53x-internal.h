@@ -124,6 +124,10 @@
 #  define PN53x_EXTENDED_FRAME__DATA_MAX_LEN            264
 #  define PN53x_EXTENDED_FRAME__OVERHEAD                11
 #  define PN53x_ACK_FRAME__LEN                          6
+// Most data carried by one TgSetData or TgSetMetaData command
+#  define PN53x_TG_DATA__MAX_LEN                        262
+// Most data carried by one InDataExchange command
+#  define PN53x_IN_DATA__MAX_LEN                        262
 
 typedef struct {
   uint8_t ui8Code;
@@ -0,0 +1,594 @@
+/*-
+ * Free/Libre Near Field Communication (NFC) library
+ *
+ * Libnfc historical contributors:
+ * Copyright (C) 2009      Roel Verdult
+ * Copyright (C) 2009-2013 Romuald Conty
+ * Copyright (C) 2010-2012 Romain Tartière
+ * Copyright (C) 2010-2013 Philippe Teuwen
+ * Copyright (C) 2012-2013 Ludovic Rousseau
+ * See AUTHORS file for a more comprehensive list of contributors.
+ * Additional contributors of this file:
+ * Copyright (C) 2020      Adam Laurie
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+/**
+ * @file pn53x-picc.c
+ * @brief ISO/IEC 14443-4 PICC emulated by the host for PN531 and PN533
+ *
+ * Unlike the PN532, these chips leave the ISO/IEC 14443-4 layer of a target
+ * to the host: they hand over every frame received from the PCD through
+ * TgGetInitiatorCommand and send back whatever TgResponseToInitiator gets.
+ * This file answers RATS with the ATS of the emulated target and runs the
+ * block protocol (I-, R- and S-blocks, chaining on both ways, DESELECT)
+ * underneath pn53x_target_receive_bytes() and pn53x_target_send_bytes().
+ *
+ * While the application prepares its answer, a watchdog thread sends
+ * S(WTX) requests before the frame waiting time announced in the ATS runs
+ * out, so slow answers do not make the PCD give up. All buffers are part of
+ * the PICC state, allocated once per device.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifndef _WIN32
+#  include <pthread.h>
+#endif
+
+#include "nfc/nfc.h"
+#include "nfc-internal.h"
+#include "pn53x.h"
+#include "pn53x-internal.h"
+
+#define LOG_CATEGORY "libnfc.chip.pn53x"
+#define LOG_GROUP    NFC_LOG_GROUP_CHIP
+
+// ISO/IEC 14443-4 block coding
+#define PCB_IS_I_BLOCK(pcb)      (((pcb) & 0xe2) == 0x02)
+#define PCB_IS_R_BLOCK(pcb)      (((pcb) & 0xe6) == 0xa2)
+#define PCB_IS_S_DESELECT(pcb)   (((pcb) & 0xf7) == 0xc2)
+#define PCB_IS_S_WTX(pcb)        (((pcb) & 0xf7) == 0xf2)
+#define PCB_BLOCK_NUMBER      0x01
+#define PCB_NAD               0x04
+#define PCB_CID               0x08
+#define PCB_CHAINING          0x10
+#define PCB_R_NAK             0x10
+#define PCB_I                 0x02
+#define PCB_R_ACK             0xa2
+#define PCB_S_DESELECT        0xc2
+#define PCB_S_WTX             0xf2
+
+#define RATS                  0xe0
+
+// Frame waiting time defaults to FWI 4 when the ATS has no TB(1)
+#define PICC_DEFAULT_FWI      4
+// Longest waiting time asked for at once through S(WTX), in ms
+#define PICC_WTX_TARGET_MS    200
+#define PICC_WTXM_MAX         59
+// How long the PCD may take to answer an S(WTX) request
+#define PICC_WTX_RESPONSE_TIMEOUT 100
+
+static const size_t aszFsd[] = { 16, 24, 32, 40, 48, 64, 96, 128, 256 };
+
+struct pn53x_picc {
+  struct nfc_device *pnd;
+  /** RATS was answered, frames are ISO/IEC 14443-4 blocks */
+  bool bActive;
+  /** Current block number */
+  uint8_t btBlockNumber;
+  /** Whether the PCD addresses us with a CID, and which one */
+  bool bCid;
+  uint8_t btCid;
+  /** Largest frame the PCD accepts, CRC included */
+  size_t szFsd;
+  /** Frame waiting time, in ms */
+  int iFwt;
+  /** ATS, TL included */
+  uint8_t abtAts[1 + sizeof(((nfc_iso14443a_info *)0)->abtAts)];
+  size_t szAts;
+  /** Last answer of TgGetInitiatorCommand, status byte first */
+  uint8_t abtFrame[PN53x_EXTENDED_FRAME__DATA_MAX_LEN];
+  /** Last block sent, TgResponseToInitiator first, kept for retransmissions */
+  uint8_t abtBlock[PN53x_EXTENDED_FRAME__DATA_MAX_LEN];
+  size_t szBlock;
+#ifndef _WIN32
+  /** WTX watchdog */
+  pthread_t thread;
+  bool bThread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  clockid_t clock;
+  bool bArmed;
+  bool bQuit;
+  struct timespec tsDeadline;
+  int iWtxError;
+#endif
+};
+
+#define PICC(pnd) (CHIP_DATA(pnd)->picc)
+
+static int
+picc_get_frame(struct nfc_device *pnd, int timeout)
+{
+  const uint8_t abtCmd[] = { TgGetInitiatorCommand };
+  int res;
+  if ((res = pn53x_transceive(pnd, abtCmd, sizeof(abtCmd), PICC(pnd)->abtFrame, sizeof(PICC(pnd)->abtFrame), timeout)) < 0)
+    return res;
+  if (res < 1)
+    return pnd->last_error = NFC_EIO;
+  // Skip the status byte
+  return res - 1;
+}
+
+// Length of the block header (PCB, CID, NAD), 0 if the frame is too short
+static size_t
+picc_parse_header(struct pn53x_picc *picc, const uint8_t *pbtFrame, const size_t szFrame)
+{
+  const uint8_t pcb = pbtFrame[0];
+  size_t szHeader = 1;
+  if (pcb & PCB_CID) {
+    if (szFrame < 2)
+      return 0;
+    picc->bCid = true;
+    picc->btCid = pbtFrame[1] & 0x0f;
+    szHeader++;
+  } else {
+    picc->bCid = false;
+  }
+  if (PCB_IS_I_BLOCK(pcb) && (pcb & PCB_NAD))
+    szHeader++;
+  return (szFrame >= szHeader) ? szHeader : 0;
+}
+
+static int
+picc_send_block(struct nfc_device *pnd, const uint8_t pcb, const uint8_t *pbtInf, const size_t szInf, int timeout)
+{
+  struct pn53x_picc *picc = PICC(pnd);
+  size_t n = 0;
+  picc->abtBlock[n++] = TgResponseToInitiator;
+  picc->abtBlock[n++] = pcb | (picc->bCid ? PCB_CID : 0);
+  if (picc->bCid)
+    picc->abtBlock[n++] = picc->btCid;
+  if (szInf)
+    memcpy(picc->abtBlock + n, pbtInf, szInf);
+  picc->szBlock = n + szInf;
+  return pn53x_transceive(pnd, picc->abtBlock, picc->szBlock, NULL, 0, timeout);
+}
+
+static int
+picc_resend_block(struct nfc_device *pnd, int timeout)
+{
+  struct pn53x_picc *picc = PICC(pnd);
+  if (picc->szBlock == 0)
+    return NFC_SUCCESS;
+  return pn53x_transceive(pnd, picc->abtBlock, picc->szBlock, NULL, 0, timeout);
+}
+
+static int
+picc_deselect(struct nfc_device *pnd, int timeout)
+{
+  int res;
+  PICC(pnd)->bActive = false;
+  if ((res = picc_send_block(pnd, PCB_S_DESELECT, NULL, 0, timeout)) < 0)
+    return res;
+  log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "%s", "ISO14443-4 PICC deselected");
+  return pnd->last_error = NFC_ETGRELEASED;
+}
+
+static int
+picc_answer_rats(struct nfc_device *pnd, const uint8_t *pbtRats, const size_t szRats, int timeout)
+{
+  struct pn53x_picc *picc = PICC(pnd);
+  uint8_t abtCmd[1 + sizeof(picc->abtAts)];
+  if (szRats < 2)
+    return pnd->last_error = NFC_EIO;
+  picc->szFsd = aszFsd[MIN(pbtRats[1] >> 4, 8)];
+  picc->btCid = pbtRats[1] & 0x0f;
+  picc->bCid = false;
+  // PICC block number starts at 1, the first I-block of the PCD uses 0
+  picc->btBlockNumber = 1;
+  picc->szBlock = 0;
+  abtCmd[0] = TgResponseToInitiator;
+  memcpy(abtCmd + 1, picc->abtAts, picc->szAts);
+  int res;
+  if ((res = pn53x_transceive(pnd, abtCmd, 1 + picc->szAts, NULL, 0, timeout)) < 0)
+    return res;
+  picc->bActive = true;
+  log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "ISO14443-4 PICC activated (FSD %d, FWT %d ms)", (int) picc->szFsd, picc->iFwt);
+  return NFC_SUCCESS;
+}
+
+#ifndef _WIN32
+static void
+picc_timespec_in(struct pn53x_picc *picc, struct timespec *pts, const int ms)
+{
+  clock_gettime(picc->clock, pts);
+  pts->tv_sec += ms / 1000;
+  pts->tv_nsec += (long)(ms % 1000) * 1000000L;
+  if (pts->tv_nsec >= 1000000000L) {
+    pts->tv_sec++;
+    pts->tv_nsec -= 1000000000L;
+  }
+}
+
+// Ask for more time and wait for the PCD to grant it; called with the device locked
+static int
+picc_wtx(struct nfc_device *pnd, int *piGranted)
+{
+  struct pn53x_picc *picc = PICC(pnd);
+  uint8_t abtCmd[4];
+  size_t n = 0;
+  int wtxm = (PICC_WTX_TARGET_MS + picc->iFwt - 1) / picc->iFwt;
+  int res;
+
+  wtxm = MAX(1, MIN(wtxm, PICC_WTXM_MAX));
+  abtCmd[n++] = TgResponseToInitiator;
+  abtCmd[n++] = PCB_S_WTX | (picc->bCid ? PCB_CID : 0);
+  if (picc->bCid)
+    abtCmd[n++] = picc->btCid;
+  abtCmd[n++] = wtxm;
+  if ((res = pn53x_transceive(pnd, abtCmd, n, NULL, 0, PICC_WTX_RESPONSE_TIMEOUT)) < 0)
+    return res;
+  if ((res = picc_get_frame(pnd, PICC_WTX_RESPONSE_TIMEOUT)) < 0)
+    return res;
+  const uint8_t *pbtFrame = picc->abtFrame + 1;
+  if ((res == 0) || !picc_parse_header(picc, pbtFrame, res))
+    return pnd->last_error = NFC_EIO;
+  if (PCB_IS_S_DESELECT(pbtFrame[0]))
+    return picc_deselect(pnd, PICC_WTX_RESPONSE_TIMEOUT);
+  if (!PCB_IS_S_WTX(pbtFrame[0]))
+    return pnd->last_error = NFC_EIO;
+  *piGranted = picc->iFwt * wtxm;
+  return NFC_SUCCESS;
+}
+
+static void *
+picc_watchdog(void *arg)
+{
+  struct pn53x_picc *picc = arg;
+  pthread_mutex_lock(&picc->mutex);
+  while (!picc->bQuit) {
+    if (!picc->bArmed) {
+      pthread_cond_wait(&picc->cond, &picc->mutex);
+      continue;
+    }
+    if (pthread_cond_timedwait(&picc->cond, &picc->mutex, &picc->tsDeadline) != ETIMEDOUT)
+      continue;
+    if (!picc->bArmed || picc->bQuit)
+      continue;
+    // The device lock comes first: drop ours to respect the lock order
+    pthread_mutex_unlock(&picc->mutex);
+    nfc_device_lock(picc->pnd);
+    pthread_mutex_lock(&picc->mutex);
+    if (picc->bArmed && !picc->bQuit) {
+      int iGranted = 0;
+      pthread_mutex_unlock(&picc->mutex);
+      int res = picc_wtx(picc->pnd, &iGranted);
+      pthread_mutex_lock(&picc->mutex);
+      if (res < 0) {
+        log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "S(WTX) failed (%d)", res);
+        picc->iWtxError = res;
+        picc->bArmed = false;
+      } else {
+        // Next request halfway through the extended waiting time
+        picc_timespec_in(picc, &picc->tsDeadline, iGranted / 2);
+      }
+    }
+    nfc_device_unlock(picc->pnd);
+  }
+  pthread_mutex_unlock(&picc->mutex);
+  return NULL;
+}
+#endif
+
+// Start counting the frame waiting time of the command just handed over
+static void
+picc_arm_wtx(struct pn53x_picc *picc)
+{
+#ifndef _WIN32
+  if (!picc->bThread)
+    return;
+  pthread_mutex_lock(&picc->mutex);
+  picc->bArmed = true;
+  picc->iWtxError = 0;
+  // Host and USB latencies eat part of the budget: ask halfway
+  picc_timespec_in(picc, &picc->tsDeadline, picc->iFwt / 2);
+  pthread_cond_signal(&picc->cond);
+  pthread_mutex_unlock(&picc->mutex);
+#else
+  (void) picc;
+#endif
+}
+
+// Stop it, returns the error met by the watchdog, if any
+static int
+picc_disarm_wtx(struct pn53x_picc *picc)
+{
+  int res = 0;
+#ifndef _WIN32
+  if (!picc->bThread)
+    return 0;
+  pthread_mutex_lock(&picc->mutex);
+  picc->bArmed = false;
+  res = picc->iWtxError;
+  picc->iWtxError = 0;
+  pthread_mutex_unlock(&picc->mutex);
+#else
+  (void) picc;
+#endif
+  return res;
+}
+
+static struct pn53x_picc *
+picc_new(struct nfc_device *pnd)
+{
+  struct pn53x_picc *picc = calloc(1, sizeof(struct pn53x_picc));
+  if (!picc)
+    return NULL;
+  picc->pnd = pnd;
+#ifndef _WIN32
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  picc->clock = CLOCK_REALTIME;
+#  if !defined(__APPLE__)
+  if (pthread_condattr_setclock(&attr, CLOCK_MONOTONIC) == 0)
+    picc->clock = CLOCK_MONOTONIC;
+#  endif
+  pthread_mutex_init(&picc->mutex, NULL);
+  pthread_cond_init(&picc->cond, &attr);
+  pthread_condattr_destroy(&attr);
+  if (pthread_create(&picc->thread, NULL, picc_watchdog, picc) == 0) {
+    picc->bThread = true;
+  } else {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Unable to start the WTX watchdog, S(WTX) will not be sent");
+  }
+#endif
+  return picc;
+}
+
+/** @internal
+ * @brief Set up the PICC of a target just activated by TgInitAsTarget
+ * @return the number of bytes left for the application in \a pbtRx: 0 when
+ * the first frame was a RATS, answered here, \a szRx otherwise
+ */
+int
+pn53x_picc_start(struct nfc_device *pnd, const nfc_target *pnt, const uint8_t *pbtRx, const size_t szRx, int timeout)
+{
+  if (!PICC(pnd) && !(PICC(pnd) = picc_new(pnd)))
+    return pnd->last_error = NFC_ESOFT;
+  struct pn53x_picc *picc = PICC(pnd);
+  picc_disarm_wtx(picc);
+  picc->bActive = false;
+  picc->szBlock = 0;
+
+  // ATS: TL then what the application gave, or a default one
+  const nfc_iso14443a_info *pnai = &pnt->nti.nai;
+  if (pnai->szAtsLen) {
+    picc->szAts = 1 + pnai->szAtsLen;
+    memcpy(picc->abtAts + 1, pnai->abtAts, pnai->szAtsLen);
+  } else {
+    // T0: FSCI 8 (256 bytes), TA(1) 106 kbps only, TB(1) FWI 7 SFGI 0, TC(1) no CID nor NAD
+    const uint8_t abtDefaultAts[] = { 0x78, 0x80, 0x70, 0x00 };
+    picc->szAts = 1 + sizeof(abtDefaultAts);
+    memcpy(picc->abtAts + 1, abtDefaultAts, sizeof(abtDefaultAts));
+  }
+  picc->abtAts[0] = picc->szAts;
+
+  // FWT = 256 * 16 / fc * 2^FWI, i.e. about 302 us * 2^FWI
+  int fwi = PICC_DEFAULT_FWI;
+  if ((picc->szAts > 1) && (picc->abtAts[1] & 0x20)) {
+    size_t tb = (picc->abtAts[1] & 0x10) ? 3 : 2;
+    if (tb < picc->szAts)
+      fwi = MIN(picc->abtAts[tb] >> 4, 14);
+  }
+  picc->iFwt = MAX(1, (302 << fwi) / 1000);
+
+  if ((szRx == 2) && (pbtRx[0] == RATS)) {
+    int res;
+    if ((res = picc_answer_rats(pnd, pbtRx, szRx, timeout)) < 0)
+      return res;
+    return 0;
+  }
+  return szRx;
+}
+
+/** @internal
+ * @brief Leave the emulated ISO/IEC 14443-4 session, if any
+ */
+void
+pn53x_picc_stop(struct nfc_device *pnd)
+{
+  if (PICC(pnd)) {
+    picc_disarm_wtx(PICC(pnd));
+    PICC(pnd)->bActive = false;
+  }
+}
+
+/** @internal
+ * @brief Release the PICC state, stopping its watchdog
+ */
+void
+pn53x_picc_free(struct nfc_device *pnd)
+{
+  struct pn53x_picc *picc = PICC(pnd);
+  if (!picc)
+    return;
+#ifndef _WIN32
+  if (picc->bThread) {
+    pthread_mutex_lock(&picc->mutex);
+    picc->bQuit = true;
+    pthread_cond_signal(&picc->cond);
+    pthread_mutex_unlock(&picc->mutex);
+    pthread_join(picc->thread, NULL);
+  }
+  pthread_cond_destroy(&picc->cond);
+  pthread_mutex_destroy(&picc->mutex);
+#endif
+  free(picc);
+  PICC(pnd) = NULL;
+}
+
+/** @internal
+ * @brief Receive the next command of the PCD, reassembling chained I-blocks
+ * @return the command length, NFC_ETGRELEASED once the PCD deselected us
+ */
+int
+pn53x_picc_receive_bytes(struct nfc_device *pnd, uint8_t *pbtRx, const size_t szRxLen, int timeout)
+{
+  struct pn53x_picc *picc = PICC(pnd);
+  const nfc_deadline deadline = nfc_deadline_from_timeout(timeout);
+  size_t szApdu = 0;
+  int res;
+
+  if (!picc)
+    return pnd->last_error = NFC_ESOFT;
+  picc_disarm_wtx(picc);
+  for (;;) {
+    int iTimeout = timeout;
+    if (deadline && ((iTimeout = nfc_deadline_remaining(deadline)) < 0))
+      return pnd->last_error = NFC_ETIMEOUT;
+    if ((res = picc_get_frame(pnd, iTimeout)) < 0)
+      return res;
+    const uint8_t *pbtFrame = picc->abtFrame + 1;
+    const size_t szFrame = res;
+    if (szFrame == 0)
+      continue;
+
+    if ((szFrame == 2) && (pbtFrame[0] == RATS)) {
+      // (Re)activation by the PCD
+      if ((res = picc_answer_rats(pnd, pbtFrame, szFrame, timeout)) < 0)
+        return res;
+      szApdu = 0;
+      continue;
+    }
+    if (!picc->bActive) {
+      // No RATS yet: ISO/IEC 14443-3 frames go as they are
+      if (szFrame > szRxLen)
+        return pnd->last_error = NFC_EOVFLOW;
+      memcpy(pbtRx, pbtFrame, szFrame);
+      return szFrame;
+    }
+
+    const uint8_t pcb = pbtFrame[0];
+    const size_t szHeader = picc_parse_header(picc, pbtFrame, szFrame);
+    if (szHeader == 0)
+      continue;
+    if (PCB_IS_I_BLOCK(pcb)) {
+      const size_t szInf = szFrame - szHeader;
+      if (szApdu + szInf > szRxLen)
+        return pnd->last_error = NFC_EOVFLOW;
+      memcpy(pbtRx + szApdu, pbtFrame + szHeader, szInf);
+      szApdu += szInf;
+      picc->btBlockNumber = pcb & PCB_BLOCK_NUMBER;
+      if (pcb & PCB_CHAINING) {
+        if ((res = picc_send_block(pnd, PCB_R_ACK | picc->btBlockNumber, NULL, 0, timeout)) < 0)
+          return res;
+        continue;
+      }
+      picc_arm_wtx(picc);
+      return szApdu;
+    } else if (PCB_IS_R_BLOCK(pcb)) {
+      res = NFC_SUCCESS;
+      if ((pcb & PCB_BLOCK_NUMBER) == picc->btBlockNumber) {
+        // The PCD missed our last block
+        res = picc_resend_block(pnd, timeout);
+      } else if (pcb & PCB_R_NAK) {
+        res = picc_send_block(pnd, PCB_R_ACK | picc->btBlockNumber, NULL, 0, timeout);
+      }
+      if (res < 0)
+        return res;
+    } else if (PCB_IS_S_DESELECT(pcb)) {
+      return picc_deselect(pnd, timeout);
+    }
+    // Anything else (e.g. a late S(WTX) response) is ignored
+  }
+}
+
+/** @internal
+ * @brief Send the answer to the last command, chaining I-blocks if it does not fit in one
+ * @return \a szTx, NFC_ETGRELEASED if the PCD deselected us meanwhile
+ *
+ * When \a bMore is set, the last block is chained too and the answer goes on
+ * with the next call.
+ */
+int
+pn53x_picc_send_bytes(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, const bool bMore, int timeout)
+{
+  struct pn53x_picc *picc = PICC(pnd);
+  int res;
+
+  if (!picc)
+    return pnd->last_error = NFC_ESOFT;
+  if ((res = picc_disarm_wtx(picc)) < 0)
+    return pnd->last_error = res;
+  if (!picc->bActive) {
+    if (bMore)
+      return pnd->last_error = NFC_EDEVNOTSUPP;
+    picc->abtBlock[0] = TgResponseToInitiator;
+    if (szTx > sizeof(picc->abtBlock) - 1)
+      return pnd->last_error = NFC_EOVFLOW;
+    memcpy(picc->abtBlock + 1, pbtTx, szTx);
+    picc->szBlock = 1 + szTx;
+    if ((res = pn53x_transceive(pnd, picc->abtBlock, picc->szBlock, NULL, 0, timeout)) < 0)
+      return res;
+    return szTx;
+  }
+
+  // INF room per block: FSD less PCB, CID and CRC
+  const size_t szInfMax = MIN(picc->szFsd, sizeof(picc->abtBlock) - 1) - 3 - (picc->bCid ? 1 : 0);
+  size_t szSent = 0;
+  for (;;) {
+    const size_t szInf = MIN(szTx - szSent, szInfMax);
+    const bool bChaining = bMore || ((szSent + szInf) < szTx);
+    if ((res = picc_send_block(pnd, PCB_I | (bChaining ? PCB_CHAINING : 0) | picc->btBlockNumber, pbtTx + szSent, szInf, timeout)) < 0)
+      return res;
+    szSent += szInf;
+    if (!bChaining)
+      return szTx;
+
+    // Wait for the PCD to acknowledge the block
+    for (;;) {
+      if ((res = picc_get_frame(pnd, timeout)) < 0)
+        return res;
+      const uint8_t *pbtFrame = picc->abtFrame + 1;
+      if ((res == 0) || !picc_parse_header(picc, pbtFrame, res))
+        continue;
+      const uint8_t pcb = pbtFrame[0];
+      if (PCB_IS_R_BLOCK(pcb) && !(pcb & PCB_R_NAK) && ((pcb & PCB_BLOCK_NUMBER) != picc->btBlockNumber)) {
+        picc->btBlockNumber ^= PCB_BLOCK_NUMBER;
+        if (szSent == szTx) {
+          // The rest of the answer is still being prepared
+          picc_arm_wtx(picc);
+          return szTx;
+        }
+        break;
+      } else if (PCB_IS_R_BLOCK(pcb)) {
+        if ((res = picc_resend_block(pnd, timeout)) < 0)
+          return res;
+      } else if (PCB_IS_S_DESELECT(pcb)) {
+        return picc_deselect(pnd, timeout);
+      } else {
+        return pnd->last_error = NFC_EIO;
+      }
+    }
+  }
+}
@@ -39,6 +39,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "nfc/nfc.h"
 #include "nfc-internal.h"
@@ -63,6 +64,11 @@ const nfc_baud_rate pn532_iso14443b_supported_baud_rates[] = { NBR_106, 0 };
 const nfc_baud_rate pn533_iso14443b_supported_baud_rates[] = { NBR_847, NBR_424, NBR_212, NBR_106, 0 };
 const nfc_modulation_type pn53x_supported_modulation_as_target[] = {NMT_ISO14443A, NMT_FELICA, NMT_DEP, 0};
 
+/* Default timeouts (ms) of a freshly opened device */
+#define PN53X_DEFAULT_TIMEOUT_COMMAND 350
+#define PN53X_DEFAULT_TIMEOUT_ATR 103
+#define PN53X_DEFAULT_TIMEOUT_COMMUNICATION 52
+
 /* prototypes */
 int pn53x_reset_settings(struct nfc_device *pnd);
 int pn53x_collision_settings(struct nfc_device *pnd);
@@ -76,16 +82,39 @@ void *pn53x_current_target_new(const struct nfc_device *pnd, const nfc_target *p
 void pn53x_current_target_free(const struct nfc_device *pnd);
 bool pn53x_current_target_is(const struct nfc_device *pnd, const nfc_target *pnt);
 
-/* implementations */
-int
-pn53x_init(struct nfc_device *pnd)
+static int pn53x_timing_restore(struct nfc_device *pnd);
+static int pn53x_read_collision(struct nfc_device *pnd);
+static int pn53x_firmware_version_decode(struct nfc_device *pnd, const uint8_t *abtFw, const size_t szFwLen);
+static uint8_t pn53x_int_to_timeout(const int ms);
+static int pn53x_InListPassiveTarget_frame(struct nfc_device *pnd, const pn53x_modulation pmInitModulation, const uint8_t szMaxTargets,
+                                           const uint8_t *pbtInitiatorData, const size_t szInitiatorData, uint8_t *abtCmd);
+static int pn53x_InAutoPoll_decode(struct nfc_device *pnd, const uint8_t *abtRx, const size_t szRx, nfc_target *pntTargets);
+
+/*
+ * Description of a device kept across openings (see nfc_device_cache_load()):
+ * its firmware version, which tells everything about the chip, its
+ * supported modulations, its parameters and the whole values of the
+ * registers set by pn53x_reset_settings(), so that pn53x_init_cached() only
+ * needs to check the firmware version.
+ */
+struct pn53x_device_cache {
+  uint8_t abtFirmwareVersion[4];
+  uint8_t ui8FirmwareVersionLen;
+  uint8_t ui8Parameters;
+  nfc_modulation_type anmtInitiator[NMT_END_ENUM + 1];
+  uint8_t abtKnownRegisters[PN53X_CACHE_REGISTER_SIZE];
+  uint8_t abtRegisters[PN53X_CACHE_REGISTER_SIZE];
+};
+
+static int
+pn53x_init_supported_modulations(struct nfc_device *pnd, const nfc_modulation_type *pnmtCached)
 {
-  int res = 0;
-  // GetFirmwareVersion command is used to set PN53x chips type (PN531, PN532 or PN533)
-  if ((res = pn53x_decode_firmware_version(pnd)) < 0) {
-    return res;
+  if (!CHIP_DATA(pnd)->supported_modulation_as_initiator && pnmtCached) {
+    CHIP_DATA(pnd)->supported_modulation_as_initiator = malloc(sizeof(nfc_modulation_type) * (NMT_END_ENUM + 1));
+    if (! CHIP_DATA(pnd)->supported_modulation_as_initiator)
+      return NFC_ESOFT;
+    memcpy(CHIP_DATA(pnd)->supported_modulation_as_initiator, pnmtCached, sizeof(nfc_modulation_type) * (NMT_END_ENUM + 1));
   }
-
   if (!CHIP_DATA(pnd)->supported_modulation_as_initiator) {
     CHIP_DATA(pnd)->supported_modulation_as_initiator = malloc(sizeof(nfc_modulation_type) * (NMT_END_ENUM + 1));
     if (! CHIP_DATA(pnd)->supported_modulation_as_initiator)
@@ -124,6 +153,27 @@ pn53x_init(struct nfc_device *pnd)
     CHIP_DATA(pnd)->supported_modulation_as_target = (nfc_modulation_type *) pn53x_supported_modulation_as_target;
   }
 
+  if (!CHIP_DATA(pnd)->supported_modulation_as_target) {
+    CHIP_DATA(pnd)->supported_modulation_as_target = (nfc_modulation_type *) pn53x_supported_modulation_as_target;
+  }
+  return NFC_SUCCESS;
+}
+
+/* implementations */
+int
+pn53x_init(struct nfc_device *pnd)
+{
+  int res = 0;
+
+  // GetFirmwareVersion command is used to set PN53x chips type (PN531, PN532 or PN533)
+  if ((res = pn53x_decode_firmware_version(pnd)) < 0) {
+    return res;
+  }
+
+  if ((res = pn53x_init_supported_modulations(pnd, NULL)) < 0) {
+    return res;
+  }
+
   // CRC handling should be enabled by default as declared in nfc_device_new
   // which is the case by default for pn53x, so nothing to do here
   // Parity handling should be enabled by default as declared in nfc_device_new
@@ -138,6 +188,74 @@ pn53x_init(struct nfc_device *pnd)
   if ((res = pn53x_reset_settings(pnd)) < 0) {
     return res;
   }
+
+  if ((pnd->context != NULL) && (pnd->context->device_cache_dir[0] != '\0')) {
+    struct pn53x_device_cache pdc;
+    // Flush the write-back now rather than on next command, it leaves the
+    // whole values of the written registers in wb_data
+    memset(&pdc, 0, sizeof(pdc));
+    for (size_t n = 0; n < PN53X_CACHE_REGISTER_SIZE; n++) {
+      pdc.abtKnownRegisters[n] = (CHIP_DATA(pnd)->wb_mask[n] != 0x00);
+    }
+    if ((res = pn53x_writeback_register(pnd)) < 0) {
+      return res;
+    }
+    memcpy(pdc.abtFirmwareVersion, CHIP_DATA(pnd)->abtFirmwareVersion, CHIP_DATA(pnd)->szFirmwareVersion);
+    pdc.ui8FirmwareVersionLen = (uint8_t)CHIP_DATA(pnd)->szFirmwareVersion;
+    pdc.ui8Parameters = CHIP_DATA(pnd)->ui8Parameters;
+    memcpy(pdc.anmtInitiator, CHIP_DATA(pnd)->supported_modulation_as_initiator, sizeof(pdc.anmtInitiator));
+    memcpy(pdc.abtRegisters, CHIP_DATA(pnd)->wb_data, sizeof(pdc.abtRegisters));
+    nfc_device_cache_store(pnd, &pdc, sizeof(pdc));
+  }
+  return NFC_SUCCESS;
+}
+
+/*
+ * Initialize the chip from its cached description, instead of pn53x_init()
+ * and of the probing done by the driver before it. The only round trip is
+ * GetFirmwareVersion, checking that the chip answers and is the one
+ * described: the parameters are sent along with the next change (see
+ * pn53x_set_parameters()) and the registers are written with the next
+ * command, without being read first.
+ * Returns NFC_SUCCESS, otherwise libnfc's error code when there is no
+ * usable description, then the regular initialization must be run.
+ */
+int
+pn53x_init_cached(struct nfc_device *pnd)
+{
+  const uint8_t abtCmd[] = { GetFirmwareVersion };
+  struct pn53x_device_cache pdc;
+  uint8_t abtFw[4];
+  int res;
+
+  if ((res = nfc_device_cache_load(pnd, &pdc, sizeof(pdc))) < 0)
+    return res;
+  if ((res = pn53x_transceive(pnd, abtCmd, sizeof(abtCmd), abtFw, sizeof(abtFw), -1)) < 0)
+    return res;
+  if (((size_t) res != pdc.ui8FirmwareVersionLen) || (0 != memcmp(pdc.abtFirmwareVersion, abtFw, pdc.ui8FirmwareVersionLen))) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "%s", "Cached description does not match the device anymore");
+    nfc_device_cache_invalidate(pnd);
+    return NFC_EIO;
+  }
+  if ((res = pn53x_firmware_version_decode(pnd, abtFw, (size_t) res)) < 0)
+    return res;
+  if ((res = pn53x_init_supported_modulations(pnd, pdc.anmtInitiator)) < 0)
+    return res;
+
+  // Whatever a former user left, the next change sends all the parameters
+  CHIP_DATA(pnd)->ui8Parameters = pdc.ui8Parameters;
+  CHIP_DATA(pnd)->parameters_stale = true;
+  if ((res = pn53x_reset_settings(pnd)) < 0)
+    return res;
+  // Complete the pending register writes with known-good values, so that
+  // the write-back does not need to read them first
+  for (size_t n = 0; n < PN53X_CACHE_REGISTER_SIZE; n++) {
+    if ((CHIP_DATA(pnd)->wb_mask[n]) && (pdc.abtKnownRegisters[n])) {
+      CHIP_DATA(pnd)->wb_data[n] = (CHIP_DATA(pnd)->wb_data[n] & CHIP_DATA(pnd)->wb_mask[n]) | (pdc.abtRegisters[n] & ~CHIP_DATA(pnd)->wb_mask[n]);
+      CHIP_DATA(pnd)->wb_mask[n] = 0xff;
+    }
+  }
+  log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "%s initialized from its cached description", CHIP_DATA(pnd)->firmware_text);
   return NFC_SUCCESS;
 }
 
@@ -165,6 +283,34 @@ pn53x_reset_settings(struct nfc_device *pnd)
   return NFC_SUCCESS;
 }
 
+int
+pn53x_reset(struct nfc_device *pnd)
+{
+  int res = 0;
+  // Forget whatever a former user of the device left behind
+  pn53x_current_target_free(pnd);
+  if (CHIP_DATA(pnd)->adaptive_timeout && ((res = pn53x_set_property_bool(pnd, NP_ADAPTIVE_TIMEOUT, false)) < 0))
+    return res;
+  // The chip is set back as by pn53x_init(), while the flags read as for a
+  // device fresh from nfc_device_new()
+  if ((res = pn53x_set_property_bool(pnd, NP_INFINITE_SELECT, false)) < 0)
+    return res;
+  if ((res = pn53x_set_parameters(pnd, PARAM_AUTO_ATR_RES | PARAM_AUTO_RATS, true)) < 0)
+    return res;
+  pnd->bAutoIso14443_4 = false;
+  pnd->bAutoPps = false;
+  CHIP_DATA(pnd)->operating_mode = IDLE;
+  CHIP_DATA(pnd)->timeout_command = PN53X_DEFAULT_TIMEOUT_COMMAND;
+  if ((CHIP_DATA(pnd)->timeout_atr != PN53X_DEFAULT_TIMEOUT_ATR) || (CHIP_DATA(pnd)->timeout_communication != PN53X_DEFAULT_TIMEOUT_COMMUNICATION)) {
+    CHIP_DATA(pnd)->timeout_atr = PN53X_DEFAULT_TIMEOUT_ATR;
+    CHIP_DATA(pnd)->timeout_communication = PN53X_DEFAULT_TIMEOUT_COMMUNICATION;
+    pnd->iTimeoutCom = CHIP_DATA(pnd)->timeout_communication;
+    if ((res = pn53x_RFConfiguration__Various_timings(pnd, pn53x_int_to_timeout(CHIP_DATA(pnd)->timeout_atr), pn53x_int_to_timeout(CHIP_DATA(pnd)->timeout_communication))) < 0)
+      return res;
+  }
+  return pn53x_reset_settings(pnd);
+}
+
 int
 pn53x_collision_settings(struct nfc_device *pnd)
 {
@@ -189,58 +335,14 @@ pn53x_collision_settings(struct nfc_device *pnd)
   return NFC_SUCCESS;
 }
 
-int
-pn53x_transceive(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, uint8_t *pbtRx, const size_t szRxLen, int timeout)
+/*
+ * Keep the status byte of the answer (pbtRx) to the command pbtTx, when this
+ * command has one, and tell whether the target chained its answer (MI).
+ */
+static bool
+pn53x_status_byte(struct nfc_device *pnd, const uint8_t *pbtTx, const uint8_t *pbtRx)
 {
   bool mi = false;
-  int res = 0;
-  if (CHIP_DATA(pnd)->wb_trigged) {
-    if ((res = pn53x_writeback_register(pnd)) < 0) {
-      return res;
-    }
-  }
-
-  PNCMD_TRACE(pbtTx[0]);
-  if (timeout > 0) {
-    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "Timeout value: %d", timeout);
-  } else if (timeout == 0) {
-    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "%s", "No timeout");
-  } else if (timeout == -1) {
-    timeout = CHIP_DATA(pnd)->timeout_command;
-  } else {
-    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "Invalid timeout value: %d", timeout);
-  }
-
-  uint8_t  abtRx[PN53x_EXTENDED_FRAME__DATA_MAX_LEN];
-  size_t  szRx = sizeof(abtRx);
-
-  // Check if receiving buffers are available, if not, replace them
-  if (szRxLen == 0 || !pbtRx) {
-    pbtRx = abtRx;
-  } else {
-    szRx = szRxLen;
-  }
-
-  // Call the send/receice callback functions of the current driver
-  if ((res = CHIP_DATA(pnd)->io->send(pnd, pbtTx, szTx, timeout)) < 0) {
-    return res;
-  }
-
-  // Command is sent, we store the command
-  CHIP_DATA(pnd)->last_command = pbtTx[0];
-
-  // Handle power mode for PN532
-  if ((CHIP_DATA(pnd)->type == PN532) && (TgInitAsTarget == pbtTx[0])) {  // PN532 automatically goes into PowerDown mode when TgInitAsTarget command will be sent
-    CHIP_DATA(pnd)->power_mode = POWERDOWN;
-  }
-
-  if ((res = CHIP_DATA(pnd)->io->receive(pnd, pbtRx, szRx, timeout)) < 0) {
-    return res;
-  }
-
-  if ((CHIP_DATA(pnd)->type == PN532) && (TgInitAsTarget == pbtTx[0])) { // PN532 automatically wakeup on external RF field
-    CHIP_DATA(pnd)->power_mode = NORMAL; // When TgInitAsTarget reply that means an external RF have waken up the chip
-  }
 
   switch (pbtTx[0]) {
     case PowerDown:
@@ -292,28 +394,17 @@ pn53x_transceive(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx
       CHIP_DATA(pnd)->last_status_byte = 0;
   }
 
-  while (mi) {
-    int res2;
-    uint8_t  abtRx2[PN53x_EXTENDED_FRAME__DATA_MAX_LEN];
-    // Send empty command to card
-    if ((res2 = CHIP_DATA(pnd)->io->send(pnd, pbtTx, 2, timeout)) < 0) {
-      return res2;
-    }
-    if ((res2 = CHIP_DATA(pnd)->io->receive(pnd, abtRx2, sizeof(abtRx2), timeout)) < 0) {
-      return res2;
-    }
-    mi = abtRx2[0] & 0x40;
-    if ((size_t)(res + res2 - 1) > szRx) {
-      CHIP_DATA(pnd)->last_status_byte = ESMALLBUF;
-      break;
-    }
-    memcpy(pbtRx + res, abtRx2 + 1, res2 - 1);
-    // Copy last status byte
-    pbtRx[0] = abtRx2[0];
-    res += res2 - 1;
-  }
+  return mi;
+}
 
-  szRx = (size_t) res;
+/*
+ * Map the last status byte to libnfc's errors: returns szRx when the command
+ * did succeed.
+ */
+static int
+pn53x_status_error(struct nfc_device *pnd, const size_t szRx)
+{
+  int res;
 
   switch (CHIP_DATA(pnd)->last_status_byte) {
     case 0:
@@ -363,14 +454,120 @@ pn53x_transceive(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx
       break;
   };
 
+  return res;
+}
+
+int
+pn53x_transceive(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, uint8_t *pbtRx, const size_t szRxLen, int timeout)
+{
+  bool mi = false;
+  int res = 0;
+  if (CHIP_DATA(pnd)->wb_trigged) {
+    if ((res = pn53x_writeback_register(pnd)) < 0) {
+      return res;
+    }
+  }
+
+  PNCMD_TRACE(pbtTx[0]);
+  CHIP_DATA(pnd)->iCollisionBits = -1;
+  if (timeout > 0) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "Timeout value: %d", timeout);
+  } else if (timeout == 0) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "%s", "No timeout");
+  } else if (timeout == -1) {
+    timeout = CHIP_DATA(pnd)->timeout_command;
+  } else {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "Invalid timeout value: %d", timeout);
+  }
+
+  uint8_t  abtRx[PN53x_EXTENDED_FRAME__DATA_MAX_LEN];
+  size_t  szRx = sizeof(abtRx);
+
+  // Check if receiving buffers are available, if not, replace them
+  if (szRxLen == 0 || !pbtRx) {
+    pbtRx = abtRx;
+  } else {
+    szRx = szRxLen;
+  }
+
+  // Sending and receiving share one deadline, so time spent on sending
+  // (e.g. waking up a PN532) is not given once again to the reception
+  const nfc_deadline deadline = nfc_deadline_from_timeout(timeout);
+
+  // Call the send/receice callback functions of the current driver
+  if ((res = CHIP_DATA(pnd)->io->send(pnd, pbtTx, szTx, timeout)) < 0) {
+    return res;
+  }
+
+  // Command is sent, we store the command
+  CHIP_DATA(pnd)->last_command = pbtTx[0];
+
+  // Handle power mode for PN532
+  if ((CHIP_DATA(pnd)->type == PN532) && (TgInitAsTarget == pbtTx[0])) {  // PN532 automatically goes into PowerDown mode when TgInitAsTarget command will be sent
+    CHIP_DATA(pnd)->power_mode = POWERDOWN;
+  }
+
+  if (timeout > 0) {
+    // Even past the deadline, let the driver take its shortest look at the
+    // answer: it knows how to abort the pending command on timeout
+    timeout = MAX(nfc_deadline_remaining(deadline), 1);
+  }
+  if ((res = CHIP_DATA(pnd)->io->receive(pnd, pbtRx, szRx, timeout)) < 0) {
+    return res;
+  }
+
+  if ((CHIP_DATA(pnd)->type == PN532) && (TgInitAsTarget == pbtTx[0])) { // PN532 automatically wakeup on external RF field
+    CHIP_DATA(pnd)->power_mode = NORMAL; // When TgInitAsTarget reply that means an external RF have waken up the chip
+  }
+
+  mi = pn53x_status_byte(pnd, pbtTx, pbtRx);
+
+  while (mi) {
+    int res2;
+    uint8_t  abtRx2[PN53x_EXTENDED_FRAME__DATA_MAX_LEN];
+    // The chained frames draw on the deadline of the whole exchange
+    if (timeout > 0) {
+      if (nfc_deadline_remaining(deadline) < 0) {
+        pnd->last_error = NFC_ETIMEOUT;
+        return pnd->last_error;
+      }
+      timeout = MAX(nfc_deadline_remaining(deadline), 1);
+    }
+    // Send empty command to card (target number included, TgGetData has none)
+    if ((res2 = CHIP_DATA(pnd)->io->send(pnd, pbtTx, (pbtTx[0] == TgGetData) ? 1 : 2, timeout)) < 0) {
+      return res2;
+    }
+    if (timeout > 0) {
+      timeout = MAX(nfc_deadline_remaining(deadline), 1);
+    }
+    if ((res2 = CHIP_DATA(pnd)->io->receive(pnd, abtRx2, sizeof(abtRx2), timeout)) < 0) {
+      return res2;
+    }
+    mi = abtRx2[0] & 0x40;
+    if ((size_t)(res + res2 - 1) > szRx) {
+      CHIP_DATA(pnd)->last_status_byte = ESMALLBUF;
+      break;
+    }
+    memcpy(pbtRx + res, abtRx2 + 1, res2 - 1);
+    // Copy last status byte
+    pbtRx[0] = abtRx2[0];
+    res += res2 - 1;
+  }
+
+  szRx = (size_t) res;
+
+  res = pn53x_status_error(pnd, szRx);
+
   if (res < 0) {
     pnd->last_error = res;
     log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "Chip error: \"%s\" (%02x), returned error: \"%s\" (%d))", pn53x_strerror(pnd), CHIP_DATA(pnd)->last_status_byte, nfc_strerror(pnd), res);
-    if (CHIP_DATA(pnd)->last_status_byte == 0x06) {
-      uint8_t reg;
+    if (CHIP_DATA(pnd)->last_status_byte == EBITCOLL) {
       int res3 = 0;
-      if ((res3 = pn53x_read_register(pnd, PN53X_REG_CIU_Coll, &reg)) < 0)
+      if ((res3 = pn53x_read_collision(pnd)) < 0)
         return res3;
+      // Reading the registers did succeed, not the command
+      CHIP_DATA(pnd)->last_status_byte = EBITCOLL;
+      pnd->last_error = res;
     }
   } else {
     pnd->last_error = 0;
@@ -378,20 +575,90 @@ pn53x_transceive(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx
   return res;
 }
 
-int
-pn53x_set_parameters(struct nfc_device *pnd, const uint8_t ui8Parameter, const bool bEnable)
+/*
+ * A bit collision is reported as any other broken frame (NFC_ERFTRANS), the
+ * frame itself is dropped by the chip. Fetch where the first collision is
+ * (CIU_Coll) and what the CIU FIFO still holds in a single ReadRegister, so
+ * that pn53x_initiator_last_collision() can tell the bits received before it.
+ */
+static int
+pn53x_read_collision(struct nfc_device *pnd)
 {
-  uint8_t ui8Value = (bEnable) ? (CHIP_DATA(pnd)->ui8Parameters | ui8Parameter) : (CHIP_DATA(pnd)->ui8Parameters & ~(ui8Parameter));
-  if (ui8Value != CHIP_DATA(pnd)->ui8Parameters) {
-    return pn53x_SetParameters(pnd, ui8Value);
+  uint8_t abtRes[PN53x_EXTENDED_FRAME__DATA_MAX_LEN];
+  size_t off = 0;
+  int res;
+
+  BUFFER_INIT(abtReadRegisterCmd, PN53x_EXTENDED_FRAME__DATA_MAX_LEN);
+  BUFFER_APPEND(abtReadRegisterCmd, ReadRegister);
+  BUFFER_APPEND(abtReadRegisterCmd, PN53X_REG_CIU_Coll  >> 8);
+  BUFFER_APPEND(abtReadRegisterCmd, PN53X_REG_CIU_Coll & 0xff);
+  BUFFER_APPEND(abtReadRegisterCmd, PN53X_REG_CIU_FIFOLevel  >> 8);
+  BUFFER_APPEND(abtReadRegisterCmd, PN53X_REG_CIU_FIFOLevel & 0xff);
+  for (size_t i = 0; i < PN53X_COLLISION_MAX_LEN; i++) {
+    BUFFER_APPEND(abtReadRegisterCmd, PN53X_REG_CIU_FIFOData  >> 8);
+    BUFFER_APPEND(abtReadRegisterCmd, PN53X_REG_CIU_FIFOData & 0xff);
+  }
+  if ((res = pn53x_transceive(pnd, abtReadRegisterCmd, BUFFER_SIZE(abtReadRegisterCmd), abtRes, sizeof(abtRes), -1)) < 0)
+    return res;
+  if (CHIP_DATA(pnd)->type == PN533) {
+    // PN533 prepends its answer by a status byte
+    off = 1;
   }
+  if ((size_t) res < off + 2 + PN53X_COLLISION_MAX_LEN)
+    return NFC_EIO;
+
+  // CollPos counts from 1 and stands for the 32nd bit when 0, it is not valid past it
+  const uint8_t ui8Coll = abtRes[off];
+  int iBits = PN53X_COLLISION_MAX_LEN * 8;
+  if (!(ui8Coll & SYMBOL_COLL_POS_NOT_VALID))
+    iBits = ((ui8Coll & SYMBOL_COLL_POS) ? (ui8Coll & SYMBOL_COLL_POS) : iBits) - 1;
+  // Only what is left in the FIFO can be given back
+  const size_t szFifo = MIN(abtRes[off + 1] & SYMBOL_FIFO_LEVEL, PN53X_COLLISION_MAX_LEN);
+  iBits = MIN(iBits, (int)(szFifo * 8));
+
+  memset(CHIP_DATA(pnd)->abtCollision, 0x00, sizeof(CHIP_DATA(pnd)->abtCollision));
+  memcpy(CHIP_DATA(pnd)->abtCollision, abtRes + off + 2, szFifo);
+  CHIP_DATA(pnd)->iCollisionBits = iBits;
   return NFC_SUCCESS;
 }
 
+/**
+ * @brief Give back the bits received before the bit collision of the last exchange
+ * @return number of bits received before the collision (framed as pn53x_initiator_transceive_bits() returns them), NFC_EINVARG when the last exchange did not end on a collision
+ *
+ * The bits are stored in \a pbtRx (and their parity in \a pbtRxPar when the
+ * parity is handled by the host). They can be fewer than the ones before the
+ * collision, or none, when the chip did empty its FIFO already.
+ */
 int
-pn53x_set_tx_bits(struct nfc_device *pnd, const uint8_t ui8Bits)
+pn53x_initiator_last_collision(struct nfc_device *pnd, uint8_t *pbtRx, uint8_t *pbtRxPar)
 {
-  // Test if we need to update the transmission bits register setting
+  const int iBits = CHIP_DATA(pnd)->iCollisionBits;
+
+  if (iBits < 0)
+    return NFC_EINVARG;
+  if (iBits == 0)
+    return 0;
+  if (!pnd->bPar)
+    return pn53x_unwrap_frame(CHIP_DATA(pnd)->abtCollision, iBits, pbtRx, pbtRxPar);
+  memcpy(pbtRx, CHIP_DATA(pnd)->abtCollision, (iBits + 7) / 8);
+  return iBits;
+}
+
+int
+pn53x_set_parameters(struct nfc_device *pnd, const uint8_t ui8Parameter, const bool bEnable)
+{
+  uint8_t ui8Value = (bEnable) ? (CHIP_DATA(pnd)->ui8Parameters | ui8Parameter) : (CHIP_DATA(pnd)->ui8Parameters & ~(ui8Parameter));
+  if ((ui8Value != CHIP_DATA(pnd)->ui8Parameters) || CHIP_DATA(pnd)->parameters_stale) {
+    return pn53x_SetParameters(pnd, ui8Value);
+  }
+  return NFC_SUCCESS;
+}
+
+int
+pn53x_set_tx_bits(struct nfc_device *pnd, const uint8_t ui8Bits)
+{
+  // Test if we need to update the transmission bits register setting
   if (CHIP_DATA(pnd)->ui8TxBits != ui8Bits) {
     int res = 0;
     // Set the amount of transmission bits in the PN53X chip register
@@ -804,7 +1071,14 @@ pn53x_decode_firmware_version(struct nfc_device *pnd)
   if ((res = pn53x_transceive(pnd, abtCmd, sizeof(abtCmd), abtFw, szFwLen, -1)) < 0) {
     return res;
   }
-  szFwLen = (size_t) res;
+  return pn53x_firmware_version_decode(pnd, abtFw, (size_t) res);
+}
+
+static int
+pn53x_firmware_version_decode(struct nfc_device *pnd, const uint8_t *abtFw, const size_t szFwLen)
+{
+  memcpy(CHIP_DATA(pnd)->abtFirmwareVersion, abtFw, szFwLen);
+  CHIP_DATA(pnd)->szFirmwareVersion = szFwLen;
   // Determine which version of chip it is: PN531 will return only 2 bytes, while others return 4 bytes and have the first to tell the version IC
   if (szFwLen == 2) {
     CHIP_DATA(pnd)->type = PN531;
@@ -874,6 +1148,7 @@ pn53x_set_property_int(struct nfc_device *pnd, const nfc_property property, cons
       return pn53x_RFConfiguration__Various_timings(pnd, pn53x_int_to_timeout(CHIP_DATA(pnd)->timeout_atr), pn53x_int_to_timeout(CHIP_DATA(pnd)->timeout_communication));
     case NP_TIMEOUT_COM:
       CHIP_DATA(pnd)->timeout_communication = value;
+      pnd->iTimeoutCom = value;
       return pn53x_RFConfiguration__Various_timings(pnd, pn53x_int_to_timeout(CHIP_DATA(pnd)->timeout_atr), pn53x_int_to_timeout(CHIP_DATA(pnd)->timeout_communication));
     // Following properties are invalid (not integer)
     case NP_HANDLE_CRC:
@@ -888,6 +1163,8 @@ pn53x_set_property_int(struct nfc_device *pnd, const nfc_property property, cons
     case NP_FORCE_ISO14443_A:
     case NP_FORCE_ISO14443_B:
     case NP_FORCE_SPEED_106:
+    case NP_AUTO_PPS:
+    case NP_ADAPTIVE_TIMEOUT:
       return NFC_EINVARG;
   }
   return NFC_SUCCESS;
@@ -962,11 +1239,23 @@ pn53x_set_property_bool(struct nfc_device *pnd, const nfc_property property, con
       pnd->bAutoIso14443_4 = bEnable;
       return pn53x_set_parameters(pnd, PARAM_AUTO_RATS, bEnable);
 
+    case NP_AUTO_PPS:
+      // Handled by the host right after selection
+      pnd->bAutoPps = bEnable;
+      return NFC_SUCCESS;
+
+    case NP_ADAPTIVE_TIMEOUT:
+      CHIP_DATA(pnd)->adaptive_timeout = bEnable;
+      CHIP_DATA(pnd)->szTimingStats = 0;
+      return pn53x_timing_restore(pnd);
+
     case NP_FORCE_ISO14443_A:
+      pnd->bForceIso14443a = bEnable;
       if (!bEnable) {
         // Nothing to do
         return NFC_SUCCESS;
       }
+      pnd->bForceIso14443b = false;
       // Force pn53x to be in ISO14443-A mode
       if ((res = pn53x_write_register(pnd, PN53X_REG_CIU_TxMode, SYMBOL_TX_FRAMING, 0x00)) < 0) {
         return res;
@@ -978,10 +1267,12 @@ pn53x_set_property_bool(struct nfc_device *pnd, const nfc_property property, con
       return pn53x_write_register(pnd, PN53X_REG_CIU_TxAuto, SYMBOL_FORCE_100_ASK, 0x40);
 
     case NP_FORCE_ISO14443_B:
+      pnd->bForceIso14443b = bEnable;
       if (!bEnable) {
         // Nothing to do
         return NFC_SUCCESS;
       }
+      pnd->bForceIso14443a = false;
       // Force pn53x to be in ISO14443-B mode
       if ((res = pn53x_write_register(pnd, PN53X_REG_CIU_TxMode, SYMBOL_TX_FRAMING, 0x03)) < 0) {
         return res;
@@ -989,6 +1280,7 @@ pn53x_set_property_bool(struct nfc_device *pnd, const nfc_property property, con
       return pn53x_write_register(pnd, PN53X_REG_CIU_RxMode, SYMBOL_RX_FRAMING, 0x03);
 
     case NP_FORCE_SPEED_106:
+      pnd->bForceSpeed106 = bEnable;
       if (!bEnable) {
         // Nothing to do
         return NFC_SUCCESS;
@@ -1014,6 +1306,7 @@ pn53x_idle(struct nfc_device *pnd)
   int res = 0;
   switch (CHIP_DATA(pnd)->operating_mode) {
     case TARGET:
+      pn53x_picc_stop(pnd);
       // InRelease used in target mode stops the target emulation and no more
       // tag are seen from external initiator
       if ((res = pn53x_InRelease(pnd, 0)) < 0) {
@@ -1074,6 +1367,9 @@ pn53x_initiator_init(struct nfc_device *pnd)
 {
   pn53x_reset_settings(pnd);
   int res;
+  // Timeouts learnt from former targets are forgotten
+  if (CHIP_DATA(pnd)->adaptive_timeout && ((res = pn53x_set_property_bool(pnd, NP_ADAPTIVE_TIMEOUT, false)) < 0))
+    return res;
   if (CHIP_DATA(pnd)->sam_mode != PSM_NORMAL) {
     if ((res = pn532_SAMConfiguration(pnd, PSM_NORMAL, -1)) < 0) {
       return res;
@@ -1215,6 +1511,75 @@ pn532_initiator_init_secure_element(struct nfc_device *pnd)
   return pn532_SAMConfiguration(pnd, PSM_WIRED_CARD, -1);
 }
 
+/*
+ * Highest bit rate supported in both directions by the device and by an
+ * ISO14443-4A target, according to TA(1) of its ATS (see ISO/IEC 14443-4)
+ */
+static nfc_baud_rate
+pn53x_ISO14443A_4_max_baud_rate(struct nfc_device *pnd, const nfc_iso14443a_info *pnai)
+{
+  const nfc_baud_rate *supported_br;
+  nfc_baud_rate nbrMax = NBR_106;
+
+  // Only PN532 and PN533 handle PPS for ISO14443-4 targets in InPSL
+  if ((CHIP_DATA(pnd)->type != PN532) && (CHIP_DATA(pnd)->type != PN533))
+    return NBR_106;
+  // T0 tells whether TA(1) is transmitted
+  if (!(pnai->btSak & 0x20) || (pnai->szAtsLen < 2) || !(pnai->abtAts[0] & 0x10))
+    return NBR_106;
+  if (pn53x_get_supported_baud_rate(pnd, N_INITIATOR, NMT_ISO14443A, &supported_br) < 0)
+    return NBR_106;
+
+  const uint8_t btTa1 = pnai->abtAts[1];
+  for (size_t n = 0; supported_br[n]; n++) {
+    uint8_t btMask;
+    // DS (PICC to PCD) and DR (PCD to PICC) bits
+    switch (supported_br[n]) {
+      case NBR_212:
+        btMask = 0x11;
+        break;
+      case NBR_424:
+        btMask = 0x22;
+        break;
+      case NBR_847:
+        btMask = 0x44;
+        break;
+      default:
+        continue;
+    }
+    if (((btTa1 & btMask) == btMask) && (supported_br[n] > nbrMax))
+      nbrMax = supported_br[n];
+  }
+  return nbrMax;
+}
+
+/*
+ * Negotiate with PPS (sent by InPSL) the highest bit rate of an ISO14443-4A
+ * target. When it fails, the former bit rate is set back so the target is
+ * still usable.
+ */
+static int
+pn53x_ISO14443A_4_pps(struct nfc_device *pnd, const uint8_t ui8Tg, nfc_target *pnt)
+{
+  const nfc_baud_rate nbr = pn53x_ISO14443A_4_max_baud_rate(pnd, &(pnt->nti.nai));
+  int res;
+
+  if (nbr <= pnt->nm.nbr)
+    return NFC_SUCCESS;
+  uint8_t abtCmd[4] = { InPSL, ui8Tg, nbr - 1, nbr - 1 };
+  if ((res = pn53x_transceive(pnd, abtCmd, sizeof(abtCmd), NULL, 0, 0)) < 0) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "PPS to %s failed, staying at %s", str_nfc_baud_rate(nbr), str_nfc_baud_rate(pnt->nm.nbr));
+    abtCmd[2] = pnt->nm.nbr - 1;
+    abtCmd[3] = pnt->nm.nbr - 1;
+    if ((res = pn53x_transceive(pnd, abtCmd, sizeof(abtCmd), NULL, 0, 0)) < 0)
+      return res;
+    return NFC_SUCCESS;
+  }
+  log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "Target switched to %s", str_nfc_baud_rate(nbr));
+  pnt->nm.nbr = nbr;
+  return NFC_SUCCESS;
+}
+
 static int
 pn53x_initiator_select_passive_target_ext(struct nfc_device *pnd,
                                           const nfc_modulation nm,
@@ -1471,6 +1836,10 @@ pn53x_initiator_select_passive_target_ext(struct nfc_device *pnd,
         return res;
       }
     }
+    if ((nm.nmt == NMT_ISO14443A) && pnd->bAutoPps) {
+      if ((res = pn53x_ISO14443A_4_pps(pnd, abtTargetsData[1], &nttmp)) < 0)
+        return res;
+    }
   }
   if (pn53x_current_target_new(pnd, &nttmp) == NULL) {
     pnd->last_error = NFC_ESOFT;
@@ -1492,89 +1861,440 @@ pn53x_initiator_select_passive_target(struct nfc_device *pnd,
   return pn53x_initiator_select_passive_target_ext(pnd, nm, pbtInitData, szInitData, pnt, 300);
 }
 
+static int
+pn53x_target_data_len(const struct nfc_device *pnd, const nfc_modulation_type nmt, const uint8_t *pbtRawData, const size_t szRawData)
+{
+  size_t szLen;
+  switch (nmt) {
+    case NMT_ISO14443A:
+      // Tg, SENS_RES (2 bytes), SEL_RES, NFCIDLength, NFCID1
+      if (szRawData < 5)
+        return NFC_ECHIP;
+      szLen = 5 + pbtRawData[4];
+      // ATS is only there when the chip sent RATS on its own, its first byte (TL) counts the whole ATS
+      if ((pbtRawData[3] & 0x20) && pnd->bAutoIso14443_4 && (szRawData > szLen))
+        szLen += pbtRawData[szLen];
+      break;
+    case NMT_ISO14443B:
+      // Tg, ATQB (12 bytes), ATTRIB_RES length, ATTRIB_RES
+      if (szRawData < 14)
+        return NFC_ECHIP;
+      szLen = 14 + pbtRawData[13];
+      break;
+    case NMT_FELICA:
+      // Tg, POL_RES length, POL_RES (length byte is counted in POL_RES length)
+      if (szRawData < 2)
+        return NFC_ECHIP;
+      szLen = 1 + pbtRawData[1];
+      break;
+    case NMT_JEWEL:
+      // Tg, SENS_RES (2 bytes), JEWELID (4 bytes)
+      szLen = 7;
+      break;
+    default:
+      szLen = szRawData;
+      break;
+  }
+  if (szLen > szRawData)
+    return NFC_ECHIP;
+  return (int) szLen;
+}
+
 int
-pn53x_initiator_poll_target(struct nfc_device *pnd,
-                            const nfc_modulation *pnmModulations, const size_t szModulations,
-                            const uint8_t uiPollNr, const uint8_t uiPeriod,
-                            nfc_target *pnt)
+pn53x_initiator_select_passive_targets(struct nfc_device *pnd,
+                                       const nfc_modulation nm,
+                                       const uint8_t *pbtInitData, const size_t szInitData,
+                                       nfc_target ant[], const size_t szTargets)
 {
+  uint8_t  abtTargetsData[PN53x_EXTENDED_FRAME__DATA_MAX_LEN];
+  size_t  szTargetsData = sizeof(abtTargetsData);
+  nfc_target ntTargets[PN53X_MAX_TARGETS];
   int res = 0;
 
-  if (CHIP_DATA(pnd)->type == PN532) {
-    size_t szTargetTypes = 0;
-    pn53x_target_type apttTargetTypes[32];
-    memset(apttTargetTypes, PTT_UNDEFINED, 32 * sizeof(pn53x_target_type));
-    for (size_t n = 0; n < szModulations; n++) {
-      const pn53x_target_type ptt = pn53x_nm_to_ptt(pnmModulations[n]);
-      if (PTT_UNDEFINED == ptt) {
-        pnd->last_error = NFC_EINVARG;
-        return pnd->last_error;
+  if (szTargets == 0) {
+    pnd->last_error = NFC_EINVARG;
+    return pnd->last_error;
+  }
+
+  const pn53x_modulation pm = pn53x_nm_to_pm(nm);
+  if ((PM_UNDEFINED == pm) || (nm.nmt == NMT_BARCODE)) {
+    // Targets discovered by the host can only be handled one at a time
+    return pn53x_initiator_select_passive_target_ext(pnd, nm, pbtInitData, szInitData, ant, 300);
+  }
+  if (NBR_UNDEFINED == nm.nbr) {
+    pnd->last_error = NFC_EINVARG;
+    return pnd->last_error;
+  }
+
+  // Jewel tags can only be listed one by one
+  const uint8_t szMaxTargets = (nm.nmt == NMT_JEWEL) ? 1 : MIN(szTargets, PN53X_MAX_TARGETS);
+  if ((res = pn53x_InListPassiveTarget(pnd, pm, szMaxTargets, pbtInitData, szInitData, abtTargetsData, &szTargetsData, 300)) <= 0)
+    return res;
+
+  const size_t szFound = MIN(abtTargetsData[0], szMaxTargets);
+  const uint8_t *pbtRawData = abtTargetsData + 1;
+  size_t szRawData = szTargetsData - 1;
+  memset(ntTargets, 0x00, sizeof(ntTargets));
+  for (size_t n = 0; n < szFound; n++) {
+    int len;
+    if ((len = pn53x_target_data_len(pnd, nm.nmt, pbtRawData, szRawData)) < 0) {
+      pnd->last_error = len;
+      return pnd->last_error;
+    }
+    ntTargets[n].nm = nm;
+    if ((res = pn53x_decode_target_data(pbtRawData, len, CHIP_DATA(pnd)->type, nm.nmt, &(ntTargets[n].nti))) < 0) {
+      return res;
+    }
+    if ((nm.nmt == NMT_ISO14443A) && (nm.nbr != NBR_106)) {
+      uint8_t pncmd_inpsl[4] = { InPSL, pbtRawData[0] };
+      pncmd_inpsl[2] = nm.nbr - 1;
+      pncmd_inpsl[3] = nm.nbr - 1;
+      if ((res = pn53x_transceive(pnd, pncmd_inpsl, sizeof(pncmd_inpsl), NULL, 0, 0)) < 0) {
+        return res;
       }
-      apttTargetTypes[szTargetTypes] = ptt;
-      if ((pnd->bAutoIso14443_4) && (ptt == PTT_MIFARE)) { // Hack to have ATS
-        apttTargetTypes[szTargetTypes] = PTT_ISO14443_4A_106;
-        szTargetTypes++;
-        apttTargetTypes[szTargetTypes] = PTT_MIFARE;
+    }
+    if ((nm.nmt == NMT_ISO14443A) && pnd->bAutoPps) {
+      if ((res = pn53x_ISO14443A_4_pps(pnd, pbtRawData[0], &ntTargets[n])) < 0)
+        return res;
+    }
+    pbtRawData += len;
+    szRawData -= len;
+  }
+
+  // The first target (Tg 1) is the current one until another one is addressed
+  if (pn53x_current_target_new(pnd, &ntTargets[0]) == NULL) {
+    pnd->last_error = NFC_ESOFT;
+    return pnd->last_error;
+  }
+  memcpy(CHIP_DATA(pnd)->session_targets, ntTargets, szFound * sizeof(nfc_target));
+  CHIP_DATA(pnd)->szSessionTargets = szFound;
+  memcpy(ant, ntTargets, szFound * sizeof(nfc_target));
+  return szFound;
+}
+
+// Shortest time given to a modulation, whatever its history
+#define PN53X_POLL_SLICE_MIN_MS 30
+
+static int
+pn53x_poll_elapsed_ms(const struct timespec *ptsStart)
+{
+  struct timespec tsNow;
+  clock_gettime(CLOCK_MONOTONIC, &tsNow);
+  return (int)((tsNow.tv_sec - ptsStart->tv_sec) * 1000 + (tsNow.tv_nsec - ptsStart->tv_nsec) / 1000000);
+}
+
+/*
+ * Find the polling history of a modulation, or make room for it by
+ * forgetting the least successful modulation not polled by this call.
+ */
+static struct pn53x_poll_stats *
+pn53x_poll_stats_get(struct nfc_device *pnd, const nfc_modulation nm, struct pn53x_poll_stats *apStats[], const size_t szStats)
+{
+  struct pn53x_data *data = CHIP_DATA(pnd);
+  struct pn53x_poll_stats *pStats = NULL;
+
+  for (size_t n = 0; n < data->szPollStats; n++) {
+    if ((data->poll_stats[n].nm.nmt == nm.nmt) && (data->poll_stats[n].nm.nbr == nm.nbr))
+      return &(data->poll_stats[n]);
+  }
+  if (data->szPollStats < PN53X_POLL_STATS_MAX) {
+    pStats = &(data->poll_stats[data->szPollStats++]);
+  } else {
+    for (size_t n = 0; n < PN53X_POLL_STATS_MAX; n++) {
+      bool bInUse = false;
+      for (size_t i = 0; i < szStats; i++) {
+        if (apStats[i] == &(data->poll_stats[n]))
+          bInUse = true;
       }
-      szTargetTypes++;
+      if ((!bInUse) && ((pStats == NULL) || (data->poll_stats[n].ui16Score < pStats->ui16Score)))
+        pStats = &(data->poll_stats[n]);
     }
-    nfc_target ntTargets[2];
-    memset(ntTargets, 0x00, sizeof(nfc_target) * 2);
+  }
+  pStats->nm = nm;
+  pStats->ui16Score = 0;
+  pStats->response_ms = 0;
+  return pStats;
+}
+
+/*
+ * Time given to a modulation: a whole period until a target has been seen,
+ * then a few times the time it usually takes to find one.
+ */
+static int
+pn53x_poll_slice_ms(const struct pn53x_poll_stats *pStats, const int period_ms)
+{
+  if (pStats->response_ms == 0)
+    return period_ms;
+  int slice_ms = 3 * pStats->response_ms;
+  if (slice_ms < PN53X_POLL_SLICE_MIN_MS)
+    slice_ms = PN53X_POLL_SLICE_MIN_MS;
+  return (slice_ms < period_ms) ? slice_ms : period_ms;
+}
+
+static void
+pn53x_poll_stats_update(struct pn53x_poll_stats *pStats, const bool bHit, const int elapsed_ms)
+{
+  if (bHit) {
+    pStats->ui16Score += (256 - pStats->ui16Score) / 4;
+    pStats->response_ms = (pStats->response_ms) ? (3 * pStats->response_ms + elapsed_ms) / 4 : elapsed_ms;
+    if (pStats->response_ms == 0)
+      pStats->response_ms = 1;
+  } else {
+    // Rounded up, so that a modulation which stopped bringing targets gets back to 0
+    pStats->ui16Score -= (pStats->ui16Score + 7) / 8;
+  }
+}
+
+/*
+ * Modulations the chip can not discover by itself: the host does a single
+ * attempt in pn53x_initiator_select_passive_target_ext() unless infinite
+ * select is enabled, in which case it would never give up.
+ */
+static bool
+pn53x_poll_is_host_discovered(const nfc_modulation_type nmt)
+{
+  switch (nmt) {
+    case NMT_ISO14443BI:
+    case NMT_ISO14443B2SR:
+    case NMT_ISO14443B2CT:
+    case NMT_ISO14443BICLASS:
+    case NMT_BARCODE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/*
+ * One attempt to find a target of modulation nm within timeout ms, the chip
+ * retrying by itself when it can: returns like select_passive_target.
+ */
+static int
+pn53x_poll_attempt(struct nfc_device *pnd, const nfc_modulation nm,
+                   const uint8_t *pbtInitiatorData, const size_t szInitiatorData,
+                   nfc_target *pnt, const int timeout, bool *pbCurrentInfiniteSelect)
+{
+  int res;
 
-    if ((res = pn53x_InAutoPoll(pnd, apttTargetTypes, szTargetTypes, uiPollNr, uiPeriod, ntTargets, 0)) < 0)
+  const bool bWantInfiniteSelect = !pn53x_poll_is_host_discovered(nm.nmt);
+  if (bWantInfiniteSelect != *pbCurrentInfiniteSelect) {
+    if ((res = pn53x_set_property_bool(pnd, NP_INFINITE_SELECT, bWantInfiniteSelect)) < 0) {
+      pnd->last_error = res;
       return res;
-    switch (res) {
-      case 0:
-        return pnd->last_error = NFC_SUCCESS;
-        break;
-      case 1:
-        *pnt = ntTargets[0];
-        if (pn53x_current_target_new(pnd, pnt) == NULL) {
-          return pnd->last_error = NFC_ESOFT;
+    }
+    *pbCurrentInfiniteSelect = bWantInfiniteSelect;
+  }
+  if (nm.nmt == NMT_DEP) {
+    res = pn53x_initiator_select_dep_target(pnd, NDM_PASSIVE, nm.nbr, NULL, pnt, timeout);
+    if (res < 0)
+      pnd->last_error = res;
+    return res;
+  }
+  return pn53x_initiator_select_passive_target_ext(pnd, nm, pbtInitiatorData, szInitiatorData, pnt, timeout);
+}
+
+/*
+ * Polling without any history, for what the scheduler does not keep track
+ * of (more than PN53X_POLL_STATS_MAX modulations, or a period of 0, which
+ * means no timeout): each modulation in turn for a whole period.
+ */
+static int
+pn53x_initiator_poll_target_unweighted(struct nfc_device *pnd,
+                                       const nfc_modulation *pnmModulations, const size_t szModulations,
+                                       const uint8_t uiPollNr, const uint8_t uiPeriod,
+                                       nfc_target *pnt)
+{
+  const bool bInfiniteSelect = pnd->bInfiniteSelect;
+  bool bCurrentInfiniteSelect = bInfiniteSelect;
+  int res = 0;
+  int result = 0;
+
+  do {
+    for (size_t p = 0; p < uiPollNr; p++) {
+      for (size_t n = 0; n < szModulations; n++) {
+        uint8_t *pbtInitiatorData;
+        size_t szInitiatorData;
+        prepare_initiator_data(pnmModulations[n], &pbtInitiatorData, &szInitiatorData);
+
+        res = pn53x_poll_attempt(pnd, pnmModulations[n], pbtInitiatorData, szInitiatorData, pnt, uiPeriod * 150, &bCurrentInfiniteSelect);
+        if (res > 0) {
+          result = res;
+          goto end;
         }
-        return res;
-      case 2:
-        *pnt = ntTargets[1]; // We keep the selected one
-        if (pn53x_current_target_new(pnd, pnt) == NULL) {
-          return pnd->last_error = NFC_ESOFT;
+        if ((res < 0) && (pnd->last_error != NFC_ETIMEOUT)) {
+          result = pnd->last_error;
+          goto end;
         }
-        return res;
-      default:
-        return NFC_ECHIP;
+      }
     }
-  } else {
-    bool bInfiniteSelect = pnd->bInfiniteSelect;
-    int result = 0;
-    if ((res = pn53x_set_property_bool(pnd, NP_INFINITE_SELECT, true)) < 0)
+  } while (uiPollNr == 0xff); // uiPollNr==0xff means infinite polling
+  // We reach this point when each listing give no result, we simply have to return 0
+end:
+  if (bCurrentInfiniteSelect != bInfiniteSelect) {
+    if ((res = pn53x_set_property_bool(pnd, NP_INFINITE_SELECT, bInfiniteSelect)) < 0)
       return res;
-    // FIXME It does not support DEP targets
-    do {
-      for (size_t p = 0; p < uiPollNr; p++) {
-        for (size_t n = 0; n < szModulations; n++) {
-          uint8_t *pbtInitiatorData;
-          size_t szInitiatorData;
-          prepare_initiator_data(pnmModulations[n], &pbtInitiatorData, &szInitiatorData);
-          const int timeout_ms = uiPeriod * 150;
-
-          if ((res = pn53x_initiator_select_passive_target_ext(pnd, pnmModulations[n], pbtInitiatorData, szInitiatorData, pnt, timeout_ms)) < 0) {
-            if (pnd->last_error != NFC_ETIMEOUT) {
-              result = pnd->last_error;
-              goto end;
-            }
-          } else {
+  }
+  return result;
+}
+
+/*
+ * InAutoPoll emulation for chips lacking it: within each polling, the
+ * modulations are tried by decreasing hit rate, each during a slice of time
+ * fitted to its history, over and over until the time the PN532 would spend
+ * (one period per modulation) is elapsed.
+ */
+static int
+pn53x_initiator_poll_target_scheduled(struct nfc_device *pnd,
+                                      const nfc_modulation *pnmModulations, const size_t szModulations,
+                                      const uint8_t uiPollNr, const uint8_t uiPeriod,
+                                      nfc_target *pnt)
+{
+  struct pn53x_poll_stats *apStats[PN53X_POLL_STATS_MAX];
+  uint8_t *apbtInitiatorData[PN53X_POLL_STATS_MAX];
+  size_t aszInitiatorData[PN53X_POLL_STATS_MAX];
+  size_t aszOrder[PN53X_POLL_STATS_MAX];
+  const int period_ms = uiPeriod * 150;
+  const int budget_ms = period_ms * (int)szModulations;
+  int res = 0;
+  int result = 0;
+
+  if ((szModulations > PN53X_POLL_STATS_MAX) || (uiPeriod == 0))
+    return pn53x_initiator_poll_target_unweighted(pnd, pnmModulations, szModulations, uiPollNr, uiPeriod, pnt);
+  if (szModulations == 0)
+    return 0;
+  // Initiator data does not change from one polling to the next
+  for (size_t n = 0; n < szModulations; n++) {
+    prepare_initiator_data(pnmModulations[n], &(apbtInitiatorData[n]), &(aszInitiatorData[n]));
+    apStats[n] = pn53x_poll_stats_get(pnd, pnmModulations[n], apStats, n);
+  }
+
+  const bool bInfiniteSelect = pnd->bInfiniteSelect;
+  bool bCurrentInfiniteSelect = bInfiniteSelect;
+  do {
+    for (size_t p = 0; p < uiPollNr; p++) {
+      // Most successful modulations first, ties keep the caller's order
+      for (size_t n = 0; n < szModulations; n++) {
+        size_t i = n;
+        while ((i > 0) && (apStats[aszOrder[i - 1]]->ui16Score < apStats[n]->ui16Score)) {
+          aszOrder[i] = aszOrder[i - 1];
+          i--;
+        }
+        aszOrder[i] = n;
+      }
+      struct timespec tsPoll;
+      clock_gettime(CLOCK_MONOTONIC, &tsPoll);
+      int remaining_ms = budget_ms;
+      while (remaining_ms > 0) {
+        for (size_t i = 0; (i < szModulations) && (remaining_ms > 0); i++) {
+          const size_t n = aszOrder[i];
+          const nfc_modulation nm = pnmModulations[n];
+          int slice_ms = pn53x_poll_slice_ms(apStats[n], period_ms);
+          if (slice_ms > remaining_ms)
+            slice_ms = remaining_ms;
+
+          // The chip retries by itself during the whole slice
+          struct timespec tsSlice;
+          clock_gettime(CLOCK_MONOTONIC, &tsSlice);
+          res = pn53x_poll_attempt(pnd, nm, apbtInitiatorData[n], aszInitiatorData[n], pnt, slice_ms, &bCurrentInfiniteSelect);
+          pn53x_poll_stats_update(apStats[n], res > 0, pn53x_poll_elapsed_ms(&tsSlice));
+          if (res > 0) {
             result = res;
             goto end;
           }
+          if ((res < 0) && (pnd->last_error != NFC_ETIMEOUT)) {
+            result = pnd->last_error;
+            goto end;
+          }
+          remaining_ms = budget_ms - pn53x_poll_elapsed_ms(&tsPoll);
         }
       }
-    } while (uiPollNr == 0xff); // uiPollNr==0xff means infinite polling
-    // We reach this point when each listing give no result, we simply have to return 0
+    }
+  } while (uiPollNr == 0xff); // uiPollNr==0xff means infinite polling
+  // We reach this point when each listing give no result, we simply have to return 0
 end:
-    if (! bInfiniteSelect) {
-      if ((res = pn53x_set_property_bool(pnd, NP_INFINITE_SELECT, false)) < 0)
-        return res;
+  if (bCurrentInfiniteSelect != bInfiniteSelect) {
+    if ((res = pn53x_set_property_bool(pnd, NP_INFINITE_SELECT, bInfiniteSelect)) < 0)
+      return res;
+  }
+  return result;
+}
+
+/*
+ * Target types InAutoPoll looks for, for the modulations to poll: returns
+ * their count (32 at most).
+ */
+static int
+pn53x_poll_target_types(struct nfc_device *pnd, const nfc_modulation *pnmModulations, const size_t szModulations,
+                        pn53x_target_type *apttTargetTypes)
+{
+  size_t szTargetTypes = 0;
+
+  memset(apttTargetTypes, PTT_UNDEFINED, 32 * sizeof(pn53x_target_type));
+  for (size_t n = 0; n < szModulations; n++) {
+    const pn53x_target_type ptt = pn53x_nm_to_ptt(pnmModulations[n]);
+    if ((PTT_UNDEFINED == ptt) || (szTargetTypes >= 31)) {
+      pnd->last_error = NFC_EINVARG;
+      return pnd->last_error;
     }
-    return result;
+    apttTargetTypes[szTargetTypes] = ptt;
+    if ((pnd->bAutoIso14443_4) && (ptt == PTT_MIFARE)) { // Hack to have ATS
+      apttTargetTypes[szTargetTypes] = PTT_ISO14443_4A_106;
+      szTargetTypes++;
+      apttTargetTypes[szTargetTypes] = PTT_MIFARE;
+    }
+    szTargetTypes++;
+  }
+  return (int) szTargetTypes;
+}
+
+/*
+ * Keep the target selected by InAutoPoll, which found res of them.
+ */
+static int
+pn53x_poll_target_found(struct nfc_device *pnd, const int res, const nfc_target *ntTargets, nfc_target *pnt)
+{
+  switch (res) {
+    case 0:
+      return pnd->last_error = NFC_SUCCESS;
+      break;
+    case 1:
+      *pnt = ntTargets[0];
+      if (pn53x_current_target_new(pnd, pnt) == NULL) {
+        return pnd->last_error = NFC_ESOFT;
+      }
+      return res;
+    case 2:
+      *pnt = ntTargets[1]; // We keep the selected one
+      if (pn53x_current_target_new(pnd, pnt) == NULL) {
+        return pnd->last_error = NFC_ESOFT;
+      }
+      return res;
+    default:
+      return NFC_ECHIP;
+  }
+}
+
+int
+pn53x_initiator_poll_target(struct nfc_device *pnd,
+                            const nfc_modulation *pnmModulations, const size_t szModulations,
+                            const uint8_t uiPollNr, const uint8_t uiPeriod,
+                            nfc_target *pnt)
+{
+  int res = 0;
+
+  if (CHIP_DATA(pnd)->type == PN532) {
+    pn53x_target_type apttTargetTypes[32];
+    int szTargetTypes;
+    if ((szTargetTypes = pn53x_poll_target_types(pnd, pnmModulations, szModulations, apttTargetTypes)) < 0)
+      return szTargetTypes;
+    nfc_target ntTargets[2];
+    memset(ntTargets, 0x00, sizeof(nfc_target) * 2);
+
+    if ((res = pn53x_InAutoPoll(pnd, apttTargetTypes, (size_t) szTargetTypes, uiPollNr, uiPeriod, ntTargets, 0)) < 0)
+      return res;
+    return pn53x_poll_target_found(pnd, res, ntTargets, pnt);
+  } else {
+    return pn53x_initiator_poll_target_scheduled(pnd, pnmModulations, szModulations, uiPollNr, uiPeriod, pnt);
   }
   return NFC_ECHIP;
 }
@@ -1619,6 +2339,36 @@ pn53x_initiator_select_dep_target(struct nfc_device *pnd,
   return res;
 }
 
+/*
+ * Switch the selected D.E.P. target to baud rate nbr in both directions,
+ * with the PSL_REQ sent by InPSL (see NFCIP-1 12.5.3)
+ */
+int
+pn53x_initiator_dep_psl(struct nfc_device *pnd, const nfc_baud_rate nbr)
+{
+  int res;
+
+  if (!CHIP_DATA(pnd)->current_target || (CHIP_DATA(pnd)->current_target->nm.nmt != NMT_DEP)) {
+    pnd->last_error = NFC_EINVARG;
+    return pnd->last_error;
+  }
+  switch (nbr) {
+    case NBR_106:
+    case NBR_212:
+    case NBR_424:
+      break;
+    case NBR_847:
+    case NBR_UNDEFINED:
+      pnd->last_error = NFC_EINVARG;
+      return pnd->last_error;
+  }
+  const uint8_t abtCmd[4] = { InPSL, 0x01, nbr - 1, nbr - 1 };
+  if ((res = pn53x_transceive(pnd, abtCmd, sizeof(abtCmd), NULL, 0, 0)) < 0)
+    return res;
+  CHIP_DATA(pnd)->current_target->nm.nbr = nbr;
+  return NFC_SUCCESS;
+}
+
 int
 pn53x_initiator_transceive_bits(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTxBits,
                                 const uint8_t *pbtTxPar, uint8_t *pbtRx, uint8_t *pbtRxPar)
@@ -1701,8 +2451,146 @@ pn53x_initiator_transceive_bits(struct nfc_device *pnd, const uint8_t *pbtTx, co
   return szRxBits;
 }
 
-int
-pn53x_initiator_transceive_bytes(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, uint8_t *pbtRx,
+// Bounds of the timeouts learnt from response times (ms)
+#define PN53X_TIMING_MIN_MS 10
+// Time (ms) given on top of the RF timeout to carry the answer to the host
+#define PN53X_TIMING_TRANSPORT_MS 25
+
+/*
+ * Find the response time statistics of a kind of command, or make room for
+ * them by forgetting the least recently used kind.
+ */
+static struct pn53x_timing_stats *
+pn53x_timing_stats_get(struct nfc_device *pnd, const uint8_t ui8Command, const uint8_t ui8TargetCommand)
+{
+  struct pn53x_data *data = CHIP_DATA(pnd);
+  struct pn53x_timing_stats *pStats = NULL;
+
+  data->ui32TimingClock++;
+  for (size_t n = 0; n < data->szTimingStats; n++) {
+    if ((data->timing_stats[n].ui8Command == ui8Command) && (data->timing_stats[n].ui8TargetCommand == ui8TargetCommand)) {
+      data->timing_stats[n].ui32LastUse = data->ui32TimingClock;
+      return &(data->timing_stats[n]);
+    }
+  }
+  if (data->szTimingStats < PN53X_TIMING_STATS_MAX) {
+    pStats = &(data->timing_stats[data->szTimingStats++]);
+  } else {
+    pStats = &(data->timing_stats[0]);
+    for (size_t n = 1; n < PN53X_TIMING_STATS_MAX; n++) {
+      if (data->timing_stats[n].ui32LastUse < pStats->ui32LastUse)
+        pStats = &(data->timing_stats[n]);
+    }
+  }
+  memset(pStats, 0x00, sizeof(struct pn53x_timing_stats));
+  pStats->ui8Command = ui8Command;
+  pStats->ui8TargetCommand = ui8TargetCommand;
+  pStats->ui32LastUse = data->ui32TimingClock;
+  return pStats;
+}
+
+/*
+ * Timeout of a kind of command: smoothed response time plus four times its
+ * deviation, which covers nearly every answer, doubled on each timeout in a
+ * row. It never exceeds the default command timeout.
+ */
+static int
+pn53x_timing_timeout_ms(struct nfc_device *pnd, const struct pn53x_timing_stats *pStats)
+{
+  const int max_ms = CHIP_DATA(pnd)->timeout_command;
+  if (pStats->srtt_us == 0)
+    return max_ms;
+  int timeout_ms = (pStats->srtt_us + 4 * pStats->rttvar_us + 999) / 1000;
+  if (timeout_ms < PN53X_TIMING_MIN_MS)
+    timeout_ms = PN53X_TIMING_MIN_MS;
+  for (uint8_t n = 0; (n < pStats->ui8Misses) && ((max_ms == 0) || (timeout_ms < max_ms)); n++)
+    timeout_ms *= 2;
+  return ((max_ms > 0) && (timeout_ms > max_ms)) ? max_ms : timeout_ms;
+}
+
+/*
+ * RF timeout (in us) encoded as by pn53x_int_to_timeout(): 100 us times a
+ * power of two, 0 meaning no timeout.
+ */
+static int
+pn53x_timeout_to_us(const uint8_t ui8Timeout)
+{
+  return (ui8Timeout == 0) ? 0 : (100 << (ui8Timeout - 1));
+}
+
+/*
+ * Host-side timeout of a kind of command: the learnt one, but never shorter
+ * than the RF timeout in use plus the time to carry the answer, so that the
+ * host does not give up while the chip is still waiting for the target.
+ */
+static int
+pn53x_timing_host_timeout_ms(struct nfc_device *pnd, const struct pn53x_timing_stats *pStats)
+{
+  const uint8_t ui8RfTimeout = CHIP_DATA(pnd)->ui8TimingRfTimeout ? CHIP_DATA(pnd)->ui8TimingRfTimeout : pn53x_int_to_timeout(CHIP_DATA(pnd)->timeout_communication);
+  const int timeout_ms = pn53x_timing_timeout_ms(pnd, pStats);
+  if ((timeout_ms == 0) || (ui8RfTimeout == 0))
+    return timeout_ms;
+  const int min_ms = (pn53x_timeout_to_us(ui8RfTimeout) + 999) / 1000 + PN53X_TIMING_TRANSPORT_MS;
+  return MAX(timeout_ms, min_ms);
+}
+
+/*
+ * The RF timeout of the chip follows the slowest kind of command of the
+ * current target, so that it is seldom changed.
+ */
+static int
+pn53x_timing_apply(struct nfc_device *pnd)
+{
+  int rf_timeout_ms = 0;
+  for (size_t n = 0; n < CHIP_DATA(pnd)->szTimingStats; n++) {
+    if (CHIP_DATA(pnd)->timing_stats[n].srtt_us == 0)
+      return pn53x_timing_restore(pnd);
+    const int timeout_ms = pn53x_timing_timeout_ms(pnd, &(CHIP_DATA(pnd)->timing_stats[n]));
+    if (timeout_ms > rf_timeout_ms)
+      rf_timeout_ms = timeout_ms;
+  }
+  if ((rf_timeout_ms == 0) || (rf_timeout_ms >= CHIP_DATA(pnd)->timeout_communication))
+    return pn53x_timing_restore(pnd);
+  // pn53x_int_to_timeout() rounds down to a power of two
+  const uint8_t ui8RfTimeout = pn53x_int_to_timeout(2 * rf_timeout_ms);
+  if (ui8RfTimeout == CHIP_DATA(pnd)->ui8TimingRfTimeout)
+    return NFC_SUCCESS;
+  CHIP_DATA(pnd)->ui8TimingRfTimeout = ui8RfTimeout;
+  return pn53x_RFConfiguration__Various_timings(pnd, pn53x_int_to_timeout(CHIP_DATA(pnd)->timeout_atr), ui8RfTimeout);
+}
+
+static int
+pn53x_timing_restore(struct nfc_device *pnd)
+{
+  if (CHIP_DATA(pnd)->ui8TimingRfTimeout == 0)
+    return NFC_SUCCESS;
+  CHIP_DATA(pnd)->ui8TimingRfTimeout = 0;
+  return pn53x_RFConfiguration__Various_timings(pnd, pn53x_int_to_timeout(CHIP_DATA(pnd)->timeout_atr), pn53x_int_to_timeout(CHIP_DATA(pnd)->timeout_communication));
+}
+
+static void
+pn53x_timing_stats_update(struct nfc_device *pnd, struct pn53x_timing_stats *pStats, const int res, const int elapsed_us)
+{
+  if (res >= 0) {
+    if (pStats->srtt_us == 0) {
+      pStats->srtt_us = (elapsed_us > 0) ? elapsed_us : 1;
+      pStats->rttvar_us = elapsed_us / 2;
+    } else {
+      const int delta_us = elapsed_us - pStats->srtt_us;
+      pStats->srtt_us += delta_us / 8;
+      pStats->rttvar_us += (((delta_us < 0) ? -delta_us : delta_us) - pStats->rttvar_us) / 4;
+      if (pStats->srtt_us <= 0)
+        pStats->srtt_us = 1;
+    }
+    pStats->ui8Misses = 0;
+  } else if ((res == NFC_ETIMEOUT) || ((res == NFC_ERFTRANS) && (CHIP_DATA(pnd)->last_status_byte == 0x01))) {
+    if (pStats->ui8Misses < 8)
+      pStats->ui8Misses++;
+  }
+}
+
+int
+pn53x_initiator_transceive_bytes(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, uint8_t *pbtRx,
                                  const size_t szRx, int timeout)
 {
   size_t  szExtraTxLen;
@@ -1715,42 +2603,804 @@ pn53x_initiator_transceive_bytes(struct nfc_device *pnd, const uint8_t *pbtTx, c
     return pnd->last_error;
   }
 
+  // To transfer command frames bytes we can not have any leading bits, reset this to zero
+  if ((res = pn53x_set_tx_bits(pnd, 0)) < 0) {
+    pnd->last_error = res;
+    return pnd->last_error;
+  }
+
   // Copy the data into the command frame
+  size_t szSent = 0;
   if (pnd->bEasyFraming) {
     abtCmd[0] = InDataExchange;
-    abtCmd[1] = 1;              /* target number */
-    memcpy(abtCmd + 2, pbtTx, szTx);
+    // Longer frames are chained: with the MI bit set along the target
+    // number, the chip sends the part and waits for the target to ask for more.
+    // All the parts and the last frame share one deadline.
+    const nfc_deadline deadline = nfc_deadline_from_timeout((timeout == -1) ? CHIP_DATA(pnd)->timeout_command : timeout);
+    while (szTx - szSent > PN53x_IN_DATA__MAX_LEN) {
+      int iPartTimeout = timeout;
+      if (deadline != 0) {
+        if ((iPartTimeout = nfc_deadline_remaining(deadline)) < 0) {
+          pnd->last_error = NFC_ETIMEOUT;
+          return pnd->last_error;
+        }
+      }
+      abtCmd[1] = CHIP_DATA(pnd)->current_tg | 0x40;
+      memcpy(abtCmd + 2, pbtTx + szSent, PN53x_IN_DATA__MAX_LEN);
+      if ((res = pn53x_transceive(pnd, abtCmd, PN53x_IN_DATA__MAX_LEN + 2, NULL, 0, iPartTimeout)) < 0) {
+        pnd->last_error = res;
+        return pnd->last_error;
+      }
+      szSent += PN53x_IN_DATA__MAX_LEN;
+    }
+    // A chained frame gets what is left, not a timeout learnt on whole frames
+    if ((szSent > 0) && (deadline != 0)) {
+      if ((timeout = nfc_deadline_remaining(deadline)) < 0) {
+        pnd->last_error = NFC_ETIMEOUT;
+        return pnd->last_error;
+      }
+    }
+    abtCmd[1] = CHIP_DATA(pnd)->current_tg; /* target number */
+    memcpy(abtCmd + 2, pbtTx + szSent, szTx - szSent);
     szExtraTxLen = 2;
   } else {
+    if (szTx > sizeof(abtCmd) - 1) {
+      pnd->last_error = NFC_EOVFLOW;
+      return pnd->last_error;
+    }
     abtCmd[0] = InCommunicateThru;
     memcpy(abtCmd + 1, pbtTx, szTx);
     szExtraTxLen = 1;
   }
 
-  // To transfer command frames bytes we can not have any leading bits, reset this to zero
-  if ((res = pn53x_set_tx_bits(pnd, 0)) < 0) {
-    pnd->last_error = res;
-    return pnd->last_error;
-  }
+  // Without an explicit timeout, use the one learnt from the target if asked to
+  struct pn53x_timing_stats *pStats = NULL;
+  struct timespec tsStart;
+  if ((timeout == -1) && CHIP_DATA(pnd)->adaptive_timeout && (CHIP_DATA(pnd)->current_target != NULL) && (szTx > 0)) {
+    pStats = pn53x_timing_stats_get(pnd, abtCmd[0], pbtTx[0]);
+    if ((res = pn53x_timing_apply(pnd)) < 0) {
+      pnd->last_error = res;
+      return pnd->last_error;
+    }
+    timeout = pn53x_timing_host_timeout_ms(pnd, pStats);
+    clock_gettime(CLOCK_MONOTONIC, &tsStart);
+  }
+
+  // Send the frame to the PN53X chip and get the answer
+  // We have to give the amount of bytes + (the two command bytes 0xD4, 0x42)
+  uint8_t  abtRx[PN53x_EXTENDED_FRAME__DATA_MAX_LEN];
+  // Answers chained by the target (MI) are gathered straight into a large
+  // enough caller buffer, the status byte first
+  uint8_t *pbtAnswer = ((pbtRx != NULL) && (szRx >= sizeof(abtRx))) ? pbtRx : abtRx;
+  res = pn53x_transceive(pnd, abtCmd, szTx - szSent + szExtraTxLen, pbtAnswer, (pbtAnswer == pbtRx) ? szRx : sizeof(abtRx), timeout);
+  if (pStats != NULL) {
+    struct timespec tsStop;
+    clock_gettime(CLOCK_MONOTONIC, &tsStop);
+    pn53x_timing_stats_update(pnd, pStats, res, (int)((tsStop.tv_sec - tsStart.tv_sec) * 1000000 + (tsStop.tv_nsec - tsStart.tv_nsec) / 1000));
+  }
+  if (res < 0) {
+    pnd->last_error = res;
+    return pnd->last_error;
+  }
+  const size_t szRxLen = (size_t)res - 1;
+  if (pbtRx != NULL) {
+    if (szRxLen >  szRx) {
+      log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "Buffer size is too short: %" PRIuPTR " available(s), %" PRIuPTR " needed", szRx, szRxLen);
+      return NFC_EOVFLOW;
+    }
+    // Copy the received bytes
+    memmove(pbtRx, pbtAnswer + 1, szRxLen);
+  }
+  // Everything went successful, we return received bytes count
+  return szRxLen;
+}
+
+int
+pn53x_initiator_transceive_bytes_target(struct nfc_device *pnd, const size_t szTarget, const uint8_t *pbtTx, const size_t szTx,
+                                        uint8_t *pbtRx, const size_t szRx, int timeout)
+{
+  if (szTarget >= CHIP_DATA(pnd)->szSessionTargets) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "Target %" PRIuPTR " is not activated", szTarget);
+    pnd->last_error = NFC_EINVARG;
+    return pnd->last_error;
+  }
+  // Only InDataExchange lets us choose the logical target
+  if (!pnd->bEasyFraming) {
+    pnd->last_error = NFC_EINVARG;
+    return pnd->last_error;
+  }
+  if (CHIP_DATA(pnd)->current_tg != szTarget + 1) {
+    memcpy(CHIP_DATA(pnd)->current_target, &(CHIP_DATA(pnd)->session_targets[szTarget]), sizeof(nfc_target));
+    CHIP_DATA(pnd)->current_tg = szTarget + 1;
+  }
+  return pn53x_initiator_transceive_bytes(pnd, pbtTx, szTx, pbtRx, szRx, timeout);
+}
+
+/*
+ * Split-phase commands
+ *
+ * A command submitted by one of the pn53x_*_submit() functions is sent at
+ * once, without waiting for anything: its ACK and its answer are gathered by
+ * pn53x_command_resume(), which an event loop calls whenever the file
+ * descriptor given by pn53x_get_event_fd() is readable or the timeout given
+ * by pn53x_get_event_timeout() expires. The frames chained to the target and
+ * the answers chained by the target (MI) are carried the same way, one chip
+ * command after the other. Only the transports which gather the frames
+ * without blocking support them (see struct pn53x_io).
+ *
+ * Settings still go through blocking commands: the registers left to write
+ * back, the bit framing and the RF timeout of the adaptive timeouts are
+ * written before the command is sent, when they change.
+ */
+typedef enum {
+  PCO_NONE = 0,
+  PCO_TRANSCEIVE_BYTES,
+  PCO_SELECT_PASSIVE_TARGET,
+  PCO_POLL_TARGET,
+  PCO_PROBE_TARGET,
+} pn53x_command_op;
+
+struct pn53x_command {
+  pn53x_command_op op;
+  /** The chip did ACK the last chip command */
+  bool bAcked;
+  /** Done (or cancelled) with iResult, until pn53x_command_resume() tells it */
+  bool bDone;
+  int iResult;
+  /** Timeout of each chip command and its deadline, 0 without any */
+  int iTimeout;
+  nfc_deadline deadline;
+  /** Last chip command sent, kept for the MI follow-ups */
+  uint8_t abtCmd[PN53x_EXTENDED_FRAME__DATA_MAX_LEN];
+  /** Answer gathered so far, the status byte first */
+  uint8_t abtRx[PN53x_EXTENDED_FRAME__DATA_MAX_LEN];
+  size_t szRx;
+  /** Bytes to the target, how many of them are sent and where the answer goes (transceive) */
+  const uint8_t *pbtTx;
+  size_t szTx;
+  size_t szSent;
+  uint8_t *pbtRx;
+  size_t szRxLen;
+  /** Where the target found goes (select, poll) */
+  nfc_target *pnt;
+  nfc_modulation nm;
+  /** Response time statistics to update, and when the last chip command was sent */
+  struct pn53x_timing_stats *pStats;
+  int64_t i64Start;
+  /** Probe: its chip command length, the answer length expected, the attempts left */
+  size_t szProbe;
+  size_t szProbeRx;
+  int iProbeAttempts;
+  /** Probe: a timeout means the target left (PN533 pinging ISO14443-4A targets) */
+  bool bProbeTimeoutReleased;
+};
+
+/*
+ * Get the split-phase command ready for a new submission, when the transport
+ * supports it and no other one is running.
+ */
+static struct pn53x_command *
+pn53x_command_new(struct nfc_device *pnd)
+{
+  const struct pn53x_io *io = CHIP_DATA(pnd)->io;
+
+  if (!io->get_fd || !io->send_frame || !io->send_ack || !io->receive_frame) {
+    pnd->last_error = NFC_EDEVNOTSUPP;
+    return NULL;
+  }
+  if (CHIP_DATA(pnd)->command == NULL) {
+    if ((CHIP_DATA(pnd)->command = malloc(sizeof(struct pn53x_command))) == NULL) {
+      pnd->last_error = NFC_ESOFT;
+      return NULL;
+    }
+  } else if (CHIP_DATA(pnd)->command->op != PCO_NONE) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "A split-phase command is already running");
+    pnd->last_error = NFC_ESOFT;
+    return NULL;
+  }
+  memset(CHIP_DATA(pnd)->command, 0x00, sizeof(struct pn53x_command));
+  return CHIP_DATA(pnd)->command;
+}
+
+/*
+ * Send the szCmd first bytes of the chip command held by the split-phase
+ * command, without waiting for its ACK.
+ */
+static int
+pn53x_command_send(struct nfc_device *pnd, const size_t szCmd)
+{
+  struct pn53x_command *pc = CHIP_DATA(pnd)->command;
+  int res = 0;
+
+  if (CHIP_DATA(pnd)->wb_trigged) {
+    if ((res = pn53x_writeback_register(pnd)) < 0) {
+      return res;
+    }
+  }
+
+  PNCMD_TRACE(pc->abtCmd[0]);
+  CHIP_DATA(pnd)->iCollisionBits = -1;
+  pc->bAcked = false;
+  if ((res = CHIP_DATA(pnd)->io->send_frame(pnd, pc->abtCmd, szCmd)) < 0) {
+    return res;
+  }
+  CHIP_DATA(pnd)->last_command = pc->abtCmd[0];
+  return NFC_SUCCESS;
+}
+
+/*
+ * Send the next part of the bytes to the target: like
+ * pn53x_initiator_transceive_bytes(), InDataExchange chains the frames longer
+ * than PN53x_IN_DATA__MAX_LEN.
+ */
+static int
+pn53x_command_send_data(struct nfc_device *pnd)
+{
+  struct pn53x_command *pc = CHIP_DATA(pnd)->command;
+  size_t szCmd;
+
+  if (pnd->bEasyFraming) {
+    const size_t szPart = MIN(pc->szTx - pc->szSent, PN53x_IN_DATA__MAX_LEN);
+    pc->abtCmd[0] = InDataExchange;
+    pc->abtCmd[1] = CHIP_DATA(pnd)->current_tg | ((pc->szTx - pc->szSent > PN53x_IN_DATA__MAX_LEN) ? 0x40 : 0x00);
+    memcpy(pc->abtCmd + 2, pc->pbtTx + pc->szSent, szPart);
+    szCmd = szPart + 2;
+    pc->szSent += szPart;
+  } else {
+    pc->abtCmd[0] = InCommunicateThru;
+    memcpy(pc->abtCmd + 1, pc->pbtTx, pc->szTx);
+    szCmd = pc->szTx + 1;
+    pc->szSent = pc->szTx;
+  }
+  pc->szRx = 0;
+  pc->deadline = nfc_deadline_from_timeout(pc->iTimeout);
+  pc->i64Start = nfc_monotonic_us();
+  return pn53x_command_send(pnd, szCmd);
+}
+
+/*
+ * Send the probe held by the split-phase command (again).
+ */
+static int
+pn53x_command_send_probe(struct nfc_device *pnd)
+{
+  struct pn53x_command *pc = CHIP_DATA(pnd)->command;
+
+  pc->szRx = 0;
+  pc->deadline = nfc_deadline_from_timeout(pc->iTimeout);
+  return pn53x_command_send(pnd, pc->szProbe);
+}
+
+/*
+ * The split-phase command is over with res: finish what is left of it.
+ */
+static void
+pn53x_command_complete(struct nfc_device *pnd, int res)
+{
+  struct pn53x_command *pc = CHIP_DATA(pnd)->command;
+
+  switch (pc->op) {
+    case PCO_TRANSCEIVE_BYTES:
+      if ((res >= 0) && (pc->szSent < pc->szTx)) {
+        // The target got this part, send it the next one
+        if ((res = pn53x_command_send_data(pnd)) >= 0)
+          return;
+        break;
+      }
+      if (pc->pStats != NULL) {
+        pn53x_timing_stats_update(pnd, pc->pStats, res, (int)(nfc_monotonic_us() - pc->i64Start));
+      }
+      if (res >= 0) {
+        const size_t szRxLen = (size_t)res - 1;
+        if (pc->pbtRx != NULL) {
+          if (szRxLen > pc->szRxLen) {
+            log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "Buffer size is too short: %" PRIuPTR " available(s), %" PRIuPTR " needed", pc->szRxLen, szRxLen);
+            res = NFC_EOVFLOW;
+            break;
+          }
+          memcpy(pc->pbtRx, pc->abtRx + 1, szRxLen);
+        }
+        res = (int) szRxLen;
+      }
+      break;
+    case PCO_SELECT_PASSIVE_TARGET:
+      if (res >= 0) {
+        // Like pn53x_initiator_select_passive_target_ext() on InListPassiveTarget
+        if ((pc->szRx <= 1) || (pc->abtRx[0] == 0)) {
+          res = 0;
+          break;
+        }
+        nfc_target nttmp;
+        memset(&nttmp, 0x00, sizeof(nfc_target));
+        nttmp.nm = pc->nm;
+        if ((res = pn53x_decode_target_data(pc->abtRx + 1, pc->szRx - 1, CHIP_DATA(pnd)->type, pc->nm.nmt, &(nttmp.nti))) < 0)
+          break;
+        if (pn53x_current_target_new(pnd, &nttmp) == NULL) {
+          res = NFC_ESOFT;
+          break;
+        }
+        if (pc->pnt) {
+          memcpy(pc->pnt, &nttmp, sizeof(nfc_target));
+        }
+        res = pc->abtRx[0];
+      }
+      break;
+    case PCO_POLL_TARGET:
+      if (res >= 0) {
+        nfc_target ntTargets[2];
+        memset(ntTargets, 0x00, sizeof(nfc_target) * 2);
+        if ((res = pn53x_InAutoPoll_decode(pnd, pc->abtRx, pc->szRx, ntTargets)) >= 0)
+          res = pn53x_poll_target_found(pnd, res, ntTargets, pc->pnt);
+      }
+      break;
+    case PCO_PROBE_TARGET:
+      // Like the pn53x_*_is_present() functions: only a timeout of the target tells it left
+      if ((res >= 1) && ((size_t) res - 1 >= pc->szProbeRx)) {
+        res = NFC_SUCCESS;
+        break;
+      }
+      if (((res == NFC_ERFTRANS) && (CHIP_DATA(pnd)->last_status_byte == 0x01)) ||
+          ((res == NFC_ETIMEOUT) && pc->bProbeTimeoutReleased)) {
+        res = NFC_ETGRELEASED;
+      } else if (--pc->iProbeAttempts > 0) {
+        // Other errors can appear when card is tired-off, let's try again
+        if ((res = pn53x_command_send_probe(pnd)) >= 0)
+          return;
+      } else if (res >= 0) {
+        // Not the answer expected (FeliCa), which is reported as a release
+        res = NFC_ETGRELEASED;
+      }
+      if (res == NFC_ETGRELEASED)
+        pn53x_current_target_free(pnd);
+      break;
+    case PCO_NONE:
+      break;
+  }
+  pc->bDone = true;
+  pc->iResult = res;
+}
+
+/*
+ * Handle an answer of the chip (szFrame bytes at pbtFrame) to the split-phase
+ * command, like pn53x_transceive() does.
+ */
+static void
+pn53x_command_answer(struct nfc_device *pnd, const uint8_t *pbtFrame, const size_t szFrame)
+{
+  struct pn53x_command *pc = CHIP_DATA(pnd)->command;
+  bool mi = false;
+  int res;
+
+  if (pc->szRx == 0) {
+    memcpy(pc->abtRx, pbtFrame, szFrame);
+    pc->szRx = szFrame;
+    mi = pn53x_status_byte(pnd, pc->abtCmd, pc->abtRx);
+  } else if (szFrame > 0) {
+    // Part of an answer chained by the target, after its status byte
+    mi = pbtFrame[0] & 0x40;
+    if (pc->szRx + szFrame - 1 > sizeof(pc->abtRx)) {
+      CHIP_DATA(pnd)->last_status_byte = ESMALLBUF;
+      mi = false;
+    } else {
+      memcpy(pc->abtRx + pc->szRx, pbtFrame + 1, szFrame - 1);
+      // Copy last status byte
+      pc->abtRx[0] = pbtFrame[0];
+      pc->szRx += szFrame - 1;
+    }
+  }
+
+  if (mi) {
+    // Send empty command to card (target number included, TgGetData has none)
+    if ((res = pn53x_command_send(pnd, (pc->abtCmd[0] == TgGetData) ? 1 : 2)) < 0)
+      pn53x_command_complete(pnd, res);
+    return;
+  }
+
+  if ((res = pn53x_status_error(pnd, pc->szRx)) < 0) {
+    // A bit collision is not read back here: pn53x_initiator_last_collision() can not locate it
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "Chip error: \"%s\" (%02x), returned error: %d", pn53x_strerror(pnd), CHIP_DATA(pnd)->last_status_byte, res);
+  }
+  pn53x_command_complete(pnd, res);
+}
+
+int
+pn53x_initiator_transceive_bytes_submit(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx,
+                                        uint8_t *pbtRx, const size_t szRx, int timeout)
+{
+  struct pn53x_command *pc;
+  int res = 0;
+
+  // We can not just send bytes without parity if while the PN53X expects we handled them
+  if (!pnd->bPar) {
+    pnd->last_error = NFC_EINVARG;
+    return pnd->last_error;
+  }
+  if (!pnd->bEasyFraming && (szTx > PN53x_EXTENDED_FRAME__DATA_MAX_LEN - 1)) {
+    pnd->last_error = NFC_EOVFLOW;
+    return pnd->last_error;
+  }
+  if ((pc = pn53x_command_new(pnd)) == NULL)
+    return pnd->last_error;
+
+  // To transfer command frames bytes we can not have any leading bits, reset this to zero
+  if ((res = pn53x_set_tx_bits(pnd, 0)) < 0) {
+    pnd->last_error = res;
+    return pnd->last_error;
+  }
+
+  // Without an explicit timeout, use the one learnt from the target if asked to
+  if ((timeout == -1) && CHIP_DATA(pnd)->adaptive_timeout && (CHIP_DATA(pnd)->current_target != NULL) && (szTx > 0)) {
+    pc->pStats = pn53x_timing_stats_get(pnd, pnd->bEasyFraming ? InDataExchange : InCommunicateThru, pbtTx[0]);
+    if ((res = pn53x_timing_apply(pnd)) < 0) {
+      pnd->last_error = res;
+      return pnd->last_error;
+    }
+    timeout = pn53x_timing_host_timeout_ms(pnd, pc->pStats);
+  } else if (timeout == -1) {
+    timeout = CHIP_DATA(pnd)->timeout_command;
+  }
+
+  pc->op = PCO_TRANSCEIVE_BYTES;
+  pc->iTimeout = timeout;
+  pc->pbtTx = pbtTx;
+  pc->szTx = szTx;
+  pc->pbtRx = pbtRx;
+  pc->szRxLen = szRx;
+  if ((res = pn53x_command_send_data(pnd)) < 0) {
+    pc->op = PCO_NONE;
+    pnd->last_error = res;
+    return pnd->last_error;
+  }
+  return NFC_SUCCESS;
+}
+
+int
+pn53x_initiator_select_passive_target_submit(struct nfc_device *pnd, const nfc_modulation nm,
+                                             const uint8_t *pbtInitData, const size_t szInitData, nfc_target *pnt)
+{
+  struct pn53x_command *pc;
+  int res = 0;
+
+  // Only InListPassiveTarget alone does the job, see pn53x_initiator_select_passive_target_ext()
+  if ((nm.nmt == NMT_ISO14443BI) || (nm.nmt == NMT_ISO14443B2SR) || (nm.nmt == NMT_ISO14443B2CT) || (nm.nmt == NMT_ISO14443BICLASS) ||
+      (nm.nmt == NMT_BARCODE) || ((nm.nmt == NMT_ISO14443A) && ((nm.nbr != NBR_106) || pnd->bAutoPps))) {
+    pnd->last_error = NFC_EDEVNOTSUPP;
+    return pnd->last_error;
+  }
+  const pn53x_modulation pm = pn53x_nm_to_pm(nm);
+  if ((PM_UNDEFINED == pm) || (NBR_UNDEFINED == nm.nbr) || (szInitData > 12)) {
+    pnd->last_error = NFC_EINVARG;
+    return pnd->last_error;
+  }
+  if ((pc = pn53x_command_new(pnd)) == NULL)
+    return pnd->last_error;
+  if ((res = pn53x_InListPassiveTarget_frame(pnd, pm, 1, pbtInitData, szInitData, pc->abtCmd)) < 0)
+    return res;
+
+  pc->op = PCO_SELECT_PASSIVE_TARGET;
+  pc->nm = nm;
+  pc->pnt = pnt;
+  pc->deadline = nfc_deadline_from_timeout(300);
+  if ((res = pn53x_command_send(pnd, (size_t) res)) < 0) {
+    pc->op = PCO_NONE;
+    pnd->last_error = res;
+    return pnd->last_error;
+  }
+  return NFC_SUCCESS;
+}
+
+int
+pn53x_initiator_poll_target_submit(struct nfc_device *pnd,
+                                   const nfc_modulation *pnmModulations, const size_t szModulations,
+                                   const uint8_t uiPollNr, const uint8_t uiPeriod,
+                                   nfc_target *pnt)
+{
+  pn53x_target_type apttTargetTypes[32];
+  struct pn53x_command *pc;
+  int szTargetTypes;
+  int res = 0;
+
+  // Only the PN532 polls on its own (InAutoPoll), the others are driven by the host
+  if (CHIP_DATA(pnd)->type != PN532) {
+    pnd->last_error = NFC_EDEVNOTSUPP;
+    return pnd->last_error;
+  }
+  if ((szTargetTypes = pn53x_poll_target_types(pnd, pnmModulations, szModulations, apttTargetTypes)) < 0)
+    return szTargetTypes;
+  if (szTargetTypes > 15) {
+    pnd->last_error = NFC_EINVARG;
+    return pnd->last_error;
+  }
+  if ((pc = pn53x_command_new(pnd)) == NULL)
+    return pnd->last_error;
+
+  // InAutoPoll frame looks like this { 0xd4, 0x60, 0x0f, 0x01, 0x00 } => { direction, command, pollnr, period, types... }
+  pc->abtCmd[0] = InAutoPoll;
+  pc->abtCmd[1] = uiPollNr;
+  pc->abtCmd[2] = uiPeriod;
+  for (int n = 0; n < szTargetTypes; n++) {
+    pc->abtCmd[3 + n] = apttTargetTypes[n];
+  }
+  pc->op = PCO_POLL_TARGET;
+  pc->pnt = pnt;
+  if ((res = pn53x_command_send(pnd, 3 + (size_t) szTargetTypes)) < 0) {
+    pc->op = PCO_NONE;
+    pnd->last_error = res;
+    return pnd->last_error;
+  }
+  return NFC_SUCCESS;
+}
+
+/**
+ * @brief Submit the cheapest presence check of the selected target
+ *
+ * One frame is enough, which the chip or the target answers without losing
+ * its state: Diagnose 0x06 (card presence detection) where the chip handles
+ * it, otherwise R(NAK) for ISO14443-4 targets, READ for MIFARE Ultralight,
+ * ATTRIB for ISO14443-B', RID for Jewel, Request Response for FeliCa... The
+ * MIFARE Classic targets are checked with Diagnose 0x06 too, so that their
+ * authentication is kept, unlike with a new selection.
+ *
+ * The command is over with NFC_SUCCESS when the target answered, or with
+ * NFC_ETGRELEASED once it left (the selected target is then forgotten).
+ *
+ * @return NFC_EDEVNOTSUPP for the targets checked with several frames
+ * (Barcode, iClass), or when the chip can not check MIFARE Classic Mini.
+ */
+int
+pn53x_initiator_target_probe_submit(struct nfc_device *pnd, const nfc_target *pnt)
+{
+  const nfc_target *pntCurrent = CHIP_DATA(pnd)->current_target;
+  const pn53x_type type = CHIP_DATA(pnd)->type;
+  uint8_t abtProbe[10];
+  size_t szProbe = 0;
+  size_t szProbeRx = 1;
+  bool bDiagnose = false;
+  bool bRaw = !pnd->bEasyFraming;
+  bool bTimeoutReleased = false;
+  int iAttempts = 2;
+  int timeout = 300;
+  struct pn53x_command *pc;
+  int res = 0;
+
+  if (pntCurrent == NULL) {
+    pnd->last_error = NFC_EINVARG;
+    return pnd->last_error;
+  }
+  if ((pnt != NULL) && (!pn53x_current_target_is(pnd, pnt))) {
+    pnd->last_error = NFC_ETGRELEASED;
+    return pnd->last_error;
+  }
+
+  pnd->last_error = NFC_EDEVNOTSUPP;
+  switch (pntCurrent->nm.nmt) {
+    case NMT_ISO14443A:
+      if (pntCurrent->nti.nai.btSak & 0x20) {
+        if (type == PN533) {
+          bDiagnose = true;
+          // This happens e.g. when a JCOP31 is removed from PN533
+          bTimeoutReleased = true;
+        } else if ((type == PN531) || (type == PN532)) {
+          // Diagnose06 failed completely with a JCOP31 on a PN532: R(NAK), CID=0
+          abtProbe[0] = 0xb2;
+          szProbe = 1;
+          bRaw = true;
+        } else {
+          return pnd->last_error;
+        }
+      } else if ((pntCurrent->nti.nai.abtAtqa[0] == 0x00) && (pntCurrent->nti.nai.abtAtqa[1] == 0x44) &&
+                 (pntCurrent->nti.nai.btSak == 0x00)) {
+        if (type == PN533) {
+          bDiagnose = true;
+        } else {
+          // Limitation: test on MFULC non-authenticated with read of first sector forbidden will fail
+          abtProbe[0] = 0x30;
+          abtProbe[1] = 0x00;
+          szProbe = 2;
+          timeout = -1;
+        }
+      } else if (pntCurrent->nti.nai.btSak & 0x08) {
+        // MFC Mini (atqa0004/sak09) fails on PN533
+        if (((type != PN531) && (type != PN532) && (type != PN533)) || ((type == PN533) && (pntCurrent->nti.nai.btSak == 0x09)))
+          return pnd->last_error;
+        bDiagnose = true;
+      } else {
+        return pnd->last_error;
+      }
+      break;
+    case NMT_DEP:
+      if ((type != PN531) && (type != PN532) && (type != PN533))
+        return pnd->last_error;
+      bDiagnose = true;
+      break;
+    case NMT_FELICA:
+      // Request Response, answered with the IDm and the mode (11 bytes)
+      abtProbe[0] = 0x0A;
+      abtProbe[1] = 0x04;
+      memcpy(abtProbe + 2, pntCurrent->nti.nfi.abtId, 8);
+      szProbe = 10;
+      szProbeRx = 11;
+      iAttempts = 3;
+      break;
+    case NMT_JEWEL:
+      abtProbe[0] = 0x78;
+      szProbe = 1;
+      timeout = -1;
+      break;
+    case NMT_ISO14443B:
+      if (type == PN533) { // Not supported on PN532 even if the doc is same as for PN533
+        bDiagnose = true;
+      } else {
+        // R(NAK), CID=1
+        abtProbe[0] = 0xba;
+        abtProbe[1] = 0x01;
+        szProbe = 2;
+        bRaw = true;
+      }
+      break;
+    case NMT_ISO14443BI:
+      // ATTRIB
+      abtProbe[0] = 0x01;
+      abtProbe[1] = 0x0f;
+      memcpy(abtProbe + 2, pntCurrent->nti.nii.abtDIV, 4);
+      szProbe = 6;
+      bRaw = true;
+      break;
+    case NMT_ISO14443B2SR:
+      // Get_UID
+      abtProbe[0] = 0x0b;
+      szProbe = 1;
+      break;
+    case NMT_ISO14443B2CT:
+      // SELECT
+      abtProbe[0] = 0x9f;
+      memcpy(abtProbe + 1, pntCurrent->nti.nci.abtUID, 2);
+      szProbe = 3;
+      break;
+    case NMT_BARCODE:
+    case NMT_ISO14443BICLASS:
+      return pnd->last_error;
+  }
+
+  if ((pc = pn53x_command_new(pnd)) == NULL)
+    return pnd->last_error;
+  if (bDiagnose) {
+    // Card Presence command can take more time than default one, see pn53x_Diagnose06()
+    pc->abtCmd[0] = Diagnose;
+    pc->abtCmd[1] = 0x06;
+    pc->szProbe = 2;
+    timeout = 1000;
+  } else {
+    // To transfer command frames bytes we can not have any leading bits, reset this to zero
+    if ((res = pn53x_set_tx_bits(pnd, 0)) < 0) {
+      pnd->last_error = res;
+      return pnd->last_error;
+    }
+    if (bRaw) {
+      pc->abtCmd[0] = InCommunicateThru;
+      memcpy(pc->abtCmd + 1, abtProbe, szProbe);
+      pc->szProbe = szProbe + 1;
+    } else {
+      pc->abtCmd[0] = InDataExchange;
+      pc->abtCmd[1] = CHIP_DATA(pnd)->current_tg;
+      memcpy(pc->abtCmd + 2, abtProbe, szProbe);
+      pc->szProbe = szProbe + 2;
+    }
+    if (timeout == -1)
+      timeout = CHIP_DATA(pnd)->timeout_command;
+  }
+  pc->op = PCO_PROBE_TARGET;
+  pc->iTimeout = timeout;
+  pc->szProbeRx = bDiagnose ? 0 : szProbeRx;
+  pc->iProbeAttempts = iAttempts;
+  pc->bProbeTimeoutReleased = bTimeoutReleased;
+  if ((res = pn53x_command_send_probe(pnd)) < 0) {
+    pc->op = PCO_NONE;
+    pnd->last_error = res;
+    return pnd->last_error;
+  }
+  return NFC_SUCCESS;
+}
+
+/**
+ * @brief Go on with the split-phase command, with the frames received so far
+ *
+ * @param pbDone is set to true when the command is over, which this function
+ * then returns the result of (as the matching blocking function would)
+ * @return NFC_SUCCESS while it is running, otherwise the result of the command
+ */
+int
+pn53x_command_resume(struct nfc_device *pnd, bool *pbDone)
+{
+  struct pn53x_command *pc = CHIP_DATA(pnd)->command;
+  uint8_t abtFrame[PN53x_EXTENDED_FRAME__DATA_MAX_LEN];
+  size_t szFrame = 0;
+  int res = 0;
+
+  *pbDone = false;
+  if ((pc == NULL) || (pc->op == PCO_NONE))
+    return NFC_SUCCESS;
+
+  while (!pc->bDone) {
+    if ((res = CHIP_DATA(pnd)->io->receive_frame(pnd, abtFrame, sizeof(abtFrame), &szFrame)) < 0) {
+      pn53x_command_complete(pnd, res);
+    } else if (res == PF_ACK) {
+      pc->bAcked = true;
+    } else if (res == PF_DATA) {
+      if (!pc->bAcked) {
+        log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Unexpected PN53x reply!");
+        pn53x_command_complete(pnd, NFC_EIO);
+      } else {
+        pn53x_command_answer(pnd, abtFrame, szFrame);
+      }
+    } else {
+      if ((pc->deadline != 0) && (nfc_deadline_remaining(pc->deadline) < 0)) {
+        log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "%s", "Timeout");
+        // The chip gives the command up on an ACK
+        CHIP_DATA(pnd)->io->send_ack(pnd);
+        pn53x_command_complete(pnd, NFC_ETIMEOUT);
+      }
+      break;
+    }
+  }
+  if (!pc->bDone)
+    return NFC_SUCCESS;
+
+  *pbDone = true;
+  pc->op = PCO_NONE;
+  pnd->last_error = (pc->iResult < 0) ? pc->iResult : 0;
+  return pc->iResult;
+}
 
-  // Send the frame to the PN53X chip and get the answer
-  // We have to give the amount of bytes + (the two command bytes 0xD4, 0x42)
-  uint8_t  abtRx[PN53x_EXTENDED_FRAME__DATA_MAX_LEN];
-  if ((res = pn53x_transceive(pnd, abtCmd, szTx + szExtraTxLen, abtRx, sizeof(abtRx), timeout)) < 0) {
-    pnd->last_error = res;
+/**
+ * @brief Abort the split-phase command
+ *
+ * The chip gives it up on an ACK; pn53x_command_resume() then tells it is
+ * over with NFC_EOPABORTED.
+ */
+int
+pn53x_command_cancel(struct nfc_device *pnd)
+{
+  struct pn53x_command *pc = CHIP_DATA(pnd)->command;
+
+  if ((pc == NULL) || (pc->op == PCO_NONE) || pc->bDone)
+    return NFC_SUCCESS;
+  CHIP_DATA(pnd)->io->send_ack(pnd);
+  pc->bDone = true;
+  pc->iResult = NFC_EOPABORTED;
+  return NFC_SUCCESS;
+}
+
+/**
+ * @brief File descriptor which gets readable when pn53x_command_resume() has something to do
+ */
+int
+pn53x_get_event_fd(struct nfc_device *pnd)
+{
+  if (!CHIP_DATA(pnd)->io->get_fd) {
+    pnd->last_error = NFC_EDEVNOTSUPP;
     return pnd->last_error;
   }
-  const size_t szRxLen = (size_t)res - 1;
-  if (pbtRx != NULL) {
-    if (szRxLen >  szRx) {
-      log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "Buffer size is too short: %" PRIuPTR " available(s), %" PRIuPTR " needed", szRx, szRxLen);
-      return NFC_EOVFLOW;
-    }
-    // Copy the received bytes
-    memcpy(pbtRx, abtRx + 1, szRxLen);
-  }
-  // Everything went successful, we return received bytes count
-  return szRxLen;
+  return CHIP_DATA(pnd)->io->get_fd(pnd);
+}
+
+/**
+ * @brief Time (ms) left before pn53x_command_resume() must run even without any event
+ * @return -1 when it only waits for the file descriptor, 0 when it is already due
+ */
+int
+pn53x_get_event_timeout(struct nfc_device *pnd)
+{
+  struct pn53x_command *pc = CHIP_DATA(pnd)->command;
+
+  if ((pc == NULL) || (pc->op == PCO_NONE))
+    return -1;
+  if (pc->bDone)
+    return 0;
+  if (pc->deadline == 0)
+    return -1;
+  const int res = nfc_deadline_remaining(pc->deadline);
+  return (res < 0) ? 0 : res;
 }
 
 static void __pn53x_init_timer(struct nfc_device *pnd, const uint32_t max_cycles)
@@ -2109,8 +3759,9 @@ static int pn53x_ISO14443A_4_is_present(struct nfc_device *pnd)
       pn53x_transceive(pnd, abtCmd, sizeof(abtCmd), NULL, 0, 2000);
       ret = NFC_ETGRELEASED;
     }
-  } else if (CHIP_DATA(pnd)->type == PN532) {
+  } else if ((CHIP_DATA(pnd)->type == PN531) || (CHIP_DATA(pnd)->type == PN532)) {
     // Diagnose06 failed completely with a JCOP31 on a PN532 so let's do it manually
+    // PN531 can not ping ISO14443-4 targets either, R(NAK) works the same way
     if ((ret = pn53x_set_property_bool(pnd, NP_EASY_FRAMING, false)) < 0)
       return ret;
     uint8_t abtCmd[1] = {0xb2}; // CID=0
@@ -2220,27 +3871,14 @@ static int pn53x_ISO14443A_MFC_is_present(struct nfc_device *pnd)
 {
   int ret;
   log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "%s", "target_is_present(): Ping MFC");
-  if ((CHIP_DATA(pnd)->type == PN533) && (CHIP_DATA(pnd)->current_target->nti.nai.btSak != 0x09)) {
+  if (((CHIP_DATA(pnd)->type == PN531) || (CHIP_DATA(pnd)->type == PN532)) ||
+      ((CHIP_DATA(pnd)->type == PN533) && (CHIP_DATA(pnd)->current_target->nti.nai.btSak != 0x09))) {
     // MFC Mini (atqa0004/sak09) fails on PN533, so we exclude it
+    // The chip checks the presence itself, which keeps the authentication
     ret = pn53x_Diagnose06(pnd);
   } else {
     // Limitation: re-select will lose authentication of already authenticated sector
-    bool bInfiniteSelect = pnd->bInfiniteSelect;
-    uint8_t pbtInitiatorData[12];
-    size_t szInitiatorData = 0;
-    iso14443_cascade_uid(CHIP_DATA(pnd)->current_target->nti.nai.abtUid, CHIP_DATA(pnd)->current_target->nti.nai.szUidLen, pbtInitiatorData, &szInitiatorData);
-    if ((ret = pn53x_set_property_bool(pnd, NP_INFINITE_SELECT, false)) < 0)
-      return ret;
-    if ((ret = pn53x_initiator_select_passive_target_ext(pnd, CHIP_DATA(pnd)->current_target->nm, pbtInitiatorData, szInitiatorData, NULL, 300)) == 1) {
-      ret = NFC_SUCCESS;
-    } else if ((ret == 0) || (ret == NFC_ETIMEOUT)) {
-      ret = NFC_ETGRELEASED;
-    }
-    if (bInfiniteSelect) {
-      int ret2;
-      if ((ret2 = pn53x_set_property_bool(pnd, NP_INFINITE_SELECT, true)) < 0)
-        return ret2;
-    }
+    ret = pn53x_initiator_target_reactivate(pnd, NULL);
   }
   return ret;
 }
@@ -2473,13 +4111,185 @@ pn53x_initiator_target_is_present(struct nfc_device *pnd, const nfc_target *pnt)
   return pnd->last_error = ret;
 }
 
+int
+pn53x_initiator_target_upgrade_bit_rate(struct nfc_device *pnd, nfc_target *pnt)
+{
+  int res;
+
+  if (CHIP_DATA(pnd)->current_target == NULL) {
+    return pnd->last_error = NFC_EINVARG;
+  }
+  if ((pnt != NULL) && (!pn53x_current_target_is(pnd, pnt))) {
+    return pnd->last_error = NFC_ETGRELEASED;
+  }
+  if (CHIP_DATA(pnd)->current_target->nm.nmt != NMT_ISO14443A) {
+    return pnd->last_error = NFC_EDEVNOTSUPP;
+  }
+  if ((res = pn53x_ISO14443A_4_pps(pnd, CHIP_DATA(pnd)->current_tg, CHIP_DATA(pnd)->current_target)) < 0) {
+    return pnd->last_error = res;
+  }
+  // Keep the copies of the target in sync
+  const nfc_baud_rate nbr = CHIP_DATA(pnd)->current_target->nm.nbr;
+  if ((CHIP_DATA(pnd)->szSessionTargets > 0) && (CHIP_DATA(pnd)->current_tg <= CHIP_DATA(pnd)->szSessionTargets)) {
+    CHIP_DATA(pnd)->session_targets[CHIP_DATA(pnd)->current_tg - 1].nm.nbr = nbr;
+  }
+  if (pnt != NULL) {
+    pnt->nm.nbr = nbr;
+  }
+  return pnd->last_error = NFC_SUCCESS;
+}
+
+#define SAK_MIFARE_CLASSIC       0x08
 #define SAK_ISO14443_4_COMPLIANT 0x20
 #define SAK_ISO18092_COMPLIANT   0x40
+
+static int
+pn53x_ISO14443A_reactivate_error(struct nfc_device *pnd, const int res)
+{
+  // No answer at all (chip timeout): the target has left the field
+  if ((res == NFC_ERFTRANS) && (CHIP_DATA(pnd)->last_status_byte == 0x01))
+    return NFC_ETGRELEASED;
+  return res;
+}
+
+/*
+ * Wake an ISO14443A target up and select it again from its known UID:
+ * WUPA then one SELECT per cascade level, without anticollision loop.
+ * Returns the final SAK or a negative error code.
+ */
+static int
+pn53x_ISO14443A_reactivate(struct nfc_device *pnd, const nfc_iso14443a_info *pnai)
+{
+  const uint8_t abtWupa[1] = { 0x52 };
+  const uint8_t abtSel[3] = { 0x93, 0x95, 0x97 };
+  uint8_t abtCascadedUid[12];
+  size_t szCascadedUid;
+  uint8_t abtRx[PN53x_EXTENDED_FRAME__DATA_MAX_LEN];
+  uint8_t abtCrc[2];
+  uint8_t btSak = 0;
+  int res;
+
+  if ((res = pn53x_initiator_transceive_bits(pnd, abtWupa, 7, NULL, abtRx, NULL)) < 0) {
+    // Several targets answering at once is fine, SELECT will single ours out
+    if ((res != NFC_ERFTRANS) || (CHIP_DATA(pnd)->iCollisionBits < 0))
+      return pn53x_ISO14443A_reactivate_error(pnd, res);
+  }
+
+  iso14443_cascade_uid(pnai->abtUid, pnai->szUidLen, abtCascadedUid, &szCascadedUid);
+  for (size_t szLevel = 0; (szLevel * 4) < szCascadedUid; szLevel++) {
+    uint8_t abtSelect[9] = { abtSel[szLevel], 0x70 };
+    memcpy(abtSelect + 2, abtCascadedUid + (szLevel * 4), 4);
+    abtSelect[6] = abtSelect[2] ^ abtSelect[3] ^ abtSelect[4] ^ abtSelect[5];
+    iso14443a_crc_append(abtSelect, 7);
+    if ((res = pn53x_initiator_transceive_bytes(pnd, abtSelect, sizeof(abtSelect), abtRx, sizeof(abtRx), -1)) < 0)
+      return pn53x_ISO14443A_reactivate_error(pnd, res);
+    // SAK + CRC_A
+    if (res != 3)
+      return NFC_EIO;
+    iso14443a_crc(abtRx, 1, abtCrc);
+    if ((abtCrc[0] != abtRx[1]) || (abtCrc[1] != abtRx[2]))
+      return NFC_EIO;
+    btSak = abtRx[0];
+    // Cascade bit has to be set on all but the last level
+    const bool bCascade = ((szLevel + 1) * 4) < szCascadedUid;
+    if (((btSak & 0x04) != 0) != bCascade)
+      return NFC_EIO;
+  }
+  return btSak;
+}
+
+int
+pn53x_initiator_target_reactivate(struct nfc_device *pnd, nfc_target *pnt)
+{
+  int res, res2;
+  const nfc_target *pntKnown = (pnt != NULL) ? pnt : CHIP_DATA(pnd)->current_target;
+
+  if (pntKnown == NULL) {
+    return pnd->last_error = NFC_EINVARG;
+  }
+  if ((pntKnown->nm.nmt != NMT_ISO14443A) || (pntKnown->nti.nai.szUidLen == 0)) {
+    return pnd->last_error = NFC_EDEVNOTSUPP;
+  }
+  const bool bCurrent = (pnt == NULL) || pn53x_current_target_is(pnd, pnt);
+  nfc_target nt = *pntKnown;
+  // Selection always happens at 106 kbps, former PPS is lost
+  nt.nm.nbr = NBR_106;
+
+  // RATS is needed here and the chip has to send it itself, otherwise it
+  // would not follow the ISO14443-4 block numbers. MIFARE Classic commands
+  // rely on the UID the chip learnt when selecting: the chip has to select
+  // a target it does not know yet. Both take the regular path.
+  if ((pnd->bAutoIso14443_4 && (nt.nti.nai.btSak & SAK_ISO14443_4_COMPLIANT)) ||
+      (!bCurrent && (nt.nti.nai.btSak & SAK_MIFARE_CLASSIC))) {
+    uint8_t abtInitiatorData[12];
+    size_t szInitiatorData;
+    const bool bInfiniteSelect = pnd->bInfiniteSelect;
+    iso14443_cascade_uid(nt.nti.nai.abtUid, nt.nti.nai.szUidLen, abtInitiatorData, &szInitiatorData);
+    if ((res = pn53x_set_property_bool(pnd, NP_INFINITE_SELECT, false)) < 0)
+      return pnd->last_error = res;
+    if ((res = pn53x_initiator_select_passive_target_ext(pnd, nt.nm, abtInitiatorData, szInitiatorData, &nt, 300)) == 1) {
+      res = NFC_SUCCESS;
+      if (pnt != NULL)
+        *pnt = nt;
+    } else if ((res == 0) || (res == NFC_ETIMEOUT)) {
+      res = NFC_ETGRELEASED;
+    }
+    if (bInfiniteSelect && ((res2 = pn53x_set_property_bool(pnd, NP_INFINITE_SELECT, true)) < 0) && (res == NFC_SUCCESS))
+      res = res2;
+    return pnd->last_error = res;
+  }
+
+  const bool bCrc = pnd->bCrc;
+  const bool bPar = pnd->bPar;
+  const bool bEasyFraming = pnd->bEasyFraming;
+  const bool bForceIso14443a = pnd->bForceIso14443a;
+  const bool bForceIso14443b = pnd->bForceIso14443b;
+  const bool bForceSpeed106 = pnd->bForceSpeed106;
+  // A former MIFARE Classic authentication would cipher WUPA and SELECT
+  if (((res = pn53x_set_property_bool(pnd, NP_ACTIVATE_CRYPTO1, false)) < 0) ||
+      ((res = pn53x_set_property_bool(pnd, NP_FORCE_ISO14443_A, true)) < 0) ||
+      ((res = pn53x_set_property_bool(pnd, NP_FORCE_SPEED_106, true)) < 0) ||
+      ((res = pn53x_set_property_bool(pnd, NP_HANDLE_CRC, false)) < 0) ||
+      ((res = pn53x_set_property_bool(pnd, NP_HANDLE_PARITY, true)) < 0) ||
+      ((res = pn53x_set_property_bool(pnd, NP_EASY_FRAMING, false)) < 0)) {
+    goto restore;
+  }
+  if ((res = pn53x_ISO14443A_reactivate(pnd, &(nt.nti.nai))) < 0)
+    goto restore;
+  nt.nti.nai.btSak = (uint8_t)res;
+  res = NFC_SUCCESS;
+
+  // The chip still knows the target from its former selection, keep ours in sync
+  if (bCurrent) {
+    CHIP_DATA(pnd)->current_target->nm.nbr = nt.nm.nbr;
+    CHIP_DATA(pnd)->current_target->nti.nai.btSak = nt.nti.nai.btSak;
+  } else if (pn53x_current_target_new(pnd, &nt) == NULL) {
+    res = NFC_ESOFT;
+    goto restore;
+  }
+  if (pnt != NULL)
+    *pnt = nt;
+
+restore:
+  // Releasing a forced framing or speed does not touch the chip, forcing does
+  if (((res2 = pn53x_set_property_bool(pnd, NP_HANDLE_CRC, bCrc)) < 0) ||
+      ((res2 = pn53x_set_property_bool(pnd, NP_HANDLE_PARITY, bPar)) < 0) ||
+      ((res2 = pn53x_set_property_bool(pnd, NP_EASY_FRAMING, bEasyFraming)) < 0) ||
+      ((res2 = pn53x_set_property_bool(pnd, NP_FORCE_ISO14443_A, bForceIso14443a)) < 0) ||
+      ((res2 = pn53x_set_property_bool(pnd, NP_FORCE_ISO14443_B, bForceIso14443b)) < 0) ||
+      ((res2 = pn53x_set_property_bool(pnd, NP_FORCE_SPEED_106, bForceSpeed106)) < 0)) {
+    if (res == NFC_SUCCESS)
+      res = res2;
+  }
+  return pnd->last_error = res;
+}
+
 int
 // TODO: FIX THIS FUNCTION -> SEGMENTATION FAULT
 pn53x_target_init(struct nfc_device *pnd, nfc_target *pnt, uint8_t *pbtRx, const size_t szRxLen, int timeout)
 {
   pn53x_reset_settings(pnd);
+  pn53x_picc_stop(pnd);
 
   CHIP_DATA(pnd)->operating_mode = TARGET;
 
@@ -2695,6 +4505,11 @@ pn53x_target_init(struct nfc_device *pnd, nfc_target *pnt, uint8_t *pbtRx, const
         // When PN532 is in PICC target mode, it automatically reply to RATS so
         // we don't need to forward this command
         szRx = 0;
+      } else if (pnd->bEasyFraming && (pnt->nm.nmt == NMT_ISO14443A) && (pnt->nti.nai.btSak & SAK_ISO14443_4_COMPLIANT)) {
+        // Other chips leave ISO/IEC 14443-4 to the host, which answers RATS itself
+        if ((res = pn53x_picc_start(pnd, pnt, pbtRx, szRx, timeout)) < 0)
+          return res;
+        szRx = res;
       }
     }
   }
@@ -2750,7 +4565,7 @@ pn53x_target_receive_bits(struct nfc_device *pnd, uint8_t *pbtRx, const size_t s
 int
 pn53x_target_receive_bytes(struct nfc_device *pnd, uint8_t *pbtRx, const size_t szRxLen, int timeout)
 {
-  uint8_t  abtCmd[1];
+  uint8_t  abtCmd[1] = { TgGetInitiatorCommand };
 
   // XXX I think this is not a clean way to provide some kind of "EasyFraming"
   // but at the moment I have no more better than this
@@ -2767,9 +4582,8 @@ pn53x_target_receive_bytes(struct nfc_device *pnd, uint8_t *pbtRx, const size_t
             abtCmd[0] = TgGetData;
             break;
           } else {
-            // TODO Support EasyFraming for other cases by software
-            pnd->last_error = NFC_ENOTIMPL;
-            return pnd->last_error;
+            // ISO/IEC 14443-4 blocks are handled by the host
+            return pn53x_picc_receive_bytes(pnd, pbtRx, szRxLen, timeout);
           }
         }
         abtCmd[0] = TgGetInitiatorCommand;
@@ -2793,6 +4607,15 @@ pn53x_target_receive_bytes(struct nfc_device *pnd, uint8_t *pbtRx, const size_t
   uint8_t abtRx[PN53x_EXTENDED_FRAME__DATA_MAX_LEN];
   size_t szRx = sizeof(abtRx);
   int res = 0;
+  if ((abtCmd[0] == TgGetData) && (szRxLen >= sizeof(abtRx))) {
+    // Frames chained by the initiator (MI) are gathered straight into the
+    // caller buffer, e.g. for extended length APDUs; the status byte comes first
+    if ((res = pn53x_transceive(pnd, abtCmd, sizeof(abtCmd), pbtRx, szRxLen, timeout)) < 0)
+      return pnd->last_error;
+    szRx = (size_t) res - 1;
+    memmove(pbtRx, pbtRx + 1, szRx);
+    return szRx;
+  }
   if ((res = pn53x_transceive(pnd, abtCmd, sizeof(abtCmd), abtRx, szRx, timeout)) < 0)
     return pnd->last_error;
   szRx = (size_t) res;
@@ -2850,15 +4673,18 @@ pn53x_target_send_bits(struct nfc_device *pnd, const uint8_t *pbtTx, const size_
   return szTxBits;
 }
 
-int
-pn53x_target_send_bytes(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, int timeout)
+static int
+pn53x_target_send_frames(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, const bool bMore, int timeout)
 {
-  uint8_t  abtCmd[PN53x_EXTENDED_FRAME__DATA_MAX_LEN];
+  uint8_t  abtCmd[PN53x_EXTENDED_FRAME__DATA_MAX_LEN] = { TgResponseToInitiator };
   int res = 0;
 
   // We can not just send bytes without parity if while the PN53X expects we handled them
   if (!pnd->bPar)
     return NFC_ECHIP;
+  // Nothing to chain yet
+  if (bMore && (szTx == 0))
+    return 0;
 
   // XXX I think this is not a clean way to provide some kind of "EasyFraming"
   // but at the moment I have no more better than this
@@ -2875,9 +4701,8 @@ pn53x_target_send_bytes(struct nfc_device *pnd, const uint8_t *pbtTx, const size
             abtCmd[0] = TgSetData;
             break;
           } else {
-            // TODO Support EasyFraming for other cases by software
-            pnd->last_error = NFC_ENOTIMPL;
-            return pnd->last_error;
+            // ISO/IEC 14443-4 blocks are handled by the host
+            return pn53x_picc_send_bytes(pnd, pbtTx, szTx, bMore, timeout);
           }
         }
         abtCmd[0] = TgResponseToInitiator;
@@ -2897,6 +4722,37 @@ pn53x_target_send_bytes(struct nfc_device *pnd, const uint8_t *pbtTx, const size
     abtCmd[0] = TgResponseToInitiator;
   }
 
+  // Whole bytes only: a previous bit frame may have left TxLastBits set
+  if ((res = pn53x_set_tx_bits(pnd, 0)) < 0) {
+    pnd->last_error = res;
+    return pnd->last_error;
+  }
+
+  if (abtCmd[0] == TgSetData) {
+    // Longer answers are chained (MI): every frame but the last one is sent
+    // with TgSetMetaData, the chip handles the acknowledgements
+    size_t szSent = 0;
+    do {
+      const size_t szChunk = MIN(szTx - szSent, PN53x_TG_DATA__MAX_LEN);
+      abtCmd[0] = ((szSent + szChunk == szTx) && !bMore) ? TgSetData : TgSetMetaData;
+      memcpy(abtCmd + 1, pbtTx + szSent, szChunk);
+      if ((res = pn53x_transceive(pnd, abtCmd, szChunk + 1, NULL, 0, timeout)) < 0)
+        return res;
+      szSent += szChunk;
+    } while (szSent < szTx);
+    return szTx;
+  }
+
+  // Raw frames can not be chained
+  if (bMore) {
+    pnd->last_error = NFC_EDEVNOTSUPP;
+    return pnd->last_error;
+  }
+  if (szTx > sizeof(abtCmd) - 1) {
+    pnd->last_error = NFC_EOVFLOW;
+    return pnd->last_error;
+  }
+
   // Copy the data into the command frame
   memcpy(abtCmd + 1, pbtTx, szTx);
 
@@ -2908,6 +4764,18 @@ pn53x_target_send_bytes(struct nfc_device *pnd, const uint8_t *pbtTx, const size
   return szTx;
 }
 
+int
+pn53x_target_send_bytes(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, int timeout)
+{
+  return pn53x_target_send_frames(pnd, pbtTx, szTx, false, timeout);
+}
+
+int
+pn53x_target_send_bytes_chained(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, int timeout)
+{
+  return pn53x_target_send_frames(pnd, pbtTx, szTx, true, timeout);
+}
+
 static struct sErrorMessage {
   int     iErrorCode;
   const char *pcErrorMsg;
@@ -3018,6 +4886,7 @@ pn53x_SetParameters(struct nfc_device *pnd, const uint8_t ui8Value)
   }
   // We save last parameters in register cache
   CHIP_DATA(pnd)->ui8Parameters = ui8Value;
+  CHIP_DATA(pnd)->parameters_stale = false;
   return NFC_SUCCESS;
 }
 
@@ -3056,35 +4925,27 @@ pn53x_PowerDown(struct nfc_device *pnd)
 {
   uint8_t  abtCmd[] = { PowerDown, 0xf0 };
   int res;
+  if (CHIP_DATA(pnd)->power_mode == LOWVBAT) {
+    // Already sleeping, sending anything would only wake the chip up
+    return NFC_SUCCESS;
+  }
   if ((res = pn53x_transceive(pnd, abtCmd, sizeof(abtCmd), NULL, 0, -1)) < 0)
     return res;
   CHIP_DATA(pnd)->power_mode = LOWVBAT;
   return res;
 }
 
-/**
- * @brief C wrapper to InListPassiveTarget command
- * @return Returns selected targets count on success, otherwise returns libnfc's error code (negative value)
- *
- * @param pnd struct nfc_device struct pointer that represent currently used device
- * @param pmInitModulation Desired modulation
- * @param pbtInitiatorData Optional initiator data used for Felica, ISO14443B, Topaz Polling or for ISO14443A selecting a specific UID
- * @param szInitiatorData Length of initiator data \a pbtInitiatorData
- * @param pbtTargetsData pointer on a pre-allocated byte array to receive TargetData[n] as described in pn53x user manual
- * @param pszTargetsData size_t pointer where size of \a pbtTargetsData will be written
- *
- * @note Selected targets count can be found in \a pbtTargetsData[0] if available (i.e. \a pszTargetsData content is more than 0)
- * @note To decode theses TargetData[n], there is @fn pn53x_decode_target_data
+/*
+ * Build the InListPassiveTarget command (15 bytes at most): returns its
+ * length, or an error when the chip does not support the modulation.
  */
-int
-pn53x_InListPassiveTarget(struct nfc_device *pnd,
-                          const pn53x_modulation pmInitModulation, const uint8_t szMaxTargets,
-                          const uint8_t *pbtInitiatorData, const size_t szInitiatorData,
-                          uint8_t *pbtTargetsData, size_t *pszTargetsData,
-                          int timeout)
+static int
+pn53x_InListPassiveTarget_frame(struct nfc_device *pnd,
+                                const pn53x_modulation pmInitModulation, const uint8_t szMaxTargets,
+                                const uint8_t *pbtInitiatorData, const size_t szInitiatorData,
+                                uint8_t *abtCmd)
 {
-  uint8_t  abtCmd[15] = { InListPassiveTarget };
-
+  abtCmd[0] = InListPassiveTarget;
   abtCmd[1] = szMaxTargets;     // MaxTg
 
   switch (pmInitModulation) {
@@ -3126,8 +4987,36 @@ pn53x_InListPassiveTarget(struct nfc_device *pnd,
   // Set the optional initiator data (used for Felica, ISO14443B, Topaz Polling or for ISO14443A selecting a specific UID).
   if (pbtInitiatorData)
     memcpy(abtCmd + 3, pbtInitiatorData, szInitiatorData);
+  return 3 + szInitiatorData;
+}
+
+/**
+ * @brief C wrapper to InListPassiveTarget command
+ * @return Returns selected targets count on success, otherwise returns libnfc's error code (negative value)
+ *
+ * @param pnd struct nfc_device struct pointer that represent currently used device
+ * @param pmInitModulation Desired modulation
+ * @param pbtInitiatorData Optional initiator data used for Felica, ISO14443B, Topaz Polling or for ISO14443A selecting a specific UID
+ * @param szInitiatorData Length of initiator data \a pbtInitiatorData
+ * @param pbtTargetsData pointer on a pre-allocated byte array to receive TargetData[n] as described in pn53x user manual
+ * @param pszTargetsData size_t pointer where size of \a pbtTargetsData will be written
+ *
+ * @note Selected targets count can be found in \a pbtTargetsData[0] if available (i.e. \a pszTargetsData content is more than 0)
+ * @note To decode theses TargetData[n], there is @fn pn53x_decode_target_data
+ */
+int
+pn53x_InListPassiveTarget(struct nfc_device *pnd,
+                          const pn53x_modulation pmInitModulation, const uint8_t szMaxTargets,
+                          const uint8_t *pbtInitiatorData, const size_t szInitiatorData,
+                          uint8_t *pbtTargetsData, size_t *pszTargetsData,
+                          int timeout)
+{
+  uint8_t  abtCmd[15];
   int res = 0;
-  if ((res = pn53x_transceive(pnd, abtCmd, 3 + szInitiatorData, pbtTargetsData, *pszTargetsData, timeout)) < 0) {
+
+  if ((res = pn53x_InListPassiveTarget_frame(pnd, pmInitModulation, szMaxTargets, pbtInitiatorData, szInitiatorData, abtCmd)) < 0)
+    return res;
+  if ((res = pn53x_transceive(pnd, abtCmd, (size_t) res, pbtTargetsData, *pszTargetsData, timeout)) < 0) {
     return res;
   }
   *pszTargetsData = (size_t) res;
@@ -3184,36 +5073,21 @@ pn53x_InRelease(struct nfc_device *pnd, const uint8_t ui8Target)
   return (res >= 0) ? NFC_SUCCESS : res;
 }
 
-int
-pn53x_InAutoPoll(struct nfc_device *pnd,
-                 const pn53x_target_type *ppttTargetTypes, const size_t szTargetTypes,
-                 const uint8_t btPollNr, const uint8_t btPeriod, nfc_target *pntTargets, const int timeout)
+/*
+ * Decode the answer to InAutoPoll: returns the count of targets found, the
+ * first two of them going to pntTargets.
+ */
+static int
+pn53x_InAutoPoll_decode(struct nfc_device *pnd, const uint8_t *abtRx, const size_t szRx, nfc_target *pntTargets)
 {
   size_t szTargetFound = 0;
-  if (CHIP_DATA(pnd)->type != PN532) {
-    // This function is not supported by pn531 neither pn533
-    pnd->last_error = NFC_EDEVNOTSUPP;
-    return pnd->last_error;
-  }
-
-  // InAutoPoll frame looks like this { 0xd4, 0x60, 0x0f, 0x01, 0x00 } => { direction, command, pollnr, period, types... }
-  size_t szTxInAutoPoll = 3 + szTargetTypes;
-  uint8_t abtCmd[3 + 15] = { InAutoPoll, btPollNr, btPeriod };
-  for (size_t n = 0; n < szTargetTypes; n++) {
-    abtCmd[3 + n] = ppttTargetTypes[n];
-  }
+  int res = 0;
 
-  uint8_t  abtRx[PN53x_EXTENDED_FRAME__DATA_MAX_LEN];
-  size_t  szRx = sizeof(abtRx);
-  int res = pn53x_transceive(pnd, abtCmd, szTxInAutoPoll, abtRx, szRx, timeout);
-  szRx = (size_t) res;
-  if (res < 0) {
-    return res;
-  } else if (szRx > 0) {
+  if (szRx > 0) {
     szTargetFound = abtRx[0];
     if (szTargetFound > 0) {
       uint8_t ln;
-      uint8_t *pbt = abtRx + 1;
+      const uint8_t *pbt = abtRx + 1;
       /* 1st target */
       // Target type
       pn53x_target_type ptt = *(pbt++);
@@ -3239,6 +5113,33 @@ pn53x_InAutoPoll(struct nfc_device *pnd,
   return szTargetFound;
 }
 
+int
+pn53x_InAutoPoll(struct nfc_device *pnd,
+                 const pn53x_target_type *ppttTargetTypes, const size_t szTargetTypes,
+                 const uint8_t btPollNr, const uint8_t btPeriod, nfc_target *pntTargets, const int timeout)
+{
+  if (CHIP_DATA(pnd)->type != PN532) {
+    // This function is not supported by pn531 neither pn533
+    pnd->last_error = NFC_EDEVNOTSUPP;
+    return pnd->last_error;
+  }
+
+  // InAutoPoll frame looks like this { 0xd4, 0x60, 0x0f, 0x01, 0x00 } => { direction, command, pollnr, period, types... }
+  size_t szTxInAutoPoll = 3 + szTargetTypes;
+  uint8_t abtCmd[3 + 15] = { InAutoPoll, btPollNr, btPeriod };
+  for (size_t n = 0; n < szTargetTypes; n++) {
+    abtCmd[3 + n] = ppttTargetTypes[n];
+  }
+
+  uint8_t  abtRx[PN53x_EXTENDED_FRAME__DATA_MAX_LEN];
+  size_t  szRx = sizeof(abtRx);
+  int res = pn53x_transceive(pnd, abtCmd, szTxInAutoPoll, abtRx, szRx, timeout);
+  if (res < 0) {
+    return res;
+  }
+  return pn53x_InAutoPoll_decode(pnd, abtRx, (size_t) res, pntTargets);
+}
+
 /**
  * @brief Wrapper for InJumpForDEP command
  * @param pmInitModulation desired initial modulation
@@ -3503,6 +5404,119 @@ pn53x_build_frame(uint8_t *pbtFrame, size_t *pszFrame, const uint8_t *pbtData, c
   }
   return NFC_SUCCESS;
 }
+
+/*
+ * Drop the szDrop first bytes gathered by pn53x_parse_frame().
+ */
+static void
+pn53x_frame_drop(uint8_t *pbtBuf, size_t *pszBuf, const size_t szDrop)
+{
+  memmove(pbtBuf, pbtBuf + szDrop, *pszBuf - szDrop);
+  *pszBuf -= szDrop;
+}
+
+/**
+ * @brief Look for a PN53x frame among the bytes received so far
+ *
+ * For the transports which carry the frames as a stream of bytes (e.g. UART)
+ * and gather them in \a pbtBuf (\a pszBuf bytes) as they come: the junk
+ * before the frame and the frame found are dropped from it.
+ *
+ * @return PF_NONE until a whole frame is there, PF_ACK, or PF_DATA when the
+ * answer to the last command (without TFI and command code) is copied to
+ * \a pbtData, otherwise libnfc's error code (all the bytes are dropped)
+ */
+int
+pn53x_parse_frame(struct nfc_device *pnd, uint8_t *pbtBuf, size_t *pszBuf, uint8_t *pbtData, const size_t szDataLen, size_t *pszData)
+{
+  size_t szStart = 0;
+  size_t szHeader, szLen;
+
+  // Skip to the start code (00 FF)
+  while ((szStart + 1 < *pszBuf) && !((pbtBuf[szStart] == 0x00) && (pbtBuf[szStart + 1] == 0xff)))
+    szStart++;
+  if (szStart > 0)
+    pn53x_frame_drop(pbtBuf, pszBuf, szStart);
+  if (*pszBuf < 4)
+    return PF_NONE;
+
+  if ((pbtBuf[2] == 0x00) && (pbtBuf[3] == 0xff)) {
+    // ACK frame: 00 FF 00 FF 00
+    if (*pszBuf < 5)
+      return PF_NONE;
+    pn53x_frame_drop(pbtBuf, pszBuf, 5);
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "%s", "PN53x ACKed");
+    return PF_ACK;
+  }
+  if ((pbtBuf[2] == 0x01) && (pbtBuf[3] == 0xff)) {
+    // Error frame: 00 FF 01 FF 7F 81 00
+    if (*pszBuf < 7)
+      return PF_NONE;
+    pn53x_frame_drop(pbtBuf, pszBuf, 7);
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Application level error detected");
+    pnd->last_error = NFC_EIO;
+    return pnd->last_error;
+  }
+  if ((pbtBuf[2] == 0xff) && (pbtBuf[3] == 0xff)) {
+    // Extended frame
+    if (*pszBuf < 7)
+      return PF_NONE;
+    if ((uint8_t)(pbtBuf[4] + pbtBuf[5] + pbtBuf[6]) != 0) {
+      log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Length checksum mismatch");
+      goto error;
+    }
+    szLen = (pbtBuf[4] << 8) + pbtBuf[5];
+    szHeader = 7;
+  } else {
+    // Normal frame
+    if ((uint8_t)(pbtBuf[2] + pbtBuf[3]) != 0) {
+      log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Length checksum mismatch");
+      goto error;
+    }
+    szLen = pbtBuf[2];
+    szHeader = 4;
+  }
+
+  // LEN includes TFI + (CC+1)
+  if ((szLen < 2) || (szLen - 2 > szDataLen)) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "Unable to receive data: buffer too small. (szDataLen: %" PRIuPTR ", len: %" PRIuPTR ")", szDataLen, szLen);
+    goto error;
+  }
+  // DCS and postamble follow the data
+  if (*pszBuf < szHeader + szLen + 2)
+    return PF_NONE;
+
+  if (pbtBuf[szHeader] != 0xD5) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "TFI Mismatch");
+    goto error;
+  }
+  if (pbtBuf[szHeader + 1] != CHIP_DATA(pnd)->last_command + 1) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Command Code verification failed");
+    goto error;
+  }
+  uint8_t btDCS = 0;
+  for (size_t szPos = 0; szPos < szLen + 1; szPos++) {
+    btDCS += pbtBuf[szHeader + szPos];
+  }
+  if (btDCS != 0) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Data checksum mismatch");
+    goto error;
+  }
+  if (pbtBuf[szHeader + szLen + 1] != 0x00) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Frame postamble mismatch");
+    goto error;
+  }
+
+  memcpy(pbtData, pbtBuf + szHeader + 2, szLen - 2);
+  *pszData = szLen - 2;
+  pn53x_frame_drop(pbtBuf, pszBuf, szHeader + szLen + 2);
+  return PF_DATA;
+
+error:
+  *pszBuf = 0;
+  pnd->last_error = NFC_EIO;
+  return pnd->last_error;
+}
 pn53x_modulation
 pn53x_nm_to_pm(const nfc_modulation nm)
 {
@@ -3887,6 +5901,11 @@ pn53x_current_target_new(const struct nfc_device *pnd, const nfc_target *pnt)
     return NULL;
   }
   memcpy(CHIP_DATA(pnd)->current_target, pnt, sizeof(nfc_target));
+  // A single target is addressed until a multi-target session is set up
+  CHIP_DATA(pnd)->current_tg = 1;
+  CHIP_DATA(pnd)->szSessionTargets = 0;
+  // Response times are learnt again for each target
+  CHIP_DATA(pnd)->szTimingStats = 0;
   return CHIP_DATA(pnd)->current_target;
 }
 
@@ -3897,6 +5916,9 @@ pn53x_current_target_free(const struct nfc_device *pnd)
     free(CHIP_DATA(pnd)->current_target);
     CHIP_DATA(pnd)->current_target = NULL;
   }
+  CHIP_DATA(pnd)->current_tg = 1;
+  CHIP_DATA(pnd)->szSessionTargets = 0;
+  CHIP_DATA(pnd)->szTimingStats = 0;
 }
 
 bool
@@ -3935,9 +5957,29 @@ pn53x_data_new(struct nfc_device *pnd, const struct pn53x_io *io)
   // Clear last status byte
   CHIP_DATA(pnd)->last_status_byte = 0x00;
 
+  // Last command did not collide
+  CHIP_DATA(pnd)->iCollisionBits = -1;
+
+  // Parameters are set by pn53x_init() or on first change (pn53x_init_cached())
+  CHIP_DATA(pnd)->ui8Parameters = 0x00;
+  CHIP_DATA(pnd)->parameters_stale = false;
+
   // Set current target to NULL
   CHIP_DATA(pnd)->current_target = NULL;
 
+  // No multi-target session, target number is 1
+  CHIP_DATA(pnd)->current_tg = 1;
+  CHIP_DATA(pnd)->szSessionTargets = 0;
+
+  // Nothing polled yet
+  CHIP_DATA(pnd)->szPollStats = 0;
+
+  // Default timeouts are used until asked otherwise
+  CHIP_DATA(pnd)->adaptive_timeout = false;
+  CHIP_DATA(pnd)->szTimingStats = 0;
+  CHIP_DATA(pnd)->ui32TimingClock = 0;
+  CHIP_DATA(pnd)->ui8TimingRfTimeout = 0;
+
   // Set current sam_mode to normal mode
   CHIP_DATA(pnd)->sam_mode = PSM_NORMAL;
 
@@ -3946,13 +5988,14 @@ pn53x_data_new(struct nfc_device *pnd, const struct pn53x_io *io)
   memset(CHIP_DATA(pnd)->wb_mask, 0x00, PN53X_CACHE_REGISTER_SIZE);
 
   // Set default command timeout (350 ms)
-  CHIP_DATA(pnd)->timeout_command = 350;
+  CHIP_DATA(pnd)->timeout_command = PN53X_DEFAULT_TIMEOUT_COMMAND;
 
   // Set default ATR timeout (103 ms)
-  CHIP_DATA(pnd)->timeout_atr = 103;
+  CHIP_DATA(pnd)->timeout_atr = PN53X_DEFAULT_TIMEOUT_ATR;
 
   // Set default communication timeout (52 ms)
-  CHIP_DATA(pnd)->timeout_communication = 52;
+  CHIP_DATA(pnd)->timeout_communication = PN53X_DEFAULT_TIMEOUT_COMMUNICATION;
+  pnd->iTimeoutCom = CHIP_DATA(pnd)->timeout_communication;
 
   CHIP_DATA(pnd)->supported_modulation_as_initiator = NULL;
 
@@ -3961,6 +6004,10 @@ pn53x_data_new(struct nfc_device *pnd, const struct pn53x_io *io)
   // Set default progressive field flag
   CHIP_DATA(pnd)->progressive_field = false;
 
+  // No ISO/IEC 14443-4 PICC emulated by the host yet
+  CHIP_DATA(pnd)->picc = NULL;
+  CHIP_DATA(pnd)->command = NULL;
+
   return pnd->chip_data;
 }
 
@@ -3970,6 +6017,12 @@ pn53x_data_free(struct nfc_device *pnd)
   // Free current target
   pn53x_current_target_free(pnd);
 
+  // Stop the ISO/IEC 14443-4 PICC emulated by the host
+  pn53x_picc_free(pnd);
+
+  // Free the split-phase command
+  free(CHIP_DATA(pnd)->command);
+
   // Free supported modulation(s)
   if (CHIP_DATA(pnd)->supported_modulation_as_initiator) {
     free(CHIP_DATA(pnd)->supported_modulation_as_initiator);
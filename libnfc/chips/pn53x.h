@@ -90,6 +90,10 @@
 #  define SYMBOL_INITIATOR          0x10
 #  define SYMBOL_RX_LAST_BITS       0x07
 
+//   PN53X_REG_CIU_Coll
+#  define SYMBOL_COLL_POS_NOT_VALID 0x20
+#  define SYMBOL_COLL_POS           0x1F
+
 //   PN53X_REG_CIU_BitFraming
 #  define SYMBOL_START_SEND         0x80
 #  define SYMBOL_RX_ALIGN           0x70
@@ -159,13 +163,81 @@ typedef enum {
 struct pn53x_io {
   int (*send)(struct nfc_device *pnd, const uint8_t *pbtData, const size_t szData, int timeout);
   int (*receive)(struct nfc_device *pnd, uint8_t *pbtData, const size_t szDataLen, int timeout);
+  /* Optional, for the split-phase commands (see pn53x_command_resume()): none of them may block */
+  /** File descriptor which gets readable when receive_frame() may find a frame */
+  int (*get_fd)(struct nfc_device *pnd);
+  /** Send a command frame, without waiting for its ACK */
+  int (*send_frame)(struct nfc_device *pnd, const uint8_t *pbtData, const size_t szData);
+  /** Send an ACK frame, which aborts the running command */
+  int (*send_ack)(struct nfc_device *pnd);
+  /** Gather the bytes received so far: returns a pn53x_frame, see pn53x_parse_frame() */
+  int (*receive_frame)(struct nfc_device *pnd, uint8_t *pbtData, const size_t szDataLen, size_t *pszData);
 };
 
+/**
+ * @internal
+ * @enum pn53x_frame
+ * @brief Frame found among the received bytes by pn53x_parse_frame()
+ */
+typedef enum {
+  /** No whole frame yet */
+  PF_NONE = 0,
+  /** ACK frame */
+  PF_ACK,
+  /** Answer to the last command */
+  PF_DATA,
+} pn53x_frame;
+
 /* defines */
 #define PN53X_CACHE_REGISTER_MIN_ADDRESS 	PN53X_REG_CIU_Mode
 #define PN53X_CACHE_REGISTER_MAX_ADDRESS 	PN53X_REG_CIU_Coll
 #define PN53X_CACHE_REGISTER_SIZE 		((PN53X_CACHE_REGISTER_MAX_ADDRESS - PN53X_CACHE_REGISTER_MIN_ADDRESS) + 1)
 
+/** Maximum count of targets a PN53x can keep activated at once (Tg 1 and 2) */
+#define PN53X_MAX_TARGETS 2
+
+// Number of kinds of command whose response time is tracked for the current target
+#define PN53X_TIMING_STATS_MAX 8
+
+// CIU_Coll locates bit collisions within the first 32 bits of a frame
+#define PN53X_COLLISION_MAX_LEN 4
+
+/**
+ * @struct pn53x_timing_stats
+ * @brief Response time of the current target to a kind of command
+ */
+struct pn53x_timing_stats {
+  /** Chip command (InDataExchange or InCommunicateThru) */
+  uint8_t ui8Command;
+  /** First byte sent to the target (its command code) */
+  uint8_t ui8TargetCommand;
+  /** Smoothed response time and its mean deviation, in us (see RFC 6298) */
+  int srtt_us;
+  int rttvar_us;
+  /** Timeouts in a row, each one doubles the timeout */
+  uint8_t ui8Misses;
+  /** Last use, the least recently used entry is forgotten first */
+  uint32_t ui32LastUse;
+};
+
+// Number of modulations whose polling history is kept
+#define PN53X_POLL_STATS_MAX 16
+
+/**
+ * @struct pn53x_poll_stats
+ * @brief Polling history of a modulation, used to schedule host-side polling
+ */
+struct pn53x_poll_stats {
+  nfc_modulation nm;
+  /** Hit rate in 1/256th: raised when a target is found, decays otherwise */
+  uint16_t ui16Score;
+  /** Smoothed time spent to find a target in ms, 0 until one is found */
+  int response_ms;
+};
+
+struct pn53x_picc;
+struct pn53x_command;
+
 /**
  * @internal
  * @struct pn53x_data
@@ -176,22 +248,47 @@ struct pn53x_data {
   pn53x_type type;
   /** Chip firmware text */
   char firmware_text[22];
+  /** Raw GetFirmwareVersion answer */
+  uint8_t abtFirmwareVersion[4];
+  size_t szFirmwareVersion;
   /** Current power mode */
   pn53x_power_mode power_mode;
   /** Current operating mode */
   pn53x_operating_mode operating_mode;
   /** Current emulated target */
   nfc_target *current_target;
+  /** Logical number (Tg) of the current target, as used by InDataExchange */
+  uint8_t current_tg;
+  /** Targets activated together by InListPassiveTarget (Tg 1 and 2) */
+  nfc_target session_targets[PN53X_MAX_TARGETS];
+  /** Count of targets in session_targets */
+  size_t szSessionTargets;
+  /** Learn timeouts from the response times of the current target */
+  bool adaptive_timeout;
+  struct pn53x_timing_stats timing_stats[PN53X_TIMING_STATS_MAX];
+  size_t szTimingStats;
+  uint32_t ui32TimingClock;
+  /** Non-DEP RF timeout set by the adaptive timeouts, 0 when the default one is in use */
+  uint8_t ui8TimingRfTimeout;
+  /** Polling history of the modulations polled by the host (PN531 and PN533) */
+  struct pn53x_poll_stats poll_stats[PN53X_POLL_STATS_MAX];
+  size_t szPollStats;
   /** Current sam mode (only applicable for PN532) */
   pn532_sam_mode sam_mode;
   /** PN53x I/O functions stored in struct */
   const struct pn53x_io *io;
   /** Last status byte returned by PN53x */
   uint8_t last_status_byte;
+  /** Frame bits received before the bit collision of the last command, -1 when it did not collide */
+  int iCollisionBits;
+  /** Those bits, as read back from the CIU FIFO (one spare byte for pn53x_unwrap_frame()) */
+  uint8_t abtCollision[PN53X_COLLISION_MAX_LEN + 1];
   /** Register cache for REG_CIU_BIT_FRAMING, SYMBOL_TX_LAST_BITS: The last TX bits setting, we need to reset this if it does not apply anymore */
   uint8_t ui8TxBits;
   /** Register cache for SetParameters function. */
   uint8_t ui8Parameters;
+  /** Does the chip maybe hold other parameters than ui8Parameters (see pn53x_init_cached()) */
+  bool parameters_stale;
   /** Last sent command */
   uint8_t last_command;
   /** Interframe timer correction */
@@ -212,6 +309,10 @@ struct pn53x_data {
   nfc_modulation_type *supported_modulation_as_initiator;
   nfc_modulation_type *supported_modulation_as_target;
   bool progressive_field;
+  /** Host-side ISO/IEC 14443-4 PICC, allocated on first use (see pn53x-picc.c) */
+  struct pn53x_picc *picc;
+  /** Split-phase command, allocated on first use (see pn53x_command_resume()) */
+  struct pn53x_command *command;
 };
 
 #define CHIP_DATA(pnd) ((struct pn53x_data*)(pnd->chip_data))
@@ -303,6 +404,7 @@ extern const uint8_t pn53x_ack_frame[PN53x_ACK_FRAME__LEN];
 extern const uint8_t pn53x_nack_frame[PN53x_ACK_FRAME__LEN];
 
 int    pn53x_init(struct nfc_device *pnd);
+int    pn53x_init_cached(struct nfc_device *pnd);
 int    pn53x_transceive(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, uint8_t *pbtRx, const size_t szRxLen, int timeout);
 
 int    pn53x_set_parameters(struct nfc_device *pnd, const uint8_t ui8Value, const bool bEnable);
@@ -320,6 +422,7 @@ int    pn53x_set_property_bool(struct nfc_device *pnd, const nfc_property proper
 
 int    pn53x_check_communication(struct nfc_device *pnd);
 int    pn53x_idle(struct nfc_device *pnd);
+int    pn53x_reset(struct nfc_device *pnd);
 
 // NFC device as Initiator functions
 int    pn53x_initiator_init(struct nfc_device *pnd);
@@ -330,6 +433,10 @@ int    pn53x_initiator_select_passive_target(struct nfc_device *pnd,
                                              const nfc_modulation nm,
                                              const uint8_t *pbtInitData, const size_t szInitData,
                                              nfc_target *pnt);
+int    pn53x_initiator_select_passive_targets(struct nfc_device *pnd,
+                                              const nfc_modulation nm,
+                                              const uint8_t *pbtInitData, const size_t szInitData,
+                                              nfc_target ant[], const size_t szTargets);
 int    pn53x_initiator_poll_target(struct nfc_device *pnd,
                                    const nfc_modulation *pnmModulations, const size_t szModulations,
                                    const uint8_t uiPollNr, const uint8_t uiPeriod,
@@ -339,16 +446,22 @@ int    pn53x_initiator_select_dep_target(struct nfc_device *pnd,
                                          const nfc_dep_info *pndiInitiator,
                                          nfc_target *pnt,
                                          const int timeout);
+int    pn53x_initiator_dep_psl(struct nfc_device *pnd, const nfc_baud_rate nbr);
 int    pn53x_initiator_transceive_bits(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTxBits,
                                        const uint8_t *pbtTxPar, uint8_t *pbtRx, uint8_t *pbtRxPar);
 int    pn53x_initiator_transceive_bytes(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx,
                                         uint8_t *pbtRx, const size_t szRx, int timeout);
+int    pn53x_initiator_transceive_bytes_target(struct nfc_device *pnd, const size_t szTarget, const uint8_t *pbtTx, const size_t szTx,
+                                               uint8_t *pbtRx, const size_t szRx, int timeout);
 int    pn53x_initiator_transceive_bits_timed(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTxBits,
                                              const uint8_t *pbtTxPar, uint8_t *pbtRx, uint8_t *pbtRxPar, uint32_t *cycles);
 int    pn53x_initiator_transceive_bytes_timed(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx,
                                               uint8_t *pbtRx, const size_t szRx, uint32_t *cycles);
+int    pn53x_initiator_last_collision(struct nfc_device *pnd, uint8_t *pbtRx, uint8_t *pbtRxPar);
 int    pn53x_initiator_deselect_target(struct nfc_device *pnd);
 int    pn53x_initiator_target_is_present(struct nfc_device *pnd, const nfc_target *pnt);
+int    pn53x_initiator_target_upgrade_bit_rate(struct nfc_device *pnd, nfc_target *pnt);
+int    pn53x_initiator_target_reactivate(struct nfc_device *pnd, nfc_target *pnt);
 
 // NFC device as Target functions
 int    pn53x_target_init(struct nfc_device *pnd, nfc_target *pnt, uint8_t *pbtRx, const size_t szRxLen, int timeout);
@@ -356,6 +469,27 @@ int    pn53x_target_receive_bits(struct nfc_device *pnd, uint8_t *pbtRx, const s
 int    pn53x_target_receive_bytes(struct nfc_device *pnd, uint8_t *pbtRx, const size_t szRxLen, int timeout);
 int    pn53x_target_send_bits(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTxBits, const uint8_t *pbtTxPar);
 int    pn53x_target_send_bytes(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, int timeout);
+int    pn53x_target_send_bytes_chained(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, int timeout);
+
+// ISO/IEC 14443-4 PICC emulated by the host (PN531, PN533)
+int    pn53x_picc_start(struct nfc_device *pnd, const nfc_target *pnt, const uint8_t *pbtRx, const size_t szRx, int timeout);
+void   pn53x_picc_stop(struct nfc_device *pnd);
+void   pn53x_picc_free(struct nfc_device *pnd);
+int    pn53x_picc_receive_bytes(struct nfc_device *pnd, uint8_t *pbtRx, const size_t szRxLen, int timeout);
+int    pn53x_picc_send_bytes(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, const bool bMore, int timeout);
+
+// Split-phase commands, driven by an event loop
+int    pn53x_initiator_transceive_bytes_submit(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx,
+                                               uint8_t *pbtRx, const size_t szRx, int timeout);
+int    pn53x_initiator_select_passive_target_submit(struct nfc_device *pnd, const nfc_modulation nm,
+                                                    const uint8_t *pbtInitData, const size_t szInitData, nfc_target *pnt);
+int    pn53x_initiator_poll_target_submit(struct nfc_device *pnd, const nfc_modulation *pnmModulations, const size_t szModulations,
+                                          const uint8_t uiPollNr, const uint8_t uiPeriod, nfc_target *pnt);
+int    pn53x_initiator_target_probe_submit(struct nfc_device *pnd, const nfc_target *pnt);
+int    pn53x_command_resume(struct nfc_device *pnd, bool *pbDone);
+int    pn53x_command_cancel(struct nfc_device *pnd);
+int    pn53x_get_event_fd(struct nfc_device *pnd);
+int    pn53x_get_event_timeout(struct nfc_device *pnd);
 
 // Error handling functions
 const char *pn53x_strerror(const struct nfc_device *pnd);
@@ -397,6 +531,7 @@ int    pn53x_RFConfiguration__MaxRetries(struct nfc_device *pnd, const uint8_t M
 int    pn53x_check_ack_frame(struct nfc_device *pnd, const uint8_t *pbtRxFrame, const size_t szRxFrameLen);
 int    pn53x_check_error_frame(struct nfc_device *pnd, const uint8_t *pbtRxFrame, const size_t szRxFrameLen);
 int    pn53x_build_frame(uint8_t *pbtFrame, size_t *pszFrame, const uint8_t *pbtData, const size_t szData);
+int    pn53x_parse_frame(struct nfc_device *pnd, uint8_t *pbtBuf, size_t *pszBuf, uint8_t *pbtData, const size_t szDataLen, size_t *pszData);
 int    pn53x_get_supported_modulation(nfc_device *pnd, const nfc_mode mode, const nfc_modulation_type **const supported_mt);
 int    pn53x_get_supported_baud_rate(nfc_device *pnd, const nfc_mode mode, const nfc_modulation_type nmt, const nfc_baud_rate **const supported_br);
 int    pn53x_get_information_about(nfc_device *pnd, char **pbuf);
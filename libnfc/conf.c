@@ -217,6 +217,9 @@ conf_keyvalue_context(void *data, const char *key, const char *value)
     string_as_boolean(value, &(context->allow_intrusive_scan));
   } else if (strcmp(key, "log_level") == 0) {
     context->log_level = atoi(value);
+  } else if (strcmp(key, "device_cache_dir") == 0) {
+    strncpy(context->device_cache_dir, value, DEVICE_CACHE_DIR_LENGTH - 1);
+    context->device_cache_dir[DEVICE_CACHE_DIR_LENGTH - 1] = '\0';
   } else if (strcmp(key, "device.name") == 0) {
     if ((context->user_defined_device_count == 0) || strcmp(context->user_defined_devices[context->user_defined_device_count - 1].name, "") != 0) {
       if (context->user_defined_device_count >= MAX_USER_DEFINED_DEVICES) {
@@ -111,30 +111,39 @@ struct acr122_pcsc_data {
 
 #define DRIVER_DATA(pnd) ((struct acr122_pcsc_data*)(pnd->driver_data))
 
+// Shared by all contexts and devices, _iSCardContextRefCount is guarded by _SCardContextMutex
 static SCARDCONTEXT _SCardContext;
 static int _iSCardContextRefCount = 0;
+static nfc_mutex _SCardContextMutex = NFC_MUTEX_INITIALIZER;
 
 static SCARDCONTEXT *
 acr122_pcsc_get_scardcontext(void)
 {
+  SCARDCONTEXT *pscc = &_SCardContext;
+
+  nfc_mutex_lock(&_SCardContextMutex);
   if (_iSCardContextRefCount == 0) {
     if (SCardEstablishContext(SCARD_SCOPE_USER, NULL, NULL, &_SCardContext) != SCARD_S_SUCCESS)
-      return NULL;
+      pscc = NULL;
   }
-  _iSCardContextRefCount++;
+  if (pscc)
+    _iSCardContextRefCount++;
+  nfc_mutex_unlock(&_SCardContextMutex);
 
-  return &_SCardContext;
+  return pscc;
 }
 
 static void
 acr122_pcsc_free_scardcontext(void)
 {
+  nfc_mutex_lock(&_SCardContextMutex);
   if (_iSCardContextRefCount) {
     _iSCardContextRefCount--;
     if (!_iSCardContextRefCount) {
       SCardReleaseContext(_SCardContext);
     }
   }
+  nfc_mutex_unlock(&_SCardContextMutex);
 }
 
 #define PCSC_MAX_DEVICES 16
@@ -300,7 +309,8 @@ acr122_pcsc_open(const nfc_context *context, const nfc_connstring connstring)
 
     pnd->driver = &acr122_pcsc_driver;
 
-    pn53x_init(pnd);
+    if (pn53x_init_cached(pnd) < 0)
+      pn53x_init(pnd);
 
     free(ndd.pcsc_device_name);
     return pnd;
@@ -487,17 +497,24 @@ const struct nfc_driver acr122_pcsc_driver = {
   .initiator_init_collision         = pn53x_initiator_init_collision,
   .initiator_init_secure_element    = NULL, // No secure-element support
   .initiator_select_passive_target  = pn53x_initiator_select_passive_target,
+  .initiator_select_passive_targets = pn53x_initiator_select_passive_targets,
   .initiator_poll_target            = pn53x_initiator_poll_target,
   .initiator_select_dep_target      = pn53x_initiator_select_dep_target,
+  .initiator_dep_psl                = pn53x_initiator_dep_psl,
   .initiator_deselect_target        = pn53x_initiator_deselect_target,
   .initiator_transceive_bytes       = pn53x_initiator_transceive_bytes,
+  .initiator_transceive_bytes_target = pn53x_initiator_transceive_bytes_target,
   .initiator_transceive_bits        = pn53x_initiator_transceive_bits,
   .initiator_transceive_bytes_timed = pn53x_initiator_transceive_bytes_timed,
   .initiator_transceive_bits_timed  = pn53x_initiator_transceive_bits_timed,
+  .initiator_last_collision         = pn53x_initiator_last_collision,
   .initiator_target_is_present      = pn53x_initiator_target_is_present,
+  .initiator_target_upgrade_bit_rate = pn53x_initiator_target_upgrade_bit_rate,
+  .initiator_target_reactivate = pn53x_initiator_target_reactivate,
 
   .target_init           = pn53x_target_init,
   .target_send_bytes     = pn53x_target_send_bytes,
+  .target_send_bytes_chained = pn53x_target_send_bytes_chained,
   .target_receive_bytes  = pn53x_target_receive_bytes,
   .target_send_bits      = pn53x_target_send_bits,
   .target_receive_bits   = pn53x_target_receive_bits,
@@ -512,5 +529,15 @@ const struct nfc_driver acr122_pcsc_driver = {
   .idle           = pn53x_idle,
   /* Even if PN532, PowerDown is not recommended on those devices */
   .powerdown      = NULL,
+  .reset          = pn53x_reset,
+
+  .initiator_transceive_bytes_submit      = pn53x_initiator_transceive_bytes_submit,
+  .initiator_select_passive_target_submit = pn53x_initiator_select_passive_target_submit,
+  .initiator_poll_target_submit           = pn53x_initiator_poll_target_submit,
+  .initiator_target_probe_submit          = pn53x_initiator_target_probe_submit,
+  .command_resume                         = pn53x_command_resume,
+  .command_cancel                         = pn53x_command_cancel,
+  .get_event_fd                           = pn53x_get_event_fd,
+  .get_event_timeout                      = pn53x_get_event_timeout,
 };
 
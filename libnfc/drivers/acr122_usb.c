@@ -302,7 +302,7 @@ acr122_usb_scan(const nfc_context *context, nfc_connstring connstrings[], const
 {
   (void)context;
 
-  usb_prepare();
+  usb_prepare(context);
 
   size_t device_found = 0;
   uint32_t uiBusIndex = 0;
@@ -402,7 +402,7 @@ acr122_usb_open(const nfc_context *context, const nfc_connstring connstring)
   struct usb_bus *bus;
   struct usb_device *dev;
 
-  usb_prepare();
+  usb_prepare(context);
 
   for (bus = usb_get_busses(); bus; bus = bus->next) {
     if (connstring_decode_level > 1)  {
@@ -450,6 +450,9 @@ acr122_usb_open(const nfc_context *context, const nfc_connstring connstring)
         goto error;
       }
       acr122_usb_get_usb_device_name(dev, data.pudh, pnd->name, sizeof(pnd->name));
+      // The cached description follows the device wherever it is plugged
+      if (!dev->descriptor.iSerialNumber || (usb_get_string_simple(data.pudh, dev->descriptor.iSerialNumber, pnd->serial, sizeof(pnd->serial)) < 0))
+        pnd->serial[0] = '\0';
 
       pnd->driver_data = malloc(sizeof(struct acr122_usb_data));
       if (!pnd->driver_data) {
@@ -593,14 +596,14 @@ acr122_usb_receive(nfc_device *pnd, uint8_t *pbtData, const size_t szDataLen, co
    * timeout to allow breaking the loop if the user wants to stop it.
    */
   int usb_timeout;
-  int remaining_time = timeout;
+  const nfc_deadline deadline = nfc_deadline_from_timeout(timeout);
 read:
   if (timeout == USB_INFINITE_TIMEOUT) {
     usb_timeout = USB_TIMEOUT_PER_PASS;
   } else {
     // A user-provided timeout is set, we have to cut it in multiple chunk to be able to keep an nfc_abort_command() mechanism
-    remaining_time -= USB_TIMEOUT_PER_PASS;
-    if (remaining_time <= 0) {
+    const int remaining_time = nfc_deadline_remaining(deadline);
+    if (remaining_time < 0) {
       pnd->last_error = NFC_ETIMEOUT;
       return pnd->last_error;
     } else {
@@ -805,6 +808,9 @@ acr122_usb_init(nfc_device *pnd)
   if ((res = acr122_usb_send_apdu(pnd, 0x00, 0x51, 0x00, NULL, 0, 0, abtRxBuf, sizeof(abtRxBuf))) < 0)
     return res;
 
+  if (pn53x_init_cached(pnd) == NFC_SUCCESS)
+    return NFC_SUCCESS;
+
   res = 0;
   for (i = 0; i < 3; i++) {
     if (res < 0)
@@ -842,17 +848,24 @@ const struct nfc_driver acr122_usb_driver = {
   .initiator_init_collision         = pn53x_initiator_init_collision,
   .initiator_init_secure_element    = NULL, // No secure-element support
   .initiator_select_passive_target  = pn53x_initiator_select_passive_target,
+  .initiator_select_passive_targets = pn53x_initiator_select_passive_targets,
   .initiator_poll_target            = pn53x_initiator_poll_target,
   .initiator_select_dep_target      = pn53x_initiator_select_dep_target,
+  .initiator_dep_psl                = pn53x_initiator_dep_psl,
   .initiator_deselect_target        = pn53x_initiator_deselect_target,
   .initiator_transceive_bytes       = pn53x_initiator_transceive_bytes,
+  .initiator_transceive_bytes_target = pn53x_initiator_transceive_bytes_target,
   .initiator_transceive_bits        = pn53x_initiator_transceive_bits,
   .initiator_transceive_bytes_timed = pn53x_initiator_transceive_bytes_timed,
   .initiator_transceive_bits_timed  = pn53x_initiator_transceive_bits_timed,
+  .initiator_last_collision         = pn53x_initiator_last_collision,
   .initiator_target_is_present      = pn53x_initiator_target_is_present,
+  .initiator_target_upgrade_bit_rate = pn53x_initiator_target_upgrade_bit_rate,
+  .initiator_target_reactivate = pn53x_initiator_target_reactivate,
 
   .target_init           = pn53x_target_init,
   .target_send_bytes     = pn53x_target_send_bytes,
+  .target_send_bytes_chained = pn53x_target_send_bytes_chained,
   .target_receive_bytes  = pn53x_target_receive_bytes,
   .target_send_bits      = pn53x_target_send_bits,
   .target_receive_bits   = pn53x_target_receive_bits,
@@ -867,4 +880,14 @@ const struct nfc_driver acr122_usb_driver = {
   .idle           = pn53x_idle,
   /* Even if PN532, PowerDown is not recommended on those devices */
   .powerdown      = NULL,
+  .reset          = pn53x_reset,
+
+  .initiator_transceive_bytes_submit      = pn53x_initiator_transceive_bytes_submit,
+  .initiator_select_passive_target_submit = pn53x_initiator_select_passive_target_submit,
+  .initiator_poll_target_submit           = pn53x_initiator_poll_target_submit,
+  .initiator_target_probe_submit          = pn53x_initiator_target_probe_submit,
+  .command_resume                         = pn53x_command_resume,
+  .command_cancel                         = pn53x_command_cancel,
+  .get_event_fd                           = pn53x_get_event_fd,
+  .get_event_timeout                      = pn53x_get_event_timeout,
 };
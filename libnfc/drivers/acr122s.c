@@ -207,10 +207,11 @@ acr122s_send_frame(nfc_device *pnd, uint8_t *frame, int timeout)
   abort_p = &(DRIVER_DATA(pnd)->abort_flag);
 #endif
 
+  const nfc_deadline deadline = nfc_deadline_from_timeout(timeout);
   if ((ret = uart_send(port, frame, frame_size, timeout)) < 0)
     return ret;
 
-  if ((ret = uart_receive(port, ack, 4, abort_p, timeout)) < 0)
+  if ((ret = uart_receive(port, ack, 4, abort_p, nfc_deadline_remaining(deadline))) < 0)
     return ret;
 
   if (memcmp(ack, positive_ack, 4) != 0) {
@@ -245,6 +246,7 @@ acr122s_recv_frame(nfc_device *pnd, uint8_t *frame, size_t frame_size, void *abo
   }
   int ret;
   serial_port port = DRIVER_DATA(pnd)->port;
+  const nfc_deadline deadline = nfc_deadline_from_timeout(timeout);
 
   if ((ret = uart_receive(port, frame, 11, abort_p, timeout)) != 0)
     return ret;
@@ -256,7 +258,7 @@ acr122s_recv_frame(nfc_device *pnd, uint8_t *frame, size_t frame_size, void *abo
   }
 
   size_t remaining = FRAME_SIZE(frame) - 11;
-  if ((ret = uart_receive(port, frame + 11, remaining, abort_p, timeout)) != 0)
+  if ((ret = uart_receive(port, frame + 11, remaining, abort_p, nfc_deadline_remaining(deadline))) != 0)
     return ret;
 
   struct xfr_block_res *res = (struct xfr_block_res *) &frame[1];
@@ -647,7 +649,7 @@ acr122s_open(const nfc_context *context, const nfc_connstring connstring)
   }
 #endif
 
-  if (pn53x_init(pnd) < 0) {
+  if ((pn53x_init_cached(pnd) < 0) && (pn53x_init(pnd) < 0)) {
     log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Failed initializing PN532 chip.");
     acr122s_close(pnd);
     return NULL;
@@ -745,17 +747,24 @@ const struct nfc_driver acr122s_driver = {
   .initiator_init_collision         = pn53x_initiator_init_collision,
   .initiator_init_secure_element    = NULL, // No secure-element support
   .initiator_select_passive_target  = pn53x_initiator_select_passive_target,
+  .initiator_select_passive_targets = pn53x_initiator_select_passive_targets,
   .initiator_poll_target            = pn53x_initiator_poll_target,
   .initiator_select_dep_target      = pn53x_initiator_select_dep_target,
+  .initiator_dep_psl                = pn53x_initiator_dep_psl,
   .initiator_deselect_target        = pn53x_initiator_deselect_target,
   .initiator_transceive_bytes       = pn53x_initiator_transceive_bytes,
+  .initiator_transceive_bytes_target = pn53x_initiator_transceive_bytes_target,
   .initiator_transceive_bits        = pn53x_initiator_transceive_bits,
   .initiator_transceive_bytes_timed = pn53x_initiator_transceive_bytes_timed,
   .initiator_transceive_bits_timed  = pn53x_initiator_transceive_bits_timed,
+  .initiator_last_collision         = pn53x_initiator_last_collision,
   .initiator_target_is_present      = pn53x_initiator_target_is_present,
+  .initiator_target_upgrade_bit_rate = pn53x_initiator_target_upgrade_bit_rate,
+  .initiator_target_reactivate = pn53x_initiator_target_reactivate,
 
   .target_init           = pn53x_target_init,
   .target_send_bytes     = pn53x_target_send_bytes,
+  .target_send_bytes_chained = pn53x_target_send_bytes_chained,
   .target_receive_bytes  = pn53x_target_receive_bytes,
   .target_send_bits      = pn53x_target_send_bits,
   .target_receive_bits   = pn53x_target_receive_bits,
@@ -770,4 +779,14 @@ const struct nfc_driver acr122s_driver = {
   .idle           = pn53x_idle,
   /* Even if PN532, PowerDown is not recommended on those devices */
   .powerdown      = NULL,
+  .reset          = pn53x_reset,
+
+  .initiator_transceive_bytes_submit      = pn53x_initiator_transceive_bytes_submit,
+  .initiator_select_passive_target_submit = pn53x_initiator_select_passive_target_submit,
+  .initiator_poll_target_submit           = pn53x_initiator_poll_target_submit,
+  .initiator_target_probe_submit          = pn53x_initiator_target_probe_submit,
+  .command_resume                         = pn53x_command_resume,
+  .command_cancel                         = pn53x_command_cancel,
+  .get_event_fd                           = pn53x_get_event_fd,
+  .get_event_timeout                      = pn53x_get_event_timeout,
 };
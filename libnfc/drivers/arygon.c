@@ -328,7 +328,8 @@ arygon_open(const nfc_context *context, const nfc_connstring connstring)
   snprintf(pnd->name, sizeof(pnd->name), "%s %s", pcName, arygon_firmware_version);
   free(pcName);
 
-  pn53x_init(pnd);
+  if (pn53x_init_cached(pnd) < 0)
+    pn53x_init(pnd);
   return pnd;
 }
 
@@ -356,6 +357,7 @@ arygon_tama_send(nfc_device *pnd, const uint8_t *pbtData, const size_t szData, i
     return pnd->last_error;
   }
 
+  const nfc_deadline deadline = nfc_deadline_from_timeout(timeout);
   if ((res = uart_send(DRIVER_DATA(pnd)->port, abtFrame, szFrame + 1, timeout)) != 0) {
     log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Unable to transmit data. (TX)");
     pnd->last_error = res;
@@ -363,7 +365,7 @@ arygon_tama_send(nfc_device *pnd, const uint8_t *pbtData, const size_t szData, i
   }
 
   uint8_t abtRxBuf[PN53x_ACK_FRAME__LEN];
-  if ((res = uart_receive(DRIVER_DATA(pnd)->port, abtRxBuf, sizeof(abtRxBuf), 0, timeout)) != 0) {
+  if ((res = uart_receive(DRIVER_DATA(pnd)->port, abtRxBuf, sizeof(abtRxBuf), 0, nfc_deadline_remaining(deadline))) != 0) {
     log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Unable to read ACK");
     pnd->last_error = res;
     return pnd->last_error;
@@ -375,7 +377,7 @@ arygon_tama_send(nfc_device *pnd, const uint8_t *pbtData, const size_t szData, i
     log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Bad frame format.");
     // We have already read 6 bytes and arygon_error_unknown_mode is 10 bytes long
     // so we have to read 4 remaining bytes to be synchronized at the next receiving pass.
-    pnd->last_error = uart_receive(DRIVER_DATA(pnd)->port, abtRxBuf, 4, 0, timeout);
+    pnd->last_error = uart_receive(DRIVER_DATA(pnd)->port, abtRxBuf, 4, 0, nfc_deadline_remaining(deadline));
     return pnd->last_error;
   } else {
     return pnd->last_error;
@@ -401,6 +403,8 @@ arygon_tama_receive(nfc_device *pnd, uint8_t *pbtData, const size_t szDataLen, i
   uint8_t  abtRxBuf[5];
   size_t len;
   void *abort_p = NULL;
+  // The frame is read in several chunks: all of them share this deadline
+  const nfc_deadline deadline = nfc_deadline_from_timeout(timeout);
 
 #ifndef WIN32
   abort_p = &(DRIVER_DATA(pnd)->iAbortFds[1]);
@@ -432,7 +436,7 @@ arygon_tama_receive(nfc_device *pnd, uint8_t *pbtData, const size_t szDataLen, i
 
   if ((0x01 == abtRxBuf[3]) && (0xff == abtRxBuf[4])) {
     // Error frame
-    uart_receive(DRIVER_DATA(pnd)->port, abtRxBuf, 3, 0, timeout);
+    uart_receive(DRIVER_DATA(pnd)->port, abtRxBuf, 3, 0, nfc_deadline_remaining(deadline));
     log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Application level error detected");
     pnd->last_error = NFC_EIO;
     return pnd->last_error;
@@ -460,7 +464,7 @@ arygon_tama_receive(nfc_device *pnd, uint8_t *pbtData, const size_t szDataLen, i
   }
 
   // TFI + PD0 (CC+1)
-  pnd->last_error = uart_receive(DRIVER_DATA(pnd)->port, abtRxBuf, 2, 0, timeout);
+  pnd->last_error = uart_receive(DRIVER_DATA(pnd)->port, abtRxBuf, 2, 0, nfc_deadline_remaining(deadline));
   if (pnd->last_error != 0) {
     log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Unable to receive data. (RX)");
     return pnd->last_error;
@@ -479,14 +483,14 @@ arygon_tama_receive(nfc_device *pnd, uint8_t *pbtData, const size_t szDataLen, i
   }
 
   if (len) {
-    pnd->last_error = uart_receive(DRIVER_DATA(pnd)->port, pbtData, len, 0, timeout);
+    pnd->last_error = uart_receive(DRIVER_DATA(pnd)->port, pbtData, len, 0, nfc_deadline_remaining(deadline));
     if (pnd->last_error != 0) {
       log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Unable to receive data. (RX)");
       return pnd->last_error;
     }
   }
 
-  pnd->last_error = uart_receive(DRIVER_DATA(pnd)->port, abtRxBuf, 2, 0, timeout);
+  pnd->last_error = uart_receive(DRIVER_DATA(pnd)->port, abtRxBuf, 2, 0, nfc_deadline_remaining(deadline));
   if (pnd->last_error != 0) {
     log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Unable to receive data. (RX)");
     return pnd->last_error;
@@ -604,17 +608,24 @@ const struct nfc_driver arygon_driver = {
   .initiator_init_collision         = NULL,
   .initiator_init_secure_element    = NULL, // No secure-element support
   .initiator_select_passive_target  = pn53x_initiator_select_passive_target,
+  .initiator_select_passive_targets = pn53x_initiator_select_passive_targets,
   .initiator_poll_target            = pn53x_initiator_poll_target,
   .initiator_select_dep_target      = pn53x_initiator_select_dep_target,
+  .initiator_dep_psl                = pn53x_initiator_dep_psl,
   .initiator_deselect_target        = pn53x_initiator_deselect_target,
   .initiator_transceive_bytes       = pn53x_initiator_transceive_bytes,
+  .initiator_transceive_bytes_target = pn53x_initiator_transceive_bytes_target,
   .initiator_transceive_bits        = pn53x_initiator_transceive_bits,
   .initiator_transceive_bytes_timed = pn53x_initiator_transceive_bytes_timed,
   .initiator_transceive_bits_timed  = pn53x_initiator_transceive_bits_timed,
+  .initiator_last_collision         = pn53x_initiator_last_collision,
   .initiator_target_is_present      = pn53x_initiator_target_is_present,
+  .initiator_target_upgrade_bit_rate = pn53x_initiator_target_upgrade_bit_rate,
+  .initiator_target_reactivate = pn53x_initiator_target_reactivate,
 
   .target_init           = pn53x_target_init,
   .target_send_bytes     = pn53x_target_send_bytes,
+  .target_send_bytes_chained = pn53x_target_send_bytes_chained,
   .target_receive_bytes  = pn53x_target_receive_bytes,
   .target_send_bits      = pn53x_target_send_bits,
   .target_receive_bits   = pn53x_target_receive_bits,
@@ -629,5 +640,15 @@ const struct nfc_driver arygon_driver = {
   .idle           = pn53x_idle,
   /* Even if PN532, PowerDown is not recommended on those devices */
   .powerdown      = NULL,
+  .reset          = pn53x_reset,
+
+  .initiator_transceive_bytes_submit      = pn53x_initiator_transceive_bytes_submit,
+  .initiator_select_passive_target_submit = pn53x_initiator_select_passive_target_submit,
+  .initiator_poll_target_submit           = pn53x_initiator_poll_target_submit,
+  .initiator_target_probe_submit          = pn53x_initiator_target_probe_submit,
+  .command_resume                         = pn53x_command_resume,
+  .command_cancel                         = pn53x_command_cancel,
+  .get_event_fd                           = pn53x_get_event_fd,
+  .get_event_timeout                      = pn53x_get_event_timeout,
 };
 
@@ -0,0 +1,821 @@
+/*-
+ * Free/Libre Near Field Communication (NFC) library
+ *
+ * Libnfc historical contributors:
+ * Copyright (C) 2009      Roel Verdult
+ * Copyright (C) 2009-2013 Romuald Conty
+ * Copyright (C) 2010-2012 Romain Tarti?re
+ * Copyright (C) 2010-2013 Philippe Teuwen
+ * Copyright (C) 2012-2013 Ludovic Rousseau
+ * See AUTHORS file for a more comprehensive list of contributors.
+ * Additional contributors of this file:
+ * Copyright (C) 2013      Laurent Latil
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+/**
+ * @file nfcd.c
+ * @brief Driver for devices shared by the nfcd daemon
+ *
+ * Every driver operation is forwarded to the daemon as one request on its
+ * Unix socket and the call blocks until the matching response comes back.
+ * Frame payloads are not sent through the socket but copied into the shared
+ * memory rings described in nfcd.h, so an exchange costs one small message
+ * each way plus one copy of the payload on this side.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include "nfcd.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+#include <nfc/nfc.h>
+
+#include "drivers.h"
+#include "nfc-internal.h"
+
+#define LOG_CATEGORY "libnfc.driver.nfcd"
+#define LOG_GROUP    NFC_LOG_GROUP_DRIVER
+
+#define NFCD_MAX_MODULATION_TYPES 32
+#define NFCD_MAX_BAUD_RATES       16
+
+// Internal data structs
+struct nfcd_data {
+  int      iSocket;
+  uint8_t *pbtShm;
+  uint32_t uiTxHead;
+  int32_t  iCookie;
+  char     acSocketPath[sizeof(((struct sockaddr_un *)0)->sun_path)];
+  // Storage for the lists handed out by get_supported_*()
+  nfc_modulation_type anmtSupported[2][NFCD_MAX_MODULATION_TYPES];
+  nfc_baud_rate anbrSupported[NFCD_MAX_BAUD_RATES];
+};
+
+#define DRIVER_DATA(pnd) ((struct nfcd_data*)(pnd->driver_data))
+
+static int
+nfcd_write_all(int fd, const void *pData, size_t szData)
+{
+  const uint8_t *pbt = pData;
+  while (szData > 0) {
+    ssize_t res = send(fd, pbt, szData, MSG_NOSIGNAL);
+    if (res < 0) {
+      if (errno == EINTR)
+        continue;
+      return NFC_EIO;
+    }
+    pbt += res;
+    szData -= res;
+  }
+  return NFC_SUCCESS;
+}
+
+static int
+nfcd_read_all(int fd, void *pData, size_t szData, int *piFd)
+{
+  uint8_t *pbt = pData;
+  while (szData > 0) {
+    union {
+      struct cmsghdr hdr;
+      uint8_t abt[CMSG_SPACE(sizeof(int))];
+    } control;
+    struct iovec iov = { .iov_base = pbt, .iov_len = szData };
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (piFd) {
+      msg.msg_control = control.abt;
+      msg.msg_controllen = sizeof(control.abt);
+    }
+    ssize_t res = recvmsg(fd, &msg, 0);
+    if (res < 0) {
+      if (errno == EINTR)
+        continue;
+      return NFC_EIO;
+    }
+    if (res == 0)
+      return NFC_EIO;
+    if (piFd) {
+      struct cmsghdr *pcmsg = CMSG_FIRSTHDR(&msg);
+      if (pcmsg && (pcmsg->cmsg_level == SOL_SOCKET) && (pcmsg->cmsg_type == SCM_RIGHTS)) {
+        memcpy(piFd, CMSG_DATA(pcmsg), sizeof(int));
+        piFd = NULL;
+      }
+    }
+    pbt += res;
+    szData -= res;
+  }
+  return NFC_SUCCESS;
+}
+
+static int
+nfcd_connect(const char *pcSocketPath)
+{
+  struct sockaddr_un sun;
+  if (strlen(pcSocketPath) >= sizeof(sun.sun_path))
+    return -1;
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return -1;
+  memset(&sun, 0, sizeof(sun));
+  sun.sun_family = AF_UNIX;
+  strcpy(sun.sun_path, pcSocketPath);
+  if (connect(fd, (struct sockaddr *)&sun, sizeof(sun)) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// One-shot request on a fresh connection, used by scan and abort
+static int
+nfcd_call_once(const char *pcSocketPath, struct nfcd_request *pReq, struct nfcd_response *pRes)
+{
+  int fd = nfcd_connect(pcSocketPath);
+  if (fd < 0)
+    return NFC_EIO;
+  int res;
+  if (((res = nfcd_write_all(fd, pReq, sizeof(*pReq))) == NFC_SUCCESS) &&
+      ((res = nfcd_read_all(fd, pRes, sizeof(*pRes), NULL)) == NFC_SUCCESS)) {
+    res = pRes->iRes;
+  }
+  close(fd);
+  return res;
+}
+
+static void
+nfcd_request_init(struct nfcd_request *pReq, const nfcd_op op, const int timeout)
+{
+  memset(pReq, 0, sizeof(*pReq));
+  pReq->uiOp = op;
+  pReq->iTimeout = timeout;
+}
+
+// Copy a payload into the client ring and return its offset
+static uint32_t
+nfcd_tx_put(nfc_device *pnd, const void *pData, const size_t szData)
+{
+  if (DRIVER_DATA(pnd)->uiTxHead + szData > NFCD_RING_SIZE)
+    DRIVER_DATA(pnd)->uiTxHead = 0;
+  uint32_t uiOffset = DRIVER_DATA(pnd)->uiTxHead;
+  if (szData)
+    memcpy(NFCD_TX_RING(DRIVER_DATA(pnd)->pbtShm) + uiOffset, pData, szData);
+  DRIVER_DATA(pnd)->uiTxHead += szData;
+  return uiOffset;
+}
+
+// Locate a payload in the daemon ring, NULL if the response is inconsistent
+static const uint8_t *
+nfcd_rx_get(nfc_device *pnd, const struct nfcd_response *pRes, const size_t szData)
+{
+  if ((pRes->uiRxOffset > NFCD_RING_SIZE) || (szData > NFCD_RING_SIZE - pRes->uiRxOffset))
+    return NULL;
+  return NFCD_RX_RING(DRIVER_DATA(pnd)->pbtShm) + pRes->uiRxOffset;
+}
+
+static int
+nfcd_call(nfc_device *pnd, const struct nfcd_request *pReq, struct nfcd_response *pRes)
+{
+  if ((nfcd_write_all(DRIVER_DATA(pnd)->iSocket, pReq, sizeof(*pReq)) < 0) ||
+      (nfcd_read_all(DRIVER_DATA(pnd)->iSocket, pRes, sizeof(*pRes), NULL) < 0)) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Lost connection to nfcd");
+    return pnd->last_error = NFC_EIO;
+  }
+  pnd->last_error = pRes->iLastError;
+  return pRes->iRes;
+}
+
+static size_t
+nfcd_scan(const nfc_context *context, nfc_connstring connstrings[], const size_t connstrings_len)
+{
+  (void) context;
+  struct nfcd_request req;
+  struct nfcd_response res;
+  nfcd_request_init(&req, NFCD_OP_LIST, 0);
+  int iDevices = nfcd_call_once(NFCD_DEFAULT_SOCKET, &req, &res);
+  if (iDevices <= 0)
+    return 0;
+  size_t device_found = 0;
+  for (int i = 0; (i < iDevices) && (device_found < connstrings_len); i++) {
+    snprintf(connstrings[device_found], sizeof(nfc_connstring), "%s:%s:%d", NFCD_DRIVER_NAME, NFCD_DEFAULT_SOCKET, i);
+    device_found++;
+  }
+  return device_found;
+}
+
+static void
+nfcd_close(nfc_device *pnd)
+{
+  if (DRIVER_DATA(pnd)->pbtShm)
+    munmap(DRIVER_DATA(pnd)->pbtShm, NFCD_SHM_SIZE);
+  close(DRIVER_DATA(pnd)->iSocket);
+  nfc_device_free(pnd);
+}
+
+static nfc_device *
+nfcd_open(const nfc_context *context, const nfc_connstring connstring)
+{
+  char *pcSocketPath;
+  char *pcIndex;
+  int iIndex = 0;
+  int connstring_decode_level = connstring_decode(connstring, NFCD_DRIVER_NAME, NULL, &pcSocketPath, &pcIndex);
+  if (connstring_decode_level == 3) {
+    if (sscanf(pcIndex, "%10d", &iIndex) != 1) {
+      free(pcSocketPath);
+      free(pcIndex);
+      return NULL;
+    }
+    free(pcIndex);
+  }
+  if (connstring_decode_level < 1) {
+    return NULL;
+  }
+  if (connstring_decode_level < 2) {
+    pcSocketPath = strdup(NFCD_DEFAULT_SOCKET);
+    if (!pcSocketPath) {
+      perror("malloc");
+      return NULL;
+    }
+  }
+
+  log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "Attempt to open device %d of nfcd at %s.", iIndex, pcSocketPath);
+  int fd = nfcd_connect(pcSocketPath);
+  if (fd < 0) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "Unable to connect to nfcd at %s", pcSocketPath);
+    free(pcSocketPath);
+    return NULL;
+  }
+
+  nfc_device *pnd = nfc_device_new(context, connstring);
+  if (!pnd) {
+    perror("malloc");
+    free(pcSocketPath);
+    close(fd);
+    return NULL;
+  }
+  pnd->driver = &nfcd_driver;
+  pnd->driver_data = calloc(1, sizeof(struct nfcd_data));
+  if (!pnd->driver_data) {
+    perror("malloc");
+    free(pcSocketPath);
+    close(fd);
+    nfc_device_free(pnd);
+    return NULL;
+  }
+  DRIVER_DATA(pnd)->iSocket = fd;
+  snprintf(DRIVER_DATA(pnd)->acSocketPath, sizeof(DRIVER_DATA(pnd)->acSocketPath), "%s", pcSocketPath);
+  free(pcSocketPath);
+
+  struct nfcd_request req;
+  struct nfcd_response res;
+  nfcd_request_init(&req, NFCD_OP_OPEN, 0);
+  req.aiArgs[0] = NFCD_PROTOCOL_VERSION;
+  req.aiArgs[1] = iIndex;
+  req.aiArgs[2] = sizeof(nfc_target);
+  int iShm = -1;
+  if ((nfcd_write_all(fd, &req, sizeof(req)) < 0) ||
+      (nfcd_read_all(fd, &res, sizeof(res), &iShm) < 0) ||
+      (res.iRes < 0) || (iShm < 0)) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "nfcd refused to open device %d", iIndex);
+    if (iShm >= 0)
+      close(iShm);
+    nfcd_close(pnd);
+    return NULL;
+  }
+  void *pShm = mmap(NULL, NFCD_SHM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, iShm, 0);
+  close(iShm);
+  if (pShm == MAP_FAILED) {
+    perror("mmap");
+    nfcd_close(pnd);
+    return NULL;
+  }
+  DRIVER_DATA(pnd)->pbtShm = pShm;
+  DRIVER_DATA(pnd)->iCookie = res.iRes;
+  res.abtArg[sizeof(pnd->name) - 1] = '\0';
+  strcpy(pnd->name, (const char *)res.abtArg);
+  return pnd;
+}
+
+static int
+nfcd_simple_call(nfc_device *pnd, const nfcd_op op)
+{
+  struct nfcd_request req;
+  struct nfcd_response res;
+  nfcd_request_init(&req, op, 0);
+  return nfcd_call(pnd, &req, &res);
+}
+
+static int
+nfcd_initiator_init(nfc_device *pnd)
+{
+  return nfcd_simple_call(pnd, NFCD_OP_INITIATOR_INIT);
+}
+
+static int
+nfcd_initiator_init_collision(nfc_device *pnd)
+{
+  return nfcd_simple_call(pnd, NFCD_OP_INITIATOR_INIT_COLLISION);
+}
+
+static int
+nfcd_initiator_init_secure_element(nfc_device *pnd)
+{
+  return nfcd_simple_call(pnd, NFCD_OP_INITIATOR_INIT_SECURE_ELEMENT);
+}
+
+static int
+nfcd_initiator_deselect_target(nfc_device *pnd)
+{
+  return nfcd_simple_call(pnd, NFCD_OP_INITIATOR_DESELECT_TARGET);
+}
+
+static int
+nfcd_idle(nfc_device *pnd)
+{
+  return nfcd_simple_call(pnd, NFCD_OP_IDLE);
+}
+
+/*
+ * The daemon goes through the public selection functions, which cascade
+ * ISO14443A UIDs themselves: undo the cascading done on our side so the UID
+ * is not cascaded twice.
+ */
+static size_t
+nfcd_uncascade_uid(const nfc_modulation nm, const uint8_t *pbtInitData, const size_t szInitData, uint8_t *pbtUid)
+{
+  size_t szUid = 0;
+  size_t i = 0;
+  if (nm.nmt != NMT_ISO14443A) {
+    memcpy(pbtUid, pbtInitData, szInitData);
+    return szInitData;
+  }
+  while (i < szInitData) {
+    if ((szInitData - i > 4) && (pbtInitData[i] == 0x88)) {
+      memcpy(pbtUid + szUid, pbtInitData + i + 1, 3);
+      szUid += 3;
+      i += 4;
+    } else {
+      memcpy(pbtUid + szUid, pbtInitData + i, szInitData - i);
+      szUid += szInitData - i;
+      i = szInitData;
+    }
+  }
+  return szUid;
+}
+
+static int
+nfcd_initiator_select_passive_target(nfc_device *pnd, const nfc_modulation nm, const uint8_t *pbtInitData, const size_t szInitData, nfc_target *pnt)
+{
+  struct nfcd_request req;
+  struct nfcd_response res;
+  uint8_t abtInit[64];
+  if (szInitData > sizeof(abtInit))
+    return pnd->last_error = NFC_EINVARG;
+  nfcd_request_init(&req, NFCD_OP_INITIATOR_SELECT_PASSIVE_TARGET, 0);
+  req.aiArgs[0] = nm.nmt;
+  req.aiArgs[1] = nm.nbr;
+  req.aiArgs[2] = (pnt != NULL);
+  req.uiTxLen = nfcd_uncascade_uid(nm, pbtInitData, szInitData, abtInit);
+  req.uiTxOffset = nfcd_tx_put(pnd, abtInit, req.uiTxLen);
+  int iRes = nfcd_call(pnd, &req, &res);
+  if ((iRes > 0) && pnt)
+    memcpy(pnt, res.abtArg, sizeof(*pnt));
+  return iRes;
+}
+
+static int
+nfcd_initiator_select_passive_targets(nfc_device *pnd, const nfc_modulation nm, const uint8_t *pbtInitData, const size_t szInitData, nfc_target ant[], const size_t szTargets)
+{
+  struct nfcd_request req;
+  struct nfcd_response res;
+  uint8_t abtInit[64];
+  if ((szInitData > sizeof(abtInit)) || (szTargets > NFCD_RING_SIZE / sizeof(nfc_target)))
+    return pnd->last_error = NFC_EINVARG;
+  nfcd_request_init(&req, NFCD_OP_INITIATOR_SELECT_PASSIVE_TARGETS, 0);
+  req.aiArgs[0] = nm.nmt;
+  req.aiArgs[1] = nm.nbr;
+  req.uiTxLen = nfcd_uncascade_uid(nm, pbtInitData, szInitData, abtInit);
+  req.uiTxOffset = nfcd_tx_put(pnd, abtInit, req.uiTxLen);
+  req.uiRxLen = szTargets * sizeof(nfc_target);
+  int iRes = nfcd_call(pnd, &req, &res);
+  if (iRes > 0) {
+    const uint8_t *pbtRx = nfcd_rx_get(pnd, &res, iRes * sizeof(nfc_target));
+    if (!pbtRx || ((size_t) iRes > szTargets))
+      return pnd->last_error = NFC_EIO;
+    memcpy(ant, pbtRx, iRes * sizeof(nfc_target));
+  }
+  return iRes;
+}
+
+static int
+nfcd_initiator_poll_target(nfc_device *pnd, const nfc_modulation *pnmModulations, const size_t szModulations, const uint8_t uiPollNr, const uint8_t btPeriod, nfc_target *pnt)
+{
+  struct nfcd_request req;
+  struct nfcd_response res;
+  if (szModulations * sizeof(nfc_modulation) > NFCD_ARG_SIZE)
+    return pnd->last_error = NFC_EINVARG;
+  nfcd_request_init(&req, NFCD_OP_INITIATOR_POLL_TARGET, 0);
+  req.aiArgs[0] = szModulations;
+  req.aiArgs[1] = uiPollNr;
+  req.aiArgs[2] = btPeriod;
+  req.aiArgs[3] = (pnt != NULL);
+  memcpy(req.abtArg, pnmModulations, szModulations * sizeof(nfc_modulation));
+  int iRes = nfcd_call(pnd, &req, &res);
+  if ((iRes > 0) && pnt)
+    memcpy(pnt, res.abtArg, sizeof(*pnt));
+  return iRes;
+}
+
+static int
+nfcd_initiator_select_dep_target(nfc_device *pnd, const nfc_dep_mode ndm, const nfc_baud_rate nbr, const nfc_dep_info *pndiInitiator, nfc_target *pnt, const int timeout)
+{
+  struct nfcd_request req;
+  struct nfcd_response res;
+  nfcd_request_init(&req, NFCD_OP_INITIATOR_SELECT_DEP_TARGET, timeout);
+  req.aiArgs[0] = ndm;
+  req.aiArgs[1] = nbr;
+  req.aiArgs[2] = (pndiInitiator != NULL);
+  req.aiArgs[3] = (pnt != NULL);
+  if (pndiInitiator)
+    memcpy(req.abtArg, pndiInitiator, sizeof(*pndiInitiator));
+  int iRes = nfcd_call(pnd, &req, &res);
+  if ((iRes > 0) && pnt)
+    memcpy(pnt, res.abtArg, sizeof(*pnt));
+  return iRes;
+}
+
+static int
+nfcd_transceive_bytes(nfc_device *pnd, const nfcd_op op, const int32_t iArg, const uint8_t *pbtTx, const size_t szTx, uint8_t *pbtRx, const size_t szRx, int timeout, uint32_t *cycles)
+{
+  struct nfcd_request req;
+  struct nfcd_response res;
+  if ((szTx > NFCD_RING_SIZE) || (szRx > NFCD_RING_SIZE))
+    return pnd->last_error = NFC_EINVARG;
+  nfcd_request_init(&req, op, timeout);
+  req.aiArgs[0] = iArg;
+  req.aiArgs[1] = cycles ? (int32_t)(*cycles) : 0;
+  req.uiTxLen = szTx;
+  req.uiTxOffset = nfcd_tx_put(pnd, pbtTx, szTx);
+  req.uiRxLen = pbtRx ? szRx : 0;
+  int iRes = nfcd_call(pnd, &req, &res);
+  if ((iRes > 0) && pbtRx) {
+    const uint8_t *pbtData = nfcd_rx_get(pnd, &res, res.uiRxLen);
+    if (!pbtData || (res.uiRxLen > szRx))
+      return pnd->last_error = NFC_EIO;
+    memcpy(pbtRx, pbtData, res.uiRxLen);
+  }
+  if ((iRes >= 0) && cycles)
+    *cycles = res.uiCycles;
+  return iRes;
+}
+
+static int
+nfcd_initiator_transceive_bytes(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, uint8_t *pbtRx, const size_t szRx, int timeout)
+{
+  return nfcd_transceive_bytes(pnd, NFCD_OP_INITIATOR_TRANSCEIVE_BYTES, 0, pbtTx, szTx, pbtRx, szRx, timeout, NULL);
+}
+
+static int
+nfcd_initiator_transceive_bytes_target(nfc_device *pnd, const size_t szTarget, const uint8_t *pbtTx, const size_t szTx, uint8_t *pbtRx, const size_t szRx, int timeout)
+{
+  return nfcd_transceive_bytes(pnd, NFCD_OP_INITIATOR_TRANSCEIVE_BYTES_TARGET, szTarget, pbtTx, szTx, pbtRx, szRx, timeout, NULL);
+}
+
+static int
+nfcd_initiator_transceive_bytes_timed(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, uint8_t *pbtRx, const size_t szRx, uint32_t *cycles)
+{
+  return nfcd_transceive_bytes(pnd, NFCD_OP_INITIATOR_TRANSCEIVE_BYTES_TIMED, 0, pbtTx, szTx, pbtRx, szRx, 0, cycles);
+}
+
+static int
+nfcd_target_send_bytes(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, int timeout)
+{
+  return nfcd_transceive_bytes(pnd, NFCD_OP_TARGET_SEND_BYTES, 0, pbtTx, szTx, NULL, 0, timeout, NULL);
+}
+
+static int
+nfcd_target_send_bytes_chained(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, int timeout)
+{
+  return nfcd_transceive_bytes(pnd, NFCD_OP_TARGET_SEND_BYTES_CHAINED, 0, pbtTx, szTx, NULL, 0, timeout, NULL);
+}
+
+static int
+nfcd_target_receive_bytes(nfc_device *pnd, uint8_t *pbtRx, const size_t szRxLen, int timeout)
+{
+  return nfcd_transceive_bytes(pnd, NFCD_OP_TARGET_RECEIVE_BYTES, 0, NULL, 0, pbtRx, szRxLen, timeout, NULL);
+}
+
+/*
+ * Bit frames: the parity bytes follow the data bytes in the client ring;
+ * in the daemon ring they start uiRxLen bytes after the data.
+ */
+static int
+nfcd_transceive_bits(nfc_device *pnd, const nfcd_op op, const uint8_t *pbtTx, const size_t szTxBits, const uint8_t *pbtTxPar, uint8_t *pbtRx, const size_t szRx, uint8_t *pbtRxPar, uint32_t *cycles)
+{
+  struct nfcd_request req;
+  struct nfcd_response res;
+  const size_t szTxBytes = (szTxBits + 7) / 8;
+  if ((szTxBytes > NFCD_BITS_FRAME_MAX) || (szRx > NFCD_BITS_FRAME_MAX))
+    return pnd->last_error = NFC_EINVARG;
+  nfcd_request_init(&req, op, 0);
+  req.aiArgs[0] = szTxBits;
+  req.aiArgs[1] = (pbtTxPar != NULL);
+  req.aiArgs[2] = (pbtRxPar != NULL);
+  req.aiArgs[3] = cycles ? (int32_t)(*cycles) : 0;
+  if (szTxBytes) {
+    uint8_t abtTx[2 * NFCD_BITS_FRAME_MAX];
+    memcpy(abtTx, pbtTx, szTxBytes);
+    req.uiTxLen = szTxBytes;
+    if (pbtTxPar) {
+      memcpy(abtTx + szTxBytes, pbtTxPar, szTxBytes);
+      req.uiTxLen += szTxBytes;
+    }
+    req.uiTxOffset = nfcd_tx_put(pnd, abtTx, req.uiTxLen);
+  }
+  req.uiRxLen = pbtRx ? szRx : 0;
+  int iRes = nfcd_call(pnd, &req, &res);
+  if ((iRes > 0) && pbtRx) {
+    const uint8_t *pbtData = nfcd_rx_get(pnd, &res, req.uiRxLen + res.uiRxLen);
+    if (!pbtData || (res.uiRxLen > szRx))
+      return pnd->last_error = NFC_EIO;
+    memcpy(pbtRx, pbtData, res.uiRxLen);
+    if (pbtRxPar)
+      memcpy(pbtRxPar, pbtData + req.uiRxLen, res.uiRxLen);
+  }
+  if ((iRes >= 0) && cycles)
+    *cycles = res.uiCycles;
+  return iRes;
+}
+
+static int
+nfcd_initiator_transceive_bits(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTxBits, const uint8_t *pbtTxPar, uint8_t *pbtRx, uint8_t *pbtRxPar)
+{
+  return nfcd_transceive_bits(pnd, NFCD_OP_INITIATOR_TRANSCEIVE_BITS, pbtTx, szTxBits, pbtTxPar, pbtRx, NFCD_BITS_FRAME_MAX, pbtRxPar, NULL);
+}
+
+static int
+nfcd_initiator_transceive_bits_timed(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTxBits, const uint8_t *pbtTxPar, uint8_t *pbtRx, uint8_t *pbtRxPar, uint32_t *cycles)
+{
+  return nfcd_transceive_bits(pnd, NFCD_OP_INITIATOR_TRANSCEIVE_BITS_TIMED, pbtTx, szTxBits, pbtTxPar, pbtRx, NFCD_BITS_FRAME_MAX, pbtRxPar, cycles);
+}
+
+static int
+nfcd_target_send_bits(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTxBits, const uint8_t *pbtTxPar)
+{
+  return nfcd_transceive_bits(pnd, NFCD_OP_TARGET_SEND_BITS, pbtTx, szTxBits, pbtTxPar, NULL, 0, NULL, NULL);
+}
+
+static int
+nfcd_target_receive_bits(nfc_device *pnd, uint8_t *pbtRx, const size_t szRxLen, uint8_t *pbtRxPar)
+{
+  return nfcd_transceive_bits(pnd, NFCD_OP_TARGET_RECEIVE_BITS, NULL, 0, NULL, pbtRx, MIN(szRxLen, NFCD_BITS_FRAME_MAX), pbtRxPar, NULL);
+}
+
+// Operations carrying a target in and out
+static int
+nfcd_target_call(nfc_device *pnd, const nfcd_op op, nfc_target *pnt)
+{
+  struct nfcd_request req;
+  struct nfcd_response res;
+  nfcd_request_init(&req, op, 0);
+  req.aiArgs[0] = (pnt != NULL);
+  if (pnt)
+    memcpy(req.abtArg, pnt, sizeof(*pnt));
+  int iRes = nfcd_call(pnd, &req, &res);
+  if ((iRes >= 0) && pnt)
+    memcpy(pnt, res.abtArg, sizeof(*pnt));
+  return iRes;
+}
+
+static int
+nfcd_initiator_target_is_present(nfc_device *pnd, const nfc_target *pnt)
+{
+  struct nfcd_request req;
+  struct nfcd_response res;
+  nfcd_request_init(&req, NFCD_OP_INITIATOR_TARGET_IS_PRESENT, 0);
+  req.aiArgs[0] = (pnt != NULL);
+  if (pnt)
+    memcpy(req.abtArg, pnt, sizeof(*pnt));
+  return nfcd_call(pnd, &req, &res);
+}
+
+static int
+nfcd_initiator_target_upgrade_bit_rate(nfc_device *pnd, nfc_target *pnt)
+{
+  return nfcd_target_call(pnd, NFCD_OP_INITIATOR_TARGET_UPGRADE_BIT_RATE, pnt);
+}
+
+static int
+nfcd_initiator_target_reactivate(nfc_device *pnd, nfc_target *pnt)
+{
+  return nfcd_target_call(pnd, NFCD_OP_INITIATOR_TARGET_REACTIVATE, pnt);
+}
+
+static int
+nfcd_target_init(nfc_device *pnd, nfc_target *pnt, uint8_t *pbtRx, const size_t szRx, int timeout)
+{
+  struct nfcd_request req;
+  struct nfcd_response res;
+  if (szRx > NFCD_RING_SIZE)
+    return pnd->last_error = NFC_EINVARG;
+  nfcd_request_init(&req, NFCD_OP_TARGET_INIT, timeout);
+  memcpy(req.abtArg, pnt, sizeof(*pnt));
+  req.uiRxLen = szRx;
+  int iRes = nfcd_call(pnd, &req, &res);
+  if (iRes >= 0) {
+    const uint8_t *pbtData = nfcd_rx_get(pnd, &res, res.uiRxLen);
+    if (!pbtData || (res.uiRxLen > szRx))
+      return pnd->last_error = NFC_EIO;
+    memcpy(pbtRx, pbtData, res.uiRxLen);
+    memcpy(pnt, res.abtArg, sizeof(*pnt));
+  }
+  return iRes;
+}
+
+static int
+nfcd_set_property_bool(nfc_device *pnd, const nfc_property property, const bool bEnable)
+{
+  struct nfcd_request req;
+  struct nfcd_response res;
+  nfcd_request_init(&req, NFCD_OP_SET_PROPERTY_BOOL, 0);
+  req.aiArgs[0] = property;
+  req.aiArgs[1] = bEnable;
+  int iRes = nfcd_call(pnd, &req, &res);
+  if (iRes < 0)
+    return iRes;
+  // Keep the flags the generic code reads in sync with the remote device
+  switch (property) {
+    case NP_HANDLE_CRC:
+      pnd->bCrc = bEnable;
+      break;
+    case NP_HANDLE_PARITY:
+      pnd->bPar = bEnable;
+      break;
+    case NP_EASY_FRAMING:
+      pnd->bEasyFraming = bEnable;
+      break;
+    case NP_INFINITE_SELECT:
+      pnd->bInfiniteSelect = bEnable;
+      break;
+    case NP_AUTO_ISO14443_4:
+      pnd->bAutoIso14443_4 = bEnable;
+      break;
+    case NP_AUTO_PPS:
+      pnd->bAutoPps = bEnable;
+      break;
+    default:
+      break;
+  }
+  return iRes;
+}
+
+static int
+nfcd_set_property_int(nfc_device *pnd, const nfc_property property, const int value)
+{
+  struct nfcd_request req;
+  struct nfcd_response res;
+  nfcd_request_init(&req, NFCD_OP_SET_PROPERTY_INT, 0);
+  req.aiArgs[0] = property;
+  req.aiArgs[1] = value;
+  return nfcd_call(pnd, &req, &res);
+}
+
+static int
+nfcd_get_supported_modulation(nfc_device *pnd, const nfc_mode mode, const nfc_modulation_type **const supported_mt)
+{
+  struct nfcd_request req;
+  struct nfcd_response res;
+  nfc_modulation_type *pnmt = DRIVER_DATA(pnd)->anmtSupported[(mode == N_INITIATOR) ? 1 : 0];
+  nfcd_request_init(&req, NFCD_OP_GET_SUPPORTED_MODULATION, 0);
+  req.aiArgs[0] = mode;
+  int iRes = nfcd_call(pnd, &req, &res);
+  if (iRes < 0)
+    return iRes;
+  memcpy(pnmt, res.abtArg, (NFCD_MAX_MODULATION_TYPES - 1) * sizeof(nfc_modulation_type));
+  pnmt[NFCD_MAX_MODULATION_TYPES - 1] = 0;
+  *supported_mt = pnmt;
+  return iRes;
+}
+
+static int
+nfcd_get_supported_baud_rate(nfc_device *pnd, const nfc_mode mode, const nfc_modulation_type nmt, const nfc_baud_rate **const supported_br)
+{
+  struct nfcd_request req;
+  struct nfcd_response res;
+  nfc_baud_rate *pnbr = DRIVER_DATA(pnd)->anbrSupported;
+  nfcd_request_init(&req, NFCD_OP_GET_SUPPORTED_BAUD_RATE, 0);
+  req.aiArgs[0] = mode;
+  req.aiArgs[1] = nmt;
+  int iRes = nfcd_call(pnd, &req, &res);
+  if (iRes < 0)
+    return iRes;
+  memcpy(pnbr, res.abtArg, (NFCD_MAX_BAUD_RATES - 1) * sizeof(nfc_baud_rate));
+  pnbr[NFCD_MAX_BAUD_RATES - 1] = 0;
+  *supported_br = pnbr;
+  return iRes;
+}
+
+static int
+nfcd_get_information_about(nfc_device *pnd, char **pbuf)
+{
+  struct nfcd_request req;
+  struct nfcd_response res;
+  nfcd_request_init(&req, NFCD_OP_GET_INFORMATION_ABOUT, 0);
+  req.uiRxLen = NFCD_RING_SIZE;
+  int iRes = nfcd_call(pnd, &req, &res);
+  if (iRes < 0)
+    return iRes;
+  const uint8_t *pbtData = nfcd_rx_get(pnd, &res, res.uiRxLen);
+  if (!pbtData || (res.uiRxLen == 0))
+    return pnd->last_error = NFC_EIO;
+  *pbuf = malloc(res.uiRxLen);
+  if (!*pbuf)
+    return pnd->last_error = NFC_ESOFT;
+  memcpy(*pbuf, pbtData, res.uiRxLen);
+  (*pbuf)[res.uiRxLen - 1] = '\0';
+  return iRes;
+}
+
+/*
+ * The session is busy with the request being aborted, so the abort goes
+ * through a connection of its own, identified by the session cookie.
+ */
+static int
+nfcd_abort_command(nfc_device *pnd)
+{
+  struct nfcd_request req;
+  struct nfcd_response res;
+  nfcd_request_init(&req, NFCD_OP_ABORT, 0);
+  req.aiArgs[0] = DRIVER_DATA(pnd)->iCookie;
+  return nfcd_call_once(DRIVER_DATA(pnd)->acSocketPath, &req, &res);
+}
+
+const struct nfc_driver nfcd_driver = {
+  .name                             = NFCD_DRIVER_NAME,
+  .scan_type                        = NOT_INTRUSIVE,
+  .scan                             = nfcd_scan,
+  .open                             = nfcd_open,
+  .close                            = nfcd_close,
+
+  .initiator_init                   = nfcd_initiator_init,
+  .initiator_init_collision         = nfcd_initiator_init_collision,
+  .initiator_init_secure_element    = nfcd_initiator_init_secure_element,
+  .initiator_select_passive_target  = nfcd_initiator_select_passive_target,
+  .initiator_select_passive_targets = nfcd_initiator_select_passive_targets,
+  .initiator_poll_target            = nfcd_initiator_poll_target,
+  .initiator_select_dep_target      = nfcd_initiator_select_dep_target,
+  .initiator_deselect_target        = nfcd_initiator_deselect_target,
+  .initiator_transceive_bytes       = nfcd_initiator_transceive_bytes,
+  .initiator_transceive_bytes_target = nfcd_initiator_transceive_bytes_target,
+  .initiator_transceive_bits        = nfcd_initiator_transceive_bits,
+  .initiator_transceive_bytes_timed = nfcd_initiator_transceive_bytes_timed,
+  .initiator_transceive_bits_timed  = nfcd_initiator_transceive_bits_timed,
+  .initiator_target_is_present      = nfcd_initiator_target_is_present,
+  .initiator_target_upgrade_bit_rate = nfcd_initiator_target_upgrade_bit_rate,
+  .initiator_target_reactivate = nfcd_initiator_target_reactivate,
+
+  .target_init           = nfcd_target_init,
+  .target_send_bytes     = nfcd_target_send_bytes,
+  .target_send_bytes_chained = nfcd_target_send_bytes_chained,
+  .target_receive_bytes  = nfcd_target_receive_bytes,
+  .target_send_bits      = nfcd_target_send_bits,
+  .target_receive_bits   = nfcd_target_receive_bits,
+
+  .device_set_property_bool     = nfcd_set_property_bool,
+  .device_set_property_int      = nfcd_set_property_int,
+  .get_supported_modulation     = nfcd_get_supported_modulation,
+  .get_supported_baud_rate      = nfcd_get_supported_baud_rate,
+  .device_get_information_about = nfcd_get_information_about,
+
+  .abort_command  = nfcd_abort_command,
+  .idle           = nfcd_idle,
+  .powerdown      = NULL,
+  .reset          = NULL,
+};
@@ -0,0 +1,145 @@
+/*-
+ * Free/Libre Near Field Communication (NFC) library
+ *
+ * Libnfc historical contributors:
+ * Copyright (C) 2009      Roel Verdult
+ * Copyright (C) 2009-2013 Romuald Conty
+ * Copyright (C) 2010-2012 Romain Tarti?re
+ * Copyright (C) 2010-2013 Philippe Teuwen
+ * Copyright (C) 2012-2013 Ludovic Rousseau
+ * See AUTHORS file for a more comprehensive list of contributors.
+ * Additional contributors of this file:
+ * Copyright (C) 2013      Laurent Latil
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+/**
+ * @file nfcd.h
+ * @brief Client driver for devices shared by the nfcd daemon
+ *
+ * This header also defines the wire protocol spoken between this driver and
+ * the daemon (utils/nfcd.c): fixed-size requests and responses travel over a
+ * Unix stream socket, while frame payloads are exchanged through a shared
+ * memory segment the daemon creates for each client and passes along with
+ * the reply to NFCD_OP_OPEN.
+ */
+
+#ifndef __NFC_DRIVER_NFCD_H__
+#define __NFC_DRIVER_NFCD_H__
+
+#include <nfc/nfc-types.h>
+
+#define NFCD_DRIVER_NAME "nfcd"
+#define NFCD_DEFAULT_SOCKET "/var/run/nfcd.sock"
+
+/* Bumped each time requests, responses or the shared layout change */
+#define NFCD_PROTOCOL_VERSION 2
+
+/*
+ * Shared memory segment: one ring for client-to-daemon payloads followed by
+ * one ring for daemon-to-client payloads. Each ring has a single writer that
+ * keeps its own write offset and wraps to 0 when a payload does not fit in
+ * the remaining space; as the protocol is synchronous, a payload is always
+ * consumed before the next one is written. A ring holds an extended length
+ * C-APDU or R-APDU (ISO/IEC 7816-4) in one payload.
+ */
+#define NFCD_RING_SIZE    131072
+#define NFCD_SHM_SIZE     (2 * NFCD_RING_SIZE)
+#define NFCD_TX_RING(base) ((uint8_t *)(base))
+#define NFCD_RX_RING(base) ((uint8_t *)(base) + NFCD_RING_SIZE)
+
+/* Room for in-band arguments (nfc_target, nfc_dep_info, modulation lists...) */
+#define NFCD_ARG_SIZE 512
+
+/* Largest frame a bit-oriented exchange may return */
+#define NFCD_BITS_FRAME_MAX 512
+
+typedef enum {
+  NFCD_OP_LIST = 1,
+  NFCD_OP_OPEN,
+  NFCD_OP_ABORT,
+  NFCD_OP_INITIATOR_INIT,
+  NFCD_OP_INITIATOR_INIT_COLLISION,
+  NFCD_OP_INITIATOR_INIT_SECURE_ELEMENT,
+  NFCD_OP_INITIATOR_SELECT_PASSIVE_TARGET,
+  NFCD_OP_INITIATOR_SELECT_PASSIVE_TARGETS,
+  NFCD_OP_INITIATOR_POLL_TARGET,
+  NFCD_OP_INITIATOR_SELECT_DEP_TARGET,
+  NFCD_OP_INITIATOR_DESELECT_TARGET,
+  NFCD_OP_INITIATOR_TRANSCEIVE_BYTES,
+  NFCD_OP_INITIATOR_TRANSCEIVE_BYTES_TARGET,
+  NFCD_OP_INITIATOR_TRANSCEIVE_BITS,
+  NFCD_OP_INITIATOR_TRANSCEIVE_BYTES_TIMED,
+  NFCD_OP_INITIATOR_TRANSCEIVE_BITS_TIMED,
+  NFCD_OP_INITIATOR_TARGET_IS_PRESENT,
+  NFCD_OP_INITIATOR_TARGET_UPGRADE_BIT_RATE,
+  NFCD_OP_INITIATOR_TARGET_REACTIVATE,
+  NFCD_OP_TARGET_INIT,
+  NFCD_OP_TARGET_SEND_BYTES,
+  NFCD_OP_TARGET_RECEIVE_BYTES,
+  NFCD_OP_TARGET_SEND_BITS,
+  NFCD_OP_TARGET_RECEIVE_BITS,
+  NFCD_OP_SET_PROPERTY_BOOL,
+  NFCD_OP_SET_PROPERTY_INT,
+  NFCD_OP_GET_SUPPORTED_MODULATION,
+  NFCD_OP_GET_SUPPORTED_BAUD_RATE,
+  NFCD_OP_GET_INFORMATION_ABOUT,
+  NFCD_OP_IDLE,
+  NFCD_OP_TARGET_SEND_BYTES_CHAINED,
+} nfcd_op;
+
+/*
+ * Request, sent by the client. aiArgs[] carries scalar arguments, abtArg
+ * structured ones; uiTx* locate the payload in the client ring and uiRxLen
+ * is the room the caller has for the answer.
+ *
+ * NFCD_OP_LIST:  no argument
+ * NFCD_OP_OPEN:  aiArgs[0] = NFCD_PROTOCOL_VERSION, aiArgs[1] = device index,
+ *                aiArgs[2] = sizeof(nfc_target)
+ * NFCD_OP_ABORT: aiArgs[0] = session cookie returned by NFCD_OP_OPEN, only
+ *                honoured from the process which opened the session
+ */
+struct nfcd_request {
+  uint32_t uiOp;
+  int32_t  iTimeout;
+  int32_t  aiArgs[4];
+  uint32_t uiTxOffset;
+  uint32_t uiTxLen;
+  uint32_t uiRxLen;
+  uint8_t  abtArg[NFCD_ARG_SIZE];
+};
+
+/*
+ * Response, sent by the daemon. iRes is the value returned by the device
+ * function and iLastError the device last error; uiRx* locate any payload in
+ * the daemon ring.
+ *
+ * NFCD_OP_LIST: iRes = number of devices
+ * NFCD_OP_OPEN: iRes = session cookie, abtArg = device name, the shared
+ *               memory file descriptor is attached as SCM_RIGHTS
+ */
+struct nfcd_response {
+  int32_t  iRes;
+  int32_t  iLastError;
+  uint32_t uiRxOffset;
+  uint32_t uiRxLen;
+  uint32_t uiCycles;
+  uint8_t  abtArg[NFCD_ARG_SIZE];
+};
+
+/* Reference to the nfcd driver structure */
+extern const struct nfc_driver nfcd_driver;
+
+#endif // ! __NFC_DRIVER_NFCD_H__
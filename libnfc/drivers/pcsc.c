@@ -102,8 +102,10 @@ struct pcsc_data {
 
 #define DRIVER_DATA(pnd) ((struct pcsc_data*)(pnd->driver_data))
 
+// Shared by all contexts and devices, _iSCardContextRefCount is guarded by _SCardContextMutex
 static SCARDCONTEXT _SCardContext;
 static int _iSCardContextRefCount = 0;
+static nfc_mutex _SCardContextMutex = NFC_MUTEX_INITIALIZER;
 
 const nfc_baud_rate pcsc_supported_brs[] = {NBR_106, NBR_424, 0};
 const nfc_modulation_type pcsc_supported_mts[] = {NMT_ISO14443A, NMT_ISO14443B, 0};
@@ -111,24 +113,31 @@ const nfc_modulation_type pcsc_supported_mts[] = {NMT_ISO14443A, NMT_ISO14443B,
 static SCARDCONTEXT *
 pcsc_get_scardcontext(void)
 {
+  SCARDCONTEXT *pscc = &_SCardContext;
+
+  nfc_mutex_lock(&_SCardContextMutex);
   if (_iSCardContextRefCount == 0) {
     if (SCardEstablishContext(SCARD_SCOPE_USER, NULL, NULL, &_SCardContext) != SCARD_S_SUCCESS)
-      return NULL;
+      pscc = NULL;
   }
-  _iSCardContextRefCount++;
+  if (pscc)
+    _iSCardContextRefCount++;
+  nfc_mutex_unlock(&_SCardContextMutex);
 
-  return &_SCardContext;
+  return pscc;
 }
 
 static void
 pcsc_free_scardcontext(void)
 {
+  nfc_mutex_lock(&_SCardContextMutex);
   if (_iSCardContextRefCount) {
     _iSCardContextRefCount--;
     if (!_iSCardContextRefCount) {
       SCardReleaseContext(_SCardContext);
     }
   }
+  nfc_mutex_unlock(&_SCardContextMutex);
 }
 
 #define ICC_TYPE_UNKNOWN 0
@@ -931,6 +940,8 @@ static int pcsc_device_set_property_bool(struct nfc_device *pnd, const nfc_prope
       break;
     case NP_ACCEPT_INVALID_FRAMES:
     case NP_ACCEPT_MULTIPLE_FRAMES:
+    case NP_AUTO_PPS:
+    case NP_ADAPTIVE_TIMEOUT:
       if (bEnable == false)
         return NFC_SUCCESS;
       break;
@@ -1055,11 +1066,13 @@ const struct nfc_driver pcsc_driver = {
   .initiator_select_passive_target  = pcsc_initiator_select_passive_target,
   .initiator_poll_target            = NULL,
   .initiator_select_dep_target      = NULL,
+  .initiator_dep_psl                = NULL,
   .initiator_deselect_target        = NULL,
   .initiator_transceive_bytes       = pcsc_initiator_transceive_bytes,
   .initiator_transceive_bits        = NULL,
   .initiator_transceive_bytes_timed = NULL,
   .initiator_transceive_bits_timed  = NULL,
+  .initiator_last_collision         = NULL,
   .initiator_target_is_present      = pcsc_initiator_target_is_present,
 
   .target_init           = NULL,
@@ -42,6 +42,7 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <time.h>
+#include <sys/uio.h>
 
 #include <nfc/nfc.h>
 
@@ -72,6 +73,8 @@ const struct pn53x_io pn532_i2c_io;
 struct pn532_i2c_data {
   i2c_device dev;
   volatile bool abort_flag;
+  // End of the last bus transaction
+  struct timespec transaction_stop;
 };
 
 /* preamble and start bytes, see pn532-internal.h for details */
@@ -92,7 +95,7 @@ static int pn532_i2c_abort_command(nfc_device *pnd);
 
 static int pn532_i2c_wakeup(nfc_device *pnd);
 
-static int pn532_i2c_wait_rdyframe(nfc_device *pnd, uint8_t *pbtData, const size_t szDataLen, int timeout);
+static int pn532_i2c_wait_rdyframe(nfc_device *pnd, const struct iovec *aiov, const size_t szIov, int timeout);
 
 static size_t pn532_i2c_scan(const nfc_context *context, nfc_connstring connstrings[], const size_t connstrings_len);
 
@@ -100,38 +103,65 @@ static size_t pn532_i2c_scan(const nfc_context *context, nfc_connstring connstri
 #define DRIVER_DATA(pnd) ((struct pn532_i2c_data*)(pnd->driver_data))
 
 /*
- * Bus free time (in ms) between a STOP condition and START condition. See
+ * Bus free time (in us) between a STOP condition and START condition. See
  * tBuf in the PN532 data sheet, section 12.25: Timing for the I2C interface,
  * table 320. I2C timing specification, page 211, rev. 3.2 - 2007-12-07.
  */
 #define PN532_BUS_FREE_TIME 5
-static struct timespec __transaction_stop;
+
+/*
+ * Delay (in us) between two polls of the status byte while the PN532 is busy.
+ * It starts short so that quick answers (e.g. ACK frames) are picked up early,
+ * then doubles after each busy status up to the maximum so that long running
+ * commands do not keep the bus busy.
+ */
+#define PN532_I2C_POLL_MIN_DELAY 500
+#define PN532_I2C_POLL_MAX_DELAY 8000
+
+// Longest frame header: preamble and start code, extended LEN and LCS
+#define PN532_I2C_HEADER_LEN 8
+
+// Largest number of buffers a frame is scattered over (status byte included)
+#define PN532_I2C_MAX_IOV 4
 
 /**
- * @brief Wrapper around i2c_read to ensure proper timing by respecting the
- * 	  minimal free bus time between a STOP condition and a START condition.
+ * @brief Wait until the minimal free bus time since the end of the last
+ *        transaction has elapsed.
  *
- * @note This is not thread safe, but since libnfc is single threaded
- * 	 this should be okay.
+ * @param pnd \a nfc_device struct pointer, which keeps track of its last transaction
+ */
+static void
+pn532_i2c_bus_free(nfc_device *pnd)
+{
+  struct timespec now;
+  int64_t elapsed;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  elapsed = (int64_t)(now.tv_sec - DRIVER_DATA(pnd)->transaction_stop.tv_sec) * 1000000000 +
+            (now.tv_nsec - DRIVER_DATA(pnd)->transaction_stop.tv_nsec);
+  if (elapsed < PN532_BUS_FREE_TIME * 1000) {
+    struct timespec bus_free_time = { 0, (long)(PN532_BUS_FREE_TIME * 1000 - elapsed) };
+    nanosleep(&bus_free_time, NULL);
+  }
+}
+
+/**
+ * @brief Wrapper around i2c_read_scatter to ensure proper timing by respecting
+ * 	  the minimal free bus time between a STOP condition and a START condition.
  *
- * @param id I2C device
- * @param buf pointer on buffer used to store data
- * @param len length of the buffer
+ * @param pnd \a nfc_device struct pointer, which keeps track of its last transaction
+ * @param aiov array of buffers used to store data, in frame order
+ * @param szIov number of buffers
  * @return length (in bytes) of read data, or driver error code (negative value)
  */
-static ssize_t pn532_i2c_read(const i2c_device id,
-                              uint8_t *buf, const size_t len)
+static ssize_t pn532_i2c_read(nfc_device *pnd,
+                              const struct iovec *aiov, const size_t szIov)
 {
-  struct timespec transaction_start, bus_free_time = { 0, 0 };
   ssize_t ret;
 
-  clock_gettime(CLOCK_MONOTONIC, &transaction_start);
-  bus_free_time.tv_nsec = (PN532_BUS_FREE_TIME * 1000 * 1000) -
-                          (transaction_start.tv_nsec - __transaction_stop.tv_nsec);
-  nanosleep(&bus_free_time, NULL);
-
-  ret = i2c_read(id, buf, len);
-  clock_gettime(CLOCK_MONOTONIC, &__transaction_stop);
+  pn532_i2c_bus_free(pnd);
+  ret = i2c_read_scatter(DRIVER_DATA(pnd)->dev, aiov, szIov);
+  clock_gettime(CLOCK_MONOTONIC, &DRIVER_DATA(pnd)->transaction_stop);
   return ret;
 }
 
@@ -139,27 +169,19 @@ static ssize_t pn532_i2c_read(const i2c_device id,
  * @brief Wrapper around i2c_write to ensure proper timing by respecting the
  * 	  minimal free bus time between a STOP condition and a START condition.
  *
- * @note This is not thread safe, but since libnfc is single threaded
- * 	 this should be okay.
- *
- * @param id I2C device
+ * @param pnd \a nfc_device struct pointer, which keeps track of its last transaction
  * @param buf pointer on buffer containing data
  * @param len length of the buffer
  * @return NFC_SUCCESS on success, otherwise driver error code
  */
-static ssize_t pn532_i2c_write(const i2c_device id,
+static ssize_t pn532_i2c_write(nfc_device *pnd,
                                const uint8_t *buf, const size_t len)
 {
-  struct timespec transaction_start, bus_free_time = { 0, 0 };
   ssize_t ret;
 
-  clock_gettime(CLOCK_MONOTONIC, &transaction_start);
-  bus_free_time.tv_nsec = (PN532_BUS_FREE_TIME * 1000 * 1000) -
-                          (transaction_start.tv_nsec - __transaction_stop.tv_nsec);
-  nanosleep(&bus_free_time, NULL);
-
-  ret = i2c_write(id, buf, len);
-  clock_gettime(CLOCK_MONOTONIC, &__transaction_stop);
+  pn532_i2c_bus_free(pnd);
+  ret = i2c_write(DRIVER_DATA(pnd)->dev, buf, len);
+  clock_gettime(CLOCK_MONOTONIC, &DRIVER_DATA(pnd)->transaction_stop);
   return ret;
 }
 
@@ -213,6 +235,8 @@ pn532_i2c_scan(const nfc_context *context, nfc_connstring connstrings[], const s
         return 0;
       }
       DRIVER_DATA(pnd)->dev = id;
+      DRIVER_DATA(pnd)->transaction_stop.tv_sec = 0;
+      DRIVER_DATA(pnd)->transaction_stop.tv_nsec = 0;
 
       // Alloc and init chip's data
       if (pn53x_data_new(pnd, &pn532_i2c_io) == NULL) {
@@ -321,6 +345,8 @@ pn532_i2c_open(const nfc_context *context, const nfc_connstring connstring)
     return NULL;
   }
   DRIVER_DATA(pnd)->dev = i2c_dev;
+  DRIVER_DATA(pnd)->transaction_stop.tv_sec = 0;
+  DRIVER_DATA(pnd)->transaction_stop.tv_nsec = 0;
 
   // Alloc and init chip's data
   if (pn53x_data_new(pnd, &pn532_i2c_io) == NULL) {
@@ -341,6 +367,10 @@ pn532_i2c_open(const nfc_context *context, const nfc_connstring connstring)
 
   DRIVER_DATA(pnd)->abort_flag = false;
 
+  // A verified cached description replaces the communication check and pn53x_init()
+  if (pn53x_init_cached(pnd) == NFC_SUCCESS)
+    return pnd;
+
   // Check communication using "Diagnose" command, with "Communication test" (0x00)
   if (pn53x_check_communication(pnd) < 0) {
     nfc_perror(pnd, "pn53x_check_communication");
@@ -412,7 +442,7 @@ pn532_i2c_send(nfc_device *pnd, const uint8_t *pbtData, const size_t szData, int
   }
 
   for (retries = PN532_SEND_RETRIES; retries > 0; retries--) {
-    res = pn532_i2c_write(DRIVER_DATA(pnd)->dev, abtFrame, szFrame);
+    res = pn532_i2c_write(pnd, abtFrame, szFrame);
     if (res >= 0)
       break;
 
@@ -426,9 +456,10 @@ pn532_i2c_send(nfc_device *pnd, const uint8_t *pbtData, const size_t szData, int
   }
 
   uint8_t abtRxBuf[PN53x_ACK_FRAME__LEN];
+  const struct iovec iovAck = { abtRxBuf, sizeof(abtRxBuf) };
 
   // Wait for the ACK frame
-  res = pn532_i2c_wait_rdyframe(pnd, abtRxBuf, sizeof(abtRxBuf), timeout);
+  res = pn532_i2c_wait_rdyframe(pnd, &iovAck, 1, timeout);
   if (res < 0) {
     if (res == NFC_EOPABORTED) {
       // Send an ACK frame from host to abort the command.
@@ -447,35 +478,22 @@ pn532_i2c_send(nfc_device *pnd, const uint8_t *pbtData, const size_t szData, int
 }
 
 /**
- * @brief Read data from the PN532 device until getting a frame with RDY bit set
+ * @brief Poll the status byte of the PN532 device until its RDY bit is set
  *
  * @param pnd pointer on the NFC device.
- * @param pbtData buffer used to store the received frame data.
- * @param szDataLen allocated size of buffer.
- * @param timeout timeout delay before aborting the operation (in ms). Use 0 for no timeout.
- * @return length (in bytes) of the received frame, or NFC_ETIMEOUT if timeout delay has expired,
+ * @param deadline point in time after which waiting is given up (0 for none).
+ * @return NFC_SUCCESS once the PN532 is ready, or NFC_ETIMEOUT if the deadline has passed,
  *         NFC_EOPABORTED if operation has been aborted, NFC_EIO in case of IO failure
  */
 static int
-pn532_i2c_wait_rdyframe(nfc_device *pnd, uint8_t *pbtData, const size_t szDataLen, int timeout)
+pn532_i2c_wait_ready(nfc_device *pnd, const nfc_deadline deadline)
 {
-  bool done = false;
-  int res;
+  long lDelay = PN532_I2C_POLL_MIN_DELAY;
+  uint8_t btStatus;
+  const struct iovec iovStatus = { &btStatus, 1 };
 
-  struct timeval start_tv, cur_tv;
-  long long duration;
-
-  // Actual I2C response frame includes an additional status byte,
-  // so we use a temporary buffer to read the I2C frame
-  uint8_t i2cRx[PN53x_EXTENDED_FRAME__DATA_MAX_LEN + 1];
-
-  if (timeout > 0) {
-    // If a timeout is specified, get current timestamp
-    gettimeofday(&start_tv, NULL);
-  }
-
-  do {
-    int recCount = pn532_i2c_read(DRIVER_DATA(pnd)->dev, i2cRx, szDataLen + 1);
+  for (;;) {
+    ssize_t recCount = pn532_i2c_read(pnd, &iovStatus, 1);
 
     if (DRIVER_DATA(pnd)->abort_flag) {
       // Reset abort flag
@@ -487,43 +505,90 @@ pn532_i2c_wait_rdyframe(nfc_device *pnd, uint8_t *pbtData, const size_t szDataLe
     }
 
     if (recCount <= 0) {
-      done = true;
-      res = NFC_EIO;
-    } else {
-      const uint8_t rdy = i2cRx[0];
-      if (rdy & 1) {
-        int copyLength;
-
-        done = true;
-        res = recCount - 1;
-        copyLength = MIN(res, (int)szDataLen);
-        memcpy(pbtData, &(i2cRx[1]), copyLength);
-      } else {
-        /* Not ready yet. Check for elapsed timeout. */
-
-        if (timeout > 0) {
-          gettimeofday(&cur_tv, NULL);
-          duration = (cur_tv.tv_sec - start_tv.tv_sec) * 1000000L
-                     + (cur_tv.tv_usec - start_tv.tv_usec);
-
-          if (duration / 1000 > timeout) {
-            res = NFC_ETIMEOUT;
-            done = true;
-
-            log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG,
-                    "timeout reached with no READY frame.");
-          }
-        }
-      }
+      return NFC_EIO;
     }
-  } while (!done);
+    if (btStatus & 1) {
+      return NFC_SUCCESS;
+    }
+
+    /* Not ready yet. Check for elapsed timeout, then back off. */
+    const int remaining = nfc_deadline_remaining(deadline);
+    if (remaining < 0) {
+      log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG,
+              "timeout reached with no READY frame.");
+      return NFC_ETIMEOUT;
+    }
+
+    struct timespec delay = { 0, lDelay * 1000 };
+    if ((remaining > 0) && ((long) remaining * 1000 < lDelay)) {
+      delay.tv_nsec = (long) remaining * 1000 * 1000;
+    }
+    nanosleep(&delay, NULL);
+    lDelay = MIN(lDelay * 2, PN532_I2C_POLL_MAX_DELAY);
+  }
+}
+
+/**
+ * @brief Read a frame from the PN532 device once it is ready
+ *
+ * Each read transaction starts over with the status byte and the beginning
+ * of the pending frame, which is scattered over the given buffers.
+ *
+ * @param pnd pointer on the NFC device.
+ * @param aiov array of buffers used to store the frame, in frame order.
+ * @param szIov number of buffers (at most PN532_I2C_MAX_IOV - 1).
+ * @return length (in bytes) of the received frame, or NFC_EIO in case of IO failure
+ */
+static int
+pn532_i2c_read_frame(nfc_device *pnd, const struct iovec *aiov, const size_t szIov)
+{
+  uint8_t btStatus;
+  struct iovec aiovFrame[PN532_I2C_MAX_IOV];
+
+  aiovFrame[0].iov_base = &btStatus;
+  aiovFrame[0].iov_len = 1;
+  memcpy(&aiovFrame[1], aiov, szIov * sizeof(struct iovec));
 
-  return res;
+  ssize_t recCount = pn532_i2c_read(pnd, aiovFrame, szIov + 1);
+  if (recCount <= 0) {
+    return NFC_EIO;
+  }
+  if (!(btStatus & 1)) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Frame read while the PN532 is not ready");
+    return NFC_EIO;
+  }
+  return (int)(recCount - 1);
+}
+
+/**
+ * @brief Wait for the PN532 device to get ready, then read its frame
+ *
+ * @param pnd pointer on the NFC device.
+ * @param aiov array of buffers used to store the frame, in frame order.
+ * @param szIov number of buffers (at most PN532_I2C_MAX_IOV - 1).
+ * @param timeout timeout delay before aborting the operation (in ms). Use 0 for no timeout.
+ * @return length (in bytes) of the received frame, or NFC_ETIMEOUT if timeout delay has expired,
+ *         NFC_EOPABORTED if operation has been aborted, NFC_EIO in case of IO failure
+ */
+static int
+pn532_i2c_wait_rdyframe(nfc_device *pnd, const struct iovec *aiov, const size_t szIov, int timeout)
+{
+  int res;
+
+  // Monotonic, so that wall-clock adjustments cannot stretch or cut the wait
+  if ((res = pn532_i2c_wait_ready(pnd, nfc_deadline_from_timeout(timeout))) < 0) {
+    return res;
+  }
+  return pn532_i2c_read_frame(pnd, aiov, szIov);
 }
 
 /**
  * @brief Read a response frame from the PN532 device.
  *
+ * Once the PN532 is ready, the frame header is read first to learn the frame
+ * length, then the whole frame is read again with its data stored directly in
+ * \a pbtData.
+ *
  * @param pnd pointer on the NFC device.
  * @param pbtData buffer used to store the response frame data.
  * @param szDataLen allocated size of buffer.
@@ -534,38 +599,45 @@ pn532_i2c_wait_rdyframe(nfc_device *pnd, uint8_t *pbtData, const size_t szDataLe
 static int
 pn532_i2c_receive(nfc_device *pnd, uint8_t *pbtData, const size_t szDataLen, int timeout)
 {
-  uint8_t frameBuf[PN53x_EXTENDED_FRAME__DATA_MAX_LEN];
-  int frameLength;
+  uint8_t abtHeader[PN532_I2C_HEADER_LEN];
+  uint8_t abtPrefix[PN532_I2C_HEADER_LEN + 2];
+  uint8_t abtTrailer[2];
+  struct iovec aiov[3];
+  int res;
   int TFI_idx;
   size_t len;
 
-  frameLength = pn532_i2c_wait_rdyframe(pnd, frameBuf, sizeof(frameBuf), timeout);
+  aiov[0].iov_base = abtHeader;
+  aiov[0].iov_len = sizeof(abtHeader);
+  res = pn532_i2c_wait_rdyframe(pnd, aiov, 1, timeout);
 
-  if (NFC_EOPABORTED == pnd->last_error) {
-    return pn532_i2c_ack(pnd);
+  if (NFC_EOPABORTED == res) {
+    pn532_i2c_ack(pnd);
+    return NFC_EOPABORTED;
   }
 
-  if (frameLength < 0) {
+  if (res < 0) {
+    pnd->last_error = res;
     goto error;
   }
 
-  if (0 != (memcmp(frameBuf, pn53x_preamble_and_start, PN53X_PREAMBLE_AND_START_LEN))) {
+  if (0 != (memcmp(abtHeader, pn53x_preamble_and_start, PN53X_PREAMBLE_AND_START_LEN))) {
     log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Frame preamble+start code mismatch");
     pnd->last_error = NFC_EIO;
     goto error;
   }
 
-  if ((0x01 == frameBuf[3]) && (0xff == frameBuf[4])) {
-    uint8_t errorCode = frameBuf[5];
+  if ((0x01 == abtHeader[3]) && (0xff == abtHeader[4])) {
+    uint8_t errorCode = abtHeader[5];
     log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "Application level error detected  (%d)", errorCode);
     pnd->last_error = NFC_EIO;
     goto error;
-  } else if ((0xff == frameBuf[3]) && (0xff == frameBuf[4])) {
+  } else if ((0xff == abtHeader[3]) && (0xff == abtHeader[4])) {
     // Extended frame
-    len = (frameBuf[5] << 8) + frameBuf[6];
+    len = (abtHeader[5] << 8) + abtHeader[6];
 
     // Verify length checksum
-    if (((frameBuf[5] + frameBuf[6] + frameBuf[7]) % 256) != 0) {
+    if (((abtHeader[5] + abtHeader[6] + abtHeader[7]) % 256) != 0) {
       log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "Length checksum mismatch");
       pnd->last_error = NFC_EIO;
       goto error;
@@ -574,10 +646,10 @@ pn532_i2c_receive(nfc_device *pnd, uint8_t *pbtData, const size_t szDataLen, int
   } else {
     // Normal frame
 
-    len = frameBuf[3];
+    len = abtHeader[3];
 
     // Verify length checksum
-    if ((uint8_t)(frameBuf[3] + frameBuf[4])) {
+    if ((uint8_t)(abtHeader[3] + abtHeader[4])) {
       log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Length checksum mismatch");
       pnd->last_error = NFC_EIO;
       goto error;
@@ -591,26 +663,44 @@ pn532_i2c_receive(nfc_device *pnd, uint8_t *pbtData, const size_t szDataLen, int
     goto error;
   }
 
-  uint8_t TFI = frameBuf[TFI_idx];
+  // Read exactly the announced frame: header up to the command code, data, DCS and postamble
+  aiov[0].iov_base = abtPrefix;
+  aiov[0].iov_len = TFI_idx + 2;
+  aiov[1].iov_base = pbtData;
+  aiov[1].iov_len = len - 2;
+  aiov[2].iov_base = abtTrailer;
+  aiov[2].iov_len = sizeof(abtTrailer);
+  if ((res = pn532_i2c_read_frame(pnd, aiov, 3)) < 0) {
+    pnd->last_error = res;
+    goto error;
+  }
+
+  if (0 != memcmp(abtPrefix, abtHeader, MIN(sizeof(abtHeader), (size_t)(TFI_idx + 2)))) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Frame header changed between reads");
+    pnd->last_error = NFC_EIO;
+    goto error;
+  }
+
+  uint8_t TFI = abtPrefix[TFI_idx];
   if (TFI != 0xD5) {
     log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "TFI Mismatch");
     pnd->last_error = NFC_EIO;
     goto error;
   }
 
-  if (frameBuf[TFI_idx + 1] != CHIP_DATA(pnd)->last_command + 1) {
+  if (abtPrefix[TFI_idx + 1] != CHIP_DATA(pnd)->last_command + 1) {
     log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "Command Code verification failed.  (got %d,  expected %d)",
-            frameBuf[TFI_idx + 1], CHIP_DATA(pnd)->last_command + 1);
+            abtPrefix[TFI_idx + 1], CHIP_DATA(pnd)->last_command + 1);
     pnd->last_error = NFC_EIO;
     goto error;
   }
 
-  uint8_t DCS = frameBuf[TFI_idx + len];
-  uint8_t btDCS = DCS;
+  uint8_t DCS = abtTrailer[0];
+  uint8_t btDCS = DCS + TFI + abtPrefix[TFI_idx + 1];
 
   // Compute data checksum
-  for (size_t i = 0; i < len; i++) {
-    btDCS += frameBuf[TFI_idx + i];
+  for (size_t i = 0; i < len - 2; i++) {
+    btDCS += pbtData[i];
   }
 
   if (btDCS != 0) {
@@ -619,14 +709,12 @@ pn532_i2c_receive(nfc_device *pnd, uint8_t *pbtData, const size_t szDataLen, int
     goto error;
   }
 
-  if (0x00 != frameBuf[TFI_idx + len + 1]) {
-    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "Frame postamble mismatch  (got %d)", frameBuf[frameLength - 1]);
+  if (0x00 != abtTrailer[1]) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "Frame postamble mismatch  (got %d)", abtTrailer[1]);
     pnd->last_error = NFC_EIO;
     goto error;
   }
 
-  memcpy(pbtData, &frameBuf[TFI_idx + 2], len - 2);
-
   /* The PN53x command is done and we successfully received the reply */
   return len - 2;
 error:
@@ -642,7 +730,7 @@ error:
 int
 pn532_i2c_ack(nfc_device *pnd)
 {
-  return pn532_i2c_write(DRIVER_DATA(pnd)->dev, pn53x_ack_frame, sizeof(pn53x_ack_frame));
+  return pn532_i2c_write(pnd, pn53x_ack_frame, sizeof(pn53x_ack_frame));
 }
 
 /**
@@ -677,17 +765,24 @@ const struct nfc_driver pn532_i2c_driver = {
   .initiator_init_collision         = pn53x_initiator_init_collision,
   .initiator_init_secure_element    = pn532_initiator_init_secure_element,
   .initiator_select_passive_target  = pn53x_initiator_select_passive_target,
+  .initiator_select_passive_targets = pn53x_initiator_select_passive_targets,
   .initiator_poll_target            = pn53x_initiator_poll_target,
   .initiator_select_dep_target      = pn53x_initiator_select_dep_target,
+  .initiator_dep_psl                = pn53x_initiator_dep_psl,
   .initiator_deselect_target        = pn53x_initiator_deselect_target,
   .initiator_transceive_bytes       = pn53x_initiator_transceive_bytes,
+  .initiator_transceive_bytes_target = pn53x_initiator_transceive_bytes_target,
   .initiator_transceive_bits        = pn53x_initiator_transceive_bits,
   .initiator_transceive_bytes_timed = pn53x_initiator_transceive_bytes_timed,
   .initiator_transceive_bits_timed  = pn53x_initiator_transceive_bits_timed,
+  .initiator_last_collision         = pn53x_initiator_last_collision,
   .initiator_target_is_present      = pn53x_initiator_target_is_present,
+  .initiator_target_upgrade_bit_rate = pn53x_initiator_target_upgrade_bit_rate,
+  .initiator_target_reactivate = pn53x_initiator_target_reactivate,
 
   .target_init           = pn53x_target_init,
   .target_send_bytes     = pn53x_target_send_bytes,
+  .target_send_bytes_chained = pn53x_target_send_bytes_chained,
   .target_receive_bytes  = pn53x_target_receive_bytes,
   .target_send_bits      = pn53x_target_send_bits,
   .target_receive_bits   = pn53x_target_receive_bits,
@@ -701,5 +796,15 @@ const struct nfc_driver pn532_i2c_driver = {
   .abort_command  = pn532_i2c_abort_command,
   .idle           = pn53x_idle,
   .powerdown      = pn53x_PowerDown,
+  .reset          = pn53x_reset,
+
+  .initiator_transceive_bytes_submit      = pn53x_initiator_transceive_bytes_submit,
+  .initiator_select_passive_target_submit = pn53x_initiator_select_passive_target_submit,
+  .initiator_poll_target_submit           = pn53x_initiator_poll_target_submit,
+  .initiator_target_probe_submit          = pn53x_initiator_target_probe_submit,
+  .command_resume                         = pn53x_command_resume,
+  .command_cancel                         = pn53x_command_cancel,
+  .get_event_fd                           = pn53x_get_event_fd,
+  .get_event_timeout                      = pn53x_get_event_timeout,
 };
 
@@ -271,6 +271,10 @@ pn532_spi_open(const nfc_context *context, const nfc_connstring connstring)
 
   DRIVER_DATA(pnd)->abort_flag = false;
 
+  // A verified cached description replaces the communication check and pn53x_init()
+  if (pn53x_init_cached(pnd) == NFC_SUCCESS)
+    return pnd;
+
   // Check communication using "Diagnose" command, with "Communication test" (0x00)
   if (pn53x_check_communication(pnd) < 0) {
     nfc_perror(pnd, "pn53x_check_communication");
@@ -346,7 +350,8 @@ pn532_spi_wait_for_data(nfc_device *pnd, int timeout)
   static const int pn532_spi_poll_interval = 10; //ms
 
 
-  int timer = 0;
+  // Counting sleeps would ignore the time spent on the SPI transfers
+  const nfc_deadline deadline = nfc_deadline_from_timeout(timeout);
 
   int ret;
   while ((ret = pn532_spi_read_spi_status(pnd)) != pn532_spi_ready) {
@@ -360,12 +365,12 @@ pn532_spi_wait_for_data(nfc_device *pnd, int timeout)
     }
 
     if (timeout > 0) {
-      timer += pn532_spi_poll_interval;
-      if (timer > timeout) {
+      const int remaining = nfc_deadline_remaining(deadline);
+      if (remaining < 0) {
         return NFC_ETIMEOUT;
       }
 
-      msleep(pn532_spi_poll_interval);
+      msleep(MIN(remaining, pn532_spi_poll_interval));
     }
   }
 
@@ -676,17 +681,24 @@ const struct nfc_driver pn532_spi_driver = {
   .initiator_init_collision         = pn53x_initiator_init_collision,
   .initiator_init_secure_element    = pn532_initiator_init_secure_element,
   .initiator_select_passive_target  = pn53x_initiator_select_passive_target,
+  .initiator_select_passive_targets = pn53x_initiator_select_passive_targets,
   .initiator_poll_target            = pn53x_initiator_poll_target,
   .initiator_select_dep_target      = pn53x_initiator_select_dep_target,
+  .initiator_dep_psl                = pn53x_initiator_dep_psl,
   .initiator_deselect_target        = pn53x_initiator_deselect_target,
   .initiator_transceive_bytes       = pn53x_initiator_transceive_bytes,
+  .initiator_transceive_bytes_target = pn53x_initiator_transceive_bytes_target,
   .initiator_transceive_bits        = pn53x_initiator_transceive_bits,
   .initiator_transceive_bytes_timed = pn53x_initiator_transceive_bytes_timed,
   .initiator_transceive_bits_timed  = pn53x_initiator_transceive_bits_timed,
+  .initiator_last_collision         = pn53x_initiator_last_collision,
   .initiator_target_is_present      = pn53x_initiator_target_is_present,
+  .initiator_target_upgrade_bit_rate = pn53x_initiator_target_upgrade_bit_rate,
+  .initiator_target_reactivate = pn53x_initiator_target_reactivate,
 
   .target_init           = pn53x_target_init,
   .target_send_bytes     = pn53x_target_send_bytes,
+  .target_send_bytes_chained = pn53x_target_send_bytes_chained,
   .target_receive_bytes  = pn53x_target_receive_bytes,
   .target_send_bits      = pn53x_target_send_bits,
   .target_receive_bits   = pn53x_target_receive_bits,
@@ -700,5 +712,15 @@ const struct nfc_driver pn532_spi_driver = {
   .abort_command  = pn532_spi_abort_command,
   .idle           = pn53x_idle,
   .powerdown      = pn53x_PowerDown,
+  .reset          = pn53x_reset,
+
+  .initiator_transceive_bytes_submit      = pn53x_initiator_transceive_bytes_submit,
+  .initiator_select_passive_target_submit = pn53x_initiator_select_passive_target_submit,
+  .initiator_poll_target_submit           = pn53x_initiator_poll_target_submit,
+  .initiator_target_probe_submit          = pn53x_initiator_target_probe_submit,
+  .command_resume                         = pn53x_command_resume,
+  .command_cancel                         = pn53x_command_cancel,
+  .get_event_fd                           = pn53x_get_event_fd,
+  .get_event_timeout                      = pn53x_get_event_timeout,
 };
 
@@ -54,6 +54,8 @@
 #define LOG_CATEGORY "libnfc.driver.pn532_uart"
 #define LOG_GROUP    NFC_LOG_GROUP_DRIVER
 
+#define PN532_BUFFER_LEN (PN53x_EXTENDED_FRAME__DATA_MAX_LEN + PN53x_EXTENDED_FRAME__OVERHEAD)
+
 // Internal data structs
 const struct pn53x_io pn532_uart_io;
 struct pn532_uart_data {
@@ -63,6 +65,9 @@ struct pn532_uart_data {
 #else
   volatile bool abort_flag;
 #endif
+  // Bytes gathered by pn532_uart_receive_frame(), not a whole frame yet
+  uint8_t abtFrame[PN532_BUFFER_LEN];
+  size_t  szFrame;
 };
 
 // Prototypes
@@ -259,6 +264,7 @@ pn532_uart_open(const nfc_context *context, const nfc_connstring connstring)
     return NULL;
   }
   DRIVER_DATA(pnd)->port = sp;
+  DRIVER_DATA(pnd)->szFrame = 0;
 
   // Alloc and init chip's data
   if (pn53x_data_new(pnd, &pn532_uart_io) == NULL) {
@@ -288,6 +294,10 @@ pn532_uart_open(const nfc_context *context, const nfc_connstring connstring)
   DRIVER_DATA(pnd)->abort_flag = false;
 #endif
 
+  // A verified cached description replaces the communication check and pn53x_init()
+  if (pn53x_init_cached(pnd) == NFC_SUCCESS)
+    return pnd;
+
   // Check communication using "Diagnose" command, with "Communication test" (0x00)
   if (pn53x_check_communication(pnd) < 0) {
     log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "pn53x_check_communication error");
@@ -309,13 +319,16 @@ pn532_uart_wakeup(nfc_device *pnd)
   return res;
 }
 
-#define PN532_BUFFER_LEN (PN53x_EXTENDED_FRAME__DATA_MAX_LEN + PN53x_EXTENDED_FRAME__OVERHEAD)
+/*
+ * Get ready to send a command: discard any junk bytes and wake the PN532 up.
+ */
 static int
-pn532_uart_send(nfc_device *pnd, const uint8_t *pbtData, const size_t szData, int timeout)
+pn532_uart_prepare(nfc_device *pnd)
 {
   int res = 0;
   // Before sending anything, we need to discard from any junk bytes
   uart_flush_input(DRIVER_DATA(pnd)->port, false);
+  DRIVER_DATA(pnd)->szFrame = 0;
 
   switch (CHIP_DATA(pnd)->power_mode) {
     case LOWVBAT: {
@@ -339,6 +352,17 @@ pn532_uart_send(nfc_device *pnd, const uint8_t *pbtData, const size_t szData, in
       // Nothing to do :)
       break;
   };
+  return NFC_SUCCESS;
+}
+
+static int
+pn532_uart_send(nfc_device *pnd, const uint8_t *pbtData, const size_t szData, int timeout)
+{
+  int res = 0;
+
+  if ((res = pn532_uart_prepare(pnd)) < 0) {
+    return res;
+  }
 
   uint8_t  abtFrame[PN532_BUFFER_LEN] = { 0x00, 0x00, 0xff };       // Every packet must start with "00 00 ff"
   size_t szFrame = 0;
@@ -348,6 +372,7 @@ pn532_uart_send(nfc_device *pnd, const uint8_t *pbtData, const size_t szData, in
     return pnd->last_error;
   }
 
+  const nfc_deadline deadline = nfc_deadline_from_timeout(timeout);
   res = uart_send(DRIVER_DATA(pnd)->port, abtFrame, szFrame, timeout);
   if (res != 0) {
     log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Unable to transmit data. (TX)");
@@ -356,7 +381,7 @@ pn532_uart_send(nfc_device *pnd, const uint8_t *pbtData, const size_t szData, in
   }
 
   uint8_t abtRxBuf[PN53x_ACK_FRAME__LEN];
-  res = uart_receive(DRIVER_DATA(pnd)->port, abtRxBuf, sizeof(abtRxBuf), 0, timeout);
+  res = uart_receive(DRIVER_DATA(pnd)->port, abtRxBuf, sizeof(abtRxBuf), 0, nfc_deadline_remaining(deadline));
   if (res != 0) {
     log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "%s", "Unable to read ACK");
     pnd->last_error = res;
@@ -377,6 +402,8 @@ pn532_uart_receive(nfc_device *pnd, uint8_t *pbtData, const size_t szDataLen, in
   uint8_t  abtRxBuf[5];
   size_t len;
   void *abort_p = NULL;
+  // The frame is read in several chunks: all of them share this deadline
+  const nfc_deadline deadline = nfc_deadline_from_timeout(timeout);
 
 #ifndef WIN32
   abort_p = &(DRIVER_DATA(pnd)->iAbortFds[1]);
@@ -404,13 +431,13 @@ pn532_uart_receive(nfc_device *pnd, uint8_t *pbtData, const size_t szDataLen, in
 
   if ((0x01 == abtRxBuf[3]) && (0xff == abtRxBuf[4])) {
     // Error frame
-    uart_receive(DRIVER_DATA(pnd)->port, abtRxBuf, 3, 0, timeout);
+    uart_receive(DRIVER_DATA(pnd)->port, abtRxBuf, 3, 0, nfc_deadline_remaining(deadline));
     log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Application level error detected");
     pnd->last_error = NFC_EIO;
     goto error;
   } else if ((0xff == abtRxBuf[3]) && (0xff == abtRxBuf[4])) {
     // Extended frame
-    pnd->last_error = uart_receive(DRIVER_DATA(pnd)->port, abtRxBuf, 3, 0, timeout);
+    pnd->last_error = uart_receive(DRIVER_DATA(pnd)->port, abtRxBuf, 3, 0, nfc_deadline_remaining(deadline));
     if (pnd->last_error != 0) {
       log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Unable to receive data. (RX)");
       goto error;
@@ -442,7 +469,7 @@ pn532_uart_receive(nfc_device *pnd, uint8_t *pbtData, const size_t szDataLen, in
   }
 
   // TFI + PD0 (CC+1)
-  pnd->last_error = uart_receive(DRIVER_DATA(pnd)->port, abtRxBuf, 2, 0, timeout);
+  pnd->last_error = uart_receive(DRIVER_DATA(pnd)->port, abtRxBuf, 2, 0, nfc_deadline_remaining(deadline));
   if (pnd->last_error != 0) {
     log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Unable to receive data. (RX)");
     goto error;
@@ -461,14 +488,14 @@ pn532_uart_receive(nfc_device *pnd, uint8_t *pbtData, const size_t szDataLen, in
   }
 
   if (len) {
-    pnd->last_error = uart_receive(DRIVER_DATA(pnd)->port, pbtData, len, 0, timeout);
+    pnd->last_error = uart_receive(DRIVER_DATA(pnd)->port, pbtData, len, 0, nfc_deadline_remaining(deadline));
     if (pnd->last_error != 0) {
       log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Unable to receive data. (RX)");
       goto error;
     }
   }
 
-  pnd->last_error = uart_receive(DRIVER_DATA(pnd)->port, abtRxBuf, 2, 0, timeout);
+  pnd->last_error = uart_receive(DRIVER_DATA(pnd)->port, abtRxBuf, 2, 0, nfc_deadline_remaining(deadline));
   if (pnd->last_error != 0) {
     log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Unable to receive data. (RX)");
     goto error;
@@ -510,6 +537,63 @@ pn532_uart_ack(nfc_device *pnd)
   return (uart_send(DRIVER_DATA(pnd)->port, pn53x_ack_frame, sizeof(pn53x_ack_frame),  0));
 }
 
+static int
+pn532_uart_get_fd(nfc_device *pnd)
+{
+  return uart_get_fd(DRIVER_DATA(pnd)->port);
+}
+
+static int
+pn532_uart_send_frame(nfc_device *pnd, const uint8_t *pbtData, const size_t szData)
+{
+  int res = 0;
+
+  // The frames are gathered with uart_receive_available() from now on
+  if ((res = uart_get_fd(DRIVER_DATA(pnd)->port)) < 0) {
+    pnd->last_error = res;
+    return pnd->last_error;
+  }
+  if ((res = pn532_uart_prepare(pnd)) < 0) {
+    return res;
+  }
+
+  uint8_t  abtFrame[PN532_BUFFER_LEN] = { 0x00, 0x00, 0xff };       // Every packet must start with "00 00 ff"
+  size_t szFrame = 0;
+
+  if ((res = pn53x_build_frame(abtFrame, &szFrame, pbtData, szData)) < 0) {
+    pnd->last_error = res;
+    return pnd->last_error;
+  }
+  if ((res = uart_send(DRIVER_DATA(pnd)->port, abtFrame, szFrame, 0)) != 0) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Unable to transmit data. (TX)");
+    pnd->last_error = res;
+    return pnd->last_error;
+  }
+  return NFC_SUCCESS;
+}
+
+static int
+pn532_uart_receive_frame(nfc_device *pnd, uint8_t *pbtData, const size_t szDataLen, size_t *pszData)
+{
+  struct pn532_uart_data *data = DRIVER_DATA(pnd);
+  int res = 0;
+
+  while ((res = pn53x_parse_frame(pnd, data->abtFrame, &data->szFrame, pbtData, szDataLen, pszData)) == PF_NONE) {
+    if (data->szFrame == sizeof(data->abtFrame)) {
+      // No frame is that long
+      data->szFrame = 0;
+      pnd->last_error = NFC_EIO;
+      return pnd->last_error;
+    }
+    if ((res = uart_receive_available(data->port, data->abtFrame + data->szFrame, sizeof(data->abtFrame) - data->szFrame)) <= 0) {
+      // Nothing more for now (PF_NONE), or an error
+      return res;
+    }
+    data->szFrame += res;
+  }
+  return res;
+}
+
 static int
 pn532_uart_abort_command(nfc_device *pnd)
 {
@@ -527,8 +611,12 @@ pn532_uart_abort_command(nfc_device *pnd)
 }
 
 const struct pn53x_io pn532_uart_io = {
-  .send       = pn532_uart_send,
-  .receive    = pn532_uart_receive,
+  .send          = pn532_uart_send,
+  .receive       = pn532_uart_receive,
+  .get_fd        = pn532_uart_get_fd,
+  .send_frame    = pn532_uart_send_frame,
+  .send_ack      = pn532_uart_ack,
+  .receive_frame = pn532_uart_receive_frame,
 };
 
 const struct nfc_driver pn532_uart_driver = {
@@ -543,17 +631,24 @@ const struct nfc_driver pn532_uart_driver = {
   .initiator_init_collision         = pn53x_initiator_init_collision,
   .initiator_init_secure_element    = pn532_initiator_init_secure_element,
   .initiator_select_passive_target  = pn53x_initiator_select_passive_target,
+  .initiator_select_passive_targets = pn53x_initiator_select_passive_targets,
   .initiator_poll_target            = pn53x_initiator_poll_target,
   .initiator_select_dep_target      = pn53x_initiator_select_dep_target,
+  .initiator_dep_psl                = pn53x_initiator_dep_psl,
   .initiator_deselect_target        = pn53x_initiator_deselect_target,
   .initiator_transceive_bytes       = pn53x_initiator_transceive_bytes,
+  .initiator_transceive_bytes_target = pn53x_initiator_transceive_bytes_target,
   .initiator_transceive_bits        = pn53x_initiator_transceive_bits,
   .initiator_transceive_bytes_timed = pn53x_initiator_transceive_bytes_timed,
   .initiator_transceive_bits_timed  = pn53x_initiator_transceive_bits_timed,
+  .initiator_last_collision         = pn53x_initiator_last_collision,
   .initiator_target_is_present      = pn53x_initiator_target_is_present,
+  .initiator_target_upgrade_bit_rate = pn53x_initiator_target_upgrade_bit_rate,
+  .initiator_target_reactivate = pn53x_initiator_target_reactivate,
 
   .target_init           = pn53x_target_init,
   .target_send_bytes     = pn53x_target_send_bytes,
+  .target_send_bytes_chained = pn53x_target_send_bytes_chained,
   .target_receive_bytes  = pn53x_target_receive_bytes,
   .target_send_bits      = pn53x_target_send_bits,
   .target_receive_bits   = pn53x_target_receive_bits,
@@ -567,5 +662,15 @@ const struct nfc_driver pn532_uart_driver = {
   .abort_command  = pn532_uart_abort_command,
   .idle           = pn53x_idle,
   .powerdown      = pn53x_PowerDown,
+  .reset          = pn53x_reset,
+
+  .initiator_transceive_bytes_submit      = pn53x_initiator_transceive_bytes_submit,
+  .initiator_select_passive_target_submit = pn53x_initiator_select_passive_target_submit,
+  .initiator_poll_target_submit           = pn53x_initiator_poll_target_submit,
+  .initiator_target_probe_submit          = pn53x_initiator_target_probe_submit,
+  .command_resume                         = pn53x_command_resume,
+  .command_cancel                         = pn53x_command_cancel,
+  .get_event_fd                           = pn53x_get_event_fd,
+  .get_event_timeout                      = pn53x_get_event_timeout,
 };
 
@@ -294,7 +294,7 @@ pn53x_usb_scan(const nfc_context *context, nfc_connstring connstrings[], const s
 {
   (void)context;
 
-  usb_prepare();
+  usb_prepare(context);
 
   size_t device_found = 0;
   uint32_t uiBusIndex = 0;
@@ -409,7 +409,7 @@ pn53x_usb_open(const nfc_context *context, const nfc_connstring connstring)
   struct usb_bus *bus;
   struct usb_device *dev;
 
-  usb_prepare();
+  usb_prepare(context);
 
   for (bus = usb_get_busses(); bus; bus = bus->next) {
     if (connstring_decode_level > 1)  {
@@ -463,6 +463,9 @@ pn53x_usb_open(const nfc_context *context, const nfc_connstring connstring)
         goto error;
       }
       pn53x_usb_get_usb_device_name(dev, data.pudh, pnd->name, sizeof(pnd->name));
+      // The cached description follows the device wherever it is plugged
+      if (!dev->descriptor.iSerialNumber || (usb_get_string_simple(data.pudh, dev->descriptor.iSerialNumber, pnd->serial, sizeof(pnd->serial)) < 0))
+        pnd->serial[0] = '\0';
 
       pnd->driver_data = malloc(sizeof(struct pn53x_usb_data));
       if (!pnd->driver_data) {
@@ -618,14 +621,14 @@ pn53x_usb_receive(nfc_device *pnd, uint8_t *pbtData, const size_t szDataLen, con
    * timeout to allow breaking the loop if the user wants to stop it.
    */
   int usb_timeout;
-  int remaining_time = timeout;
+  const nfc_deadline deadline = nfc_deadline_from_timeout(timeout);
 read:
   if (timeout == USB_INFINITE_TIMEOUT) {
     usb_timeout = USB_TIMEOUT_PER_PASS;
   } else {
     // A user-provided timeout is set, we have to cut it in multiple chunk to be able to keep an nfc_abort_command() mechanism
-    remaining_time -= USB_TIMEOUT_PER_PASS;
-    if (remaining_time <= 0) {
+    const int remaining_time = nfc_deadline_remaining(deadline);
+    if (remaining_time < 0) {
       pnd->last_error = NFC_ETIMEOUT;
       return pnd->last_error;
     } else {
@@ -751,21 +754,26 @@ int
 pn53x_usb_init(nfc_device *pnd)
 {
   int res = 0;
-  // Sometimes PN53x USB doesn't reply ACK one the first frame, so we need to send a dummy one...
-  //pn53x_check_communication (pnd); // Sony RC-S360 doesn't support this command for now so let's use a get_firmware_version instead:
-  const uint8_t abtCmd[] = { GetFirmwareVersion };
-  pn53x_transceive(pnd, abtCmd, sizeof(abtCmd), NULL, 0, -1);
-  // ...and we don't care about error
-  pnd->last_error = 0;
-  if (SONY_RCS360 == DRIVER_DATA(pnd)->model) {
-    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "%s", "SONY RC-S360 initialization.");
-    const uint8_t abtCmd2[] = { 0x18, 0x01 };
-    pn53x_transceive(pnd, abtCmd2, sizeof(abtCmd2), NULL, 0, -1);
-    pn53x_usb_ack(pnd);
-  }
+  // A verified cached description replaces the probing below and
+  // pn53x_init(), except on Sony RC-S360 which needs its own initialization
+  if ((SONY_RCS360 == DRIVER_DATA(pnd)->model) || (pn53x_init_cached(pnd) < 0)) {
+    pnd->last_error = 0;
+    // Sometimes PN53x USB doesn't reply ACK one the first frame, so we need to send a dummy one...
+    //pn53x_check_communication (pnd); // Sony RC-S360 doesn't support this command for now so let's use a get_firmware_version instead:
+    const uint8_t abtCmd[] = { GetFirmwareVersion };
+    pn53x_transceive(pnd, abtCmd, sizeof(abtCmd), NULL, 0, -1);
+    // ...and we don't care about error
+    pnd->last_error = 0;
+    if (SONY_RCS360 == DRIVER_DATA(pnd)->model) {
+      log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "%s", "SONY RC-S360 initialization.");
+      const uint8_t abtCmd2[] = { 0x18, 0x01 };
+      pn53x_transceive(pnd, abtCmd2, sizeof(abtCmd2), NULL, 0, -1);
+      pn53x_usb_ack(pnd);
+    }
 
-  if ((res = pn53x_init(pnd)) < 0)
-    return res;
+    if ((res = pn53x_init(pnd)) < 0)
+      return res;
+  }
 
   if (ASK_LOGO == DRIVER_DATA(pnd)->model) {
     log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "%s", "ASK LoGO initialization.");
@@ -882,17 +890,24 @@ const struct nfc_driver pn53x_usb_driver = {
   .initiator_init_collision         = pn53x_initiator_init_collision,
   .initiator_init_secure_element    = NULL, // No secure-element support
   .initiator_select_passive_target  = pn53x_initiator_select_passive_target,
+  .initiator_select_passive_targets = pn53x_initiator_select_passive_targets,
   .initiator_poll_target            = pn53x_initiator_poll_target,
   .initiator_select_dep_target      = pn53x_initiator_select_dep_target,
+  .initiator_dep_psl                = pn53x_initiator_dep_psl,
   .initiator_deselect_target        = pn53x_initiator_deselect_target,
   .initiator_transceive_bytes       = pn53x_initiator_transceive_bytes,
+  .initiator_transceive_bytes_target = pn53x_initiator_transceive_bytes_target,
   .initiator_transceive_bits        = pn53x_initiator_transceive_bits,
   .initiator_transceive_bytes_timed = pn53x_initiator_transceive_bytes_timed,
   .initiator_transceive_bits_timed  = pn53x_initiator_transceive_bits_timed,
+  .initiator_last_collision         = pn53x_initiator_last_collision,
   .initiator_target_is_present      = pn53x_initiator_target_is_present,
+  .initiator_target_upgrade_bit_rate = pn53x_initiator_target_upgrade_bit_rate,
+  .initiator_target_reactivate = pn53x_initiator_target_reactivate,
 
   .target_init           = pn53x_target_init,
   .target_send_bytes     = pn53x_target_send_bytes,
+  .target_send_bytes_chained = pn53x_target_send_bytes_chained,
   .target_receive_bytes  = pn53x_target_receive_bytes,
   .target_send_bits      = pn53x_target_send_bits,
   .target_receive_bits   = pn53x_target_receive_bits,
@@ -906,4 +921,14 @@ const struct nfc_driver pn53x_usb_driver = {
   .abort_command  = pn53x_usb_abort_command,
   .idle           = pn53x_idle,
   .powerdown      = pn53x_PowerDown,
+  .reset          = pn53x_reset,
+
+  .initiator_transceive_bytes_submit      = pn53x_initiator_transceive_bytes_submit,
+  .initiator_select_passive_target_submit = pn53x_initiator_select_passive_target_submit,
+  .initiator_poll_target_submit           = pn53x_initiator_poll_target_submit,
+  .initiator_target_probe_submit          = pn53x_initiator_target_probe_submit,
+  .command_resume                         = pn53x_command_resume,
+  .command_cancel                         = pn53x_command_cancel,
+  .get_event_fd                           = pn53x_get_event_fd,
+  .get_event_timeout                      = pn53x_get_event_timeout,
 };
@@ -564,11 +564,13 @@ const struct nfc_driver pn71xx_driver = {
   .initiator_select_passive_target  = pn71xx_initiator_select_passive_target,
   .initiator_poll_target            = pn71xx_initiator_poll_target,
   .initiator_select_dep_target      = NULL,
+  .initiator_dep_psl                = NULL,
   .initiator_deselect_target        = pn71xx_initiator_deselect_target,
   .initiator_transceive_bytes       = pn71xx_initiator_transceive_bytes,
   .initiator_transceive_bits        = NULL,
   .initiator_transceive_bytes_timed = NULL,
   .initiator_transceive_bits_timed  = NULL,
+  .initiator_last_collision         = NULL,
   .initiator_target_is_present      = pn71xx_initiator_target_is_present,
 
   .target_init                      = NULL,
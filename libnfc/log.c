@@ -54,13 +54,23 @@ log_priority_to_str(const int priority)
 
 #include "log-internal.h"
 
+#if defined(_MSC_VER)
+#  define LOG_THREAD_LOCAL __declspec(thread)
+#else
+#  define LOG_THREAD_LOCAL __thread
+#endif
+
+// Log level of the last initialized context, -1 before the first one: the
+// level is process-wide, as LIBNFC_LOG_LEVEL used to be, not per context
+static int log_level_current = -1;
+// Logs are muted for the calling thread only, see log_set_quiet()
+static LOG_THREAD_LOCAL bool log_quiet = false;
+
 void
 log_init(const nfc_context *context)
 {
 #ifdef ENVVARS
-  char str[32];
-  sprintf(str, "%"PRIu32, context->log_level);
-  setenv("LIBNFC_LOG_LEVEL", str, 1);
+  NFC_ATOMIC_STORE(&log_level_current, (int)context->log_level);
 #else
   (void)context;
 #endif
@@ -71,23 +81,40 @@ log_exit(void)
 {
 }
 
+/**
+ * @brief Mute (or unmute) logs emitted by the calling thread
+ */
+void
+log_set_quiet(const bool bQuiet)
+{
+  log_quiet = bQuiet;
+}
+
 void
 log_put(const uint8_t group, const char *category, const uint8_t priority, const char *format, ...)
 {
-  char *env_log_level = NULL;
+  int level = NFC_ATOMIC_LOAD(&log_level_current);
+  uint32_t log_level;
+
+  if (log_quiet)
+    return;
+  if (level < 0) {
+    char *env_log_level = NULL;
 #ifdef ENVVARS
-  env_log_level = getenv("LIBNFC_LOG_LEVEL");
+    env_log_level = getenv("LIBNFC_LOG_LEVEL");
 #endif
-  uint32_t log_level;
-  if (NULL == env_log_level) {
-    // LIBNFC_LOG_LEVEL is not set
+    if (NULL == env_log_level) {
+      // LIBNFC_LOG_LEVEL is not set
 #ifdef DEBUG
-    log_level = 3;
+      log_level = 3;
 #else
-    log_level = 1;
+      log_level = 1;
 #endif
+    } else {
+      log_level = atoi(env_log_level);
+    }
   } else {
-    log_level = atoi(env_log_level);
+    log_level = (uint32_t)level;
   }
 
   //  printf("log_level = %"PRIu32" group = %"PRIu8" priority = %"PRIu8"\n", log_level, group, priority);
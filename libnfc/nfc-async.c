@@ -0,0 +1,801 @@
+/*-
+ * Free/Libre Near Field Communication (NFC) library
+ *
+ * Libnfc historical contributors:
+ * Copyright (C) 2009      Roel Verdult
+ * Copyright (C) 2009-2013 Romuald Conty
+ * Copyright (C) 2010-2012 Romain Tartière
+ * Copyright (C) 2010-2013 Philippe Teuwen
+ * Copyright (C) 2012-2013 Ludovic Rousseau
+ * See AUTHORS file for a more comprehensive list of contributors.
+ * Additional contributors of this file:
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+
+/**
+ * @file nfc-async.c
+ * @brief Provide a split-phase (submit, then complete) variant of the initiator commands
+ *
+ * Commands submitted to a device are queued and run in order, one at a time,
+ * without any thread: the driver sends the command and returns at once, its
+ * answer is then gathered by nfc_device_process_events() whenever the file
+ * descriptor of the device (see nfc_device_get_event_fd()) is readable or
+ * the timeout given by nfc_device_get_event_timeout() expires. The
+ * callbacks are invoked from there, in the application thread.
+ *
+ * The presence monitor (nfc_initiator_target_monitor()) is driven the same
+ * way: its probes are queued as any other command, at its cadence.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <nfc/nfc.h>
+
+#include "nfc-internal.h"
+
+#define LOG_CATEGORY "libnfc.general"
+#define LOG_GROUP    NFC_LOG_GROUP_GENERAL
+
+#ifndef _WIN32
+
+enum nfc_async_op {
+  NAO_TRANSCEIVE_BYTES,
+  NAO_SELECT_PASSIVE_TARGET,
+  NAO_POLL_TARGET,
+  NAO_PROBE_TARGET,
+};
+
+struct nfc_async_command {
+  struct nfc_async_command *pnacNext;
+  enum nfc_async_op op;
+  // Copies of the input, owned by the command
+  uint8_t *pbtTx;
+  size_t szTx;
+  nfc_modulation *pnmModulations;
+  size_t szModulations;
+  uint8_t uiPollNr;
+  uint8_t uiPeriod;
+  int timeout;
+  // Output, owned by the application until the callback returns
+  uint8_t *pbtRx;
+  size_t szRx;
+  nfc_target *pnt;
+  nfc_completion_callback cb;
+  // Probe ending a presence monitor: invoked instead of cb
+  nfc_target_monitor_callback monitor_cb;
+  void *user_data;
+  int res;
+};
+
+struct nfc_async {
+  // Commands in submission order: the first one runs on the device once started
+  struct nfc_async_command *pnacQueue;
+  struct nfc_async_command **ppnacQueueTail;
+  bool bStarted;
+  // Set while nfc_close() completes the commands left: no more are accepted
+  bool bClosing;
+  // Commands over, waiting for nfc_device_process_events() to invoke their callbacks
+  struct nfc_async_command *pnacDone;
+  struct nfc_async_command **ppnacDoneTail;
+  // Presence monitor: the target it probes (if given), every iCadence ms from the last probe
+  bool bMonitor;
+  bool bMonitorTarget;
+  nfc_target ntMonitor;
+  int iCadence;
+  int64_t i64NextProbe;
+  // Probe of the monitor queued, whose result is awaited
+  struct nfc_async_command *pnacProbe;
+  nfc_target_monitor_callback monitor_cb;
+  void *monitor_user_data;
+};
+
+/*
+ * Hand a command to the driver, which sends it without waiting for anything.
+ */
+static int
+nfc_async_run(nfc_device *pnd, struct nfc_async_command *pnac)
+{
+  pnd->last_error = NFC_EDEVNOTSUPP;
+  switch (pnac->op) {
+    case NAO_TRANSCEIVE_BYTES:
+      if (pnd->driver->initiator_transceive_bytes_submit)
+        return pnd->driver->initiator_transceive_bytes_submit(pnd, pnac->pbtTx, pnac->szTx, pnac->pbtRx, pnac->szRx, pnac->timeout);
+      break;
+    case NAO_SELECT_PASSIVE_TARGET:
+      if (pnd->driver->initiator_select_passive_target_submit)
+        return pnd->driver->initiator_select_passive_target_submit(pnd, pnac->pnmModulations[0], pnac->pbtTx, pnac->szTx, pnac->pnt);
+      break;
+    case NAO_POLL_TARGET:
+      if (pnd->driver->initiator_poll_target_submit)
+        return pnd->driver->initiator_poll_target_submit(pnd, pnac->pnmModulations, pnac->szModulations, pnac->uiPollNr, pnac->uiPeriod, pnac->pnt);
+      break;
+    case NAO_PROBE_TARGET:
+      if (pnd->driver->initiator_target_probe_submit)
+        return pnd->driver->initiator_target_probe_submit(pnd, pnac->pnt);
+      break;
+  }
+  return pnd->last_error;
+}
+
+/*
+ * The presence monitor is over with res: the probe pnac reports it.
+ */
+static void
+nfc_async_monitor_end(struct nfc_async *pna, struct nfc_async_command *pnac, const int res)
+{
+  pna->bMonitor = false;
+  pna->pnacProbe = NULL;
+  pnac->res = res;
+  pnac->monitor_cb = pna->monitor_cb;
+  pnac->user_data = pna->monitor_user_data;
+}
+
+/*
+ * The first queued command is over with res: it waits for its callback.
+ */
+static void
+nfc_async_done(struct nfc_async *pna, const int res)
+{
+  struct nfc_async_command *pnac = pna->pnacQueue;
+
+  if (!(pna->pnacQueue = pnac->pnacNext))
+    pna->ppnacQueueTail = &pna->pnacQueue;
+  pnac->pnacNext = NULL;
+  pnac->res = res;
+  if (pnac == pna->pnacProbe) {
+    // The monitor goes on while the target answers its probes
+    pna->pnacProbe = NULL;
+    if (res < 0)
+      nfc_async_monitor_end(pna, pnac, res);
+  }
+  *pna->ppnacDoneTail = pnac;
+  pna->ppnacDoneTail = &pnac->pnacNext;
+  pna->bStarted = false;
+}
+
+/*
+ * Start the queued commands until one runs: the ones the driver refuses are
+ * over at once.
+ */
+static void
+nfc_async_start(nfc_device *pnd)
+{
+  struct nfc_async *pna = pnd->async;
+  int res;
+
+  while (pna->pnacQueue && !pna->bStarted) {
+    if ((res = nfc_async_run(pnd, pna->pnacQueue)) < 0)
+      nfc_async_done(pna, res);
+    else
+      pna->bStarted = true;
+  }
+}
+
+/*
+ * Invoke the callbacks of the commands over, without the device lock, and
+ * release them: returns how many there were.
+ */
+static int
+nfc_async_complete(nfc_device *pnd, struct nfc_async_command *pnac)
+{
+  int res = 0;
+
+  while (pnac) {
+    struct nfc_async_command *pnacNext = pnac->pnacNext;
+    if (pnac->monitor_cb)
+      pnac->monitor_cb(pnd, pnac->pnt, pnac->res, pnac->user_data);
+    else if (pnac->cb)
+      pnac->cb(pnd, pnac->res, pnac->user_data);
+    free(pnac);
+    pnac = pnacNext;
+    res++;
+  }
+  return res;
+}
+
+static struct nfc_async_command *
+nfc_async_command_new(nfc_device *pnd, const enum nfc_async_op op, const size_t szTx,
+                      const nfc_modulation *pnmModulations, const size_t szModulations,
+                      nfc_completion_callback cb, void *user_data)
+{
+  struct nfc_async_command *pnac;
+
+  // The copies of the modulations and of the bytes follow the command
+  if (!(pnac = calloc(1, sizeof(*pnac) + szModulations * sizeof(nfc_modulation) + szTx))) {
+    pnd->last_error = NFC_ESOFT;
+    return NULL;
+  }
+  pnac->op = op;
+  pnac->pnmModulations = (nfc_modulation *)(pnac + 1);
+  if (szModulations)
+    memcpy(pnac->pnmModulations, pnmModulations, szModulations * sizeof(nfc_modulation));
+  pnac->szModulations = szModulations;
+  pnac->pbtTx = (uint8_t *)(pnac->pnmModulations + szModulations);
+  pnac->cb = cb;
+  pnac->user_data = user_data;
+  return pnac;
+}
+
+/*
+ * Get the queue of a device, created on first use, with the device locked:
+ * NULL when it is closing.
+ */
+static struct nfc_async *
+nfc_async_get(nfc_device *pnd)
+{
+  struct nfc_async *pna;
+
+  if (!(pna = pnd->async)) {
+    if (!(pna = calloc(1, sizeof(*pna)))) {
+      pnd->last_error = NFC_ESOFT;
+      return NULL;
+    }
+    pna->ppnacQueueTail = &pna->pnacQueue;
+    pna->ppnacDoneTail = &pna->pnacDone;
+    pnd->async = pna;
+  }
+  if (pna->bClosing) {
+    // Submitted from a callback invoked by nfc_close()
+    pnd->last_error = NFC_EOPABORTED;
+    return NULL;
+  }
+  return pna;
+}
+
+/*
+ * Queue a command, started at once when the device is free: then the driver
+ * refusing it is reported here (and the command released).
+ */
+static int
+nfc_async_queue(nfc_device *pnd, struct nfc_async *pna, struct nfc_async_command *pnac)
+{
+  int res;
+
+  if (!pna->pnacQueue) {
+    if ((res = nfc_async_run(pnd, pnac)) < 0) {
+      free(pnac);
+      return res;
+    }
+    pna->bStarted = true;
+  }
+  *pna->ppnacQueueTail = pnac;
+  pna->ppnacQueueTail = &pnac->pnacNext;
+  return NFC_SUCCESS;
+}
+
+static int
+nfc_async_submit(nfc_device *pnd, struct nfc_async_command *pnac)
+{
+  struct nfc_async *pna;
+  int res;
+
+  nfc_device_lock(pnd);
+  if (!(pna = nfc_async_get(pnd))) {
+    free(pnac);
+    res = pnd->last_error;
+  } else {
+    res = nfc_async_queue(pnd, pna, pnac);
+  }
+  nfc_device_unlock(pnd);
+  return res;
+}
+
+/*
+ * New probe of the monitored target, with its own copy of the target.
+ */
+static struct nfc_async_command *
+nfc_async_probe_new(nfc_device *pnd)
+{
+  struct nfc_async *pna = pnd->async;
+  struct nfc_async_command *pnac;
+
+  if (!(pnac = nfc_async_command_new(pnd, NAO_PROBE_TARGET, sizeof(nfc_target), NULL, 0, NULL, NULL)))
+    return NULL;
+  if (pna->bMonitorTarget) {
+    pnac->pnt = (nfc_target *)pnac->pbtTx;
+    memcpy(pnac->pnt, &pna->ntMonitor, sizeof(nfc_target));
+  }
+  return pnac;
+}
+
+/*
+ * Queue the next probe of the monitor once its cadence elapsed: a probe the
+ * driver refuses ends the monitor.
+ */
+static void
+nfc_async_monitor_run(nfc_device *pnd)
+{
+  struct nfc_async *pna = pnd->async;
+  struct nfc_async_command *pnac;
+  const int64_t i64Now = nfc_monotonic_us();
+
+  if (!pna->bMonitor || pna->pnacProbe || (i64Now < pna->i64NextProbe))
+    return;
+  if (!(pnac = nfc_async_probe_new(pnd)))
+    return;
+  pna->i64NextProbe = i64Now + (int64_t) pna->iCadence * 1000;
+  pna->pnacProbe = pnac;
+  *pna->ppnacQueueTail = pnac;
+  pna->ppnacQueueTail = &pnac->pnacNext;
+  nfc_async_start(pnd);
+}
+
+/*
+ * Cancel the command running on a device, for nfc_abort_command(): returns
+ * true when there is one. The device lock is only tried, so that a blocking
+ * command holding it is aborted the usual way.
+ */
+bool
+nfc_async_cancel(nfc_device *pnd)
+{
+  bool bCancelled = false;
+
+  if (!nfc_mutex_trylock(&pnd->mutex))
+    return false;
+  if (pnd->async && pnd->async->bStarted) {
+    pnd->driver->command_cancel(pnd);
+    bCancelled = true;
+  }
+  nfc_device_unlock(pnd);
+  return bCancelled;
+}
+
+/*
+ * Complete the commands left when the device is closed: the running one is
+ * cancelled, the queued ones never start. Their callbacks get
+ * NFC_EOPABORTED, after the ones of the commands already over, and so does
+ * the one of the presence monitor.
+ */
+void
+nfc_async_free(nfc_device *pnd)
+{
+  struct nfc_async *pna = pnd->async;
+  struct nfc_async_command *pnac;
+
+  if (!pna)
+    return;
+  nfc_device_lock(pnd);
+  pna->bClosing = true;
+  if (pna->bStarted) {
+    // The driver gives the command up right away, and forgets it
+    bool bDone = false;
+    pnd->driver->command_cancel(pnd);
+    pnd->driver->command_resume(pnd, &bDone);
+    nfc_async_done(pna, NFC_EOPABORTED);
+  }
+  while (pna->pnacQueue)
+    nfc_async_done(pna, NFC_EOPABORTED);
+  if (pna->bMonitor && (pnac = nfc_async_probe_new(pnd))) {
+    // Waiting for its next probe
+    nfc_async_monitor_end(pna, pnac, NFC_EOPABORTED);
+    *pna->ppnacDoneTail = pnac;
+    pna->ppnacDoneTail = &pnac->pnacNext;
+  }
+  pnac = pna->pnacDone;
+  pna->pnacDone = NULL;
+  pna->ppnacDoneTail = &pna->pnacDone;
+  nfc_device_unlock(pnd);
+
+  nfc_async_complete(pnd, pnac);
+
+  nfc_device_lock(pnd);
+  pnd->async = NULL;
+  nfc_device_unlock(pnd);
+  free(pna);
+}
+
+/** @ingroup dev
+ * @brief Get the file descriptor to watch for the progress of submitted commands
+ * @return Returns a file descriptor on success, otherwise returns libnfc's error code (negative value)
+ *
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ *
+ * This is the file descriptor of the device itself (e.g. its serial port):
+ * when it gets readable, call nfc_device_process_events(). Watch it for
+ * input with poll(), select() or epoll, with the timeout given by
+ * nfc_device_get_event_timeout(). It stays valid until nfc_close() and
+ * must not be read nor closed by the application.
+ *
+ * @note Only some drivers support the split-phase commands (PN532 on UART
+ * for now), the others return \a NFC_EDEVNOTSUPP.
+ */
+int
+nfc_device_get_event_fd(nfc_device *pnd)
+{
+  HAL(get_event_fd, pnd);
+}
+
+/** @ingroup dev
+ * @brief Get the time before nfc_device_process_events() must be called, even without any input
+ * @return Returns a timeout in milliseconds for poll(), -1 when there is none
+ *
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ *
+ * A command which times out, or which is over without any input (e.g.
+ * cancelled, or refused by the driver once started), is only reported once
+ * this timeout expires, and so is the next probe of the presence monitor
+ * due. This is 0 when callbacks are already due.
+ */
+int
+nfc_device_get_event_timeout(nfc_device *pnd)
+{
+  struct nfc_async *pna;
+  int res = -1;
+
+  nfc_device_lock(pnd);
+  if (!(pna = pnd->async))
+    goto end;
+  if (pna->pnacDone)
+    res = 0;
+  else if (pna->bStarted && pnd->driver->get_event_timeout)
+    res = pnd->driver->get_event_timeout(pnd);
+  if ((res != 0) && pna->bMonitor && !pna->pnacProbe) {
+    // Until the next probe of the monitor
+    const int64_t i64Wait = pna->i64NextProbe - nfc_monotonic_us();
+    const int iWait = (i64Wait <= 0) ? 0 : (int)((i64Wait + 999) / 1000);
+    if ((res < 0) || (iWait < res))
+      res = iWait;
+  }
+end:
+  nfc_device_unlock(pnd);
+  return res;
+}
+
+/** @ingroup dev
+ * @brief Go on with the submitted commands, and invoke the callbacks of the ones over
+ * @return Returns the number of callbacks invoked, otherwise returns libnfc's error code (negative value)
+ *
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ *
+ * This function does not block: it takes what the device sent so far, and
+ * starts the next command once one is over (or the next probe of the
+ * presence monitor once due). The callbacks are invoked in submission order
+ * from the calling thread; they may submit further commands.
+ */
+int
+nfc_device_process_events(nfc_device *pnd)
+{
+  struct nfc_async *pna;
+  struct nfc_async_command *pnac = NULL;
+  int res = 0;
+
+  nfc_device_lock(pnd);
+  if (!(pna = pnd->async)) {
+    nfc_device_unlock(pnd);
+    return 0;
+  }
+  if (pna->bStarted) {
+    bool bDone = false;
+    res = pnd->driver->command_resume(pnd, &bDone);
+    if (bDone) {
+      nfc_async_done(pna, res);
+      nfc_async_start(pnd);
+    }
+  }
+  nfc_async_monitor_run(pnd);
+  pnac = pna->pnacDone;
+  pna->pnacDone = NULL;
+  pna->ppnacDoneTail = &pna->pnacDone;
+  nfc_device_unlock(pnd);
+
+  return nfc_async_complete(pnd, pnac);
+}
+
+/** @ingroup initiator
+ * @brief Submit nfc_initiator_transceive_bytes() without waiting for its completion
+ * @return Returns 0 on success, otherwise returns libnfc's error code (negative value)
+ *
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ * @param pbtTx contains a byte array of the frame that needs to be transmitted, copied before returning
+ * @param szTx contains the length in bytes
+ * @param[out] pbtRx response from the target, must stay valid until \a cb is invoked
+ * @param szRx size of \a pbtRx
+ * @param timeout in milliseconds, see nfc_initiator_transceive_bytes()
+ * @param cb function invoked by nfc_device_process_events() with the result nfc_initiator_transceive_bytes() returned (optionnal, can be \e NULL)
+ * @param user_data pointer given back to \a cb
+ *
+ * Commands submitted to a device run in order, one at a time, driven by
+ * nfc_device_process_events(). An error is returned here when the device is
+ * free and the driver refuses the command at once (e.g. \a NFC_EDEVNOTSUPP),
+ * otherwise \a cb gets it. A running command can be cancelled with
+ * nfc_abort_command(), its callback then gets \a NFC_EOPABORTED. The
+ * commands not completed when the device is closed get \a NFC_EOPABORTED
+ * too, their callbacks being invoked by nfc_close(): they must not use the
+ * device any more.
+ *
+ * @note Do not run blocking commands on the device while submitted ones are
+ * not over.
+ */
+int
+nfc_initiator_transceive_bytes_submit(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, uint8_t *pbtRx,
+                                      const size_t szRx, int timeout, nfc_completion_callback cb, void *user_data)
+{
+  struct nfc_async_command *pnac;
+
+  if (!(pnac = nfc_async_command_new(pnd, NAO_TRANSCEIVE_BYTES, szTx, NULL, 0, cb, user_data)))
+    return pnd->last_error;
+  memcpy(pnac->pbtTx, pbtTx, szTx);
+  pnac->szTx = szTx;
+  pnac->pbtRx = pbtRx;
+  pnac->szRx = szRx;
+  pnac->timeout = timeout;
+  return nfc_async_submit(pnd, pnac);
+}
+
+/** @ingroup initiator
+ * @brief Submit nfc_initiator_select_passive_target() without waiting for its completion
+ * @return Returns 0 on success, otherwise returns libnfc's error code (negative value)
+ *
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ * @param nm desired modulation
+ * @param pbtInitData optional initiator data, copied before returning
+ * @param szInitData length of initiator data \a pbtInitData
+ * @param[out] pnt \a nfc_target struct pointer which will filled if available, must stay valid until \a cb is invoked
+ * @param cb function invoked by nfc_device_process_events() with the result nfc_initiator_select_passive_target() returned (optionnal, can be \e NULL)
+ * @param user_data pointer given back to \a cb
+ *
+ * See nfc_initiator_transceive_bytes_submit() about the ordering and the cancellation.
+ */
+int
+nfc_initiator_select_passive_target_submit(nfc_device *pnd, const nfc_modulation nm, const uint8_t *pbtInitData,
+                                           const size_t szInitData, nfc_target *pnt, nfc_completion_callback cb, void *user_data)
+{
+  struct nfc_async_command *pnac;
+  int res;
+
+  // The initiator data the driver gets, see nfc_initiator_select_passive_target()
+  if (!(pnac = nfc_async_command_new(pnd, NAO_SELECT_PASSIVE_TARGET, MAX(12, szInitData), &nm, 1, cb, user_data)))
+    return pnd->last_error;
+  if ((res = nfc_initiator_init_data(pnd, nm, pbtInitData, szInitData, pnac->pbtTx, &pnac->szTx)) < 0) {
+    free(pnac);
+    return res;
+  }
+  pnac->pnt = pnt;
+  return nfc_async_submit(pnd, pnac);
+}
+
+/** @ingroup initiator
+ * @brief Submit nfc_initiator_poll_target() without waiting for its completion
+ * @return Returns 0 on success, otherwise returns libnfc's error code (negative value)
+ *
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ * @param pnmModulations desired modulations, copied before returning
+ * @param szModulations size of \a pnmModulations
+ * @param uiPollNr specifies the number of polling (0x01 – 0xFE: 1 up to 254 polling, 0xFF: Endless polling)
+ * @param uiPeriod indicates the polling period in units of 150 ms (0x01 – 0x0F: 150ms – 2.25s)
+ * @param[out] pnt pointer on \a nfc_target (over)writable struct, must stay valid until \a cb is invoked
+ * @param cb function invoked by nfc_device_process_events() with the result nfc_initiator_poll_target() returned (optionnal, can be \e NULL)
+ * @param user_data pointer given back to \a cb
+ *
+ * See nfc_initiator_transceive_bytes_submit() about the ordering and the
+ * cancellation: endless polling is stopped with nfc_abort_command().
+ */
+int
+nfc_initiator_poll_target_submit(nfc_device *pnd, const nfc_modulation *pnmModulations, const size_t szModulations,
+                                 const uint8_t uiPollNr, const uint8_t uiPeriod, nfc_target *pnt,
+                                 nfc_completion_callback cb, void *user_data)
+{
+  struct nfc_async_command *pnac;
+
+  if (!szModulations) {
+    pnd->last_error = NFC_EINVARG;
+    return pnd->last_error;
+  }
+  if (!(pnac = nfc_async_command_new(pnd, NAO_POLL_TARGET, 0, pnmModulations, szModulations, cb, user_data)))
+    return pnd->last_error;
+  pnac->uiPollNr = uiPollNr;
+  pnac->uiPeriod = uiPeriod;
+  pnac->pnt = pnt;
+  return nfc_async_submit(pnd, pnac);
+}
+
+/** @ingroup initiator
+ * @brief Watch a selected target until it leaves the field, without blocking
+ * @return Returns 0 on success, otherwise returns libnfc's error code (negative value)
+ *
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ * @param pnt a \a nfc_target struct pointer where desired target information was stored (optionnal, can be \e NULL for the last selected target), copied before returning
+ * @param cadence time between the starts of two presence checks, in milliseconds
+ * @param cb function invoked by nfc_device_process_events() once the monitor is over
+ * @param user_data pointer given back to \a cb
+ *
+ * The presence of the target is checked every \a cadence milliseconds by a
+ * probe queued with the submitted commands (see
+ * nfc_initiator_transceive_bytes_submit()): nfc_device_get_event_timeout()
+ * tells when the next one is due, nfc_device_process_events() sends it. The
+ * driver picks the cheapest probe for the target type and the chip, a single
+ * frame (e.g. Diagnose on PN533, R(NAK) for ISO/IEC 14443-4 targets on
+ * PN532, a READ for MIFARE Ultralight, ATTRIB for ISO/IEC 14443 B'). MIFARE
+ * Classic targets are checked by the chip itself and keep their
+ * authentication. The device stays idle between two probes, and may run
+ * other submitted commands meanwhile.
+ *
+ * \a cb gets \a NFC_ETGRELEASED once the target has left the field, another
+ * error when a probe failed (e.g. \a NFC_EDEVNOTSUPP for the targets which
+ * can not be checked with a single frame, or \a NFC_EOPABORTED when the probe
+ * is cancelled by nfc_abort_command() or the device is closed). A monitor
+ * started on a device replaces the previous one, whose callback is not
+ * invoked.
+ */
+int
+nfc_initiator_target_monitor(nfc_device *pnd, const nfc_target *pnt, const int cadence,
+                             nfc_target_monitor_callback cb, void *user_data)
+{
+  struct nfc_async *pna;
+  struct nfc_async_command *pnac;
+  int res;
+
+  if ((cadence <= 0) || (cb == NULL)) {
+    pnd->last_error = NFC_EINVARG;
+    return pnd->last_error;
+  }
+  nfc_device_lock(pnd);
+  if (!(pna = nfc_async_get(pnd))) {
+    res = pnd->last_error;
+    goto end;
+  }
+  pna->bMonitor = true;
+  pna->bMonitorTarget = (pnt != NULL);
+  if (pnt != NULL)
+    memcpy(&pna->ntMonitor, pnt, sizeof(nfc_target));
+  pna->iCadence = cadence;
+  pna->monitor_cb = cb;
+  pna->monitor_user_data = user_data;
+  // The first probe is sent right away, so that a target which can not be checked is told here
+  pna->pnacProbe = NULL;
+  if (!(pnac = nfc_async_probe_new(pnd))) {
+    pna->bMonitor = false;
+    res = pnd->last_error;
+    goto end;
+  }
+  pna->i64NextProbe = nfc_monotonic_us() + (int64_t) cadence * 1000;
+  if ((res = nfc_async_queue(pnd, pna, pnac)) < 0) {
+    pna->bMonitor = false;
+    goto end;
+  }
+  pna->pnacProbe = pnac;
+end:
+  nfc_device_unlock(pnd);
+  return res;
+}
+
+/** @ingroup initiator
+ * @brief Stop watching the target monitored with nfc_initiator_target_monitor()
+ * @return Returns 0 on success, otherwise returns libnfc's error code (negative value)
+ *
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ *
+ * The callback of the monitor is not invoked. A probe already sent goes on
+ * until the target answers, its result is ignored.
+ */
+int
+nfc_initiator_target_monitor_stop(nfc_device *pnd)
+{
+  nfc_device_lock(pnd);
+  if (pnd->async) {
+    pnd->async->bMonitor = false;
+    pnd->async->pnacProbe = NULL;
+  }
+  nfc_device_unlock(pnd);
+  return NFC_SUCCESS;
+}
+
+#else // _WIN32
+
+void
+nfc_async_free(nfc_device *pnd)
+{
+  (void)pnd;
+}
+
+bool
+nfc_async_cancel(nfc_device *pnd)
+{
+  (void)pnd;
+  return false;
+}
+
+int
+nfc_device_get_event_fd(nfc_device *pnd)
+{
+  (void)pnd;
+  return NFC_ENOTIMPL;
+}
+
+int
+nfc_device_get_event_timeout(nfc_device *pnd)
+{
+  (void)pnd;
+  return -1;
+}
+
+int
+nfc_device_process_events(nfc_device *pnd)
+{
+  (void)pnd;
+  return NFC_ENOTIMPL;
+}
+
+int
+nfc_initiator_transceive_bytes_submit(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, uint8_t *pbtRx,
+                                      const size_t szRx, int timeout, nfc_completion_callback cb, void *user_data)
+{
+  (void)pnd;
+  (void)pbtTx;
+  (void)szTx;
+  (void)pbtRx;
+  (void)szRx;
+  (void)timeout;
+  (void)cb;
+  (void)user_data;
+  return NFC_ENOTIMPL;
+}
+
+int
+nfc_initiator_select_passive_target_submit(nfc_device *pnd, const nfc_modulation nm, const uint8_t *pbtInitData,
+                                           const size_t szInitData, nfc_target *pnt, nfc_completion_callback cb, void *user_data)
+{
+  (void)pnd;
+  (void)nm;
+  (void)pbtInitData;
+  (void)szInitData;
+  (void)pnt;
+  (void)cb;
+  (void)user_data;
+  return NFC_ENOTIMPL;
+}
+
+int
+nfc_initiator_poll_target_submit(nfc_device *pnd, const nfc_modulation *pnmModulations, const size_t szModulations,
+                                 const uint8_t uiPollNr, const uint8_t uiPeriod, nfc_target *pnt,
+                                 nfc_completion_callback cb, void *user_data)
+{
+  (void)pnd;
+  (void)pnmModulations;
+  (void)szModulations;
+  (void)uiPollNr;
+  (void)uiPeriod;
+  (void)pnt;
+  (void)cb;
+  (void)user_data;
+  return NFC_ENOTIMPL;
+}
+
+int
+nfc_initiator_target_monitor(nfc_device *pnd, const nfc_target *pnt, const int cadence,
+                             nfc_target_monitor_callback cb, void *user_data)
+{
+  (void)pnd;
+  (void)pnt;
+  (void)cadence;
+  (void)cb;
+  (void)user_data;
+  return NFC_ENOTIMPL;
+}
+
+int
+nfc_initiator_target_monitor_stop(nfc_device *pnd)
+{
+  (void)pnd;
+  return NFC_ENOTIMPL;
+}
+
+#endif // _WIN32
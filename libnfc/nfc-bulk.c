@@ -0,0 +1,210 @@
+/*-
+ * Free/Libre Near Field Communication (NFC) library
+ *
+ * Libnfc historical contributors:
+ * Copyright (C) 2009      Roel Verdult
+ * Copyright (C) 2009-2013 Romuald Conty
+ * Copyright (C) 2010-2012 Romain Tartière
+ * Copyright (C) 2010-2013 Philippe Teuwen
+ * Copyright (C) 2012-2013 Ludovic Rousseau
+ * See AUTHORS file for a more comprehensive list of contributors.
+ * Additional contributors of this file:
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+/**
+ * @file nfc-bulk.c
+ * @brief Provide routines to move large payloads over NFC-DEP
+ *
+ * Frames longer than what the device carries at once are chained (MI bit)
+ * by the driver, both ways, so a whole payload goes through one call. These
+ * helpers add the selection of the fastest NFC-DEP link a target accepts
+ * and report the throughput achieved.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <string.h>
+
+#include <nfc/nfc.h>
+
+#include "nfc-internal.h"
+
+#define LOG_CATEGORY "libnfc.general"
+#define LOG_GROUP    NFC_LOG_GROUP_GENERAL
+
+static const nfc_dep_mode andmBulk[] = { NDM_ACTIVE, NDM_PASSIVE };
+static const nfc_baud_rate anbrBulk[] = { NBR_424, NBR_212, NBR_106 };
+
+static bool
+bulk_baud_rate_is_supported(nfc_device *pnd, const nfc_baud_rate nbr)
+{
+  const nfc_baud_rate *supported_br;
+  if (nfc_device_get_supported_baud_rate(pnd, NMT_DEP, &supported_br) < 0)
+    return true;
+  for (size_t n = 0; supported_br[n]; n++) {
+    if (supported_br[n] == nbr)
+      return true;
+  }
+  return false;
+}
+
+static void
+bulk_stats_fill(nfc_bulk_stats *pstats, const size_t szSent, const size_t szReceived, const int64_t i64Start)
+{
+  if (!pstats)
+    return;
+  pstats->szSent = szSent;
+  pstats->szReceived = szReceived;
+  pstats->ui64Microseconds = MAX(nfc_monotonic_us() - i64Start, 1);
+  pstats->uiBytesPerSecond = (uint32_t) MIN(((uint64_t)(szSent + szReceived) * 1000000) / pstats->ui64Microseconds, UINT32_MAX);
+}
+
+/** @ingroup initiator
+ * @brief Select a D.E.P. (NFCIP-1) target on the fastest link it accepts
+ * @return Returns selected D.E.P. targets count on success, otherwise returns libnfc's error code (negative value).
+ *
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ * @param pndiInitiator pointer \a nfc_dep_info struct that contains \e NFCID3 and \e General \e Bytes to set to the initiator device (optionnal, can be \e NULL)
+ * @param[out] pnt is a \a nfc_target struct pointer where target information will be put; its mode and baud rate tell the link in use.
+ * @param timeout in milliseconds, shared among the attempts
+ *
+ * The links of the targets selected before by this device are tried first
+ * (see nfc_initiator_dep_session_lookup()), most recent first; a target which
+ * does not answer straight at its former rate is selected at 106 kbps then
+ * switched to that rate by PSL once recognized by its NFCID3. Then active
+ * mode is tried, then
+ * passive mode, each from 424 kbps down to 106 kbps (skipping the rates the
+ * device does not support), until a target answers. The frame length (LR) is
+ * left to the device, which asks for the largest one (254 bytes) in its
+ * ATR_REQ.
+ *
+ * Only the last attempt may block indefinitely when \a timeout is 0.
+ */
+int
+nfc_initiator_select_dep_target_fastest(nfc_device *pnd, const nfc_dep_info *pndiInitiator, nfc_target *pnt, const int timeout)
+{
+  const nfc_deadline deadline = nfc_deadline_from_timeout(timeout);
+  const size_t szAttempts = (sizeof(andmBulk) / sizeof(andmBulk[0])) * (sizeof(anbrBulk) / sizeof(anbrBulk[0]));
+  size_t szAttempt = 0;
+  int res = 0;
+
+  nfc_device_lock(pnd);
+  // Known peers first, straight on the link they accepted last time
+  if ((res = nfc_dep_session_resume(pnd, NDM_UNDEFINED, NBR_UNDEFINED, true, pndiInitiator, pnt, timeout)) != 0)
+    goto end;
+  for (size_t m = 0; m < sizeof(andmBulk) / sizeof(andmBulk[0]); m++) {
+    for (size_t b = 0; b < sizeof(anbrBulk) / sizeof(anbrBulk[0]); b++) {
+      szAttempt++;
+      if (!bulk_baud_rate_is_supported(pnd, anbrBulk[b]))
+        continue;
+      int iTimeout = timeout;
+      if (deadline) {
+        int remaining;
+        if ((remaining = nfc_deadline_remaining(deadline)) < 0) {
+          res = NFC_ETIMEOUT;
+          goto end;
+        }
+        // Leave time to the slower links
+        iTimeout = MAX(remaining / (int)(szAttempts - szAttempt + 1), 1);
+      } else if ((timeout == 0) && (szAttempt < szAttempts)) {
+        iTimeout = -1;
+      }
+      res = nfc_initiator_select_dep_target(pnd, andmBulk[m], anbrBulk[b], pndiInitiator, pnt, iTimeout);
+      if (res > 0) {
+        log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "D.E.P. target selected in %s mode at %s",
+                (andmBulk[m] == NDM_ACTIVE) ? "active" : "passive", str_nfc_baud_rate(anbrBulk[b]));
+        goto end;
+      }
+      if ((res == NFC_EOPABORTED) || (res == NFC_EIO) || (res == NFC_ENOTSUCHDEV))
+        goto end;
+    }
+  }
+end:
+  nfc_device_unlock(pnd);
+  return res;
+}
+
+/** @ingroup initiator
+ * @brief Send a payload of any length to the selected target then retrieve its answer
+ * @return Returns received bytes count on success, otherwise returns libnfc's error code
+ *
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ * @param pbtTx payload to send
+ * @param szTx payload length
+ * @param[out] pbtRx answer of the target
+ * @param szRx size of \a pbtRx (Will return NFC_EOVFLOW if RX exceeds this size)
+ * @param[out] pstats throughput achieved (optionnal, can be \e NULL)
+ * @param timeout in milliseconds, for each frame
+ *
+ * Like nfc_initiator_transceive_bytes(), the payload and the answer being
+ * chained over as many frames as needed by the device.
+ *
+ * @warning The configuration option \a NP_EASY_FRAMING must be set to \c true (the default value).
+ */
+int
+nfc_initiator_transceive_bulk(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, uint8_t *pbtRx, const size_t szRx, nfc_bulk_stats *pstats, int timeout)
+{
+  const int64_t i64Start = nfc_monotonic_us();
+  int res = nfc_initiator_transceive_bytes(pnd, pbtTx, szTx, pbtRx, szRx, timeout);
+  if (res >= 0)
+    bulk_stats_fill(pstats, szTx, res, i64Start);
+  return res;
+}
+
+/** @ingroup target
+ * @brief Receive a payload of any length from the initiator
+ * @return Returns received bytes count on success, otherwise returns libnfc's error code
+ *
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ * @param pbtRx payload received
+ * @param szRx size of \a pbtRx
+ * @param[out] pstats throughput achieved (optionnal, can be \e NULL)
+ * @param timeout in milliseconds
+ *
+ * The throughput is measured from the call, so the time spent waiting for
+ * the initiator to start sending is included.
+ */
+int
+nfc_target_receive_bulk(nfc_device *pnd, uint8_t *pbtRx, const size_t szRx, nfc_bulk_stats *pstats, int timeout)
+{
+  const int64_t i64Start = nfc_monotonic_us();
+  int res = nfc_target_receive_bytes(pnd, pbtRx, szRx, timeout);
+  if (res >= 0)
+    bulk_stats_fill(pstats, 0, res, i64Start);
+  return res;
+}
+
+/** @ingroup target
+ * @brief Send a payload of any length to the initiator
+ * @return Returns sent bytes count on success, otherwise returns libnfc's error code
+ *
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ * @param pbtTx payload to send
+ * @param szTx payload length
+ * @param[out] pstats throughput achieved (optionnal, can be \e NULL)
+ * @param timeout in milliseconds, for each frame
+ */
+int
+nfc_target_send_bulk(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, nfc_bulk_stats *pstats, int timeout)
+{
+  const int64_t i64Start = nfc_monotonic_us();
+  int res = nfc_target_send_bytes(pnd, pbtTx, szTx, timeout);
+  if (res >= 0)
+    bulk_stats_fill(pstats, szTx, 0, i64Start);
+  return res;
+}
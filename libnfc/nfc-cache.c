@@ -0,0 +1,296 @@
+/*-
+ * Free/Libre Near Field Communication (NFC) library
+ *
+ * Libnfc historical contributors:
+ * Copyright (C) 2009      Roel Verdult
+ * Copyright (C) 2009-2013 Romuald Conty
+ * Copyright (C) 2010-2012 Romain Tartière
+ * Copyright (C) 2010-2013 Philippe Teuwen
+ * Copyright (C) 2012-2013 Ludovic Rousseau
+ * See AUTHORS file for a more comprehensive list of contributors.
+ * Additional contributors of this file:
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+/**
+ * @file nfc-cache.c
+ * @brief Provide an on-disk cache of device descriptions, to speed up nfc_open()
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <stdio.h>
+#include <string.h>
+
+#include <nfc/nfc.h>
+
+#include "nfc-internal.h"
+
+#define LOG_CATEGORY "libnfc.general"
+#define LOG_GROUP    NFC_LOG_GROUP_GENERAL
+
+#define NFC_DEVICE_CACHE_MAGIC   "NFCC"
+#define NFC_DEVICE_CACHE_VERSION 2
+
+#define NFC_DEVICE_CACHE_PATH_LENGTH (DEVICE_CACHE_DIR_LENGTH + NFC_BUFSIZE_CONNSTRING + 8)
+
+/*
+ * Every record starts with this header: a record is only used if it was
+ * written by the same driver for the same device. A device with a serial
+ * number is known by it wherever it is plugged, any other one by its
+ * connstring.
+ */
+struct nfc_device_cache_header {
+  char acMagic[4];
+  uint32_t ui32Version;
+  uint32_t ui32RecordLen;
+  char acDriver[32];
+  char acName[DEVICE_NAME_LENGTH];
+  char acSerial[DEVICE_SERIAL_LENGTH];
+  nfc_connstring acConnstring;
+};
+
+/*
+ * What this process knows of the cache files, so that a device opened again
+ * does not touch the disk: the record read or written last, or the absence of
+ * record. Records larger than NFC_DEVICE_CACHE_MEMO_RECORD_LEN are not kept.
+ */
+#define NFC_DEVICE_CACHE_MEMO_LEN        8
+#define NFC_DEVICE_CACHE_MEMO_RECORD_LEN 512
+
+struct nfc_device_cache_memo {
+  char acPath[NFC_DEVICE_CACHE_PATH_LENGTH];
+  bool bPresent;
+  struct nfc_device_cache_header ndch;
+  uint8_t abtRecord[NFC_DEVICE_CACHE_MEMO_RECORD_LEN];
+};
+
+static struct nfc_device_cache_memo andcmMemo[NFC_DEVICE_CACHE_MEMO_LEN];
+static size_t szMemoNext = 0;
+static nfc_mutex ndcmMutex = NFC_MUTEX_INITIALIZER;
+
+static struct nfc_device_cache_memo *
+nfc_device_cache_memo_find(const char *pcPath)
+{
+  for (size_t n = 0; n < NFC_DEVICE_CACHE_MEMO_LEN; n++) {
+    if (strcmp(andcmMemo[n].acPath, pcPath) == 0)
+      return &andcmMemo[n];
+  }
+  return NULL;
+}
+
+/*
+ * Remember the record of pcPath, or its absence when pndch is NULL. Must be
+ * called with ndcmMutex held.
+ */
+static void
+nfc_device_cache_memo_set(const char *pcPath, const struct nfc_device_cache_header *pndch, const void *pRecord, const size_t szRecord)
+{
+  struct nfc_device_cache_memo *pndcm;
+
+  if (!(pndcm = nfc_device_cache_memo_find(pcPath))) {
+    pndcm = &andcmMemo[szMemoNext];
+    szMemoNext = (szMemoNext + 1) % NFC_DEVICE_CACHE_MEMO_LEN;
+  }
+  if (pndch && (szRecord > sizeof(pndcm->abtRecord))) {
+    // Too large to be kept, the file will be read next time
+    pndcm->acPath[0] = '\0';
+    return;
+  }
+  snprintf(pndcm->acPath, sizeof(pndcm->acPath), "%s", pcPath);
+  pndcm->bPresent = (pndch != NULL);
+  if (pndch) {
+    pndcm->ndch = *pndch;
+    memcpy(pndcm->abtRecord, pRecord, szRecord);
+  }
+}
+
+static void
+nfc_device_cache_header_init(const nfc_device *pnd, struct nfc_device_cache_header *pndch, const size_t szRecord)
+{
+  memset(pndch, 0, sizeof(*pndch));
+  memcpy(pndch->acMagic, NFC_DEVICE_CACHE_MAGIC, sizeof(pndch->acMagic));
+  pndch->ui32Version = NFC_DEVICE_CACHE_VERSION;
+  pndch->ui32RecordLen = (uint32_t)szRecord;
+  // Bytes past the strings stay zeroed, headers are compared as a whole
+  snprintf(pndch->acDriver, sizeof(pndch->acDriver), "%s", pnd->driver->name);
+  snprintf(pndch->acName, sizeof(pndch->acName), "%s", pnd->name);
+  snprintf(pndch->acSerial, sizeof(pndch->acSerial), "%s", pnd->serial);
+  // The connstring of an USB device changes each time it is plugged
+  if (pnd->serial[0] == '\0')
+    snprintf(pndch->acConnstring, sizeof(pndch->acConnstring), "%s", pnd->connstring);
+}
+
+/*
+ * Build the cache file path of a device, one file per serial number (with
+ * the driver name) or else per connstring.
+ * Returns false if caching is disabled.
+ */
+static bool
+nfc_device_cache_path(const nfc_device *pnd, char *pcPath, const size_t szPath)
+{
+  char acKey[NFC_BUFSIZE_CONNSTRING];
+  char acFile[NFC_BUFSIZE_CONNSTRING];
+
+  if ((pnd->context == NULL) || (pnd->context->device_cache_dir[0] == '\0'))
+    return false;
+  if (pnd->serial[0] != '\0') {
+    snprintf(acKey, sizeof(acKey), "%s-%s", pnd->driver->name, pnd->serial);
+  } else {
+    snprintf(acKey, sizeof(acKey), "%s", pnd->connstring);
+  }
+  // Keep the key as file name, only with harmless characters
+  size_t n;
+  for (n = 0; (acKey[n] != '\0') && (n < sizeof(acFile) - 1); n++) {
+    const char c = acKey[n];
+    if (((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || ((c >= '0') && (c <= '9')) || (c == '-') || (c == '.')) {
+      acFile[n] = c;
+    } else {
+      acFile[n] = '_';
+    }
+  }
+  acFile[n] = '\0';
+  return snprintf(pcPath, szPath, "%s/%s.cache", pnd->context->device_cache_dir, acFile) < (int)szPath;
+}
+
+/**
+ * @brief Load the cached description of a device
+ * @return Returns 0 if a record matching \a pnd has been read, otherwise returns libnfc's error code
+ *
+ * @param pnd \a nfc_device struct pointer of the device being opened
+ * @param pRecord buffer receiving the record, its content is driver specific
+ * @param szRecord size of the record
+ *
+ * The file is only read the first time, the record (or its absence) being
+ * then remembered by the process.
+ */
+int
+nfc_device_cache_load(const nfc_device *pnd, void *pRecord, const size_t szRecord)
+{
+  char acPath[NFC_DEVICE_CACHE_PATH_LENGTH];
+  struct nfc_device_cache_header ndchExpected, ndchRead;
+  const struct nfc_device_cache_memo *pndcm;
+  FILE *f;
+  bool bRead = false;
+
+  if (!nfc_device_cache_path(pnd, acPath, sizeof(acPath)))
+    return NFC_ENOTIMPL;
+  nfc_device_cache_header_init(pnd, &ndchExpected, szRecord);
+  nfc_mutex_lock(&ndcmMutex);
+  if ((pndcm = nfc_device_cache_memo_find(acPath))) {
+    bRead = pndcm->bPresent && (memcmp(&pndcm->ndch, &ndchExpected, sizeof(ndchExpected)) == 0);
+    if (bRead)
+      memcpy(pRecord, pndcm->abtRecord, szRecord);
+    nfc_mutex_unlock(&ndcmMutex);
+    return bRead ? NFC_SUCCESS : NFC_EIO;
+  }
+  if ((f = fopen(acPath, "rb")) != NULL) {
+    bRead = (fread(&ndchRead, sizeof(ndchRead), 1, f) == 1) &&
+            (memcmp(&ndchRead, &ndchExpected, sizeof(ndchRead)) == 0) &&
+            (fread(pRecord, szRecord, 1, f) == 1);
+    fclose(f);
+  }
+  nfc_device_cache_memo_set(acPath, bRead ? &ndchExpected : NULL, pRecord, szRecord);
+  nfc_mutex_unlock(&ndcmMutex);
+  if (!bRead) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "No usable cached description \"%s\"", acPath);
+    return NFC_EIO;
+  }
+  log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "Cached description \"%s\" loaded", acPath);
+  return NFC_SUCCESS;
+}
+
+/**
+ * @brief Save the description of a device for its next openings
+ * @return Returns 0 on success, otherwise returns libnfc's error code
+ *
+ * @param pnd \a nfc_device struct pointer of the device being opened
+ * @param pRecord record to save, its content is driver specific
+ * @param szRecord size of the record
+ *
+ * Nothing is written when the record did not change. Otherwise it is written
+ * aside then renamed, so that a concurrent opening never reads a partial
+ * record.
+ */
+int
+nfc_device_cache_store(const nfc_device *pnd, const void *pRecord, const size_t szRecord)
+{
+  char acPath[NFC_DEVICE_CACHE_PATH_LENGTH];
+  char acTmpPath[sizeof(acPath) + 4];
+  struct nfc_device_cache_header ndch;
+  const struct nfc_device_cache_memo *pndcm;
+  FILE *f;
+  int res = NFC_EIO;
+
+  if (!nfc_device_cache_path(pnd, acPath, sizeof(acPath)))
+    return NFC_ENOTIMPL;
+  nfc_device_cache_header_init(pnd, &ndch, szRecord);
+  nfc_mutex_lock(&ndcmMutex);
+  if ((pndcm = nfc_device_cache_memo_find(acPath)) && pndcm->bPresent &&
+      (memcmp(&pndcm->ndch, &ndch, sizeof(ndch)) == 0) && (memcmp(pndcm->abtRecord, pRecord, szRecord) == 0)) {
+    nfc_mutex_unlock(&ndcmMutex);
+    return NFC_SUCCESS;
+  }
+  snprintf(acTmpPath, sizeof(acTmpPath), "%s.tmp", acPath);
+  if ((f = fopen(acTmpPath, "wb")) == NULL) {
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_INFO, "Unable to write cached description \"%s\"", acTmpPath);
+    goto end;
+  }
+  const bool bWritten = (fwrite(&ndch, sizeof(ndch), 1, f) == 1) &&
+                        (fwrite(pRecord, szRecord, 1, f) == 1);
+  if ((fclose(f) != 0) || !bWritten) {
+    remove(acTmpPath);
+    goto end;
+  }
+#ifdef _WIN32
+  // rename() does not replace an existing file on Windows
+  remove(acPath);
+#endif
+  if (rename(acTmpPath, acPath) != 0) {
+    remove(acTmpPath);
+    goto end;
+  }
+  nfc_device_cache_memo_set(acPath, &ndch, pRecord, szRecord);
+  log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "Cached description \"%s\" saved", acPath);
+  res = NFC_SUCCESS;
+end:
+  nfc_mutex_unlock(&ndcmMutex);
+  return res;
+}
+
+/**
+ * @brief Forget the cached description of a device
+ *
+ * @param pnd \a nfc_device struct pointer of the device whose description does not match anymore
+ */
+void
+nfc_device_cache_invalidate(const nfc_device *pnd)
+{
+  char acPath[NFC_DEVICE_CACHE_PATH_LENGTH];
+  const struct nfc_device_cache_memo *pndcm;
+
+  if (!nfc_device_cache_path(pnd, acPath, sizeof(acPath)))
+    return;
+  nfc_mutex_lock(&ndcmMutex);
+  // Nothing to remove when the process knows there is no record
+  if (!(pndcm = nfc_device_cache_memo_find(acPath)) || pndcm->bPresent) {
+    if (remove(acPath) == 0)
+      log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "Cached description \"%s\" invalidated", acPath);
+    nfc_device_cache_memo_set(acPath, NULL, NULL, 0);
+  }
+  nfc_mutex_unlock(&ndcmMutex);
+}
@@ -0,0 +1,268 @@
+/*-
+ * Free/Libre Near Field Communication (NFC) library
+ *
+ * Libnfc historical contributors:
+ * Copyright (C) 2009      Roel Verdult
+ * Copyright (C) 2009-2013 Romuald Conty
+ * Copyright (C) 2010-2012 Romain Tartière
+ * Copyright (C) 2010-2013 Philippe Teuwen
+ * Copyright (C) 2012-2013 Ludovic Rousseau
+ * See AUTHORS file for a more comprehensive list of contributors.
+ * Additional contributors of this file:
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+
+/**
+ * @file nfc-dep-session.c
+ * @brief Provide a cache of the D.E.P. (NFCIP-1) links recently established
+ *
+ * Every successful D.E.P. selection is remembered per device, keyed by the
+ * target NFCID3: mode, baud rate and the ATR_RES parameters (DID, BS, BR,
+ * TO, PP with the frame length LR, General Bytes). When the same peer comes
+ * back, the links it accepted are tried first, straight at their known mode
+ * and rate, before the full selection procedure. A peer which does not
+ * answer straight at a rate above 106 kbps is selected at 106 kbps then,
+ * once recognized by its NFCID3, switched to the rate it accepted by PSL.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <string.h>
+
+#include <nfc/nfc.h>
+
+#include "nfc-internal.h"
+
+#define LOG_CATEGORY "libnfc.general"
+#define LOG_GROUP    NFC_LOG_GROUP_GENERAL
+
+// Time given to each cached link: the ATR exchange takes a few milliseconds
+#define NFC_DEP_SESSION_RESUME_TIMEOUT 100
+
+static struct nfc_dep_session *
+nfc_dep_session_find(nfc_device *pnd, const uint8_t *pbtNFCID3)
+{
+  for (size_t n = 0; n < NFC_DEP_SESSION_CACHE_LEN; n++) {
+    struct nfc_dep_session *pnds = &pnd->andsSessions[n];
+    if (pnds->i64LastSeen && (memcmp(pnds->ndi.abtNFCID3, pbtNFCID3, sizeof(pnds->ndi.abtNFCID3)) == 0))
+      return pnds;
+  }
+  return NULL;
+}
+
+/*
+ * Remember the D.E.P. link just established in mode ndm with target pnt,
+ * replacing the entry of the same NFCID3 or else the least recently seen one.
+ */
+void
+nfc_dep_session_store(nfc_device *pnd, const nfc_dep_mode ndm, const nfc_target *pnt)
+{
+  struct nfc_dep_session *pnds;
+
+  if (pnt->nm.nmt != NMT_DEP)
+    return;
+  if (!(pnds = nfc_dep_session_find(pnd, pnt->nti.ndi.abtNFCID3))) {
+    pnds = &pnd->andsSessions[0];
+    for (size_t n = 1; n < NFC_DEP_SESSION_CACHE_LEN; n++) {
+      if (pnd->andsSessions[n].i64LastSeen < pnds->i64LastSeen)
+        pnds = &pnd->andsSessions[n];
+    }
+  }
+  pnds->ndi = pnt->nti.ndi;
+  pnds->ndi.ndm = ndm;
+  pnds->nbr = pnt->nm.nbr;
+  pnds->i64LastSeen = MAX(nfc_monotonic_us(), 1);
+}
+
+static int
+nfc_dep_session_timeout(const nfc_deadline deadline)
+{
+  int remaining;
+
+  if (!deadline)
+    return NFC_DEP_SESSION_RESUME_TIMEOUT;
+  if ((remaining = nfc_deadline_remaining(deadline)) < 0)
+    return remaining;
+  return MIN(NFC_DEP_SESSION_RESUME_TIMEOUT, remaining);
+}
+
+static bool
+nfc_dep_session_is_fatal(const int res)
+{
+  return (res == NFC_EOPABORTED) || (res == NFC_EIO) || (res == NFC_ENOTSUCHDEV);
+}
+
+/*
+ * Select a target at 106 kbps in mode ndm then, if its NFCID3 is found in
+ * the cache with a faster link in that mode, switch it to that baud rate with
+ * a PSL_REQ (see NFCIP-1 12.5.3). A target left at another baud rate than nbr
+ * is deselected, unless bAnyRate is set.
+ * Returns 1 if a target was selected, 0 if none was kept, otherwise
+ * libnfc's error code.
+ */
+static int
+nfc_dep_session_resume_psl(nfc_device *pnd, const nfc_dep_mode ndm, const nfc_baud_rate nbr, const bool bAnyRate,
+                           const nfc_dep_info *pndiInitiator, nfc_target *pnt, const int timeout)
+{
+  const struct nfc_dep_session *pnds;
+  int res;
+
+  if (!pnd->driver->initiator_dep_psl)
+    return 0;
+  if ((res = pnd->driver->initiator_select_dep_target(pnd, ndm, NBR_106, pndiInitiator, pnt, timeout)) <= 0)
+    return res;
+  if ((pnds = nfc_dep_session_find(pnd, pnt->nti.ndi.abtNFCID3)) &&
+      (pnds->ndi.ndm == ndm) && (pnds->nbr > NBR_106) && (bAnyRate || (pnds->nbr == nbr))) {
+    if ((res = pnd->driver->initiator_dep_psl(pnd, pnds->nbr)) == NFC_SUCCESS) {
+      pnt->nm.nbr = pnds->nbr;
+    } else if (nfc_dep_session_is_fatal(res)) {
+      return res;
+    }
+  }
+  if (!bAnyRate && (pnt->nm.nbr != nbr)) {
+    if (pnd->driver->initiator_deselect_target)
+      pnd->driver->initiator_deselect_target(pnd);
+    return 0;
+  }
+  nfc_dep_session_store(pnd, ndm, pnt);
+  return 1;
+}
+
+/*
+ * Try the links found in the cache, each one once even if several peers used
+ * it: the link at baud rate nbr first, then the others most recently seen
+ * first. Links in another mode than ndm (unless ndm is NDM_UNDEFINED) are
+ * skipped, so are links at another baud rate than nbr unless bAnyRate is set.
+ * When a peer does not answer straight at a rate above 106 kbps, it is
+ * selected at 106 kbps and switched to that rate by PSL, see
+ * nfc_dep_session_resume_psl().
+ * Returns 1 if a target was selected, 0 if none answered, otherwise a fatal
+ * libnfc's error code.
+ */
+int
+nfc_dep_session_resume(nfc_device *pnd, const nfc_dep_mode ndm, const nfc_baud_rate nbr, const bool bAnyRate,
+                       const nfc_dep_info *pndiInitiator, nfc_target *pnt, const int timeout)
+{
+  const nfc_deadline deadline = nfc_deadline_from_timeout(timeout);
+  const struct nfc_dep_session *apndsTried[NFC_DEP_SESSION_CACHE_LEN];
+  size_t szTried = 0;
+  nfc_target nt;
+
+  for (;;) {
+    const struct nfc_dep_session *pnds = NULL;
+    for (size_t n = 0; n < NFC_DEP_SESSION_CACHE_LEN; n++) {
+      const struct nfc_dep_session *pndsCandidate = &pnd->andsSessions[n];
+      if (!pndsCandidate->i64LastSeen)
+        continue;
+      if ((ndm != NDM_UNDEFINED) && (pndsCandidate->ndi.ndm != ndm))
+        continue;
+      if (!bAnyRate && (pndsCandidate->nbr != nbr))
+        continue;
+      bool bTried = false;
+      for (size_t t = 0; t < szTried; t++) {
+        if ((apndsTried[t]->ndi.ndm == pndsCandidate->ndi.ndm) && (apndsTried[t]->nbr == pndsCandidate->nbr))
+          bTried = true;
+      }
+      if (bTried)
+        continue;
+      if (!pnds) {
+        pnds = pndsCandidate;
+        continue;
+      }
+      // The requested baud rate comes first, then the most recent link
+      const bool bRequested = (pndsCandidate->nbr == nbr);
+      if ((bRequested && (pnds->nbr != nbr)) ||
+          ((bRequested == (pnds->nbr == nbr)) && (pndsCandidate->i64LastSeen > pnds->i64LastSeen)))
+        pnds = pndsCandidate;
+    }
+    if (!pnds)
+      return 0;
+    apndsTried[szTried++] = pnds;
+
+    // Copy the link out of the cache, a successful selection updates it
+    const nfc_dep_mode ndmCached = pnds->ndi.ndm;
+    const nfc_baud_rate nbrCached = pnds->nbr;
+    int iTimeout;
+    if ((iTimeout = nfc_dep_session_timeout(deadline)) < 0)
+      return 0;
+    int res = nfc_initiator_select_dep_target(pnd, ndmCached, nbrCached, pndiInitiator, &nt, iTimeout);
+    if ((res <= 0) && !nfc_dep_session_is_fatal(res) && (nbrCached > NBR_106)) {
+      if ((iTimeout = nfc_dep_session_timeout(deadline)) < 0)
+        return 0;
+      res = nfc_dep_session_resume_psl(pnd, ndmCached, nbr, bAnyRate, pndiInitiator, &nt, iTimeout);
+    }
+    if (res > 0) {
+      log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "D.E.P. target resumed in %s mode at %s",
+              (ndmCached == NDM_ACTIVE) ? "active" : "passive", str_nfc_baud_rate(nt.nm.nbr));
+      if (pnt)
+        *pnt = nt;
+      return res;
+    }
+    if (nfc_dep_session_is_fatal(res))
+      return res;
+  }
+}
+
+/** @ingroup initiator
+ * @brief Look up the D.E.P. link last established with a target
+ * @return Returns 1 if the target is known, 0 if not, otherwise returns libnfc's error code (negative value)
+ *
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ * @param pbtNFCID3 NFCID3 of the target (10 bytes)
+ * @param[out] pnt is a \a nfc_target struct pointer where the target information received at that time will be put (optionnal, can be \e NULL)
+ *
+ * Each device remembers the last D.E.P. targets it selected. Their mode and
+ * baud rate are tried first by nfc_initiator_poll_dep_target() and
+ * nfc_initiator_select_dep_target_fastest(). An application can compare the
+ * General Bytes of a target just selected with the remembered ones, e.g. to
+ * skip its own parameters negotiation when they did not change.
+ *
+ * @note Peers using a random NFCID3 are never found here, their links are
+ * still tried first though.
+ */
+int
+nfc_initiator_dep_session_lookup(nfc_device *pnd, const uint8_t *pbtNFCID3, nfc_target *pnt)
+{
+  const struct nfc_dep_session *pnds;
+  int res = 0;
+
+  nfc_device_lock(pnd);
+  if ((pnds = nfc_dep_session_find(pnd, pbtNFCID3))) {
+    if (pnt) {
+      memset(pnt, 0, sizeof(*pnt));
+      pnt->nm.nmt = NMT_DEP;
+      pnt->nm.nbr = pnds->nbr;
+      pnt->nti.ndi = pnds->ndi;
+    }
+    res = 1;
+  }
+  nfc_device_unlock(pnd);
+  return res;
+}
+
+/** @ingroup initiator
+ * @brief Forget the D.E.P. links established by a device
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ */
+void
+nfc_initiator_dep_session_clear(nfc_device *pnd)
+{
+  nfc_device_lock(pnd);
+  memset(pnd->andsSessions, 0, sizeof(pnd->andsSessions));
+  nfc_device_unlock(pnd);
+}
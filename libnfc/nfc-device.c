@@ -59,8 +59,18 @@ nfc_device_new(const nfc_context *context, const nfc_connstring connstring)
   res->bEasyFraming    = false;
   res->bInfiniteSelect = false;
   res->bAutoIso14443_4 = false;
+  res->bAutoPps = false;
+  res->bForceIso14443a = false;
+  res->bForceIso14443b = false;
+  res->bForceSpeed106 = false;
+  res->iTimeoutCom = -1;
   res->last_error  = 0;
+  res->pool = NULL;
+  res->async = NULL;
+  memset(res->andsSessions, 0, sizeof(res->andsSessions));
+  nfc_mutex_init(&res->mutex);
   memcpy(res->connstring, connstring, sizeof(res->connstring));
+  res->serial[0] = '\0';
   res->driver_data = NULL;
   res->chip_data   = NULL;
 
@@ -71,6 +81,7 @@ void
 nfc_device_free(nfc_device *dev)
 {
   if (dev) {
+    nfc_mutex_destroy(&dev->mutex);
     free(dev->driver_data);
     free(dev);
   }
@@ -29,11 +29,101 @@
  * @brief Provide a small API to ease emulation in libnfc
  */
 
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <stdlib.h>
+#include <string.h>
+
 #include <nfc/nfc.h>
 #include <nfc/nfc-emulation.h>
 
+#include "nfc-internal.h"
 #include "iso7816.h"
 
+// Streamed answers are sent by parts of one short R-APDU
+#define EMULATION_STREAM_PART_LEN ISO7816_SHORT_R_APDU_MAX_LEN
+
+// NFC Forum Type 2 Tag / MIFARE Ultralight commands
+#define TYPE2_READ        0x30
+#define TYPE2_GET_VERSION 0x60
+#define TYPE2_READ_SIG    0x3C
+#define TYPE2_HALT        0x50
+// 4-bit NAK: invalid argument
+#define TYPE2_NAK         0x00
+
+#define TYPE2_CRC_LEN     2
+// Page addresses are coded on one byte
+#define TYPE2_MAX_PAGES   256
+
+static int
+nfc_emulate_target_ext(nfc_device *pnd, struct nfc_emulator *emulator, nfc_emulation_stream_callback stream, const int timeout)
+{
+  struct nfc_emulation_state_machine *state_machine = emulator->state_machine;
+  const size_t szRxLen = ISO7816_EXTENDED_C_APDU_MAX_LEN;
+  // Streamed answers go one frame at a time, the next part being read before
+  // the current one is sent to know whether it is the last one
+  const size_t szTxLen = stream ? EMULATION_STREAM_PART_LEN : ISO7816_EXTENDED_R_APDU_MAX_LEN;
+  uint8_t *pbtRx = malloc(szRxLen);
+  uint8_t *pbtTx = malloc(stream ? 2 * szTxLen : szTxLen);
+
+  int res;
+  if (!pbtRx || !pbtTx) {
+    res = pnd->last_error = NFC_ESOFT;
+    goto out;
+  }
+  if ((res = nfc_target_init(pnd, emulator->target, pbtRx, szRxLen, timeout)) < 0) {
+    goto out;
+  }
+
+  size_t szRx = res;
+  int io_res = res;
+  while (io_res >= 0) {
+    io_res = state_machine->io(emulator, pbtRx, szRx, pbtTx, szTxLen);
+    if ((io_res == (int) szTxLen) && stream) {
+      uint8_t *pbtPart = pbtTx;
+      uint8_t *pbtNext = pbtTx + szTxLen;
+      for (;;) {
+        if ((io_res = stream(emulator, pbtNext, szTxLen)) < 0)
+          break;
+        if (io_res == 0) {
+          // The part in hand is the last one
+          io_res = szTxLen;
+          break;
+        }
+        if ((res = nfc_target_send_bytes_chained(pnd, pbtPart, szTxLen, timeout)) < 0)
+          goto out;
+        uint8_t *pbt = pbtPart;
+        pbtPart = pbtNext;
+        pbtNext = pbt;
+        if (io_res < (int) szTxLen)
+          break;
+      }
+      if (io_res > 0) {
+        if ((res = nfc_target_send_bytes(pnd, pbtPart, io_res, timeout)) < 0)
+          goto out;
+      }
+    } else if (io_res > 0) {
+      if ((res = nfc_target_send_bytes(pnd, pbtTx, io_res, timeout)) < 0) {
+        goto out;
+      }
+    }
+    if (io_res >= 0) {
+      if ((res = nfc_target_receive_bytes(pnd, pbtRx, szRxLen, timeout)) < 0) {
+        goto out;
+      }
+      szRx = res;
+    }
+  }
+  res = io_res;
+
+out:
+  free(pbtRx);
+  free(pbtTx);
+  return res;
+}
+
 /** @ingroup emulation
  * @brief Emulate a target
  * @return Returns 0 on success, otherwise returns libnfc's error code (negative value).
@@ -41,36 +131,236 @@
  * @param pnd \a nfc_device struct pointer that represents currently used device
  * @param emulator \nfc_emulator struct point that handles input/output functions
  *
+ * Commands up to an extended length C-APDU (ISO/IEC 7816-4) are handed to
+ * the \a io function, the device gathering the frames chained by the
+ * initiator. \a io may answer with up to an extended length R-APDU.
+ *
  * If timeout equals to 0, the function blocks indefinitely (until an error is raised or function is completed)
  * If timeout equals to -1, the default timeout will be used
  */
 int
 nfc_emulate_target(nfc_device *pnd, struct nfc_emulator *emulator, const int timeout)
 {
-  uint8_t abtRx[ISO7816_SHORT_R_APDU_MAX_LEN];
-  uint8_t abtTx[ISO7816_SHORT_C_APDU_MAX_LEN];
+  return nfc_emulate_target_ext(pnd, emulator, NULL, timeout);
+}
+
+/** @ingroup emulation
+ * @brief Emulate a target, answers being produced part by part
+ * @return Returns 0 on success, otherwise returns libnfc's error code (negative value).
+ *
+ * @param pnd \a nfc_device struct pointer that represents currently used device
+ * @param emulator \nfc_emulator struct point that handles input/output functions
+ * @param stream function producing the next parts of an answer
+ * @param timeout timeout in milliseconds, as for nfc_emulate_target()
+ *
+ * Same as nfc_emulate_target(), but \a io gets a data_out of one frame only.
+ * If it fills it completely, \a stream is called for the next parts of the
+ * answer until it returns less than its data_out_len (possibly 0); parts are
+ * sent as they come, chained (see nfc_target_send_bytes_chained()), so large
+ * files can be served without being held in memory.
+ */
+int
+nfc_emulate_target_stream(nfc_device *pnd, struct nfc_emulator *emulator, nfc_emulation_stream_callback stream, const int timeout)
+{
+  return nfc_emulate_target_ext(pnd, emulator, stream, timeout);
+}
+
+struct nfc_emulation_type2 {
+  size_t szPages;
+  /** READ answer of each page, CRC appended */
+  uint8_t (*aabtRead)[NFC_EMULATION_TYPE2_READ_LEN + TYPE2_CRC_LEN];
+  uint8_t abtVersion[NFC_EMULATION_TYPE2_VERSION_LEN + TYPE2_CRC_LEN];
+  bool bVersion;
+  uint8_t abtSignature[NFC_EMULATION_TYPE2_SIGNATURE_LEN + TYPE2_CRC_LEN];
+  bool bSignature;
+  uint8_t abtRx[ISO7816_SHORT_C_APDU_MAX_LEN];
+};
+
+/** @ingroup emulation
+ * @brief Create a NFC Forum Type 2 Tag emulation from a memory image
+ * @return Returns a pointer to the emulation on success, NULL otherwise
+ *
+ * @param pbtMemory memory image, from page 0 (UID) to the last page
+ * @param szMemory size of \a pbtMemory, a multiple of NFC_EMULATION_TYPE2_PAGE_LEN, at least four pages and at most 256 pages
+ *
+ * The answer to every READ command is computed here once, CRC included, so
+ * nfc_emulate_type2_target() only has to pick it up. The image is copied:
+ * later changes of \a pbtMemory are not seen by the emulation.
+ */
+struct nfc_emulation_type2 *
+nfc_emulation_type2_new(const uint8_t *pbtMemory, const size_t szMemory)
+{
+  if ((szMemory % NFC_EMULATION_TYPE2_PAGE_LEN) ||
+      (szMemory < NFC_EMULATION_TYPE2_READ_LEN) ||
+      (szMemory > TYPE2_MAX_PAGES * NFC_EMULATION_TYPE2_PAGE_LEN))
+    return NULL;
+
+  struct nfc_emulation_type2 *pet2 = calloc(1, sizeof(struct nfc_emulation_type2));
+  if (!pet2)
+    return NULL;
+  pet2->szPages = szMemory / NFC_EMULATION_TYPE2_PAGE_LEN;
+  if (!(pet2->aabtRead = malloc(pet2->szPages * sizeof(*pet2->aabtRead)))) {
+    free(pet2);
+    return NULL;
+  }
+  for (size_t szPage = 0; szPage < pet2->szPages; szPage++) {
+    uint8_t *pbtRead = pet2->aabtRead[szPage];
+    // Reading past the last page rolls over to page 0, as a MIFARE Ultralight does
+    for (size_t n = 0; n < NFC_EMULATION_TYPE2_READ_LEN / NFC_EMULATION_TYPE2_PAGE_LEN; n++) {
+      memcpy(pbtRead + (n * NFC_EMULATION_TYPE2_PAGE_LEN),
+             pbtMemory + (((szPage + n) % pet2->szPages) * NFC_EMULATION_TYPE2_PAGE_LEN),
+             NFC_EMULATION_TYPE2_PAGE_LEN);
+    }
+    iso14443a_crc_append(pbtRead, NFC_EMULATION_TYPE2_READ_LEN);
+  }
+  return pet2;
+}
+
+/** @ingroup emulation
+ * @brief Free a NFC Forum Type 2 Tag emulation
+ *
+ * @param pet2 emulation to free, may be NULL
+ */
+void
+nfc_emulation_type2_free(struct nfc_emulation_type2 *pet2)
+{
+  if (pet2) {
+    free(pet2->aabtRead);
+    free(pet2);
+  }
+}
 
+/** @ingroup emulation
+ * @brief Answer GET_VERSION commands
+ * @return Returns 0 on success, otherwise returns libnfc's error code (negative value)
+ *
+ * @param pet2 emulation
+ * @param pbtVersion NFC_EMULATION_TYPE2_VERSION_LEN bytes to answer, or NULL to answer with a NAK (default)
+ */
+int
+nfc_emulation_type2_set_version(struct nfc_emulation_type2 *pet2, const uint8_t *pbtVersion)
+{
+  if (!pet2)
+    return NFC_EINVARG;
+  pet2->bVersion = (pbtVersion != NULL);
+  if (pbtVersion) {
+    memcpy(pet2->abtVersion, pbtVersion, NFC_EMULATION_TYPE2_VERSION_LEN);
+    iso14443a_crc_append(pet2->abtVersion, NFC_EMULATION_TYPE2_VERSION_LEN);
+  }
+  return NFC_SUCCESS;
+}
+
+/** @ingroup emulation
+ * @brief Answer READ_SIG commands
+ * @return Returns 0 on success, otherwise returns libnfc's error code (negative value)
+ *
+ * @param pet2 emulation
+ * @param pbtSignature NFC_EMULATION_TYPE2_SIGNATURE_LEN bytes to answer, or NULL to answer with a NAK (default)
+ */
+int
+nfc_emulation_type2_set_signature(struct nfc_emulation_type2 *pet2, const uint8_t *pbtSignature)
+{
+  if (!pet2)
+    return NFC_EINVARG;
+  pet2->bSignature = (pbtSignature != NULL);
+  if (pbtSignature) {
+    memcpy(pet2->abtSignature, pbtSignature, NFC_EMULATION_TYPE2_SIGNATURE_LEN);
+    iso14443a_crc_append(pet2->abtSignature, NFC_EMULATION_TYPE2_SIGNATURE_LEN);
+  }
+  return NFC_SUCCESS;
+}
+
+/** @ingroup emulation
+ * @brief Emulate a NFC Forum Type 2 Tag (i.e. MIFARE Ultralight)
+ * @return Returns 0 when the initiator halted the tag, otherwise returns libnfc's error code (negative value).
+ *
+ * @param pnd \a nfc_device struct pointer that represents currently used device
+ * @param pnt \a nfc_target to emulate, an ISO/IEC 14443A target which is not ISO/IEC 14443-4 compliant
+ * @param pet2 emulation holding the precomputed answers
+ *
+ * Unlike nfc_emulate_target(), frames are answered straight from the tables
+ * built by nfc_emulation_type2_new(): there is no callback, no allocation
+ * and no copy between receiving a command and sending its answer. READ,
+ * GET_VERSION and READ_SIG are supported, any other command (including
+ * writes, the tag being read-only) gets a NAK.
+ *
+ * If timeout equals to 0, the function blocks indefinitely (until an error is raised or function is completed)
+ * If timeout equals to -1, the default timeout will be used
+ */
+int
+nfc_emulate_type2_target(nfc_device *pnd, nfc_target *pnt, struct nfc_emulation_type2 *pet2, const int timeout)
+{
+  const uint8_t btNak = TYPE2_NAK;
   int res;
-  if ((res = nfc_target_init(pnd, emulator->target, abtRx, sizeof(abtRx), timeout)) < 0) {
+
+  if (!pet2 || (pnt->nm.nmt != NMT_ISO14443A))
+    return pnd->last_error = NFC_EINVARG;
+  if ((res = nfc_target_init(pnd, pnt, pet2->abtRx, sizeof(pet2->abtRx), timeout)) < 0)
     return res;
-  }
 
-  size_t szRx = res;
-  int io_res = res;
-  while (io_res >= 0) {
-    io_res = emulator->state_machine->io(emulator, abtRx, szRx, abtTx, sizeof(abtTx));
-    if (io_res > 0) {
-      if ((res = nfc_target_send_bytes(pnd, abtTx, io_res, timeout)) < 0) {
-        return res;
-      }
+  for (;;) {
+    size_t szRx = res;
+    // With CRC left to us, the answers are sent with their precomputed CRC
+    const size_t szCrc = pnd->bCrc ? 0 : TYPE2_CRC_LEN;
+    const uint8_t *pbtTx = NULL;
+    size_t szTx = 0;
+
+    if (szCrc) {
+      uint8_t abtCrc[TYPE2_CRC_LEN];
+      if (szRx < 1 + szCrc)
+        goto next;
+      szRx -= szCrc;
+      iso14443a_crc(pet2->abtRx, szRx, abtCrc);
+      if (memcmp(abtCrc, pet2->abtRx + szRx, TYPE2_CRC_LEN))
+        goto next;
     }
-    if (io_res >= 0) {
-      if ((res = nfc_target_receive_bytes(pnd, abtRx, sizeof(abtRx), timeout)) < 0) {
+    if (szRx == 0)
+      goto next;
+
+    switch (pet2->abtRx[0]) {
+      case TYPE2_READ:
+        if ((szRx == 2) && (pet2->abtRx[1] < pet2->szPages)) {
+          pbtTx = pet2->aabtRead[pet2->abtRx[1]];
+          szTx = NFC_EMULATION_TYPE2_READ_LEN;
+        }
+        break;
+      case TYPE2_GET_VERSION:
+        if ((szRx == 1) && pet2->bVersion) {
+          pbtTx = pet2->abtVersion;
+          szTx = NFC_EMULATION_TYPE2_VERSION_LEN;
+        }
+        break;
+      case TYPE2_READ_SIG:
+        if ((szRx == 2) && pet2->bSignature) {
+          pbtTx = pet2->abtSignature;
+          szTx = NFC_EMULATION_TYPE2_SIGNATURE_LEN;
+        }
+        break;
+      case TYPE2_HALT:
+        if (szRx == 2)
+          return NFC_SUCCESS;
+        break;
+    }
+
+    if (pbtTx) {
+      if ((res = nfc_target_send_bytes(pnd, pbtTx, szTx + szCrc, timeout)) < 0)
+        return res;
+    } else {
+      // A NAK is 4 bits on their own, without CRC
+      const bool bCrc = pnd->bCrc;
+      if (bCrc && ((res = nfc_device_set_property_bool(pnd, NP_HANDLE_CRC, false)) < 0))
         return res;
+      res = nfc_target_send_bits(pnd, &btNak, 4, NULL);
+      if (bCrc) {
+        const int resCrc = nfc_device_set_property_bool(pnd, NP_HANDLE_CRC, true);
+        if ((res >= 0) && (resCrc < 0))
+          res = resCrc;
       }
-      szRx = res;
+      if (res < 0)
+        return res;
     }
+next:
+    if ((res = nfc_target_receive_bytes(pnd, pet2->abtRx, sizeof(pet2->abtRx), timeout)) < 0)
+      return res;
   }
-  return io_res;
 }
-
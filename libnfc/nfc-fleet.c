@@ -0,0 +1,622 @@
+/*-
+ * Free/Libre Near Field Communication (NFC) library
+ *
+ * Libnfc historical contributors:
+ * Copyright (C) 2009      Roel Verdult
+ * Copyright (C) 2009-2013 Romuald Conty
+ * Copyright (C) 2010-2012 Romain Tartière
+ * Copyright (C) 2010-2013 Philippe Teuwen
+ * Copyright (C) 2012-2013 Ludovic Rousseau
+ * See AUTHORS file for a more comprehensive list of contributors.
+ * Additional contributors of this file:
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+/**
+ * @file nfc-fleet.c
+ * @brief Drive many devices from a bounded set of worker threads
+ *
+ * Each device of a fleet is owned by exactly one worker, which alternates
+ * between polling for a target and checking the presence of the target it
+ * found. Workers publish events in a bounded lock-free queue with multiple
+ * producers (the workers) and a single consumer (the application).
+ */
+
+#ifdef __linux__
+// pthread_setaffinity_np()
+#  define _GNU_SOURCE
+#endif
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _GNU_SOURCE
+// features.h raised _XOPEN_SOURCE, let config.h (included again by log.h) define it quietly
+#  undef _XOPEN_SOURCE
+#endif
+
+#include <nfc/nfc.h>
+
+#include "nfc-internal.h"
+
+#define LOG_CATEGORY "libnfc.general"
+#define LOG_GROUP    NFC_LOG_GROUP_GENERAL
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#define msleep(x) do { \
+    struct timespec xsleep; \
+    xsleep.tv_sec = x / 1000; \
+    xsleep.tv_nsec = (x - xsleep.tv_sec * 1000) * 1000 * 1000; \
+    nanosleep(&xsleep, NULL); \
+  } while (0)
+
+// Delay between two presence checks of a target, in ms
+#define FLEET_PRESENCE_CADENCE  100
+// Bounds of the exponential backoff applied to a failing device, in ms
+#define FLEET_MIN_BACKOFF       100
+#define FLEET_MAX_BACKOFF       5000
+// Sleep of a worker with nothing to do, in ms
+#define FLEET_IDLE_SLEEP        10
+
+#define FLEET_LOAD(p)           __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define FLEET_STORE(p, v)       __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define FLEET_INC(p)            __atomic_add_fetch((p), 1, __ATOMIC_RELAXED)
+
+struct nfc_fleet_cell {
+  size_t szSequence;
+  nfc_fleet_event nfe;
+};
+
+struct nfc_fleet_device {
+  nfc_device *pnd;
+  bool bInitialized;
+  bool bPresent;
+  nfc_target nt;
+  // Event which did not fit in the queue, the device is not operated until it is published
+  bool bPending;
+  nfc_fleet_event nfePending;
+  nfc_deadline next_deadline;
+  nfc_fleet_device_stats stats;
+};
+
+struct nfc_fleet_worker {
+  struct nfc_fleet *pnf;
+  pthread_t thread;
+  size_t szWorker;
+  int iCpu;
+  bool bStarted;
+};
+
+struct nfc_fleet {
+  nfc_modulation *pnmModulations;
+  size_t szModulations;
+  struct nfc_fleet_device *devices;
+  size_t szMaxDevices;
+  size_t szDevices;
+  struct nfc_fleet_worker *workers;
+  size_t szWorkers;
+  bool bRunning;
+  int iStop;
+  // Event queue: cells[] is a ring of szMask + 1 entries (a power of two)
+  struct nfc_fleet_cell *cells;
+  size_t szMask;
+  size_t szEnqueuePos;
+  size_t szDequeuePos;
+  // Wake-up of a consumer blocked in nfc_fleet_dequeue_events()
+  int iWaiting;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+};
+
+static bool
+nfc_fleet_enqueue(struct nfc_fleet *pnf, const nfc_fleet_event *pnfe)
+{
+  struct nfc_fleet_cell *pcell;
+  size_t szPos = __atomic_load_n(&pnf->szEnqueuePos, __ATOMIC_RELAXED);
+
+  for (;;) {
+    pcell = &(pnf->cells[szPos & pnf->szMask]);
+    const intptr_t diff = (intptr_t)FLEET_LOAD(&pcell->szSequence) - (intptr_t)szPos;
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&pnf->szEnqueuePos, &szPos, szPos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        break;
+    } else if (diff < 0) {
+      // Queue is full
+      return false;
+    } else {
+      szPos = __atomic_load_n(&pnf->szEnqueuePos, __ATOMIC_RELAXED);
+    }
+  }
+  pcell->nfe = *pnfe;
+  FLEET_STORE(&pcell->szSequence, szPos + 1);
+
+  // Pairs with the store of iWaiting in nfc_fleet_dequeue_events()
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&pnf->iWaiting, __ATOMIC_RELAXED)) {
+    pthread_mutex_lock(&pnf->mutex);
+    pthread_cond_signal(&pnf->cond);
+    pthread_mutex_unlock(&pnf->mutex);
+  }
+  return true;
+}
+
+static size_t
+nfc_fleet_dequeue(struct nfc_fleet *pnf, nfc_fleet_event anfe[], const size_t szEvents)
+{
+  size_t szCount = 0;
+
+  while (szCount < szEvents) {
+    const size_t szPos = pnf->szDequeuePos;
+    struct nfc_fleet_cell *pcell = &(pnf->cells[szPos & pnf->szMask]);
+    if (FLEET_LOAD(&pcell->szSequence) != szPos + 1)
+      break;
+    anfe[szCount++] = pcell->nfe;
+    FLEET_STORE(&pcell->szSequence, szPos + pnf->szMask + 1);
+    pnf->szDequeuePos = szPos + 1;
+  }
+  return szCount;
+}
+
+static void
+nfc_fleet_publish(struct nfc_fleet *pnf, struct nfc_fleet_device *pfd, const nfc_fleet_event *pnfe)
+{
+  if (nfc_fleet_enqueue(pnf, pnfe))
+    return;
+  // Backpressure: keep the event and stop operating this device until it fits
+  pfd->nfePending = *pnfe;
+  pfd->bPending = true;
+  FLEET_INC(&pfd->stats.uiStalls);
+}
+
+static void
+nfc_fleet_device_error(struct nfc_fleet *pnf, struct nfc_fleet_device *pfd, const size_t szDevice, const int res)
+{
+  const uint32_t uiConsecutiveErrors = FLEET_INC(&pfd->stats.uiConsecutiveErrors);
+  const int iShift = (uiConsecutiveErrors > 6) ? 6 : (int)(uiConsecutiveErrors - 1);
+  const int iBackoff = MIN(FLEET_MIN_BACKOFF << iShift, FLEET_MAX_BACKOFF);
+  nfc_fleet_event nfe;
+
+  FLEET_INC(&pfd->stats.uiErrors);
+  __atomic_store_n(&pfd->stats.iLastError, res, __ATOMIC_RELAXED);
+  log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "Fleet device \"%s\" failed (%d), retrying in %d ms", pfd->pnd->connstring, res, iBackoff);
+
+  pfd->bInitialized = false;
+  pfd->next_deadline = nfc_deadline_from_timeout(iBackoff);
+
+  // A device holds a single pending event: if a removal is already waiting, the error is only accounted
+  if (pfd->bPending)
+    return;
+  memset(&nfe, 0, sizeof(nfe));
+  nfe.nfet = NFE_ERROR;
+  nfe.szDevice = szDevice;
+  nfe.iError = res;
+  nfc_fleet_publish(pnf, pfd, &nfe);
+}
+
+static void
+nfc_fleet_device_step(struct nfc_fleet *pnf, const size_t szDevice)
+{
+  struct nfc_fleet_device *pfd = &(pnf->devices[szDevice]);
+  nfc_fleet_event nfe;
+  int res;
+
+  memset(&nfe, 0, sizeof(nfe));
+  nfe.szDevice = szDevice;
+
+  if (!pfd->bInitialized) {
+    if ((res = nfc_initiator_init(pfd->pnd)) < 0) {
+      nfc_fleet_device_error(pnf, pfd, szDevice, res);
+      return;
+    }
+    pfd->bInitialized = true;
+  }
+
+  if (!pfd->bPresent) {
+    FLEET_INC(&pfd->stats.uiPolls);
+    res = nfc_initiator_poll_target(pfd->pnd, pnf->pnmModulations, pnf->szModulations, 1, 1, &(pfd->nt));
+    if (res < 0) {
+      nfc_fleet_device_error(pnf, pfd, szDevice, res);
+      return;
+    }
+    __atomic_store_n(&pfd->stats.uiConsecutiveErrors, 0, __ATOMIC_RELAXED);
+    if (res == 0)
+      return;
+    pfd->bPresent = true;
+    pfd->next_deadline = nfc_deadline_from_timeout(FLEET_PRESENCE_CADENCE);
+    FLEET_INC(&pfd->stats.uiArrivals);
+    nfe.nfet = NFE_TARGET_ARRIVED;
+    nfe.nt = pfd->nt;
+    nfc_fleet_publish(pnf, pfd, &nfe);
+    return;
+  }
+
+  res = nfc_initiator_target_is_present(pfd->pnd, &(pfd->nt));
+  if (res == 0) {
+    __atomic_store_n(&pfd->stats.uiConsecutiveErrors, 0, __ATOMIC_RELAXED);
+    pfd->next_deadline = nfc_deadline_from_timeout(FLEET_PRESENCE_CADENCE);
+    return;
+  }
+  // Whatever the reason, the target is lost
+  pfd->bPresent = false;
+  FLEET_INC(&pfd->stats.uiRemovals);
+  nfe.nfet = NFE_TARGET_REMOVED;
+  nfe.nt = pfd->nt;
+  nfc_fleet_publish(pnf, pfd, &nfe);
+  if ((res != NFC_ETGRELEASED) && (res != NFC_ERFTRANS) && (res != NFC_ETIMEOUT))
+    nfc_fleet_device_error(pnf, pfd, szDevice, res);
+}
+
+static void *
+nfc_fleet_worker_run(void *arg)
+{
+  struct nfc_fleet_worker *pnw = arg;
+  struct nfc_fleet *pnf = pnw->pnf;
+
+  while (!FLEET_LOAD(&pnf->iStop)) {
+    bool bWorked = false;
+    for (size_t n = pnw->szWorker; (n < pnf->szDevices) && !FLEET_LOAD(&pnf->iStop); n += pnf->szWorkers) {
+      struct nfc_fleet_device *pfd = &(pnf->devices[n]);
+      if (pfd->bPending) {
+        if (!nfc_fleet_enqueue(pnf, &(pfd->nfePending)))
+          continue;
+        pfd->bPending = false;
+      }
+      if (nfc_deadline_remaining(pfd->next_deadline) > 0)
+        continue;
+      pfd->next_deadline = 0;
+      nfc_fleet_device_step(pnf, n);
+      bWorked = true;
+    }
+    if (!bWorked)
+      msleep(FLEET_IDLE_SLEEP);
+  }
+  return NULL;
+}
+
+static void
+nfc_fleet_stop(nfc_fleet *pnf)
+{
+  if (!pnf->bRunning)
+    return;
+  FLEET_STORE(&pnf->iStop, 1);
+  for (size_t n = 0; n < pnf->szWorkers; n++) {
+    if (pnf->workers[n].bStarted)
+      pthread_join(pnf->workers[n].thread, NULL);
+    pnf->workers[n].bStarted = false;
+  }
+  pnf->bRunning = false;
+}
+
+/** @ingroup dev
+ * @brief Create a fleet of devices driven by worker threads
+ * @return Returns a new \a nfc_fleet, or \e NULL on failure
+ *
+ * @param pnmModulations modulations polled by each device of the fleet
+ * @param szModulations number of items in \a pnmModulations
+ * @param szMaxDevices maximum number of devices added with nfc_fleet_add_device()
+ * @param szWorkers number of worker threads sharing the devices
+ * @param szQueue capacity of the event queue, rounded up to a power of two
+ *
+ * Devices are spread over the workers (device \e n is driven by worker \e n
+ * modulo \a szWorkers), so a slow device only delays the devices sharing its
+ * worker. Events are retrieved with nfc_fleet_dequeue_events().
+ *
+ * @warning Fleets are only available where POSIX threads are.
+ */
+nfc_fleet *
+nfc_fleet_new(const nfc_modulation *pnmModulations, const size_t szModulations, const size_t szMaxDevices, const size_t szWorkers, const size_t szQueue)
+{
+  nfc_fleet *pnf;
+  size_t szCells = 2;
+
+  if ((pnmModulations == NULL) || (szModulations == 0) || (szMaxDevices == 0) || (szWorkers == 0) || (szQueue == 0))
+    return NULL;
+
+  while (szCells < szQueue)
+    szCells <<= 1;
+
+  if ((pnf = calloc(1, sizeof(*pnf))) == NULL)
+    return NULL;
+  pnf->pnmModulations = malloc(szModulations * sizeof(nfc_modulation));
+  pnf->devices = calloc(szMaxDevices, sizeof(struct nfc_fleet_device));
+  pnf->workers = calloc(szWorkers, sizeof(struct nfc_fleet_worker));
+  pnf->cells = calloc(szCells, sizeof(struct nfc_fleet_cell));
+  if (!pnf->pnmModulations || !pnf->devices || !pnf->workers || !pnf->cells) {
+    free(pnf->pnmModulations);
+    free(pnf->devices);
+    free(pnf->workers);
+    free(pnf->cells);
+    free(pnf);
+    return NULL;
+  }
+  memcpy(pnf->pnmModulations, pnmModulations, szModulations * sizeof(nfc_modulation));
+  pnf->szModulations = szModulations;
+  pnf->szMaxDevices = szMaxDevices;
+  pnf->szWorkers = szWorkers;
+  for (size_t n = 0; n < szWorkers; n++) {
+    pnf->workers[n].pnf = pnf;
+    pnf->workers[n].szWorker = n;
+    pnf->workers[n].iCpu = -1;
+  }
+  pnf->szMask = szCells - 1;
+  for (size_t n = 0; n < szCells; n++)
+    pnf->cells[n].szSequence = n;
+  pthread_mutex_init(&pnf->mutex, NULL);
+  // Waits are bounded on the monotonic clock, as every other libnfc deadline
+  pthread_condattr_t ca;
+  pthread_condattr_init(&ca);
+  pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+  pthread_cond_init(&pnf->cond, &ca);
+  pthread_condattr_destroy(&ca);
+  return pnf;
+}
+
+/** @ingroup dev
+ * @brief Stop the workers of a fleet and free it
+ *
+ * @param pnf \a nfc_fleet struct pointer
+ *
+ * @note Devices of the fleet are not closed: they still belong to the caller.
+ */
+void
+nfc_fleet_free(nfc_fleet *pnf)
+{
+  if (pnf == NULL)
+    return;
+  nfc_fleet_stop(pnf);
+  pthread_cond_destroy(&pnf->cond);
+  pthread_mutex_destroy(&pnf->mutex);
+  free(pnf->pnmModulations);
+  free(pnf->devices);
+  free(pnf->workers);
+  free(pnf->cells);
+  free(pnf);
+}
+
+/** @ingroup dev
+ * @brief Add an opened device to a fleet
+ * @return Returns the index of the device in the fleet, otherwise returns libnfc's error code (negative value)
+ *
+ * @param pnf \a nfc_fleet struct pointer
+ * @param pnd \a nfc_device struct pointer of an opened device
+ *
+ * Devices can only be added before nfc_fleet_start(). Once the fleet runs,
+ * the device must not be used by the caller until nfc_fleet_free().
+ */
+int
+nfc_fleet_add_device(nfc_fleet *pnf, nfc_device *pnd)
+{
+  if ((pnd == NULL) || pnf->bRunning || (pnf->szDevices == pnf->szMaxDevices))
+    return NFC_EINVARG;
+  pnf->devices[pnf->szDevices].pnd = pnd;
+  return (int)pnf->szDevices++;
+}
+
+/** @ingroup dev
+ * @brief Pin a worker thread of a fleet on a CPU
+ * @return Returns 0 on success, otherwise returns libnfc's error code (negative value)
+ *
+ * @param pnf \a nfc_fleet struct pointer
+ * @param szWorker index of the worker, from 0 to the number of workers minus one
+ * @param iCpu CPU the worker runs on, -1 to let the scheduler decide (default)
+ *
+ * Affinity is applied by nfc_fleet_start(), so this has to be called before.
+ */
+int
+nfc_fleet_set_worker_affinity(nfc_fleet *pnf, const size_t szWorker, const int iCpu)
+{
+  if ((szWorker >= pnf->szWorkers) || (iCpu < -1) || pnf->bRunning)
+    return NFC_EINVARG;
+#ifndef __linux__
+  if (iCpu != -1)
+    return NFC_ENOTIMPL;
+#endif
+  pnf->workers[szWorker].iCpu = iCpu;
+  return NFC_SUCCESS;
+}
+
+/** @ingroup dev
+ * @brief Start the worker threads of a fleet
+ * @return Returns 0 on success, otherwise returns libnfc's error code (negative value)
+ *
+ * @param pnf \a nfc_fleet struct pointer
+ */
+int
+nfc_fleet_start(nfc_fleet *pnf)
+{
+  if (pnf->bRunning)
+    return NFC_EINVARG;
+
+  FLEET_STORE(&pnf->iStop, 0);
+  pnf->bRunning = true;
+  for (size_t n = 0; n < pnf->szWorkers; n++) {
+    struct nfc_fleet_worker *pnw = &(pnf->workers[n]);
+    if (pthread_create(&pnw->thread, NULL, nfc_fleet_worker_run, pnw) != 0) {
+      log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "Unable to start fleet worker %u", (unsigned int)n);
+      nfc_fleet_stop(pnf);
+      return NFC_ESOFT;
+    }
+    pnw->bStarted = true;
+#ifdef __linux__
+    if (pnw->iCpu >= 0) {
+      cpu_set_t cpuset;
+      CPU_ZERO(&cpuset);
+      CPU_SET(pnw->iCpu, &cpuset);
+      if (pthread_setaffinity_np(pnw->thread, sizeof(cpuset), &cpuset) != 0)
+        log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "Unable to pin fleet worker %u on CPU %d", (unsigned int)n, pnw->iCpu);
+    }
+#endif
+  }
+  return NFC_SUCCESS;
+}
+
+/** @ingroup dev
+ * @brief Retrieve events published by the workers of a fleet
+ * @return Returns the number of events stored in \a anfe[], otherwise returns libnfc's error code (negative value)
+ *
+ * @param pnf \a nfc_fleet struct pointer
+ * @param anfe array of \a nfc_fleet_event where events are stored
+ * @param szEvents number of items in \a anfe
+ * @param timeout in milliseconds to wait for a first event, 0 to return immediately, -1 to wait forever
+ *
+ * All available events, up to \a szEvents, are retrieved at once. Only one
+ * thread may call this function at a time for a given fleet.
+ *
+ * When the queue is full, a worker keeps its event and leaves its device
+ * alone until the event fits: nothing is lost, but a device whose events are
+ * not consumed is not polled anymore (see \a uiStalls in nfc_fleet_device_stats).
+ */
+int
+nfc_fleet_dequeue_events(nfc_fleet *pnf, nfc_fleet_event anfe[], const size_t szEvents, const int timeout)
+{
+  size_t szCount;
+  struct timespec ts;
+
+  if ((szEvents == 0) || (timeout < -1))
+    return NFC_EINVARG;
+
+  if ((szCount = nfc_fleet_dequeue(pnf, anfe, szEvents)) > 0 || (timeout == 0))
+    return (int)MIN(szCount, INT32_MAX);
+
+  if (timeout > 0) {
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += timeout / 1000;
+    ts.tv_nsec += (long)(timeout % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+      ts.tv_sec++;
+      ts.tv_nsec -= 1000000000;
+    }
+  }
+
+  pthread_mutex_lock(&pnf->mutex);
+  __atomic_store_n(&pnf->iWaiting, 1, __ATOMIC_RELAXED);
+  // Pairs with the fence in nfc_fleet_enqueue(): either the worker sees iWaiting, or we see its event
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  while ((szCount = nfc_fleet_dequeue(pnf, anfe, szEvents)) == 0) {
+    if (timeout < 0) {
+      pthread_cond_wait(&pnf->cond, &pnf->mutex);
+    } else if (pthread_cond_timedwait(&pnf->cond, &pnf->mutex, &ts) == ETIMEDOUT) {
+      szCount = nfc_fleet_dequeue(pnf, anfe, szEvents);
+      break;
+    }
+  }
+  __atomic_store_n(&pnf->iWaiting, 0, __ATOMIC_RELAXED);
+  pthread_mutex_unlock(&pnf->mutex);
+  return (int)MIN(szCount, INT32_MAX);
+}
+
+/** @ingroup dev
+ * @brief Get health statistics of a device of a fleet
+ * @return Returns 0 on success, otherwise returns libnfc's error code (negative value)
+ *
+ * @param pnf \a nfc_fleet struct pointer
+ * @param szDevice index of the device, as returned by nfc_fleet_add_device()
+ * @param pstats \a nfc_fleet_device_stats struct pointer where statistics are stored
+ *
+ * Counters are updated by the workers while they are read, so the returned
+ * values are not a consistent snapshot of the device.
+ */
+int
+nfc_fleet_get_device_stats(nfc_fleet *pnf, const size_t szDevice, nfc_fleet_device_stats *pstats)
+{
+  const nfc_fleet_device_stats *ps;
+
+  if (szDevice >= pnf->szDevices)
+    return NFC_EINVARG;
+  ps = &(pnf->devices[szDevice].stats);
+  pstats->uiPolls = __atomic_load_n(&ps->uiPolls, __ATOMIC_RELAXED);
+  pstats->uiArrivals = __atomic_load_n(&ps->uiArrivals, __ATOMIC_RELAXED);
+  pstats->uiRemovals = __atomic_load_n(&ps->uiRemovals, __ATOMIC_RELAXED);
+  pstats->uiErrors = __atomic_load_n(&ps->uiErrors, __ATOMIC_RELAXED);
+  pstats->uiConsecutiveErrors = __atomic_load_n(&ps->uiConsecutiveErrors, __ATOMIC_RELAXED);
+  pstats->uiStalls = __atomic_load_n(&ps->uiStalls, __ATOMIC_RELAXED);
+  pstats->iLastError = __atomic_load_n(&ps->iLastError, __ATOMIC_RELAXED);
+  return NFC_SUCCESS;
+}
+
+#else // _WIN32
+
+nfc_fleet *
+nfc_fleet_new(const nfc_modulation *pnmModulations, const size_t szModulations, const size_t szMaxDevices, const size_t szWorkers, const size_t szQueue)
+{
+  (void)pnmModulations;
+  (void)szModulations;
+  (void)szMaxDevices;
+  (void)szWorkers;
+  (void)szQueue;
+  log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Fleets are not available on this platform");
+  return NULL;
+}
+
+void
+nfc_fleet_free(nfc_fleet *pnf)
+{
+  (void)pnf;
+}
+
+int
+nfc_fleet_add_device(nfc_fleet *pnf, nfc_device *pnd)
+{
+  (void)pnf;
+  (void)pnd;
+  return NFC_ENOTIMPL;
+}
+
+int
+nfc_fleet_set_worker_affinity(nfc_fleet *pnf, const size_t szWorker, const int iCpu)
+{
+  (void)pnf;
+  (void)szWorker;
+  (void)iCpu;
+  return NFC_ENOTIMPL;
+}
+
+int
+nfc_fleet_start(nfc_fleet *pnf)
+{
+  (void)pnf;
+  return NFC_ENOTIMPL;
+}
+
+int
+nfc_fleet_dequeue_events(nfc_fleet *pnf, nfc_fleet_event anfe[], const size_t szEvents, const int timeout)
+{
+  (void)pnf;
+  (void)anfe;
+  (void)szEvents;
+  (void)timeout;
+  return NFC_ENOTIMPL;
+}
+
+int
+nfc_fleet_get_device_stats(nfc_fleet *pnf, const size_t szDevice, nfc_fleet_device_stats *pstats)
+{
+  (void)pnf;
+  (void)szDevice;
+  (void)pstats;
+  return NFC_ENOTIMPL;
+}
+
+#endif // _WIN32
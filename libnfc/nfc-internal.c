@@ -30,13 +30,13 @@
 * @brief Provide some useful internal functions
 */
 
-#include <nfc/nfc.h>
-#include "nfc-internal.h"
-
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 
+#include <nfc/nfc.h>
+#include "nfc-internal.h"
+
 #ifdef CONFFILES
 #include "conf.h"
 #endif
@@ -44,6 +44,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
+#ifndef _WIN32
+#  include <time.h>
+#else
+#  include <windows.h>
+#endif
 
 #define LOG_GROUP    NFC_LOG_GROUP_GENERAL
 #define LOG_CATEGORY "libnfc.general"
@@ -96,6 +101,14 @@ nfc_context_new(void)
   }
   res->user_defined_device_count = 0;
 
+  // Device description cache is disabled until a directory is given
+  strcpy(res->device_cache_dir, "");
+
+  // Closed devices are really closed until a pool is configured
+  res->pool.szMaxDevices = 0;
+  res->pool.idle_timeout = 0;
+  res->pool.szDevices = 0;
+
 #ifdef ENVVARS
   // Load user defined device from environment variable at first
   char *envvar = getenv("LIBNFC_DEFAULT_DEVICE");
@@ -138,6 +151,13 @@ nfc_context_new(void)
   if (envvar) {
     res->log_level = atoi(envvar);
   }
+
+  // Device description cache directory
+  envvar = getenv("LIBNFC_DEVICE_CACHE_DIR");
+  if (envvar) {
+    strncpy(res->device_cache_dir, envvar, DEVICE_CACHE_DIR_LENGTH - 1);
+    res->device_cache_dir[DEVICE_CACHE_DIR_LENGTH - 1] = '\0';
+  }
 #endif // ENVVARS
 
   // Initialize log before use it...
@@ -151,6 +171,7 @@ nfc_context_new(void)
 #endif
   log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "allow_autoscan is set to %s", (res->allow_autoscan) ? "true" : "false");
   log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "allow_intrusive_scan is set to %s", (res->allow_intrusive_scan) ? "true" : "false");
+  log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "device_cache_dir is set to \"%s\"", res->device_cache_dir);
 
   log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "%d device(s) defined by user", res->user_defined_device_count);
   for (uint32_t i = 0; i < res->user_defined_device_count; i++) {
@@ -260,3 +281,150 @@ connstring_decode(const nfc_connstring connstring, const char *driver_name, cons
   return res;
 }
 
+
+/**
+ * @brief Monotonic clock in µs, to measure durations
+ */
+int64_t
+nfc_monotonic_us(void)
+{
+#ifndef _WIN32
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+  LARGE_INTEGER liFrequency, liCounter;
+  QueryPerformanceFrequency(&liFrequency);
+  QueryPerformanceCounter(&liCounter);
+  return (int64_t)((liCounter.QuadPart / liFrequency.QuadPart) * 1000000 + ((liCounter.QuadPart % liFrequency.QuadPart) * 1000000) / liFrequency.QuadPart);
+#endif
+}
+
+static int64_t
+nfc_monotonic_ms(void)
+{
+#ifndef _WIN32
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#else
+  return (int64_t)GetTickCount();
+#endif
+}
+
+/**
+ * @brief Turn a relative timeout into an absolute deadline
+ * @return deadline, or 0 (no deadline) if \a timeout is 0 or negative
+ *
+ * @param timeout timeout in ms, 0 meaning no timeout
+ */
+nfc_deadline
+nfc_deadline_from_timeout(const int timeout)
+{
+  if (timeout <= 0)
+    return 0;
+  return nfc_monotonic_ms() + timeout;
+}
+
+/**
+ * @brief Time left before \a deadline
+ * @return 0 if there is no deadline, the number of ms left (at least 1) if
+ * the deadline is still ahead, NFC_ETIMEOUT if it has passed
+ *
+ * The result can be handed as is to a bus receive function as its timeout:
+ * buses treat a negative timeout as an already expired one.
+ */
+int
+nfc_deadline_remaining(const nfc_deadline deadline)
+{
+  int64_t left;
+
+  if (deadline == 0)
+    return 0;
+  left = deadline - nfc_monotonic_ms();
+  if (left <= 0)
+    return NFC_ETIMEOUT;
+  return (int)MIN(left, INT32_MAX);
+}
+
+/**
+ * @brief Set up a recursive mutex
+ */
+void
+nfc_mutex_init(nfc_mutex *pm)
+{
+#ifdef _WIN32
+  // Critical sections are recursive
+  InitializeCriticalSection(&pm->cs);
+  pm->lState = 2;
+#else
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(pm, &attr);
+  pthread_mutexattr_destroy(&attr);
+#endif
+}
+
+void
+nfc_mutex_destroy(nfc_mutex *pm)
+{
+#ifdef _WIN32
+  if (pm->lState == 2)
+    DeleteCriticalSection(&pm->cs);
+  pm->lState = 0;
+#else
+  pthread_mutex_destroy(pm);
+#endif
+}
+
+#ifdef _WIN32
+static void
+nfc_mutex_setup(nfc_mutex *pm)
+{
+  // Critical sections have no static initializer: the first locker sets it up
+  if (InterlockedCompareExchange(&pm->lState, 1, 0) == 0) {
+    InitializeCriticalSection(&pm->cs);
+    InterlockedExchange(&pm->lState, 2);
+  } else {
+    while (InterlockedCompareExchange(&pm->lState, 2, 2) != 2)
+      Sleep(0);
+  }
+}
+#endif
+
+void
+nfc_mutex_lock(nfc_mutex *pm)
+{
+#ifdef _WIN32
+  nfc_mutex_setup(pm);
+  EnterCriticalSection(&pm->cs);
+#else
+  pthread_mutex_lock(pm);
+#endif
+}
+
+/**
+ * @brief Lock a mutex unless another thread holds it
+ * @return Returns true when the mutex is now locked by the caller
+ */
+bool
+nfc_mutex_trylock(nfc_mutex *pm)
+{
+#ifdef _WIN32
+  nfc_mutex_setup(pm);
+  return TryEnterCriticalSection(&pm->cs) != 0;
+#else
+  return pthread_mutex_trylock(pm) == 0;
+#endif
+}
+
+void
+nfc_mutex_unlock(nfc_mutex *pm)
+{
+#ifdef _WIN32
+  LeaveCriticalSection(&pm->cs);
+#else
+  pthread_mutex_unlock(pm);
+#endif
+}
@@ -37,6 +37,11 @@
 #if !defined(_MSC_VER)
 #  include <sys/time.h>
 #endif
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <pthread.h>
+#endif
 
 #include "nfc/nfc.h"
 
@@ -44,9 +49,28 @@
 
 /**
  * @macro HAL
- * @brief Execute corresponding driver function if exists.
+ * @brief Execute corresponding driver function if exists, holding the device lock.
+ */
+#define HAL( FUNCTION, ... ) do { \
+    int hal_res; \
+    nfc_device_lock(pnd); \
+    pnd->last_error = 0; \
+    if (pnd->driver->FUNCTION) { \
+      hal_res = pnd->driver->FUNCTION( __VA_ARGS__ ); \
+    } else { \
+      pnd->last_error = NFC_EDEVNOTSUPP; \
+      hal_res = false; \
+    } \
+    nfc_device_unlock(pnd); \
+    return hal_res; \
+  } while (0)
+
+/**
+ * @macro HAL_UNLOCKED
+ * @brief Execute corresponding driver function if exists, without the device lock.
+ * Only meant for functions which have to run while another thread holds the lock.
  */
-#define HAL( FUNCTION, ... ) pnd->last_error = 0; \
+#define HAL_UNLOCKED( FUNCTION, ... ) pnd->last_error = 0; \
   if (pnd->driver->FUNCTION) { \
     return pnd->driver->FUNCTION( __VA_ARGS__ ); \
   } else { \
@@ -133,17 +157,24 @@ struct nfc_driver {
   int (*initiator_init_collision)(struct nfc_device *pnd);
   int (*initiator_init_secure_element)(struct nfc_device *pnd);
   int (*initiator_select_passive_target)(struct nfc_device *pnd,  const nfc_modulation nm, const uint8_t *pbtInitData, const size_t szInitData, nfc_target *pnt);
+  int (*initiator_select_passive_targets)(struct nfc_device *pnd,  const nfc_modulation nm, const uint8_t *pbtInitData, const size_t szInitData, nfc_target ant[], const size_t szTargets);
   int (*initiator_poll_target)(struct nfc_device *pnd, const nfc_modulation *pnmModulations, const size_t szModulations, const uint8_t uiPollNr, const uint8_t btPeriod, nfc_target *pnt);
   int (*initiator_select_dep_target)(struct nfc_device *pnd, const nfc_dep_mode ndm, const nfc_baud_rate nbr, const nfc_dep_info *pndiInitiator, nfc_target *pnt, const int timeout);
+  int (*initiator_dep_psl)(struct nfc_device *pnd, const nfc_baud_rate nbr);
   int (*initiator_deselect_target)(struct nfc_device *pnd);
   int (*initiator_transceive_bytes)(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, uint8_t *pbtRx, const size_t szRx, int timeout);
+  int (*initiator_transceive_bytes_target)(struct nfc_device *pnd, const size_t szTarget, const uint8_t *pbtTx, const size_t szTx, uint8_t *pbtRx, const size_t szRx, int timeout);
   int (*initiator_transceive_bits)(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTxBits, const uint8_t *pbtTxPar, uint8_t *pbtRx, uint8_t *pbtRxPar);
   int (*initiator_transceive_bytes_timed)(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, uint8_t *pbtRx, const size_t szRx, uint32_t *cycles);
   int (*initiator_transceive_bits_timed)(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTxBits, const uint8_t *pbtTxPar, uint8_t *pbtRx, uint8_t *pbtRxPar, uint32_t *cycles);
+  int (*initiator_last_collision)(struct nfc_device *pnd, uint8_t *pbtRx, uint8_t *pbtRxPar);
   int (*initiator_target_is_present)(struct nfc_device *pnd, const nfc_target *pnt);
+  int (*initiator_target_upgrade_bit_rate)(struct nfc_device *pnd, nfc_target *pnt);
+  int (*initiator_target_reactivate)(struct nfc_device *pnd, nfc_target *pnt);
 
   int (*target_init)(struct nfc_device *pnd, nfc_target *pnt, uint8_t *pbtRx, const size_t szRx, int timeout);
   int (*target_send_bytes)(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, int timeout);
+  int (*target_send_bytes_chained)(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, int timeout);
   int (*target_receive_bytes)(struct nfc_device *pnd, uint8_t *pbtRx, const size_t szRxLen, int timeout);
   int (*target_send_bits)(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTxBits, const uint8_t *pbtTxPar);
   int (*target_receive_bits)(struct nfc_device *pnd, uint8_t *pbtRx, const size_t szRxLen, uint8_t *pbtRxPar);
@@ -157,10 +188,76 @@ struct nfc_driver {
   int (*abort_command)(struct nfc_device *pnd);
   int (*idle)(struct nfc_device *pnd);
   int (*powerdown)(struct nfc_device *pnd);
+  int (*reset)(struct nfc_device *pnd);
+
+  // Split-phase commands, driven from an event loop (see nfc-async.c)
+  int (*initiator_transceive_bytes_submit)(struct nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, uint8_t *pbtRx, const size_t szRx, int timeout);
+  int (*initiator_select_passive_target_submit)(struct nfc_device *pnd, const nfc_modulation nm, const uint8_t *pbtInitData, const size_t szInitData, nfc_target *pnt);
+  int (*initiator_poll_target_submit)(struct nfc_device *pnd, const nfc_modulation *pnmModulations, const size_t szModulations, const uint8_t uiPollNr, const uint8_t btPeriod, nfc_target *pnt);
+  int (*initiator_target_probe_submit)(struct nfc_device *pnd, const nfc_target *pnt);
+  int (*command_resume)(struct nfc_device *pnd, bool *pbDone);
+  int (*command_cancel)(struct nfc_device *pnd);
+  int (*get_event_fd)(struct nfc_device *pnd);
+  int (*get_event_timeout)(struct nfc_device *pnd);
 };
 
 #  define DEVICE_NAME_LENGTH  256
+#  define DEVICE_SERIAL_LENGTH  64
 #  define DEVICE_PORT_LENGTH  64
+#  define DEVICE_CACHE_DIR_LENGTH  256
+
+/**
+ * @typedef nfc_deadline
+ * @brief Absolute point in time on a monotonic clock (in ms), 0 meaning "no deadline"
+ *
+ * An I/O operation turns its timeout into a deadline once, then only hands
+ * the time left (see nfc_deadline_remaining()) to every layer it calls, so
+ * a frame read in several chunks never lasts longer than requested.
+ */
+typedef int64_t nfc_deadline;
+
+nfc_deadline nfc_deadline_from_timeout(const int timeout);
+int nfc_deadline_remaining(const nfc_deadline deadline);
+int64_t nfc_monotonic_us(void);
+
+/**
+ * @typedef nfc_mutex
+ * @brief Mutex usable as a file-scope variable thanks to NFC_MUTEX_INITIALIZER
+ *
+ * Mutexes set up by nfc_mutex_init() are recursive, statically initialized
+ * ones may not be.
+ */
+#ifdef _WIN32
+typedef struct {
+  volatile LONG lState;
+  CRITICAL_SECTION cs;
+} nfc_mutex;
+#  define NFC_MUTEX_INITIALIZER { 0 }
+#else
+typedef pthread_mutex_t nfc_mutex;
+#  define NFC_MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+#endif
+
+void nfc_mutex_init(nfc_mutex *pm);
+void nfc_mutex_destroy(nfc_mutex *pm);
+void nfc_mutex_lock(nfc_mutex *pm);
+bool nfc_mutex_trylock(nfc_mutex *pm);
+void nfc_mutex_unlock(nfc_mutex *pm);
+
+/*
+ * Atomic operations on int, for counters and settings shared between threads.
+ */
+#if defined(_MSC_VER)
+#  define NFC_ATOMIC_LOAD(p)     InterlockedCompareExchange((volatile LONG *)(p), 0, 0)
+#  define NFC_ATOMIC_STORE(p, v) InterlockedExchange((volatile LONG *)(p), (v))
+#  define NFC_ATOMIC_INC(p)      InterlockedIncrement((volatile LONG *)(p))
+#  define NFC_ATOMIC_DEC(p)      InterlockedDecrement((volatile LONG *)(p))
+#else
+#  define NFC_ATOMIC_LOAD(p)     __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#  define NFC_ATOMIC_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+#  define NFC_ATOMIC_INC(p)      __atomic_add_fetch((p), 1, __ATOMIC_SEQ_CST)
+#  define NFC_ATOMIC_DEC(p)      __atomic_sub_fetch((p), 1, __ATOMIC_SEQ_CST)
+#endif
 
 #define MAX_USER_DEFINED_DEVICES 4
 
@@ -170,6 +267,25 @@ struct nfc_user_defined_device {
   bool optional;
 };
 
+#define MAX_POOLED_DEVICES 8
+
+struct nfc_device_pool_entry {
+  struct nfc_device *pnd;
+  nfc_deadline idle_deadline;
+  bool bPoweredDown;
+};
+
+/**
+ * @struct nfc_device_pool
+ * @brief Closed devices kept open and initialized for their next nfc_open()
+ */
+struct nfc_device_pool {
+  size_t szMaxDevices;
+  int idle_timeout;
+  size_t szDevices;
+  struct nfc_device_pool_entry entries[MAX_POOLED_DEVICES];
+};
+
 /**
  * @struct nfc_context
  * @brief NFC library context
@@ -181,6 +297,8 @@ struct nfc_context {
   uint32_t  log_level;
   struct nfc_user_defined_device user_defined_devices[MAX_USER_DEFINED_DEVICES];
   unsigned int user_defined_device_count;
+  char device_cache_dir[DEVICE_CACHE_DIR_LENGTH];
+  struct nfc_device_pool pool;
 };
 
 nfc_context *nfc_context_new(void);
@@ -190,6 +308,20 @@ void nfc_context_free(nfc_context *context);
  * @struct nfc_device
  * @brief NFC device information
  */
+/**
+ * @struct nfc_dep_session
+ * @brief D.E.P. link established with a target, see nfc-dep-session.c
+ */
+#define NFC_DEP_SESSION_CACHE_LEN 8
+struct nfc_dep_session {
+  /** ATR_RES parameters received, with the mode used */
+  nfc_dep_info ndi;
+  /** Baud rate used */
+  nfc_baud_rate nbr;
+  /** Monotonic time of the last selection in microseconds, 0 if unused */
+  int64_t i64LastSeen;
+};
+
 struct nfc_device {
   const nfc_context *context;
   const struct nfc_driver *driver;
@@ -200,6 +332,8 @@ struct nfc_device {
   char    name[DEVICE_NAME_LENGTH];
   /** Device connection string */
   nfc_connstring connstring;
+  /** Serial number of the device (e.g. USB iSerialNumber), empty if unknown */
+  char    serial[DEVICE_SERIAL_LENGTH];
   /** Is the CRC automaticly added, checked and removed from the frames */
   bool    bCrc;
   /** Does the chip handle parity bits, all parities are handled as data */
@@ -211,12 +345,38 @@ struct nfc_device {
   /** Should the chip switch automatically activate ISO14443-4 when
       selecting tags supporting it? */
   bool    bAutoIso14443_4;
+  /** Should the chip negotiate the highest bit rate once an ISO14443-4
+      target is selected? */
+  bool    bAutoPps;
+  /** Is the chip forced in ISO14443-A framing (NP_FORCE_ISO14443_A) */
+  bool    bForceIso14443a;
+  /** Is the chip forced in ISO14443-B framing (NP_FORCE_ISO14443_B) */
+  bool    bForceIso14443b;
+  /** Is the chip forced at 106 kbps (NP_FORCE_SPEED_106) */
+  bool    bForceSpeed106;
+  /** Communication timeout (NP_TIMEOUT_COM) in ms, -1 when the driver does not track it */
+  int     iTimeoutCom;
   /** Supported modulation encoded in a byte */
   uint8_t  btSupportByte;
   /** Last reported error */
   int     last_error;
+  /** Pool the device goes back to when closed, if any */
+  struct nfc_device_pool *pool;
+  /** Serializes operations on the device, see nfc_device_lock() */
+  nfc_mutex mutex;
+  /** D.E.P. links recently established */
+  struct nfc_dep_session andsSessions[NFC_DEP_SESSION_CACHE_LEN];
+  /** Queue of the submitted commands, see nfc-async.c */
+  struct nfc_async *async;
 };
 
+/**
+ * @macro nfc_device_lock
+ * @brief Take the (recursive) lock of a device for a sequence of driver calls
+ */
+#define nfc_device_lock(pnd)   nfc_mutex_lock(&((pnd)->mutex))
+#define nfc_device_unlock(pnd) nfc_mutex_unlock(&((pnd)->mutex))
+
 nfc_device *nfc_device_new(const nfc_context *context, const nfc_connstring connstring);
 void        nfc_device_free(nfc_device *dev);
 
@@ -225,7 +385,24 @@ void string_as_boolean(const char *s, bool *value);
 void iso14443_cascade_uid(const uint8_t abtUID[], const size_t szUID, uint8_t *pbtCascadedUID, size_t *pszCascadedUID);
 
 void prepare_initiator_data(const nfc_modulation nm, uint8_t **ppbtInitiatorData, size_t *pszInitiatorData);
+int  nfc_initiator_init_data(nfc_device *pnd, const nfc_modulation nm, const uint8_t *pbtInitData, const size_t szInitData,
+                             uint8_t *pbtInit, size_t *pszInit);
 
 int connstring_decode(const nfc_connstring connstring, const char *driver_name, const char *bus_name, char **pparam1, char **pparam2);
 
+int  nfc_device_cache_load(const nfc_device *pnd, void *pRecord, const size_t szRecord);
+int  nfc_device_cache_store(const nfc_device *pnd, const void *pRecord, const size_t szRecord);
+void nfc_device_cache_invalidate(const nfc_device *pnd);
+
+void nfc_dep_session_store(nfc_device *pnd, const nfc_dep_mode ndm, const nfc_target *pnt);
+int  nfc_dep_session_resume(nfc_device *pnd, const nfc_dep_mode ndm, const nfc_baud_rate nbr, const bool bAnyRate,
+                            const nfc_dep_info *pndiInitiator, nfc_target *pnt, const int timeout);
+
+bool nfc_async_cancel(nfc_device *pnd);
+void nfc_async_free(nfc_device *pnd);
+
+nfc_device *nfc_pool_take(nfc_context *context, const char *connstring);
+bool nfc_pool_put(nfc_device *pnd);
+void nfc_pool_clear(nfc_context *context);
+
 #endif // __NFC_INTERNAL_H__
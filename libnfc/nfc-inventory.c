@@ -0,0 +1,852 @@
+/*-
+ * Free/Libre Near Field Communication (NFC) library
+ *
+ * Libnfc historical contributors:
+ * Copyright (C) 2009      Roel Verdult
+ * Copyright (C) 2009-2013 Romuald Conty
+ * Copyright (C) 2010-2012 Romain Tartière
+ * Copyright (C) 2010-2013 Philippe Teuwen
+ * Copyright (C) 2012-2013 Ludovic Rousseau
+ * See AUTHORS file for a more comprehensive list of contributors.
+ * Additional contributors of this file:
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+/**
+ * @file nfc-inventory.c
+ * @brief Provide routines to enumerate every tag available in the field
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <inttypes.h>
+#include <string.h>
+
+#include <nfc/nfc.h>
+
+#include "nfc-internal.h"
+
+#define LOG_CATEGORY "libnfc.general"
+#define LOG_GROUP    NFC_LOG_GROUP_GENERAL
+
+#define ISO14443A_FRAME_MAX_LEN     264
+#define ISO14443A_CASCADE_LEVELS    3
+// UID CLn (4 bytes) followed by BCC
+#define ISO14443A_UID_CLN_BITS      40
+#define ISO14443A_SAK_CASCADE_BIT   0x04
+// Worst case: one pending branch per UID bit of each cascade level
+#define ISO14443A_INVENTORY_DEPTH   (ISO14443A_CASCADE_LEVELS * ISO14443A_UID_CLN_BITS)
+// Answer to ANTICOLLISION broken by a bit collision
+#define ISO14443A_INVENTORY_COLLISION 1
+
+static const uint8_t abtIso14443aSel[ISO14443A_CASCADE_LEVELS] = { 0x93, 0x95, 0x97 };
+
+/**
+ * @internal
+ * @struct iso14443a_inventory_node
+ * @brief Branch of the UID tree which is still to be walked
+ */
+struct iso14443a_inventory_node {
+  /** UID CLn and BCC of the cascade levels already resolved */
+  uint8_t abtUidCln[ISO14443A_CASCADE_LEVELS][5];
+  /** Cascade level being resolved (0 for CL1) */
+  size_t  szLevel;
+  /** Known leading bits of the UID CLn being resolved */
+  uint8_t abtPrefix[5];
+  size_t  szPrefixBits;
+};
+
+static uint8_t
+iso14443a_odd_parity(uint8_t bt)
+{
+  bt ^= bt >> 4;
+  bt ^= bt >> 2;
+  bt ^= bt >> 1;
+  return (~bt) & 0x01;
+}
+
+/*
+ * Parity is handled here instead of by the device: the answer to an
+ * ANTICOLLISION command starts in the middle of a byte, which the device can
+ * not know about.
+ */
+static int
+iso14443a_inventory_transceive(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTxBits, uint8_t *pbtRx, uint8_t *pbtRxPar)
+{
+  uint8_t abtTxPar[16];
+  for (size_t n = 0; n < (szTxBits + 7) / 8; n++) {
+    abtTxPar[n] = iso14443a_odd_parity(pbtTx[n]);
+  }
+  return nfc_initiator_transceive_bits(pnd, pbtTx, szTxBits, abtTxPar, pbtRx, ISO14443A_FRAME_MAX_LEN, pbtRxPar);
+}
+
+/*
+ * A bit collision is reported as any other broken frame (NFC_ERFTRANS), the
+ * device tells them apart and gives back the bits received before the first
+ * collision. Returns the count of these bits, or a negative value when the
+ * frame was not broken by a collision (or the device can not tell).
+ */
+static int
+iso14443a_inventory_collision(nfc_device *pnd, const int res, uint8_t *pbtRx, uint8_t *pbtRxPar)
+{
+  if (res != NFC_ERFTRANS)
+    return res;
+  if (pnd->driver->initiator_last_collision == NULL)
+    return NFC_EDEVNOTSUPP;
+  return pnd->driver->initiator_last_collision(pnd, pbtRx, pbtRxPar);
+}
+
+/*
+ * Received frames are unwrapped by groups of 9 bits: 8 data bits (LSB first)
+ * then parity, this returns the n-th bit as it was seen on air.
+ */
+static uint8_t
+iso14443a_inventory_raw_bit(const uint8_t *pbtRx, const uint8_t *pbtRxPar, const size_t szPos)
+{
+  if ((szPos % 9) == 8)
+    return pbtRxPar[szPos / 9] & 0x01;
+  return (pbtRx[szPos / 9] >> (szPos % 9)) & 0x01;
+}
+
+/*
+ * Append to the prefix the UID CLn bits found in the first szAirBits bits of
+ * an answer to ANTICOLLISION. The tag completes the split byte and sends its
+ * parity bit, then whole bytes with their parity.
+ */
+static void
+iso14443a_inventory_extend(struct iso14443a_inventory_node *pNode, const uint8_t *pbtRx, const uint8_t *pbtRxPar, const size_t szAirBits)
+{
+  size_t szPos = 0;
+  while ((pNode->szPrefixBits < ISO14443A_UID_CLN_BITS) && (szPos < szAirBits)) {
+    const size_t szBit = pNode->szPrefixBits++;
+    if (iso14443a_inventory_raw_bit(pbtRx, pbtRxPar, szPos++)) {
+      pNode->abtPrefix[szBit / 8] |= (1 << (szBit % 8));
+    } else {
+      pNode->abtPrefix[szBit / 8] &= ~(1 << (szBit % 8));
+    }
+    // Skip the parity bit following each complete byte
+    if ((szBit % 8) == 7)
+      szPos++;
+  }
+}
+
+/*
+ * Returns NFC_SUCCESS when the UID CLn is complete, or
+ * ISO14443A_INVENTORY_COLLISION with the prefix extended up to the first
+ * colliding bit.
+ */
+static int
+iso14443a_inventory_anticol(nfc_device *pnd, struct iso14443a_inventory_node *pNode)
+{
+  uint8_t abtTx[7];
+  uint8_t abtRx[ISO14443A_FRAME_MAX_LEN];
+  uint8_t abtRxPar[ISO14443A_FRAME_MAX_LEN];
+  const size_t szKnownBits = pNode->szPrefixBits;
+  int res;
+
+  abtTx[0] = abtIso14443aSel[pNode->szLevel];
+  // NVB: upper nibble counts the whole bytes sent, lower nibble the remaining bits
+  abtTx[1] = (uint8_t)(((2 + szKnownBits / 8) << 4) | (szKnownBits % 8));
+  memcpy(abtTx + 2, pNode->abtPrefix, (szKnownBits + 7) / 8);
+  if ((res = iso14443a_inventory_transceive(pnd, abtTx, 16 + szKnownBits, abtRx, abtRxPar)) < 0) {
+    int iIntact;
+    if ((iIntact = iso14443a_inventory_collision(pnd, res, abtRx, abtRxPar)) < 0)
+      return res;
+    // Every tag agrees on the bits before the collision: take them at once
+    iso14443a_inventory_extend(pNode, abtRx, abtRxPar, (size_t) iIntact + (size_t) iIntact / 8);
+    return ISO14443A_INVENTORY_COLLISION;
+  }
+
+  // The split byte is completed then followed by its parity bit, like whole bytes
+  const size_t szSplitBits = (8 - (szKnownBits % 8)) % 8;
+  const size_t szAirBits = szSplitBits + ((ISO14443A_UID_CLN_BITS - szKnownBits - szSplitBits) / 8) * 9 + ((szSplitBits) ? 1 : 0);
+  // Last parity bit is not needed
+  if ((size_t)res + (size_t)res / 8 + 1 < szAirBits)
+    return ISO14443A_INVENTORY_COLLISION;
+
+  iso14443a_inventory_extend(pNode, abtRx, abtRxPar, szAirBits);
+
+  // BCC is the exclusive-or of the 4 UID CLn bytes, mixed answers will hardly match it
+  if ((pNode->abtPrefix[0] ^ pNode->abtPrefix[1] ^ pNode->abtPrefix[2] ^ pNode->abtPrefix[3] ^ pNode->abtPrefix[4]) != 0) {
+    pNode->szPrefixBits = szKnownBits;
+    return ISO14443A_INVENTORY_COLLISION;
+  }
+  return NFC_SUCCESS;
+}
+
+static int
+iso14443a_inventory_select(nfc_device *pnd, const size_t szLevel, const uint8_t *pbtUidCln, uint8_t *pbtSak)
+{
+  uint8_t abtTx[9] = { abtIso14443aSel[szLevel], 0x70 };
+  uint8_t abtRx[ISO14443A_FRAME_MAX_LEN];
+  uint8_t abtRxPar[ISO14443A_FRAME_MAX_LEN];
+  uint8_t abtCrc[2];
+  int res;
+
+  memcpy(abtTx + 2, pbtUidCln, 5);
+  iso14443a_crc_append(abtTx, 7);
+  if ((res = iso14443a_inventory_transceive(pnd, abtTx, 72, abtRx, abtRxPar)) < 0)
+    return res;
+  // SAK and its CRC_A
+  if (res < 24)
+    return NFC_ERFTRANS;
+  iso14443a_crc(abtRx, 1, abtCrc);
+  if ((abtCrc[0] != abtRx[1]) || (abtCrc[1] != abtRx[2]))
+    return NFC_ERFTRANS;
+  *pbtSak = abtRx[0];
+  return NFC_SUCCESS;
+}
+
+static void
+iso14443a_inventory_halt(nfc_device *pnd)
+{
+  uint8_t abtTx[4] = { 0x50, 0x00 };
+  uint8_t abtRx[ISO14443A_FRAME_MAX_LEN];
+  uint8_t abtRxPar[ISO14443A_FRAME_MAX_LEN];
+
+  iso14443a_crc_append(abtTx, 2);
+  // A halted tag does not answer
+  iso14443a_inventory_transceive(pnd, abtTx, 32, abtRx, abtRxPar);
+}
+
+/*
+ * Walk one branch of the UID tree down to a tag, pushing the branches left
+ * aside on the way. Returns 1 when a tag has been found (and halted), 0 when
+ * the branch is empty.
+ */
+static int
+iso14443a_inventory_walk(nfc_device *pnd, struct iso14443a_inventory_node *pNode,
+                         struct iso14443a_inventory_node anNodes[], size_t *pszNodes, nfc_target *pnt)
+{
+  const uint8_t abtReqa[1] = { 0x26 };
+  uint8_t abtRx[ISO14443A_FRAME_MAX_LEN];
+  uint8_t abtRxPar[ISO14443A_FRAME_MAX_LEN];
+  uint8_t abtAtqa[2] = { 0x00, 0x00 };
+  uint8_t btSak = 0x00;
+  int res;
+
+  // Wake up the tags which are not halted yet
+  if ((res = iso14443a_inventory_transceive(pnd, abtReqa, 7, abtRx, abtRxPar)) < 0) {
+    // Tags with different ATQA collide, which still tells they are there
+    if (iso14443a_inventory_collision(pnd, res, abtRx, abtRxPar) < 0) {
+      if (res != NFC_ERFTRANS)
+        return res;
+      // Nobody answers anymore: every tag has been halted
+      *pszNodes = 0;
+      return 0;
+    }
+  } else if (res == 16) {
+    // ATQA can only be trusted when a single tag did answer
+    abtAtqa[0] = abtRx[1];
+    abtAtqa[1] = abtRx[0];
+  }
+
+  // Bring the tags of this branch back to the cascade level it stopped at
+  for (size_t szLevel = 0; szLevel < pNode->szLevel; szLevel++) {
+    if ((res = iso14443a_inventory_select(pnd, szLevel, pNode->abtUidCln[szLevel], &btSak)) < 0)
+      return (res == NFC_ERFTRANS) ? 0 : res;
+  }
+
+  // Branches pushed before this mark belong to other cascade levels or selections
+  size_t szMark = *pszNodes;
+  while (true) {
+    res = iso14443a_inventory_anticol(pnd, pNode);
+    if (res == NFC_ERFTRANS) {
+      // Nobody behind this prefix, try the sibling pushed right before if any
+      if (*pszNodes > szMark) {
+        *pNode = anNodes[--(*pszNodes)];
+        continue;
+      }
+      return 0;
+    }
+    if (res == ISO14443A_INVENTORY_COLLISION) {
+      if (pNode->szPrefixBits == ISO14443A_UID_CLN_BITS)
+        return 0;
+      if (*pszNodes == ISO14443A_INVENTORY_DEPTH)
+        return NFC_ESOFT;
+      // Split the branch: walk the '0' side now, keep the '1' side for later
+      const size_t szBit = pNode->szPrefixBits;
+      anNodes[*pszNodes] = *pNode;
+      anNodes[*pszNodes].abtPrefix[szBit / 8] |= (1 << (szBit % 8));
+      anNodes[*pszNodes].szPrefixBits++;
+      (*pszNodes)++;
+      pNode->abtPrefix[szBit / 8] &= ~(1 << (szBit % 8));
+      pNode->szPrefixBits++;
+      continue;
+    }
+    if (res < 0)
+      return res;
+
+    // UID CLn is complete, select it
+    memcpy(pNode->abtUidCln[pNode->szLevel], pNode->abtPrefix, 5);
+    if ((res = iso14443a_inventory_select(pnd, pNode->szLevel, pNode->abtPrefix, &btSak)) < 0)
+      return (res == NFC_ERFTRANS) ? 0 : res;
+    if (!(btSak & ISO14443A_SAK_CASCADE_BIT))
+      break;
+    if (++pNode->szLevel == ISO14443A_CASCADE_LEVELS)
+      return 0;
+    memset(pNode->abtPrefix, 0x00, sizeof(pNode->abtPrefix));
+    pNode->szPrefixBits = 0;
+    szMark = *pszNodes;
+  }
+
+  memset(pnt, 0x00, sizeof(nfc_target));
+  pnt->nm.nmt = NMT_ISO14443A;
+  pnt->nm.nbr = NBR_106;
+  memcpy(pnt->nti.nai.abtAtqa, abtAtqa, 2);
+  pnt->nti.nai.btSak = btSak;
+  // Cascade tag (CT) is not part of the UID
+  for (size_t szLevel = 0; szLevel < pNode->szLevel; szLevel++) {
+    memcpy(pnt->nti.nai.abtUid + pnt->nti.nai.szUidLen, pNode->abtUidCln[szLevel] + 1, 3);
+    pnt->nti.nai.szUidLen += 3;
+  }
+  memcpy(pnt->nti.nai.abtUid + pnt->nti.nai.szUidLen, pNode->abtUidCln[pNode->szLevel], 4);
+  pnt->nti.nai.szUidLen += 4;
+
+  log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "Inventory found a %" PRIuPTR "-byte UID tag", pnt->nti.nai.szUidLen);
+  iso14443a_inventory_halt(pnd);
+  return 1;
+}
+
+static int
+nfc_initiator_inventory_iso14443a_unlocked(nfc_device *pnd, nfc_target ant[], const size_t szTargets)
+{
+  struct iso14443a_inventory_node anNodes[ISO14443A_INVENTORY_DEPTH];
+  size_t szNodes = 0;
+  size_t szTargetFound = 0;
+  int res = 0;
+
+  pnd->last_error = 0;
+
+  const bool bCrc = pnd->bCrc;
+  const bool bPar = pnd->bPar;
+  const bool bEasyFraming = pnd->bEasyFraming;
+  if ((res = nfc_device_set_property_bool(pnd, NP_HANDLE_CRC, false)) < 0)
+    return res;
+  if ((res = nfc_device_set_property_bool(pnd, NP_HANDLE_PARITY, false)) < 0)
+    return res;
+  if ((res = nfc_device_set_property_bool(pnd, NP_EASY_FRAMING, false)) < 0)
+    return res;
+
+  // Start from the root of the UID tree
+  memset(&anNodes[0], 0x00, sizeof(struct iso14443a_inventory_node));
+  szNodes = 1;
+  while ((szNodes > 0) && (szTargetFound < szTargets)) {
+    struct iso14443a_inventory_node node = anNodes[--szNodes];
+    if ((res = iso14443a_inventory_walk(pnd, &node, anNodes, &szNodes, &(ant[szTargetFound]))) < 0)
+      break;
+    szTargetFound += res;
+  }
+
+  int res2;
+  if ((res2 = nfc_device_set_property_bool(pnd, NP_EASY_FRAMING, bEasyFraming)) < 0)
+    return res2;
+  if ((res2 = nfc_device_set_property_bool(pnd, NP_HANDLE_PARITY, bPar)) < 0)
+    return res2;
+  if ((res2 = nfc_device_set_property_bool(pnd, NP_HANDLE_CRC, bCrc)) < 0)
+    return res2;
+  if (res < 0) {
+    pnd->last_error = res;
+    return res;
+  }
+  return szTargetFound;
+}
+
+/** @ingroup initiator
+ * @brief List every ISO/IEC 14443 type A tag available in the field
+ * @return Returns the number of targets found on success, otherwise returns libnfc's error code (negative value)
+ *
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ * @param[out] ant array of \a nfc_target that will be filled with targets info
+ * @param szTargets size of \a ant (will be the max targets listed)
+ *
+ * Unlike nfc_initiator_list_passive_targets(), the anti-collision loop of
+ * ISO/IEC 14443-3 is driven by the host with nfc_initiator_transceive_bits():
+ * the UID tree is walked at each cascade level, straight from one bit
+ * collision to the next, so every tag in the field is found however many
+ * there are. Each tag is halted (HLTA) once found.
+ *
+ * @note ATQA is only filled when the tag was alone to answer REQA, ATS is not
+ * requested.
+ * @note Found tags are left in HALT state: they only answer WUPA until they
+ * leave the field. The initiator has to be initialized beforehand, CRC,
+ * parity and easy framing settings are restored on return.
+ * @note A device which can not tell a bit collision from another RF error
+ * only finds a tag when it is alone in the field.
+ */
+int
+nfc_initiator_inventory_iso14443a(nfc_device *pnd, nfc_target ant[], const size_t szTargets)
+{
+  int res;
+
+  nfc_device_lock(pnd);
+  res = nfc_initiator_inventory_iso14443a_unlocked(pnd, ant, szTargets);
+  nfc_device_unlock(pnd);
+  return res;
+}
+
+// Polling requests in a row which bring no new IDm before the inventory stops
+#define FELICA_INVENTORY_EMPTY_POLLS 3
+
+static int
+nfc_initiator_inventory_felica_unlocked(nfc_device *pnd, const nfc_baud_rate nbr, const uint16_t ui16SystemCode,
+                                        const uint8_t ui8TimeSlots, nfc_target ant[], const size_t szTargets)
+{
+  // Polling request payload: command code, system code, request code (system code), time slot number
+  uint8_t abtPolling[5] = { 0x00, ui16SystemCode >> 8, ui16SystemCode & 0xff, 0x01, 0x00 };
+  const nfc_modulation nm = { .nmt = NMT_FELICA, .nbr = nbr };
+  nfc_target ntPolled[2];
+  size_t szTargetFound = 0;
+  size_t szEmptyPolls = 0;
+  int res = 0;
+
+  pnd->last_error = 0;
+
+  switch (ui8TimeSlots) {
+    case 1:
+    case 2:
+    case 4:
+    case 8:
+    case 16:
+      abtPolling[4] = ui8TimeSlots - 1;
+      break;
+    default:
+      pnd->last_error = NFC_EINVARG;
+      return pnd->last_error;
+  }
+
+  // Let the reader only try once to find a tag
+  bool bInfiniteSelect = pnd->bInfiniteSelect;
+  if ((res = nfc_device_set_property_bool(pnd, NP_INFINITE_SELECT, false)) < 0) {
+    return res;
+  }
+
+  while ((szTargetFound < szTargets) && (szEmptyPolls < FELICA_INVENTORY_EMPTY_POLLS)) {
+    res = nfc_initiator_select_passive_targets(pnd, nm, abtPolling, sizeof(abtPolling), ntPolled, 2);
+    if (res == NFC_EDEVNOTSUPP) {
+      res = nfc_initiator_select_passive_target(pnd, nm, abtPolling, sizeof(abtPolling), ntPolled);
+    }
+    if ((res < 0) && (res != NFC_ETIMEOUT) && (res != NFC_ERFTRANS)) {
+      break;
+    }
+    size_t szNew = 0;
+    for (int n = 0; (n < res) && (szTargetFound < szTargets); n++) {
+      bool seen = false;
+      // Check if we've already seen this IDm
+      for (size_t i = 0; i < szTargetFound; i++) {
+        if (memcmp(ant[i].nti.nfi.abtId, ntPolled[n].nti.nfi.abtId, sizeof(ntPolled[n].nti.nfi.abtId)) == 0) {
+          seen = true;
+        }
+      }
+      if (seen) {
+        continue;
+      }
+      memcpy(&(ant[szTargetFound]), &(ntPolled[n]), sizeof(nfc_target));
+      szTargetFound++;
+      szNew++;
+    }
+    if (szNew > 0) {
+      szEmptyPolls = 0;
+      continue;
+    }
+    // Silence or known IDm only: cards left may have picked the same slots,
+    // spread them over more slots for the next request
+    szEmptyPolls++;
+    if (abtPolling[4] < 0x0f) {
+      abtPolling[4] = (abtPolling[4] << 1) | 0x01;
+    }
+  }
+  if (bInfiniteSelect) {
+    if ((res = nfc_device_set_property_bool(pnd, NP_INFINITE_SELECT, true)) < 0) {
+      return res;
+    }
+  }
+  // No answer to the last polling request is not an error
+  if ((res < 0) && (res != NFC_ETIMEOUT) && (res != NFC_ERFTRANS) && (szTargetFound == 0)) {
+    return res;
+  }
+  return szTargetFound;
+}
+
+/** @ingroup initiator
+ * @brief List FeliCa cards answering a time-slotted polling request
+ * @return Returns the number of targets found on success, otherwise returns libnfc's error code (negative value)
+ *
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ * @param nbr desired baud rate (\a NBR_212 or \a NBR_424)
+ * @param ui16SystemCode system code to poll for, 0xffff is a wildcard
+ * @param ui8TimeSlots number of time slots of the polling request (1, 2, 4, 8 or 16)
+ * @param[out] ant array of \a nfc_target that will be filled with targets info
+ * @param szTargets size of \a ant (will be the max targets listed)
+ *
+ * Each card answers in a randomly chosen time slot, so the more slots, the
+ * less likely two cards collide. Cards have no HALT state: polling is
+ * repeated until several polling requests in a row bring no new IDm, the
+ * number of time slots being doubled (up to 16) after each of them.
+ *
+ * @note PN53x devices report up to two cards per polling request.
+ */
+int
+nfc_initiator_inventory_felica(nfc_device *pnd, const nfc_baud_rate nbr, const uint16_t ui16SystemCode,
+                               const uint8_t ui8TimeSlots, nfc_target ant[], const size_t szTargets)
+{
+  int res;
+
+  nfc_device_lock(pnd);
+  res = nfc_initiator_inventory_felica_unlocked(pnd, nbr, ui16SystemCode, ui8TimeSlots, ant, szTargets);
+  nfc_device_unlock(pnd);
+  return res;
+}
+
+#define ISO14443B_INVENTORY_SLOTS    16
+// Collisions can not be told apart from silence, stop after this many rounds without news
+#define ISO14443B_INVENTORY_IDLE     2
+#define ISO14443B_INVENTORY_ROUNDS   32
+#define ISO14443B_INVENTORY_TIMEOUT  300
+// Tags answer within a few ms: an empty slot ends as soon as the device tells so
+#define ISO14443B_INVENTORY_SLOT_TIMEOUT 5
+#define ISO14443B_ATQB_LEN           12
+
+/**
+ * @internal
+ * @struct iso14443b_inventory_settings
+ * @brief Device settings changed by the type B inventories, restored on return
+ */
+struct iso14443b_inventory_settings {
+  bool bCrc;
+  bool bEasyFraming;
+  bool bForceIso14443a;
+  bool bForceIso14443b;
+  bool bForceSpeed106;
+  int  iTimeoutCom;
+};
+
+/*
+ * Type B frames are sent through the raw framing of the device: CRC_B is
+ * handled by the device, which is forced into ISO/IEC 14443 B at 106 kbps.
+ * When the device tells its communication timeout, it is shortened so that
+ * empty slots are closed by the device itself.
+ */
+static int
+iso14443b_inventory_init(nfc_device *pnd, struct iso14443b_inventory_settings *pSettings)
+{
+  int res;
+
+  pSettings->bCrc = pnd->bCrc;
+  pSettings->bEasyFraming = pnd->bEasyFraming;
+  pSettings->bForceIso14443a = pnd->bForceIso14443a;
+  pSettings->bForceIso14443b = pnd->bForceIso14443b;
+  pSettings->bForceSpeed106 = pnd->bForceSpeed106;
+  pSettings->iTimeoutCom = pnd->iTimeoutCom;
+
+  if ((res = nfc_device_set_property_bool(pnd, NP_FORCE_ISO14443_B, true)) < 0)
+    return res;
+  if ((res = nfc_device_set_property_bool(pnd, NP_FORCE_SPEED_106, true)) < 0)
+    return res;
+  if ((res = nfc_device_set_property_bool(pnd, NP_HANDLE_CRC, true)) < 0)
+    return res;
+  if ((res = nfc_device_set_property_bool(pnd, NP_EASY_FRAMING, false)) < 0)
+    return res;
+  if ((pSettings->iTimeoutCom < 0) || ((pSettings->iTimeoutCom > 0) && (pSettings->iTimeoutCom <= ISO14443B_INVENTORY_SLOT_TIMEOUT)))
+    return NFC_SUCCESS;
+  return nfc_device_set_property_int(pnd, NP_TIMEOUT_COM, ISO14443B_INVENTORY_SLOT_TIMEOUT);
+}
+
+static int
+iso14443b_inventory_restore(nfc_device *pnd, const struct iso14443b_inventory_settings *pSettings)
+{
+  int res;
+
+  if ((pSettings->iTimeoutCom >= 0) && (pnd->iTimeoutCom != pSettings->iTimeoutCom)) {
+    if ((res = nfc_device_set_property_int(pnd, NP_TIMEOUT_COM, pSettings->iTimeoutCom)) < 0)
+      return res;
+  }
+  if ((res = nfc_device_set_property_bool(pnd, NP_EASY_FRAMING, pSettings->bEasyFraming)) < 0)
+    return res;
+  if ((res = nfc_device_set_property_bool(pnd, NP_HANDLE_CRC, pSettings->bCrc)) < 0)
+    return res;
+  // Releasing a forced framing or speed does not touch the device, forcing does
+  if ((res = nfc_device_set_property_bool(pnd, NP_FORCE_ISO14443_B, pSettings->bForceIso14443b)) < 0)
+    return res;
+  if ((res = nfc_device_set_property_bool(pnd, NP_FORCE_ISO14443_A, pSettings->bForceIso14443a)) < 0)
+    return res;
+  return nfc_device_set_property_bool(pnd, NP_FORCE_SPEED_106, pSettings->bForceSpeed106);
+}
+
+/*
+ * Nobody answering and several tags answering at once are both reported as
+ * RF errors, none of them stops the inventory.
+ */
+static bool
+iso14443b_inventory_is_silent(const int res)
+{
+  return (res == NFC_ERFTRANS) || (res == NFC_ETIMEOUT);
+}
+
+/*
+ * Send REQB or a Slot-MARKER, then record and halt (HLTB) the tag answering
+ * in this slot if any. Returns 1 when a new tag has been found.
+ */
+static int
+iso14443b_inventory_slot(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, nfc_target ant[], const size_t szTargetFound)
+{
+  uint8_t abtAtqb[ISO14443A_FRAME_MAX_LEN];
+  uint8_t abtHltb[5] = { 0x50 };
+  uint8_t abtRx[1];
+  int res;
+
+  if ((res = nfc_initiator_transceive_bytes(pnd, pbtTx, szTx, abtAtqb, sizeof(abtAtqb), ISO14443B_INVENTORY_TIMEOUT)) < 0)
+    return iso14443b_inventory_is_silent(res) ? 0 : res;
+  if ((res != ISO14443B_ATQB_LEN) || (abtAtqb[0] != 0x50))
+    return 0;
+
+  // Halt it at once so that it does not take part in the next rounds
+  memcpy(abtHltb + 1, abtAtqb + 1, 4);
+  if ((res = nfc_initiator_transceive_bytes(pnd, abtHltb, sizeof(abtHltb), abtRx, sizeof(abtRx), ISO14443B_INVENTORY_TIMEOUT)) < 0) {
+    if (!iso14443b_inventory_is_silent(res))
+      return res;
+  }
+
+  // A tag whose HLTB did get lost answers again
+  for (size_t i = 0; i < szTargetFound; i++) {
+    if (memcmp(ant[i].nti.nbi.abtPupi, abtAtqb + 1, 4) == 0)
+      return 0;
+  }
+
+  nfc_target *pnt = &(ant[szTargetFound]);
+  memset(pnt, 0x00, sizeof(nfc_target));
+  pnt->nm.nmt = NMT_ISO14443B;
+  pnt->nm.nbr = NBR_106;
+  memcpy(pnt->nti.nbi.abtPupi, abtAtqb + 1, 4);
+  memcpy(pnt->nti.nbi.abtApplicationData, abtAtqb + 5, 4);
+  memcpy(pnt->nti.nbi.abtProtocolInfo, abtAtqb + 9, 3);
+  return 1;
+}
+
+static int
+nfc_initiator_inventory_iso14443b_unlocked(nfc_device *pnd, const uint8_t ui8Afi, nfc_target ant[], const size_t szTargets)
+{
+  // REQB: APf, AFI, PARAM (REQB, N = 16 slots)
+  const uint8_t abtReqb[3] = { 0x05, ui8Afi, 0x04 };
+  struct iso14443b_inventory_settings settings;
+  size_t szTargetFound = 0;
+  int res = 0;
+  int res2;
+
+  pnd->last_error = 0;
+
+  if ((res = iso14443b_inventory_init(pnd, &settings)) < 0)
+    goto restore;
+
+  size_t szIdleRounds = 0;
+  for (size_t szRound = 0; (szRound < ISO14443B_INVENTORY_ROUNDS) && (szIdleRounds < ISO14443B_INVENTORY_IDLE); szRound++) {
+    size_t szNew = 0;
+    for (uint8_t ui8Slot = 1; (ui8Slot <= ISO14443B_INVENTORY_SLOTS) && (szTargetFound < szTargets); ui8Slot++) {
+      // Slot-MARKER: APn carries the slot number minus one
+      const uint8_t abtSlotMarker[1] = { (uint8_t)(((ui8Slot - 1) << 4) | 0x05) };
+      if (ui8Slot == 1) {
+        res = iso14443b_inventory_slot(pnd, abtReqb, sizeof(abtReqb), ant, szTargetFound);
+      } else {
+        res = iso14443b_inventory_slot(pnd, abtSlotMarker, sizeof(abtSlotMarker), ant, szTargetFound);
+      }
+      if (res < 0)
+        break;
+      szTargetFound += res;
+      szNew += res;
+    }
+    if ((res < 0) || (szTargetFound == szTargets))
+      break;
+    szIdleRounds = (szNew) ? 0 : szIdleRounds + 1;
+  }
+  log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "Inventory found %" PRIuPTR " ISO14443B tag(s)", szTargetFound);
+
+restore:
+  if ((res2 = iso14443b_inventory_restore(pnd, &settings)) < 0)
+    return res2;
+  if (res < 0) {
+    pnd->last_error = res;
+    return res;
+  }
+  return szTargetFound;
+}
+
+/** @ingroup initiator
+ * @brief List every ISO/IEC 14443 type B tag available in the field
+ * @return Returns the number of targets found on success, otherwise returns libnfc's error code (negative value)
+ *
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ * @param ui8Afi Application Family Identifier to poll for, 0x00 for all families
+ * @param[out] ant array of \a nfc_target that will be filled with targets info
+ * @param szTargets size of \a ant (will be the max targets listed)
+ *
+ * Rounds of REQB with 16 slots are sent: each tag answers in a randomly
+ * chosen slot, every slot after the first one being opened by a Slot-MARKER
+ * command (see ISO/IEC 14443-3). Each tag is halted (HLTB) once found.
+ *
+ * @note Found tags are left in HALT state: they only answer WUPB until they
+ * leave the field. The initiator has to be initialized beforehand, CRC, easy
+ * framing, forced modulation and speed, and communication timeout settings
+ * are restored on return.
+ */
+int
+nfc_initiator_inventory_iso14443b(nfc_device *pnd, const uint8_t ui8Afi, nfc_target ant[], const size_t szTargets)
+{
+  int res;
+
+  nfc_device_lock(pnd);
+  res = nfc_initiator_inventory_iso14443b_unlocked(pnd, ui8Afi, ant, szTargets);
+  nfc_device_unlock(pnd);
+  return res;
+}
+
+/*
+ * Bring the ST SRx tag which drew this Chip_ID to the selected state, read
+ * its UID then deactivate it (Completion). Returns 1 when a new tag has been
+ * found.
+ */
+static int
+iso14443b2sr_inventory_read(nfc_device *pnd, const uint8_t btChipId, nfc_target ant[], const size_t szTargetFound)
+{
+  const uint8_t abtSelect[2] = { 0x0e, btChipId };
+  const uint8_t abtGetUid[1] = { 0x0b };
+  const uint8_t abtCompletion[1] = { 0x0f };
+  uint8_t abtRx[ISO14443A_FRAME_MAX_LEN];
+  int res;
+
+  // Two tags may have drawn the same Chip_ID, they will be met again in a later round
+  if ((res = nfc_initiator_transceive_bytes(pnd, abtSelect, sizeof(abtSelect), abtRx, sizeof(abtRx), ISO14443B_INVENTORY_TIMEOUT)) < 0)
+    return iso14443b_inventory_is_silent(res) ? 0 : res;
+  if ((res != 1) || (abtRx[0] != btChipId))
+    return 0;
+  if ((res = nfc_initiator_transceive_bytes(pnd, abtGetUid, sizeof(abtGetUid), abtRx, sizeof(abtRx), ISO14443B_INVENTORY_TIMEOUT)) < 0)
+    return iso14443b_inventory_is_silent(res) ? 0 : res;
+  if (res != 8)
+    return 0;
+
+  for (size_t i = 0; i < szTargetFound; i++) {
+    if (memcmp(ant[i].nti.nsi.abtUID, abtRx, 8) == 0)
+      return 0;
+  }
+  nfc_target *pnt = &(ant[szTargetFound]);
+  memset(pnt, 0x00, sizeof(nfc_target));
+  pnt->nm.nmt = NMT_ISO14443B2SR;
+  pnt->nm.nbr = NBR_106;
+  memcpy(pnt->nti.nsi.abtUID, abtRx, 8);
+
+  // A deactivated tag does not answer until it leaves the field
+  if ((res = nfc_initiator_transceive_bytes(pnd, abtCompletion, sizeof(abtCompletion), NULL, 0, ISO14443B_INVENTORY_TIMEOUT)) < 0) {
+    if (!iso14443b_inventory_is_silent(res))
+      return res;
+  }
+  return 1;
+}
+
+static int
+nfc_initiator_inventory_iso14443b2sr_unlocked(nfc_device *pnd, nfc_target ant[], const size_t szTargets)
+{
+  const uint8_t abtInitiate[2] = { 0x06, 0x00 };
+  const uint8_t abtPcall16[2] = { 0x06, 0x04 };
+  uint8_t abtRx[ISO14443A_FRAME_MAX_LEN];
+  struct iso14443b_inventory_settings settings;
+  size_t szTargetFound = 0;
+  int res = 0;
+  int res2;
+
+  pnd->last_error = 0;
+
+  if ((res = iso14443b_inventory_init(pnd, &settings)) < 0)
+    goto restore;
+
+  // Answers to Initiate() collide as soon as two tags are there, only the state change matters
+  if ((res = nfc_initiator_transceive_bytes(pnd, abtInitiate, sizeof(abtInitiate), abtRx, sizeof(abtRx), ISO14443B_INVENTORY_TIMEOUT)) < 0) {
+    if (!iso14443b_inventory_is_silent(res))
+      goto restore;
+  }
+  res = 0;
+
+  size_t szIdleRounds = 0;
+  for (size_t szRound = 0; (szRound < ISO14443B_INVENTORY_ROUNDS) && (szIdleRounds < ISO14443B_INVENTORY_IDLE); szRound++) {
+    uint8_t abtChipIds[ISO14443B_INVENTORY_SLOTS];
+    size_t szChipIds = 0;
+    for (uint8_t ui8Slot = 0; ui8Slot < ISO14443B_INVENTORY_SLOTS; ui8Slot++) {
+      const uint8_t abtSlotMarker[1] = { (uint8_t)((ui8Slot << 4) | 0x06) };
+      if (ui8Slot == 0) {
+        res = nfc_initiator_transceive_bytes(pnd, abtPcall16, sizeof(abtPcall16), abtRx, sizeof(abtRx), ISO14443B_INVENTORY_TIMEOUT);
+      } else {
+        res = nfc_initiator_transceive_bytes(pnd, abtSlotMarker, sizeof(abtSlotMarker), abtRx, sizeof(abtRx), ISO14443B_INVENTORY_TIMEOUT);
+      }
+      if (res < 0) {
+        if (!iso14443b_inventory_is_silent(res))
+          goto restore;
+        continue;
+      }
+      if (res == 1)
+        abtChipIds[szChipIds++] = abtRx[0];
+    }
+
+    size_t szNew = 0;
+    for (size_t n = 0; (n < szChipIds) && (szTargetFound < szTargets); n++) {
+      if ((res = iso14443b2sr_inventory_read(pnd, abtChipIds[n], ant, szTargetFound)) < 0)
+        goto restore;
+      szTargetFound += res;
+      szNew += res;
+    }
+    res = 0;
+    if (szTargetFound == szTargets)
+      break;
+    szIdleRounds = (szNew) ? 0 : szIdleRounds + 1;
+  }
+  log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "Inventory found %" PRIuPTR " ST SRx tag(s)", szTargetFound);
+
+restore:
+  if ((res2 = iso14443b_inventory_restore(pnd, &settings)) < 0)
+    return res2;
+  if (res < 0) {
+    pnd->last_error = res;
+    return res;
+  }
+  return szTargetFound;
+}
+
+/** @ingroup initiator
+ * @brief List every ST SRx tag (SRI512, SRIX4K, ...) available in the field
+ * @return Returns the number of targets found on success, otherwise returns libnfc's error code (negative value)
+ *
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ * @param[out] ant array of \a nfc_target that will be filled with targets info
+ * @param szTargets size of \a ant (will be the max targets listed)
+ *
+ * Tags are brought to inventory state by Initiate(), then rounds of Pcall16()
+ * and 15 Slot_marker() commands collect the Chip_ID of the tags, each one
+ * answering in a randomly chosen slot. Each Chip_ID is then selected, its UID
+ * is read and the tag is deactivated by Completion().
+ *
+ * @note Found tags are left in deactivated state: they do not answer anymore
+ * until they leave the field. The initiator has to be initialized beforehand,
+ * CRC, easy framing, forced modulation and speed, and communication timeout
+ * settings are restored on return.
+ */
+int
+nfc_initiator_inventory_iso14443b2sr(nfc_device *pnd, nfc_target ant[], const size_t szTargets)
+{
+  int res;
+
+  nfc_device_lock(pnd);
+  res = nfc_initiator_inventory_iso14443b2sr_unlocked(pnd, ant, szTargets);
+  nfc_device_unlock(pnd);
+  return res;
+}
@@ -0,0 +1,187 @@
+/*-
+ * Free/Libre Near Field Communication (NFC) library
+ *
+ * Libnfc historical contributors:
+ * Copyright (C) 2009      Roel Verdult
+ * Copyright (C) 2009-2013 Romuald Conty
+ * Copyright (C) 2010-2012 Romain Tartière
+ * Copyright (C) 2010-2013 Philippe Teuwen
+ * Copyright (C) 2012-2013 Ludovic Rousseau
+ * See AUTHORS file for a more comprehensive list of contributors.
+ * Additional contributors of this file:
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+/**
+ * @file nfc-pool.c
+ * @brief Provide a pool of devices kept open and initialized across nfc_close() / nfc_open() cycles
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <string.h>
+
+#include <nfc/nfc.h>
+
+#include "nfc-internal.h"
+
+#define LOG_CATEGORY "libnfc.general"
+#define LOG_GROUP    NFC_LOG_GROUP_GENERAL
+
+static void
+nfc_pool_remove(struct nfc_device_pool *pool, const size_t szEntry)
+{
+  pool->szDevices--;
+  memmove(&(pool->entries[szEntry]), &(pool->entries[szEntry + 1]), (pool->szDevices - szEntry) * sizeof(pool->entries[0]));
+}
+
+static void
+nfc_pool_expire(struct nfc_device_pool *pool)
+{
+  for (size_t n = 0; n < pool->szDevices; n++) {
+    struct nfc_device_pool_entry *pe = &(pool->entries[n]);
+    if (pe->bPoweredDown || (pe->idle_deadline == 0) || (nfc_deadline_remaining(pe->idle_deadline) > 0))
+      continue;
+    pe->bPoweredDown = true;
+    if (pe->pnd->driver->powerdown == NULL)
+      continue;
+    if (pe->pnd->driver->powerdown(pe->pnd) < 0) {
+      log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "Unable to power down pooled device \"%s\"", pe->pnd->connstring);
+    } else {
+      log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "Pooled device \"%s\" powered down", pe->pnd->connstring);
+    }
+  }
+}
+
+/** @ingroup dev
+ * @brief Keep closed devices open and initialized for their next opening
+ * @return Returns 0 on success, otherwise returns libnfc's error code (negative value)
+ *
+ * @param context The context to operate on
+ * @param szMaxDevices maximum number of devices kept, 0 disables the pool (default)
+ * @param idle_timeout delay (in ms) after which a pooled device is powered down, 0 for never
+ *
+ * Once configured, nfc_close() does not release a device anymore: its RF
+ * field is switched off and it is kept in the pool, still claimed. The next
+ * nfc_open() with the same connstring (as reported by nfc_device_get_connstring())
+ * gets it back, only reset to the settings of a freshly opened device.
+ * A \c NULL connstring gets the default device (the first one set by the
+ * user, see nfc_list_devices()) if it is pooled, or any pooled device when
+ * no device is set by the user.
+ *
+ * Devices idle for longer than \a idle_timeout are powered down by
+ * nfc_pool_sweep(), which nfc_open() and nfc_close() also call. Pooled
+ * devices are really closed by nfc_exit(), or here when the pool shrinks.
+ */
+int
+nfc_pool_configure(nfc_context *context, const size_t szMaxDevices, const int idle_timeout)
+{
+  if ((szMaxDevices > MAX_POOLED_DEVICES) || (idle_timeout < 0))
+    return NFC_EINVARG;
+
+  struct nfc_device_pool *pool = &(context->pool);
+  while (pool->szDevices > szMaxDevices) {
+    nfc_device *pnd = pool->entries[pool->szDevices - 1].pnd;
+    nfc_pool_remove(pool, pool->szDevices - 1);
+    pnd->driver->close(pnd);
+  }
+  pool->szMaxDevices = szMaxDevices;
+  pool->idle_timeout = idle_timeout;
+  return NFC_SUCCESS;
+}
+
+/** @ingroup dev
+ * @brief Power down the pooled devices idle for longer than the pool idle timeout
+ *
+ * @param context The context to operate on
+ *
+ * libnfc has no thread of its own: an application keeping devices pooled
+ * while doing nothing else with libnfc should call it from time to time.
+ */
+void
+nfc_pool_sweep(nfc_context *context)
+{
+  nfc_pool_expire(&(context->pool));
+}
+
+/*
+ * Get a pooled device back, reset to the state of a freshly opened one.
+ * Returns NULL if none matches: the caller opens a new one.
+ */
+nfc_device *
+nfc_pool_take(nfc_context *context, const char *connstring)
+{
+  struct nfc_device_pool *pool = &(context->pool);
+
+#ifdef CONFFILES
+  // nfc_open() would pick the first device set by the user
+  if ((connstring == NULL) && (context->user_defined_device_count > 0))
+    connstring = context->user_defined_devices[0].connstring;
+#endif // CONFFILES
+
+  nfc_pool_expire(pool);
+  for (size_t n = 0; n < pool->szDevices; n++) {
+    nfc_device *pnd = pool->entries[n].pnd;
+    if ((connstring != NULL) && (strcmp(connstring, pnd->connstring) != 0))
+      continue;
+    nfc_pool_remove(pool, n);
+    pnd->last_error = 0;
+    if (pnd->driver->reset(pnd) < 0) {
+      // Device may have been unplugged meanwhile, let the caller open it again
+      log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "Unable to reuse pooled device \"%s\"", pnd->connstring);
+      pnd->driver->close(pnd);
+      return NULL;
+    }
+    log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "\"%s\" (%s) has been taken from the pool.", pnd->name, pnd->connstring);
+    return pnd;
+  }
+  return NULL;
+}
+
+/*
+ * Keep a device being closed in its pool, with its RF field off.
+ * Returns false if it has to be really closed.
+ */
+bool
+nfc_pool_put(nfc_device *pnd)
+{
+  struct nfc_device_pool *pool = pnd->pool;
+
+  if ((pool == NULL) || (pnd->driver->reset == NULL))
+    return false;
+  nfc_pool_expire(pool);
+  if (pool->szDevices >= pool->szMaxDevices)
+    return false;
+  if ((pnd->driver->idle != NULL) && (pnd->driver->idle(pnd) < 0))
+    return false;
+
+  struct nfc_device_pool_entry *pe = &(pool->entries[pool->szDevices++]);
+  pe->pnd = pnd;
+  pe->idle_deadline = nfc_deadline_from_timeout(pool->idle_timeout);
+  pe->bPoweredDown = false;
+  log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "\"%s\" (%s) has been put back in the pool.", pnd->name, pnd->connstring);
+  return true;
+}
+
+/*
+ * Really close all pooled devices
+ */
+void
+nfc_pool_clear(nfc_context *context)
+{
+  nfc_pool_configure(context, 0, context->pool.idle_timeout);
+}
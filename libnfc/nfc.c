@@ -128,6 +128,10 @@
 #  include "drivers/pn71xx.h"
 #endif /* DRIVER_PN71XX_ENABLED */
 
+#if defined (DRIVER_NFCD_ENABLED)
+#  include "drivers/nfcd.h"
+#endif /* DRIVER_NFCD_ENABLED */
+
 
 #define LOG_CATEGORY "libnfc.general"
 #define LOG_GROUP    NFC_LOG_GROUP_GENERAL
@@ -137,7 +141,14 @@ struct nfc_driver_list {
   const struct nfc_driver *driver;
 };
 
-const struct nfc_driver_list *nfc_drivers = NULL;
+/*
+ * Drivers are shared by all contexts: the list only grows (new drivers are
+ * prepended) while a context is alive, and is released with the last one.
+ * Walking the list from a head read with nfc_drivers_head() needs no lock.
+ */
+static const struct nfc_driver_list *nfc_drivers = NULL;
+static size_t nfc_drivers_users = 0;
+static nfc_mutex nfc_drivers_mutex = NFC_MUTEX_INITIALIZER;
 
 // descritions for debugging
 const char *nfc_property_name[] = {
@@ -155,42 +166,72 @@ const char *nfc_property_name[] = {
   "NP_EASY_FRAMING",
   "NP_FORCE_ISO14443_A",
   "NP_FORCE_ISO14443_B",
-  "NP_FORCE_SPEED_106"
+  "NP_FORCE_SPEED_106",
+  "NP_AUTO_PPS",
+  "NP_ADAPTIVE_TIMEOUT"
 };
 
+static int
+nfc_drivers_add(const struct nfc_driver *ndr)
+{
+  struct nfc_driver_list *pndl = (struct nfc_driver_list *)malloc(sizeof(struct nfc_driver_list));
+  if (!pndl)
+    return NFC_ESOFT;
+
+  pndl->driver = ndr;
+  pndl->next = nfc_drivers;
+  nfc_drivers = pndl;
+
+  return NFC_SUCCESS;
+}
+
 static void
 nfc_drivers_init(void)
 {
 #if defined (DRIVER_PN53X_USB_ENABLED)
-  nfc_register_driver(&pn53x_usb_driver);
+  nfc_drivers_add(&pn53x_usb_driver);
 #endif /* DRIVER_PN53X_USB_ENABLED */
 #if defined (DRIVER_PCSC_ENABLED)
-  nfc_register_driver(&pcsc_driver);
+  nfc_drivers_add(&pcsc_driver);
 #endif /* DRIVER_ACR122_PCSC_ENABLED */
 #if defined (DRIVER_ACR122_PCSC_ENABLED)
-  nfc_register_driver(&acr122_pcsc_driver);
+  nfc_drivers_add(&acr122_pcsc_driver);
 #endif /* DRIVER_ACR122_PCSC_ENABLED */
 #if defined (DRIVER_ACR122_USB_ENABLED)
-  nfc_register_driver(&acr122_usb_driver);
+  nfc_drivers_add(&acr122_usb_driver);
 #endif /* DRIVER_ACR122_USB_ENABLED */
 #if defined (DRIVER_ACR122S_ENABLED)
-  nfc_register_driver(&acr122s_driver);
+  nfc_drivers_add(&acr122s_driver);
 #endif /* DRIVER_ACR122S_ENABLED */
 #if defined (DRIVER_PN532_UART_ENABLED)
-  nfc_register_driver(&pn532_uart_driver);
+  nfc_drivers_add(&pn532_uart_driver);
 #endif /* DRIVER_PN532_UART_ENABLED */
 #if defined (DRIVER_PN532_SPI_ENABLED)
-  nfc_register_driver(&pn532_spi_driver);
+  nfc_drivers_add(&pn532_spi_driver);
 #endif /* DRIVER_PN532_SPI_ENABLED */
 #if defined (DRIVER_PN532_I2C_ENABLED)
-  nfc_register_driver(&pn532_i2c_driver);
+  nfc_drivers_add(&pn532_i2c_driver);
 #endif /* DRIVER_PN532_I2C_ENABLED */
 #if defined (DRIVER_ARYGON_ENABLED)
-  nfc_register_driver(&arygon_driver);
+  nfc_drivers_add(&arygon_driver);
 #endif /* DRIVER_ARYGON_ENABLED */
 #if defined (DRIVER_PN71XX_ENABLED)
-  nfc_register_driver(&pn71xx_driver);
+  nfc_drivers_add(&pn71xx_driver);
 #endif /* DRIVER_PN71XX_ENABLED */
+#if defined (DRIVER_NFCD_ENABLED)
+  nfc_drivers_add(&nfcd_driver);
+#endif /* DRIVER_NFCD_ENABLED */
+}
+
+static const struct nfc_driver_list *
+nfc_drivers_head(void)
+{
+  const struct nfc_driver_list *pndl;
+
+  nfc_mutex_lock(&nfc_drivers_mutex);
+  pndl = nfc_drivers;
+  nfc_mutex_unlock(&nfc_drivers_mutex);
+  return pndl;
 }
 
 static int
@@ -206,26 +247,31 @@ nfc_device_validate_modulation(nfc_device *pnd, const nfc_mode mode, const nfc_m
 int
 nfc_register_driver(const struct nfc_driver *ndr)
 {
+  int res;
+
   if (!ndr) {
     log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "nfc_register_driver returning NFC_EINVARG");
     return NFC_EINVARG;
   }
 
-  struct nfc_driver_list *pndl = (struct nfc_driver_list *)malloc(sizeof(struct nfc_driver_list));
-  if (!pndl)
-    return NFC_ESOFT;
-
-  pndl->driver = ndr;
-  pndl->next = nfc_drivers;
-  nfc_drivers = pndl;
-
-  return NFC_SUCCESS;
+  nfc_mutex_lock(&nfc_drivers_mutex);
+  res = nfc_drivers_add(ndr);
+  nfc_mutex_unlock(&nfc_drivers_mutex);
+  return res;
 }
 
 /** @ingroup lib
  * @brief Initialize libnfc.
  * This function must be called before calling any other libnfc function
  * @param context Output location for nfc_context
+ *
+ * @note Several contexts can be created, used and released concurrently by
+ * different threads. A context itself (device scanning, opening and its
+ * device pool) must be used by one thread at a time, while each device
+ * serializes its own operations: see nfc_open().
+ * @note The log level is process-wide: the one of the last initialized
+ * context (from LIBNFC_LOG_LEVEL or the log_level setting) applies to the
+ * logs of every context and device.
  */
 void
 nfc_init(nfc_context **context)
@@ -235,8 +281,11 @@ nfc_init(nfc_context **context)
     perror("malloc");
     return;
   }
+  nfc_mutex_lock(&nfc_drivers_mutex);
   if (!nfc_drivers)
     nfc_drivers_init();
+  nfc_drivers_users++;
+  nfc_mutex_unlock(&nfc_drivers_mutex);
 }
 
 /** @ingroup lib
@@ -247,11 +296,21 @@ nfc_init(nfc_context **context)
 void
 nfc_exit(nfc_context *context)
 {
-  while (nfc_drivers) {
-    struct nfc_driver_list *pndl = (struct nfc_driver_list *) nfc_drivers;
-    nfc_drivers = pndl->next;
-    free(pndl);
+  // Pooled devices are still open
+  nfc_pool_clear(context);
+
+  // Drivers are released along with the last context
+  nfc_mutex_lock(&nfc_drivers_mutex);
+  if (nfc_drivers_users)
+    nfc_drivers_users--;
+  if (nfc_drivers_users == 0) {
+    while (nfc_drivers) {
+      struct nfc_driver_list *pndl = (struct nfc_driver_list *) nfc_drivers;
+      nfc_drivers = pndl->next;
+      free(pndl);
+    }
   }
+  nfc_mutex_unlock(&nfc_drivers_mutex);
 
   nfc_context_free(context);
 }
@@ -272,12 +331,25 @@ nfc_exit(nfc_context *context)
  *
  * @note Depending on the desired operation mode, the device needs to be configured by using nfc_initiator_init() or nfc_target_init(),
  * optionally followed by manual tuning of the parameters if the default parameters are not suiting your goals.
+ *
+ * @note When a device pool is configured (see nfc_pool_configure()), a matching
+ * pooled device is returned first, without being opened and initialized again.
+ *
+ * @note A device can be shared by several threads: each operation holds the
+ * device lock, so operations of different threads never interleave on the
+ * wire. nfc_abort_command() is the exception, as it has to interrupt the
+ * operation running in another thread. nfc_close() must not race with any
+ * other operation on the device.
  */
 nfc_device *
 nfc_open(nfc_context *context, const nfc_connstring connstring)
 {
   nfc_device *pnd = NULL;
 
+  if ((pnd = nfc_pool_take(context, connstring)) != NULL) {
+    return pnd;
+  }
+
   nfc_connstring ncs;
   if (connstring == NULL) {
     if (!nfc_list_devices(context, &ncs, 1)) {
@@ -289,7 +361,7 @@ nfc_open(nfc_context *context, const nfc_connstring connstring)
   }
 
   // Search through the device list for an available device
-  const struct nfc_driver_list *pndl = nfc_drivers;
+  const struct nfc_driver_list *pndl = nfc_drivers_head();
   while (pndl) {
     const struct nfc_driver *ndr = pndl->driver;
 
@@ -321,6 +393,7 @@ nfc_open(nfc_context *context, const nfc_connstring connstring)
       }
     }
     log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_DEBUG, "\"%s\" (%s) has been claimed.", pnd->name, pnd->connstring);
+    pnd->pool = &(context->pool);
     return pnd;
   }
 
@@ -334,11 +407,16 @@ nfc_open(nfc_context *context, const nfc_connstring connstring)
  * @param pnd \a nfc_device struct pointer that represent currently used device
  *
  * Initiator's selected tag is closed and the device, including allocated \a nfc_device struct, is released.
+ * When a device pool is configured (see nfc_pool_configure()), the device is kept open in the pool instead.
+ * The callbacks of the submitted commands not completed yet are invoked first, with \a NFC_EOPABORTED.
  */
 void
 nfc_close(nfc_device *pnd)
 {
   if (pnd) {
+    nfc_async_free(pnd);
+    if (nfc_pool_put(pnd))
+      return;
     // Close, clean up and release the device
     pnd->driver->close(pnd);
   }
@@ -365,30 +443,10 @@ nfc_list_devices(nfc_context *context, nfc_connstring connstrings[], const size_
       // let's make sure the device exists
       nfc_device *pnd = NULL;
 
-#ifdef ENVVARS
-      char *env_log_level = getenv("LIBNFC_LOG_LEVEL");
-      char *old_env_log_level = NULL;
       // do it silently
-      if (env_log_level) {
-        if ((old_env_log_level = malloc(strlen(env_log_level) + 1)) == NULL) {
-          log_put(LOG_GROUP, LOG_CATEGORY, NFC_LOG_PRIORITY_ERROR, "%s", "Unable to malloc()");
-          return 0;
-        }
-        strcpy(old_env_log_level, env_log_level);
-      }
-      setenv("LIBNFC_LOG_LEVEL", "0", 1);
-#endif // ENVVARS
-
+      log_set_quiet(true);
       pnd = nfc_open(context, context->user_defined_devices[i].connstring);
-
-#ifdef ENVVARS
-      if (old_env_log_level) {
-        setenv("LIBNFC_LOG_LEVEL", old_env_log_level, 1);
-        free(old_env_log_level);
-      } else {
-        unsetenv("LIBNFC_LOG_LEVEL");
-      }
-#endif // ENVVARS
+      log_set_quiet(false);
 
       if (pnd) {
         nfc_close(pnd);
@@ -410,7 +468,7 @@ nfc_list_devices(nfc_context *context, nfc_connstring connstrings[], const size_
 
   // Device auto-detection
   if (context->allow_autoscan) {
-    const struct nfc_driver_list *pndl = nfc_drivers;
+    const struct nfc_driver_list *pndl = nfc_drivers_head();
     while (pndl) {
       const struct nfc_driver *ndr = pndl->driver;
       if ((ndr->scan_type == NOT_INTRUSIVE) || ((context->allow_intrusive_scan) && (ndr->scan_type == INTRUSIVE))) {
@@ -469,28 +527,8 @@ nfc_device_set_property_bool(nfc_device *pnd, const nfc_property property, const
   HAL(device_set_property_bool, pnd, property, bEnable);
 }
 
-/** @ingroup initiator
- * @brief Initialize NFC device as initiator (reader)
- * @return Returns 0 on success, otherwise returns libnfc's error code (negative value)
- * @param pnd \a nfc_device struct pointer that represent currently used device
- *
- * The NFC device is configured to function as RFID reader.
- * After initialization it can be used to communicate to passive RFID tags and active NFC devices.
- * The reader will act as initiator to communicate peer 2 peer (NFCIP) to other active NFC devices.
- * - Crc is handled by the device (NP_HANDLE_CRC = true)
- * - Parity is handled the device (NP_HANDLE_PARITY = true)
- * - Cryto1 cipher is disabled (NP_ACTIVATE_CRYPTO1 = false)
- * - Easy framing is enabled (NP_EASY_FRAMING = true)
- * - Auto-switching in ISO14443-4 mode is enabled (NP_AUTO_ISO14443_4 = true)
- * - Invalid frames are not accepted (NP_ACCEPT_INVALID_FRAMES = false)
- * - Multiple frames are not accepted (NP_ACCEPT_MULTIPLE_FRAMES = false)
- * - 14443-A mode is activated (NP_FORCE_ISO14443_A = true)
- * - speed is set to 106 kbps (NP_FORCE_SPEED_106 = true)
- * - Let the device try forever to find a target (NP_INFINITE_SELECT = true)
- * - RF field is shortly dropped (if it was enabled) then activated again
- */
-int
-nfc_initiator_init(nfc_device *pnd)
+static int
+nfc_initiator_init_unlocked(nfc_device *pnd)
 {
   int res = 0;
   // Drop the field for a while
@@ -511,6 +549,9 @@ nfc_initiator_init(nfc_device *pnd)
   // Force speed at 106kbps
   if ((res = nfc_device_set_property_bool(pnd, NP_FORCE_SPEED_106, true)) < 0)
     return res;
+  // Keep the bit rate of selected targets
+  if ((res = nfc_device_set_property_bool(pnd, NP_AUTO_PPS, false)) < 0)
+    return res;
   // Disallow invalid frame
   if ((res = nfc_device_set_property_bool(pnd, NP_ACCEPT_INVALID_FRAMES, false)) < 0)
     return res;
@@ -521,27 +562,40 @@ nfc_initiator_init(nfc_device *pnd)
 }
 
 /** @ingroup initiator
- * @brief Initialize NFC device as initiator (reader) to support collision handling
+ * @brief Initialize NFC device as initiator (reader)
  * @return Returns 0 on success, otherwise returns libnfc's error code (negative value)
  * @param pnd \a nfc_device struct pointer that represent currently used device
  *
  * The NFC device is configured to function as RFID reader.
  * After initialization it can be used to communicate to passive RFID tags and active NFC devices.
  * The reader will act as initiator to communicate peer 2 peer (NFCIP) to other active NFC devices.
- * - Crc is handled by the device (NP_HANDLE_CRC = false)
- * - Parity is handled the device (NP_HANDLE_PARITY = false)
+ * - Crc is handled by the device (NP_HANDLE_CRC = true)
+ * - Parity is handled the device (NP_HANDLE_PARITY = true)
  * - Cryto1 cipher is disabled (NP_ACTIVATE_CRYPTO1 = false)
- * - Easy framing is enabled (NP_EASY_FRAMING = false)
- * - Auto-switching in ISO14443-4 mode is enabled (NP_AUTO_ISO14443_4 = false)
- * - Invalid frames are not accepted (NP_ACCEPT_INVALID_FRAMES = true)
- * - Multiple frames are accepted (NP_ACCEPT_MULTIPLE_FRAMES = true)
+ * - Easy framing is enabled (NP_EASY_FRAMING = true)
+ * - Auto-switching in ISO14443-4 mode is enabled (NP_AUTO_ISO14443_4 = true)
+ * - Invalid frames are not accepted (NP_ACCEPT_INVALID_FRAMES = false)
+ * - Multiple frames are not accepted (NP_ACCEPT_MULTIPLE_FRAMES = false)
  * - 14443-A mode is activated (NP_FORCE_ISO14443_A = true)
  * - speed is set to 106 kbps (NP_FORCE_SPEED_106 = true)
- * - Let the device try forever to find a target (NP_INFINITE_SELECT = false)
+ * - ISO14443-4 targets are kept at 106 kbps once selected (NP_AUTO_PPS = false)
+ * - Timeouts are not learnt from the targets (NP_ADAPTIVE_TIMEOUT = false)
+ * - Let the device try forever to find a target (NP_INFINITE_SELECT = true)
  * - RF field is shortly dropped (if it was enabled) then activated again
  */
 int
-nfc_initiator_init_collision(nfc_device *pnd)
+nfc_initiator_init(nfc_device *pnd)
+{
+  int res;
+
+  nfc_device_lock(pnd);
+  res = nfc_initiator_init_unlocked(pnd);
+  nfc_device_unlock(pnd);
+  return res;
+}
+
+static int
+nfc_initiator_init_collision_unlocked(nfc_device *pnd)
 {
   int res = 0;
   // Drop the field for a while
@@ -571,6 +625,37 @@ nfc_initiator_init_collision(nfc_device *pnd)
   HAL(initiator_init_collision, pnd);
 }
 
+/** @ingroup initiator
+ * @brief Initialize NFC device as initiator (reader) to support collision handling
+ * @return Returns 0 on success, otherwise returns libnfc's error code (negative value)
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ *
+ * The NFC device is configured to function as RFID reader.
+ * After initialization it can be used to communicate to passive RFID tags and active NFC devices.
+ * The reader will act as initiator to communicate peer 2 peer (NFCIP) to other active NFC devices.
+ * - Crc is handled by the device (NP_HANDLE_CRC = false)
+ * - Parity is handled the device (NP_HANDLE_PARITY = false)
+ * - Cryto1 cipher is disabled (NP_ACTIVATE_CRYPTO1 = false)
+ * - Easy framing is enabled (NP_EASY_FRAMING = false)
+ * - Auto-switching in ISO14443-4 mode is enabled (NP_AUTO_ISO14443_4 = false)
+ * - Invalid frames are not accepted (NP_ACCEPT_INVALID_FRAMES = true)
+ * - Multiple frames are accepted (NP_ACCEPT_MULTIPLE_FRAMES = true)
+ * - 14443-A mode is activated (NP_FORCE_ISO14443_A = true)
+ * - speed is set to 106 kbps (NP_FORCE_SPEED_106 = true)
+ * - Let the device try forever to find a target (NP_INFINITE_SELECT = false)
+ * - RF field is shortly dropped (if it was enabled) then activated again
+ */
+int
+nfc_initiator_init_collision(nfc_device *pnd)
+{
+  int res;
+
+  nfc_device_lock(pnd);
+  res = nfc_initiator_init_collision_unlocked(pnd);
+  nfc_device_unlock(pnd);
+  return res;
+}
+
 /** @ingroup initiator
  * @brief Initialize NFC device as initiator with its secure element as target (reader)
  * @return Returns 0 on success, otherwise returns libnfc's error code (negative value)
@@ -586,6 +671,35 @@ nfc_initiator_init_secure_element(nfc_device *pnd)
   HAL(initiator_init_secure_element, pnd);
 }
 
+/*
+ * Initiator data nfc_initiator_select_passive_target() gives to the driver:
+ * the default one, or pbtInitData with the UID cascaded for ISO/IEC 14443
+ * type A. pbtInit holds MAX(12, szInitData) bytes.
+ */
+int
+nfc_initiator_init_data(nfc_device *pnd, const nfc_modulation nm, const uint8_t *pbtInitData, const size_t szInitData,
+                        uint8_t *pbtInit, size_t *pszInit)
+{
+  uint8_t *abtInit = NULL;
+  int res;
+
+  if ((res = nfc_device_validate_modulation(pnd, N_INITIATOR, &nm)) != NFC_SUCCESS)
+    return res;
+  *pszInit = 0;
+  if (szInitData == 0) {
+    // Provide default values, if any
+    prepare_initiator_data(nm, &abtInit, pszInit);
+    if (*pszInit)
+      memcpy(pbtInit, abtInit, *pszInit);
+  } else if (nm.nmt == NMT_ISO14443A) {
+    iso14443_cascade_uid(pbtInitData, szInitData, pbtInit, pszInit);
+  } else {
+    memcpy(pbtInit, pbtInitData, szInitData);
+    *pszInit = szInitData;
+  }
+  return NFC_SUCCESS;
+}
+
 /** @ingroup initiator
  * @brief Select a passive or emulated tag
  * @return Returns selected passive target count on success, otherwise returns libnfc's error code (negative value)
@@ -642,26 +756,10 @@ nfc_initiator_select_passive_target(nfc_device *pnd,
   free(abtTmpInit);
 }
 
-/** @ingroup initiator
- * @brief List passive or emulated tags
- * @return Returns the number of targets found on success, otherwise returns libnfc's error code (negative value)
- *
- * @param pnd \a nfc_device struct pointer that represent currently used device
- * @param nm desired modulation
- * @param[out] ant array of \a nfc_target that will be filled with targets info
- * @param szTargets size of \a ant (will be the max targets listed)
- *
- * The NFC device will try to find the available passive tags. Some NFC devices
- * are capable to emulate passive tags. The standards (ISO18092 and ECMA-340)
- * describe the modulation that can be used for reader to passive
- * communications. The chip needs to know with what kind of tag it is dealing
- * with, therefore the initial modulation and speed (106, 212 or 424 kbps)
- * should be supplied.
- */
-int
-nfc_initiator_list_passive_targets(nfc_device *pnd,
-                                   const nfc_modulation nm,
-                                   nfc_target ant[], const size_t szTargets)
+static int
+nfc_initiator_list_passive_targets_unlocked(nfc_device *pnd,
+                                            const nfc_modulation nm,
+                                            nfc_target ant[], const size_t szTargets)
 {
   nfc_target nt;
   size_t  szTargetFound = 0;
@@ -671,6 +769,11 @@ nfc_initiator_list_passive_targets(nfc_device *pnd,
 
   pnd->last_error = 0;
 
+  // FeliCa cards can not be deselected, a time-slotted polling request lists them instead
+  if (nm.nmt == NMT_FELICA) {
+    return nfc_initiator_inventory_felica(pnd, nm.nbr, 0xffff, 16, ant, szTargets);
+  }
+
   // Let the reader only try once to find a tag
   bool bInfiniteSelect = pnd->bInfiniteSelect;
   if ((res = nfc_device_set_property_bool(pnd, NP_INFINITE_SELECT, false)) < 0) {
@@ -697,9 +800,9 @@ nfc_initiator_list_passive_targets(nfc_device *pnd,
       break;
     }
     nfc_initiator_deselect_target(pnd);
-    // deselect has no effect on FeliCa, Jewel and Thinfilm cards so we'll stop after one...
+    // deselect has no effect on Jewel and Thinfilm cards so we'll stop after one...
     // ISO/IEC 14443 B' cards are polled at 100% probability so it's not possible to detect correctly two cards at the same time
-    if ((nm.nmt == NMT_FELICA) || (nm.nmt == NMT_JEWEL) || (nm.nmt == NMT_BARCODE) ||
+    if ((nm.nmt == NMT_JEWEL) || (nm.nmt == NMT_BARCODE) ||
         (nm.nmt == NMT_ISO14443BI) || (nm.nmt == NMT_ISO14443B2SR) || (nm.nmt == NMT_ISO14443B2CT)) {
       break;
     }
@@ -712,6 +815,81 @@ nfc_initiator_list_passive_targets(nfc_device *pnd,
   return szTargetFound;
 }
 
+/** @ingroup initiator
+ * @brief List passive or emulated tags
+ * @return Returns the number of targets found on success, otherwise returns libnfc's error code (negative value)
+ *
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ * @param nm desired modulation
+ * @param[out] ant array of \a nfc_target that will be filled with targets info
+ * @param szTargets size of \a ant (will be the max targets listed)
+ *
+ * The NFC device will try to find the available passive tags. Some NFC devices
+ * are capable to emulate passive tags. The standards (ISO18092 and ECMA-340)
+ * describe the modulation that can be used for reader to passive
+ * communications. The chip needs to know with what kind of tag it is dealing
+ * with, therefore the initial modulation and speed (106, 212 or 424 kbps)
+ * should be supplied.
+ *
+ * @note FeliCa cards are listed by nfc_initiator_inventory_felica() with a
+ * 16 time slots polling request.
+ * @note nfc_initiator_inventory_iso14443b() and
+ * nfc_initiator_inventory_iso14443b2sr() list every ISO/IEC 14443 B,
+ * respectively ST SRx, tag in the field with time-slotted requests.
+ */
+int
+nfc_initiator_list_passive_targets(nfc_device *pnd,
+                                   const nfc_modulation nm,
+                                   nfc_target ant[], const size_t szTargets)
+{
+  int res;
+
+  nfc_device_lock(pnd);
+  res = nfc_initiator_list_passive_targets_unlocked(pnd, nm, ant, szTargets);
+  nfc_device_unlock(pnd);
+  return res;
+}
+
+/** @ingroup initiator
+ * @brief Select up to two passive tags at once and keep them all activated
+ * @return Returns activated passive target count on success, otherwise returns libnfc's error code (negative value)
+ *
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ * @param nm desired modulation
+ * @param pbtInitData optional initiator data, NULL for using the default values (see nfc_initiator_select_passive_target()).
+ * @param szInitData length of initiator data \a pbtInitData.
+ * @param[out] ant array of \a nfc_target that will be filled with activated targets info
+ * @param szTargets size of \a ant (PN53x chips can not keep more than two targets activated)
+ *
+ * Unlike nfc_initiator_list_passive_targets(), the targets are found within a
+ * single discovery command and remain activated afterwards: there is no need
+ * to deselect and re-select a tag to talk to it. Use
+ * nfc_initiator_transceive_bytes_target() with the index of a target in \a ant
+ * to address it. nfc_initiator_transceive_bytes() keeps on addressing the
+ * last addressed target (the first one right after this call).
+ *
+ * @note Only modulations discovered by the chip itself can be used, e.g.
+ * ISO/IEC 14443 A, ISO/IEC 14443 B and FeliCa. Jewel tags are always listed
+ * one at a time.
+ */
+int
+nfc_initiator_select_passive_targets(nfc_device *pnd,
+                                     const nfc_modulation nm,
+                                     const uint8_t *pbtInitData, const size_t szInitData,
+                                     nfc_target ant[], const size_t szTargets)
+{
+  uint8_t abtInit[64];
+  size_t  szInit = 0;
+  int res;
+  if (szInitData > sizeof(abtInit)) {
+    return pnd->last_error = NFC_EINVARG;
+  }
+  if ((res = nfc_initiator_init_data(pnd, nm, pbtInitData, szInitData, abtInit, &szInit)) < 0) {
+    return res;
+  }
+  HAL(initiator_select_passive_targets, pnd, nm, abtInit, szInit, ant, szTargets);
+}
+
 /** @ingroup initiator
  * @brief Polling for NFC targets
  * @return Returns polled targets count, otherwise returns libnfc's error code (negative value).
@@ -724,6 +902,11 @@ nfc_initiator_list_passive_targets(nfc_device *pnd,
  * @param uiPeriod indicates the polling period in units of 150 ms (0x01 – 0x0F: 150ms – 2.25s)
  * @note e.g. if uiPeriod=10, it will poll each desired target type during 1.5s
  * @param[out] pnt pointer on \a nfc_target (over)writable struct
+ * @note When the device has no hardware polling, the library polls by itself:
+ * within the time of one polling, the modulations which recently brought a
+ * target are tried first and each modulation is given a time fitted to the
+ * time its targets usually take to answer. \a NMT_DEP targets are selected in
+ * passive mode.
  */
 int
 nfc_initiator_poll_target(nfc_device *pnd,
@@ -751,6 +934,7 @@ nfc_initiator_poll_target(nfc_device *pnd,
  * to passive communications.
  *
  * @note \a nfc_dep_info will be returned when the target was acquired successfully.
+ * The link is then remembered, see nfc_initiator_dep_session_lookup().
  *
  * If timeout equals to 0, the function blocks indefinitely (until an error is raised or function is completed)
  * If timeout equals to -1, the default timeout will be used
@@ -760,32 +944,28 @@ nfc_initiator_select_dep_target(nfc_device *pnd,
                                 const nfc_dep_mode ndm, const nfc_baud_rate nbr,
                                 const nfc_dep_info *pndiInitiator, nfc_target *pnt, const int timeout)
 {
-  HAL(initiator_select_dep_target, pnd, ndm, nbr, pndiInitiator, pnt, timeout);
+  int res;
+
+  nfc_device_lock(pnd);
+  pnd->last_error = 0;
+  if (pnd->driver->initiator_select_dep_target) {
+    res = pnd->driver->initiator_select_dep_target(pnd, ndm, nbr, pndiInitiator, pnt, timeout);
+    if ((res > 0) && pnt)
+      nfc_dep_session_store(pnd, ndm, pnt);
+  } else {
+    pnd->last_error = NFC_EDEVNOTSUPP;
+    res = false;
+  }
+  nfc_device_unlock(pnd);
+  return res;
 }
 
-/** @ingroup initiator
- * @brief Poll a target and request active or passive mode for D.E.P. (Data Exchange Protocol)
- * @return Returns selected D.E.P targets count on success, otherwise returns libnfc's error code (negative value).
- *
- * @param pnd \a nfc_device struct pointer that represent currently used device
- * @param ndm desired D.E.P. mode (\a NDM_ACTIVE or \a NDM_PASSIVE for active, respectively passive mode)
- * @param nbr desired baud rate
- * @param pndiInitiator pointer \a nfc_dep_info struct that contains \e NFCID3 and \e General \e Bytes to set to the initiator device (optionnal, can be \e NULL)
- * @param[out] pnt is a \a nfc_target struct pointer where target information will be put.
- * @param timeout in milliseconds
- *
- * The NFC device will try to find an available D.E.P. target. The standards
- * (ISO18092 and ECMA-340) describe the modulation that can be used for reader
- * to passive communications.
- *
- * @note \a nfc_dep_info will be returned when the target was acquired successfully.
- */
-int
-nfc_initiator_poll_dep_target(struct nfc_device *pnd,
-                              const nfc_dep_mode ndm, const nfc_baud_rate nbr,
-                              const nfc_dep_info *pndiInitiator,
-                              nfc_target *pnt,
-                              const int timeout)
+static int
+nfc_initiator_poll_dep_target_unlocked(struct nfc_device *pnd,
+                                       const nfc_dep_mode ndm, const nfc_baud_rate nbr,
+                                       const nfc_dep_info *pndiInitiator,
+                                       nfc_target *pnt,
+                                       const int timeout)
 {
   const int period = 300;
   int remaining_time = timeout;
@@ -794,6 +974,13 @@ nfc_initiator_poll_dep_target(struct nfc_device *pnd,
   bool bInfiniteSelect = pnd->bInfiniteSelect;
   if ((res = nfc_device_set_property_bool(pnd, NP_INFINITE_SELECT, true)) < 0)
     return res;
+  // Known peers first, straight at the rate they accepted last time
+  const int64_t i64Start = nfc_monotonic_us();
+  if ((res = nfc_dep_session_resume(pnd, ndm, nbr, false, pndiInitiator, pnt, timeout)) != 0) {
+    result = res;
+    goto end;
+  }
+  remaining_time -= (int)((nfc_monotonic_us() - i64Start) / 1000);
   while (remaining_time > 0) {
     if ((res = nfc_initiator_select_dep_target(pnd, ndm, nbr, pndiInitiator, pnt, period)) < 0) {
       if (res != NFC_ETIMEOUT) {
@@ -816,6 +1003,44 @@ end:
   return result;
 }
 
+/** @ingroup initiator
+ * @brief Poll a target and request active or passive mode for D.E.P. (Data Exchange Protocol)
+ * @return Returns selected D.E.P targets count on success, otherwise returns libnfc's error code (negative value).
+ *
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ * @param ndm desired D.E.P. mode (\a NDM_ACTIVE or \a NDM_PASSIVE for active, respectively passive mode)
+ * @param nbr desired baud rate
+ * @param pndiInitiator pointer \a nfc_dep_info struct that contains \e NFCID3 and \e General \e Bytes to set to the initiator device (optionnal, can be \e NULL)
+ * @param[out] pnt is a \a nfc_target struct pointer where target information will be put.
+ * @param timeout in milliseconds
+ *
+ * The NFC device will try to find an available D.E.P. target. The standards
+ * (ISO18092 and ECMA-340) describe the modulation that can be used for reader
+ * to passive communications.
+ *
+ * When targets selected before by this device in mode \a ndm accepted \a nbr
+ * (see nfc_initiator_dep_session_lookup()), that link is tried first, directly
+ * then, above 106 kbps, by selecting the target at 106 kbps and switching it
+ * to \a nbr by PSL once recognized by its NFCID3. Then \a nbr is polled as
+ * usual. The target is always returned at \a nbr.
+ *
+ * @note \a nfc_dep_info will be returned when the target was acquired successfully.
+ */
+int
+nfc_initiator_poll_dep_target(struct nfc_device *pnd,
+                              const nfc_dep_mode ndm, const nfc_baud_rate nbr,
+                              const nfc_dep_info *pndiInitiator,
+                              nfc_target *pnt,
+                              const int timeout)
+{
+  int res;
+
+  nfc_device_lock(pnd);
+  res = nfc_initiator_poll_dep_target_unlocked(pnd, ndm, nbr, pndiInitiator, pnt, timeout);
+  nfc_device_unlock(pnd);
+  return res;
+}
+
 /** @ingroup initiator
  * @brief Deselect a selected passive or emulated tag
  * @return Returns 0 on success, otherwise returns libnfc's error code (negative value).
@@ -866,7 +1091,38 @@ int
 nfc_initiator_transceive_bytes(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, uint8_t *pbtRx,
                                const size_t szRx, int timeout)
 {
-  HAL(initiator_transceive_bytes, pnd, pbtTx, szTx, pbtRx, szRx, timeout)
+  HAL(initiator_transceive_bytes, pnd, pbtTx, szTx, pbtRx, szRx, timeout);
+}
+
+/** @ingroup initiator
+ * @brief Send data to one of the activated targets then retrieve data from it
+ * @return Returns received bytes count on success, otherwise returns libnfc's error code
+ *
+ * @param pnd \a nfc_device struct pointer that represents currently used device
+ * @param szTarget index of the addressed target in the array filled by nfc_initiator_select_passive_targets()
+ * @param pbtTx contains a byte array of the frame that needs to be transmitted.
+ * @param szTx contains the length in bytes.
+ * @param[out] pbtRx response from the target
+ * @param szRx size of \a pbtRx (Will return NFC_EOVFLOW if RX exceeds this size)
+ * @param timeout in milliseconds
+ *
+ * This function is similar to nfc_initiator_transceive_bytes() but lets the
+ * caller choose which of the targets activated by
+ * nfc_initiator_select_passive_targets() receives the frame. The addressed
+ * target becomes the current one, i.e. the one used by
+ * nfc_initiator_transceive_bytes() and nfc_initiator_target_is_present().
+ *
+ * @warning The configuration option \a NP_EASY_FRAMING must be set to \c true (the default value).
+ *
+ * If timeout equals to 0, the function blocks indefinitely (until an error is raised or function is completed)
+ * If timeout equals to -1, the default timeout will be used
+ */
+int
+nfc_initiator_transceive_bytes_target(nfc_device *pnd, const size_t szTarget,
+                                      const uint8_t *pbtTx, const size_t szTx,
+                                      uint8_t *pbtRx, const size_t szRx, int timeout)
+{
+  HAL(initiator_transceive_bytes_target, pnd, szTarget, pbtTx, szTx, pbtRx, szRx, timeout);
 }
 
 /** @ingroup initiator
@@ -966,6 +1222,55 @@ nfc_initiator_target_is_present(nfc_device *pnd, const nfc_target *pnt)
   HAL(initiator_target_is_present, pnd, pnt);
 }
 
+/** @ingroup initiator
+ * @brief Negotiate the highest bit rate supported by both the device and the selected target
+ * @return Returns 0 on success, otherwise returns libnfc's error code.
+ *
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ * @param[in,out] pnt a \a nfc_target struct pointer where desired target information was stored (optionnal, can be \e NULL), its bit rate is updated
+ *
+ * The bit rates supported by an ISO14443-4 target are read from TA(1) of its
+ * ATS, the new bit rate is then negotiated with a PPS request. The target
+ * stays at its former bit rate when it does not support any faster one or
+ * when the negotiation fails.
+ *
+ * @note Set \a NP_AUTO_PPS to negotiate the bit rate of every ISO14443-4
+ * target right after its selection.
+ * @warning The target have to be selected beforehand
+ */
+int
+nfc_initiator_target_upgrade_bit_rate(nfc_device *pnd, nfc_target *pnt)
+{
+  HAL(initiator_target_upgrade_bit_rate, pnd, pnt);
+}
+
+/** @ingroup initiator
+ * @brief Wake up and select again an ISO14443A target from its known UID
+ * @return Returns 0 on success, NFC_ETGRELEASED if the target does not answer, otherwise returns libnfc's error code.
+ *
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ * @param[in,out] pnt a \a nfc_target struct pointer where desired target information was stored (optionnal, can be \e NULL for last selected target), its SAK and bit rate are updated
+ *
+ * A halted target, or one which went back to IDLE after e.g. a failed
+ * MIFARE Classic authentication, is brought back with a WUPA and one SELECT
+ * per cascade level of its UID, skipping the anticollision loop of
+ * nfc_initiator_select_passive_target(). RATS is only sent (through a regular
+ * selection) when \a NP_AUTO_ISO14443_4 is set and the SAK announces an
+ * ISO14443-4 compliant target. CRC, parity, easy framing, forced modulation
+ * and speed settings are restored afterwards.
+ *
+ * @note A MIFARE Classic target comes back unauthenticated: its sectors have
+ * to be authenticated again. A MIFARE Classic target which is not the last
+ * one selected by this device goes through a regular selection, as the
+ * device needs to learn its UID for authentication.
+ * @warning The target has to be selected by this device beforehand
+ */
+int
+nfc_initiator_reactivate_target(nfc_device *pnd, nfc_target *pnt)
+{
+  HAL(initiator_target_reactivate, pnd, pnt);
+}
+
 /** @ingroup initiator
  * @brief Transceive raw bit-frames to a target
  * @return Returns received bits count on success, otherwise returns libnfc's error code
@@ -998,6 +1303,37 @@ nfc_initiator_transceive_bits_timed(nfc_device *pnd,
   HAL(initiator_transceive_bits_timed, pnd, pbtTx, szTxBits, pbtTxPar, pbtRx, pbtRxPar, cycles);
 }
 
+static int
+nfc_target_init_unlocked(nfc_device *pnd, nfc_target *pnt, uint8_t *pbtRx, const size_t szRx, int timeout)
+{
+  int res = 0;
+  // Disallow invalid frame
+  if ((res = nfc_device_set_property_bool(pnd, NP_ACCEPT_INVALID_FRAMES, false)) < 0)
+    return res;
+  // Disallow multiple frames
+  if ((res = nfc_device_set_property_bool(pnd, NP_ACCEPT_MULTIPLE_FRAMES, false)) < 0)
+    return res;
+  // Make sure we reset the CRC and parity to chip handling.
+  if ((res = nfc_device_set_property_bool(pnd, NP_HANDLE_CRC, true)) < 0)
+    return res;
+  if ((res = nfc_device_set_property_bool(pnd, NP_HANDLE_PARITY, true)) < 0)
+    return res;
+  // Activate auto ISO14443-4 switching by default
+  if ((res = nfc_device_set_property_bool(pnd, NP_AUTO_ISO14443_4, true)) < 0)
+    return res;
+  // Activate "easy framing" feature by default
+  if ((res = nfc_device_set_property_bool(pnd, NP_EASY_FRAMING, true)) < 0)
+    return res;
+  // Deactivate the CRYPTO1 cipher, it may could cause problems when still active
+  if ((res = nfc_device_set_property_bool(pnd, NP_ACTIVATE_CRYPTO1, false)) < 0)
+    return res;
+  // Drop explicitely the field
+  if ((res = nfc_device_set_property_bool(pnd, NP_ACTIVATE_FIELD, false)) < 0)
+    return res;
+
+  HAL(target_init, pnd, pnt, pbtRx, szRx, timeout);
+}
+
 /** @ingroup target
  * @brief Initialize NFC device as an emulated tag
  * @return Returns received bytes count on success, otherwise returns libnfc's error code
@@ -1034,32 +1370,12 @@ nfc_initiator_transceive_bits_timed(nfc_device *pnd,
 int
 nfc_target_init(nfc_device *pnd, nfc_target *pnt, uint8_t *pbtRx, const size_t szRx, int timeout)
 {
-  int res = 0;
-  // Disallow invalid frame
-  if ((res = nfc_device_set_property_bool(pnd, NP_ACCEPT_INVALID_FRAMES, false)) < 0)
-    return res;
-  // Disallow multiple frames
-  if ((res = nfc_device_set_property_bool(pnd, NP_ACCEPT_MULTIPLE_FRAMES, false)) < 0)
-    return res;
-  // Make sure we reset the CRC and parity to chip handling.
-  if ((res = nfc_device_set_property_bool(pnd, NP_HANDLE_CRC, true)) < 0)
-    return res;
-  if ((res = nfc_device_set_property_bool(pnd, NP_HANDLE_PARITY, true)) < 0)
-    return res;
-  // Activate auto ISO14443-4 switching by default
-  if ((res = nfc_device_set_property_bool(pnd, NP_AUTO_ISO14443_4, true)) < 0)
-    return res;
-  // Activate "easy framing" feature by default
-  if ((res = nfc_device_set_property_bool(pnd, NP_EASY_FRAMING, true)) < 0)
-    return res;
-  // Deactivate the CRYPTO1 cipher, it may could cause problems when still active
-  if ((res = nfc_device_set_property_bool(pnd, NP_ACTIVATE_CRYPTO1, false)) < 0)
-    return res;
-  // Drop explicitely the field
-  if ((res = nfc_device_set_property_bool(pnd, NP_ACTIVATE_FIELD, false)) < 0)
-    return res;
+  int res;
 
-  HAL(target_init, pnd, pnt, pbtRx, szRx, timeout);
+  nfc_device_lock(pnd);
+  res = nfc_target_init_unlocked(pnd, pnt, pbtRx, szRx, timeout);
+  nfc_device_unlock(pnd);
+  return res;
 }
 
 /** @ingroup dev
@@ -1088,11 +1404,16 @@ nfc_idle(nfc_device *pnd)
  * This function attempt to abort the current running command.
  *
  * @note The blocking function (ie. nfc_target_init()) will failed with DEABORT error.
+ * @note A submitted command (see nfc_initiator_transceive_bytes_submit()) which is running is aborted too: its callback gets \a NFC_EOPABORTED.
+ * @note Unlike other functions, this one does not wait for the device lock.
  */
 int
 nfc_abort_command(nfc_device *pnd)
 {
-  HAL(abort_command, pnd);
+  // A submitted command is given up by its driver, see nfc-async.c
+  if (nfc_async_cancel(pnd))
+    return NFC_SUCCESS;
+  HAL_UNLOCKED(abort_command, pnd);
 }
 
 /** @ingroup target
@@ -1116,6 +1437,32 @@ nfc_target_send_bytes(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx,
   HAL(target_send_bytes, pnd, pbtTx, szTx, timeout);
 }
 
+/** @ingroup target
+ * @brief Send the first part of an answer whose end is not known yet
+ * @return Returns sent bytes count on success, otherwise returns libnfc's error code
+ *
+ * @param pnd \a nfc_device struct pointer that represent currently used device
+ * @param pbtTx pointer to Tx buffer
+ * @param szTx size of Tx buffer
+ * @param timeout in milliseconds
+ *
+ * Like nfc_target_send_bytes(), but the frames are chained (ISO/IEC 14443-4
+ * or NFCIP-1 MI bit): the \e initiator waits for the rest of the answer,
+ * sent by further calls to this function and ended by nfc_target_send_bytes().
+ * This lets an answer longer than the host buffers (e.g. an extended length
+ * R-APDU) be produced piece by piece.
+ *
+ * If the \e target does not use a chaining protocol, NFC_EDEVNOTSUPP is returned.
+ *
+ * If timeout equals to 0, the function blocks indefinitely (until an error is raised or function is completed)
+ * If timeout equals to -1, the default timeout will be used
+ */
+int
+nfc_target_send_bytes_chained(nfc_device *pnd, const uint8_t *pbtTx, const size_t szTx, int timeout)
+{
+  HAL(target_send_bytes_chained, pnd, pbtTx, szTx, timeout);
+}
+
 /** @ingroup target
  * @brief Receive bytes and APDU frames
  * @return Returns received bytes count on success, otherwise returns libnfc's error code
@@ -1,8 +1,10 @@
 #include <cutter.h>
+#include <pthread.h>
 
 #include <nfc/nfc.h>
 
 #define NTESTS 10
+#define NTHREADS 4
 #define MAX_DEVICE_COUNT 8
 #define MAX_TARGET_COUNT 8
 
@@ -11,6 +13,14 @@
  * inconsistent state after use.
  */
 void test_access_storm(void);
+void test_access_storm_contexts(void);
+void test_access_storm_shared_device(void);
+
+struct thread_data {
+  void *cut_test_context;
+  size_t ref_device_count;
+  nfc_device *device;
+};
 
 void
 test_access_storm(void)
@@ -23,8 +33,10 @@ test_access_storm(void)
   nfc_init(&context);
 
   size_t ref_device_count = nfc_list_devices(context, connstrings, MAX_DEVICE_COUNT);
-  if (!ref_device_count)
+  if (!ref_device_count) {
+    nfc_exit(context);
     cut_omit("No NFC device found");
+  }
 
   while (n) {
     size_t device_count = nfc_list_devices(context, connstrings, MAX_DEVICE_COUNT);
@@ -54,3 +66,121 @@ test_access_storm(void)
   }
   nfc_exit(context);
 }
+
+static void *
+contexts_thread(void *arg)
+{
+  struct thread_data *thread_data = (struct thread_data *) arg;
+  nfc_connstring connstrings[MAX_DEVICE_COUNT];
+
+  cut_set_current_test_context(thread_data->cut_test_context);
+
+  for (int n = 0; n < NTESTS; n++) {
+    nfc_context *context;
+    nfc_init(&context);
+    cut_assert_not_null(context, cut_message("nfc_init"));
+
+    size_t device_count = nfc_list_devices(context, connstrings, MAX_DEVICE_COUNT);
+    // Devices claimed by another thread may be hidden to this one
+    cut_assert_operator_int(device_count, <=, thread_data->ref_device_count, cut_message("device count"));
+
+    nfc_exit(context);
+  }
+  return (void *) 0;
+}
+
+/*
+ * Independent contexts are created, scanned and released concurrently.
+ */
+void
+test_access_storm_contexts(void)
+{
+  pthread_t threads[NTHREADS];
+  struct thread_data thread_data;
+  nfc_connstring connstrings[MAX_DEVICE_COUNT];
+  int res;
+
+  nfc_context *context;
+  nfc_init(&context);
+
+  thread_data.cut_test_context = cut_get_current_test_context();
+  thread_data.ref_device_count = nfc_list_devices(context, connstrings, MAX_DEVICE_COUNT);
+  thread_data.device = NULL;
+  if (!thread_data.ref_device_count) {
+    nfc_exit(context);
+    cut_omit("No NFC device found");
+  }
+
+  for (int i = 0; i < NTHREADS; i++) {
+    if ((res = pthread_create(&(threads[i]), NULL, contexts_thread, &thread_data)))
+      cut_fail("pthread_create() returned %d", res);
+  }
+  for (int i = 0; i < NTHREADS; i++) {
+    if ((res = pthread_join(threads[i], NULL)))
+      cut_fail("pthread_join() returned %d", res);
+  }
+
+  // This context outlived the others: its drivers must still be there
+  size_t device_count = nfc_list_devices(context, connstrings, MAX_DEVICE_COUNT);
+  cut_assert_equal_int(thread_data.ref_device_count, device_count, cut_message("device count"));
+
+  nfc_exit(context);
+}
+
+static void *
+shared_device_thread(void *arg)
+{
+  struct thread_data *thread_data = (struct thread_data *) arg;
+  nfc_target ant[MAX_TARGET_COUNT];
+  const nfc_modulation nm = {
+    .nmt = NMT_ISO14443A,
+    .nbr = NBR_106,
+  };
+
+  cut_set_current_test_context(thread_data->cut_test_context);
+
+  for (int n = 0; n < NTESTS; n++) {
+    int res = nfc_initiator_list_passive_targets(thread_data->device, nm, ant, MAX_TARGET_COUNT);
+    cut_assert_operator_int(res, >=, 0, cut_message("nfc_initiator_list_passive_targets"));
+  }
+  return (void *) 0;
+}
+
+/*
+ * Several threads use the same device: operations must not interleave.
+ */
+void
+test_access_storm_shared_device(void)
+{
+  pthread_t threads[NTHREADS];
+  struct thread_data thread_data;
+  nfc_connstring connstrings[MAX_DEVICE_COUNT];
+  int res;
+
+  nfc_context *context;
+  nfc_init(&context);
+
+  if (!nfc_list_devices(context, connstrings, MAX_DEVICE_COUNT)) {
+    nfc_exit(context);
+    cut_omit("No NFC device found");
+  }
+
+  thread_data.cut_test_context = cut_get_current_test_context();
+  thread_data.device = nfc_open(context, connstrings[0]);
+  cut_assert_not_null(thread_data.device, cut_message("nfc_open"));
+
+  res = nfc_initiator_init(thread_data.device);
+  cut_assert_equal_int(0, res, cut_message("nfc_initiator_init"));
+
+  for (int i = 0; i < NTHREADS; i++) {
+    if ((res = pthread_create(&(threads[i]), NULL, shared_device_thread, &thread_data)))
+      cut_fail("pthread_create() returned %d", res);
+  }
+  for (int i = 0; i < NTHREADS; i++) {
+    if ((res = pthread_join(threads[i], NULL)))
+      cut_fail("pthread_join() returned %d", res);
+  }
+
+  nfc_close(thread_data.device);
+  nfc_exit(context);
+}
@@ -61,6 +61,11 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#ifndef _WIN32
+#  include <sys/mman.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
 
 #include <errno.h>
 #include <signal.h>
@@ -85,9 +90,22 @@ static int type4v = 2;
 
 typedef enum { NONE, CC_FILE, NDEF_FILE } file;
 
+// NDEF file: NLEN (2 bytes) then the NDEF message
+#define NDEF_FILE_MAX_LEN 0xFFFE
+// Flush the store to disk at least every NDEF_STORE_SYNC_UPDATES UPDATE BINARY
+#define NDEF_STORE_SYNC_UPDATES 16
+
 struct nfcforum_tag4_ndef_data {
   uint8_t *ndef_file;
   size_t   ndef_file_len;
+  // Size of the NDEF file, i.e. the Maximum NDEF Size of the tag
+  size_t   ndef_file_max_len;
+  // Whether ndef_file is mapped from a store file
+  bool     mapped;
+  // Part of the mapping written since the last flush
+  size_t   dirty_start;
+  size_t   dirty_end;
+  int      dirty_updates;
 };
 
 struct nfcforum_tag4_state_machine_data {
@@ -122,6 +140,39 @@ uint8_t nfcforum_capability_container[] = {
 
 #define ISO144434A_RATS 0xE0
 
+static void
+ndef_store_sync(struct nfcforum_tag4_ndef_data *ndef_data, bool wait)
+{
+#ifndef _WIN32
+  if (!ndef_data->mapped || (ndef_data->dirty_start >= ndef_data->dirty_end))
+    return;
+  // msync() wants a page aligned address
+  const size_t page_size = sysconf(_SC_PAGESIZE);
+  const size_t start = ndef_data->dirty_start - (ndef_data->dirty_start % page_size);
+  if (msync(ndef_data->ndef_file + start, ndef_data->dirty_end - start, wait ? MS_SYNC : MS_ASYNC) < 0)
+    ERR("msync: %s", strerror(errno));
+  ndef_data->dirty_start = ndef_data->ndef_file_max_len;
+  ndef_data->dirty_end = 0;
+  ndef_data->dirty_updates = 0;
+#else
+  (void) ndef_data;
+  (void) wait;
+#endif
+}
+
+static void
+ndef_store_update(struct nfcforum_tag4_ndef_data *ndef_data, const size_t offset, const uint8_t *data, const size_t len)
+{
+  memcpy(ndef_data->ndef_file + offset, data, len);
+  if (offset < ndef_data->dirty_start)
+    ndef_data->dirty_start = offset;
+  if (offset + len > ndef_data->dirty_end)
+    ndef_data->dirty_end = offset + len;
+  // Writers end an NDEF update with NLEN: flush once the message is complete
+  if ((offset < 2) || (++ndef_data->dirty_updates >= NDEF_STORE_SYNC_UPDATES))
+    ndef_store_sync(ndef_data, false);
+}
+
 static int
 nfcforum_tag4_io(struct nfc_emulator *emulator, const uint8_t *data_in, const size_t data_in_len, uint8_t *data_out, const size_t data_out_len)
 {
@@ -190,34 +241,55 @@ nfcforum_tag4_io(struct nfc_emulator *emulator, const uint8_t *data_in, const si
         }
 
         break;
-      case ISO7816_READ_BINARY:
-        if ((size_t)(data_in[LC] + 2) > data_out_len) {
+      case ISO7816_READ_BINARY: {
+        if ((data_in_len < 5) || ((size_t)(data_in[LC] + 2) > data_out_len)) {
           return -ENOSPC;
         }
+        const size_t offset = (data_in[P1] << 8) + data_in[P2];
         switch (state_machine_data->current_file) {
           case NONE:
             memcpy(data_out, "\x6a\x82", res = 2);
             break;
           case CC_FILE:
-            memcpy(data_out, nfcforum_capability_container + (data_in[P1] << 8) + data_in[P2], data_in[LC]);
+            if (offset + data_in[LC] > sizeof(nfcforum_capability_container)) {
+              memcpy(data_out, "\x6b\x00", res = 2);
+              break;
+            }
+            memcpy(data_out, nfcforum_capability_container + offset, data_in[LC]);
             memcpy(data_out + data_in[LC], "\x90\x00", 2);
             res = data_in[LC] + 2;
             break;
           case NDEF_FILE:
-            memcpy(data_out, ndef_data->ndef_file + (data_in[P1] << 8) + data_in[P2], data_in[LC]);
+            if (offset + data_in[LC] > ndef_data->ndef_file_max_len) {
+              memcpy(data_out, "\x6b\x00", res = 2);
+              break;
+            }
+            // Straight from the store
+            memcpy(data_out, ndef_data->ndef_file + offset, data_in[LC]);
             memcpy(data_out + data_in[LC], "\x90\x00", 2);
             res = data_in[LC] + 2;
             break;
         }
         break;
+      }
 
-      case ISO7816_UPDATE_BINARY:
-        memcpy(ndef_data->ndef_file + (data_in[P1] << 8) + data_in[P2], data_in + DATA, data_in[LC]);
-        if ((data_in[P1] << 8) + data_in[P2] == 0) {
-          ndef_data->ndef_file_len = (ndef_data->ndef_file[0] << 8) + ndef_data->ndef_file[1] + 2;
+      case ISO7816_UPDATE_BINARY: {
+        const size_t offset = (data_in[P1] << 8) + data_in[P2];
+        if ((data_in_len < 5) || (data_in_len < (size_t)(DATA + data_in[LC]))) {
+          return -ENOTSUP;
+        }
+        if ((state_machine_data->current_file != NDEF_FILE) || (offset + data_in[LC] > ndef_data->ndef_file_max_len)) {
+          memcpy(data_out, "\x6b\x00", res = 2);
+          break;
+        }
+        ndef_store_update(ndef_data, offset, data_in + DATA, data_in[LC]);
+        if (offset < 2) {
+          // NLEN comes from the reader, never let it reach past the file
+          ndef_data->ndef_file_len = MIN((size_t)((ndef_data->ndef_file[0] << 8) + ndef_data->ndef_file[1] + 2), ndef_data->ndef_file_max_len);
         }
         memcpy(data_out, "\x90\x00", res = 2);
         break;
+      }
       default: // Unknown
         if (!quiet_output) {
           printf("Unknown frame, emulated target abort.\n");
@@ -267,7 +339,7 @@ ndef_message_load(char *filename, struct nfcforum_tag4_ndef_data *tag_data)
   }
 
   /* Check file size */
-  if (sb.st_size > 0xFFFF) {
+  if ((size_t) sb.st_size > tag_data->ndef_file_max_len - 2) {
     printf("File size too large '%s'\n", filename);
     fclose(F);
     return -1;
@@ -286,9 +358,79 @@ ndef_message_load(char *filename, struct nfcforum_tag4_ndef_data *tag_data)
   }
 
   fclose(F);
+  tag_data->dirty_start = 0;
+  tag_data->dirty_end = tag_data->ndef_file_len;
+  ndef_store_sync(tag_data, true);
   return sb.st_size;
 }
 
+/*
+ * The NDEF file (NLEN included) is mapped from the store file, so UPDATE
+ * BINARY writes it in place and a killed emulation loses nothing. The size of
+ * the store is the size of the emulated tag; a new store gets the largest one.
+ */
+static int
+ndef_store_open(const char *filename, struct nfcforum_tag4_ndef_data *tag_data, bool *created)
+{
+#ifndef _WIN32
+  struct stat sb;
+  int fd;
+  if ((fd = open(filename, O_RDWR | O_CREAT, 0644)) < 0) {
+    printf("Can't open NDEF store '%s': %s\n", filename, strerror(errno));
+    return -1;
+  }
+  if (fstat(fd, &sb) < 0) {
+    printf("Can't stat NDEF store '%s': %s\n", filename, strerror(errno));
+    close(fd);
+    return -1;
+  }
+  *created = (sb.st_size == 0);
+  if (*created) {
+    sb.st_size = NDEF_FILE_MAX_LEN;
+    if (ftruncate(fd, sb.st_size) < 0) {
+      printf("Can't size NDEF store '%s': %s\n", filename, strerror(errno));
+      close(fd);
+      return -1;
+    }
+  }
+  if ((sb.st_size < 3) || (sb.st_size > NDEF_FILE_MAX_LEN)) {
+    printf("Invalid NDEF store size '%s'\n", filename);
+    close(fd);
+    return -1;
+  }
+  void *map = mmap(NULL, sb.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    printf("Can't map NDEF store '%s': %s\n", filename, strerror(errno));
+    return -1;
+  }
+  tag_data->ndef_file = map;
+  tag_data->ndef_file_max_len = sb.st_size;
+  tag_data->ndef_file_len = MIN((size_t)((tag_data->ndef_file[0] << 8) + tag_data->ndef_file[1] + 2), tag_data->ndef_file_max_len);
+  tag_data->mapped = true;
+  tag_data->dirty_start = tag_data->ndef_file_max_len;
+  tag_data->dirty_end = 0;
+  return 0;
+#else
+  (void) tag_data;
+  (void) created;
+  printf("NDEF store '%s' not supported on this platform\n", filename);
+  return -1;
+#endif
+}
+
+static void
+ndef_store_close(struct nfcforum_tag4_ndef_data *tag_data)
+{
+  ndef_store_sync(tag_data, true);
+#ifndef _WIN32
+  if (tag_data->mapped) {
+    munmap(tag_data->ndef_file, tag_data->ndef_file_max_len);
+    tag_data->mapped = false;
+  }
+#endif
+}
+
 static int
 ndef_message_save(char *filename, struct nfcforum_tag4_ndef_data *tag_data)
 {
@@ -311,8 +453,9 @@ ndef_message_save(char *filename, struct nfcforum_tag4_ndef_data *tag_data)
 static void
 usage(char *progname)
 {
-  fprintf(stderr, "usage: %s [-1] [infile [outfile]]\n", progname);
+  fprintf(stderr, "usage: %s [-1] [-m store] [infile [outfile]]\n", progname);
   fprintf(stderr, "      -1: force Tag Type 4 v1.0 (default is v2.0)\n");
+  fprintf(stderr, "      -m: keep the NDEF file in store, updated in place (created if needed)\n");
 }
 
 int
@@ -336,17 +479,20 @@ main(int argc, char *argv[])
     },
   };
 
-  uint8_t ndef_file[0xfffe] = {
+  static uint8_t ndef_file[NDEF_FILE_MAX_LEN] = {
     0x00, 33,
     0xd1, 0x02, 0x1c, 0x53, 0x70, 0x91, 0x01, 0x09, 0x54, 0x02,
     0x65, 0x6e, 0x4c, 0x69, 0x62, 0x6e, 0x66, 0x63, 0x51, 0x01,
     0x0b, 0x55, 0x03, 0x6c, 0x69, 0x62, 0x6e, 0x66, 0x63, 0x2e,
     0x6f, 0x72, 0x67
   };
+  const char *store = NULL;
+  bool store_created = false;
 
   struct nfcforum_tag4_ndef_data nfcforum_tag4_data = {
     .ndef_file = ndef_file,
     .ndef_file_len = ndef_file[1] + 2,
+    .ndef_file_max_len = sizeof(ndef_file),
   };
 
   struct nfcforum_tag4_state_machine_data state_machine_data = {
@@ -375,15 +521,34 @@ main(int argc, char *argv[])
     options += 1;
   }
 
+  if ((argc > (2 + options)) && (0 == strcmp("-m", argv[1 + options]))) {
+    store = argv[2 + options];
+    options += 2;
+  }
+
   if (argc > (3 + options)) {
     usage(argv[0]);
     exit(EXIT_FAILURE);
   }
 
+  if (store) {
+    if (ndef_store_open(store, &nfcforum_tag4_data, &store_created) < 0)
+      exit(EXIT_FAILURE);
+    // A new store starts with the default NDEF message
+    if (store_created && (argc < (2 + options))) {
+      ndef_store_update(&nfcforum_tag4_data, 0, ndef_file, ndef_file[1] + 2);
+      nfcforum_tag4_data.ndef_file_len = ndef_file[1] + 2;
+    }
+  }
+  // Maximum NDEF Size of the emulated tag
+  nfcforum_capability_container[11] = (uint8_t)(nfcforum_tag4_data.ndef_file_max_len >> 8);
+  nfcforum_capability_container[12] = (uint8_t)(nfcforum_tag4_data.ndef_file_max_len);
+
   // If some file is provided load it
   if (argc >= (2 + options)) {
     if (ndef_message_load(argv[1 + options], &nfcforum_tag4_data) < 0) {
       printf("Can't load NDEF file '%s'\n", argv[1 + options]);
+      ndef_store_close(&nfcforum_tag4_data);
       exit(EXIT_FAILURE);
     }
   }
@@ -391,6 +556,7 @@ main(int argc, char *argv[])
   nfc_init(&context);
   if (context == NULL) {
     ERR("Unable to init libnfc (malloc)\n");
+    ndef_store_close(&nfcforum_tag4_data);
     exit(EXIT_FAILURE);
   }
 
@@ -399,6 +565,7 @@ main(int argc, char *argv[])
 
   if (pnd == NULL) {
     ERR("Unable to open NFC device");
+    ndef_store_close(&nfcforum_tag4_data);
     nfc_exit(context);
     exit(EXIT_FAILURE);
   }
@@ -410,6 +577,7 @@ main(int argc, char *argv[])
 
   if (0 != nfc_emulate_target(pnd, &emulator, 0)) {  // contains already nfc_target_init() call
     nfc_perror(pnd, "nfc_emulate_target");
+    ndef_store_close(&nfcforum_tag4_data);
     nfc_close(pnd);
     nfc_exit(context);
     exit(EXIT_FAILURE);
@@ -418,12 +586,14 @@ main(int argc, char *argv[])
   if (argc == (3 + options)) {
     if (ndef_message_save(argv[2 + options], &nfcforum_tag4_data) < 0) {
       printf("Can't save NDEF file '%s'", argv[2 + options]);
+      ndef_store_close(&nfcforum_tag4_data);
       nfc_close(pnd);
       nfc_exit(context);
       exit(EXIT_FAILURE);
     }
   }
 
+  ndef_store_close(&nfcforum_tag4_data);
   nfc_close(pnd);
   nfc_exit(context);
   exit(EXIT_SUCCESS);
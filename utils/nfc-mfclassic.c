@@ -227,7 +227,7 @@ authenticate(uint32_t uiBlock)
           memcpy(mtKeys.amb[uiBlock].mbt.abtKeyB, &mp.mpa.abtKey, sizeof(mtKeys.amb[uiBlock].mbt.abtKeyB));
         return true;
       }
-      if (nfc_initiator_select_passive_target(pnd, nmMifare, nt.nti.nai.abtUid, nt.nti.nai.szUidLen, NULL) <= 0) {
+      if (nfc_initiator_reactivate_target(pnd, &nt) < 0) {
         ERR("tag was removed");
         return false;
       }
@@ -0,0 +1,844 @@
+/*-
+ * Free/Libre Near Field Communication (NFC) library
+ *
+ * Libnfc historical contributors:
+ * Copyright (C) 2009      Roel Verdult
+ * Copyright (C) 2009-2013 Romuald Conty
+ * Copyright (C) 2010-2012 Romain Tartière
+ * Copyright (C) 2010-2013 Philippe Teuwen
+ * Copyright (C) 2012-2013 Ludovic Rousseau
+ * See AUTHORS file for a more comprehensive list of contributors.
+ * Additional contributors of this file:
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  1) Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  2 )Redistributions in binary form must reproduce the above copyright
+ *  notice, this list of conditions and the following disclaimer in the
+ *  documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Note that this license only applies on the examples, NFC library itself is under LGPL
+ *
+ */
+
+/**
+ * @file nfcd.c
+ * @brief Daemon sharing local NFC devices with several processes
+ *
+ * nfcd opens the given devices once and serves them on a Unix socket to the
+ * "nfcd" driver of libnfc, so any libnfc application can use a device opened
+ * by another process with a connstring like nfcd:/var/run/nfcd.sock:0.
+ * Each client connection is served by a thread of its own.
+ *
+ * Clients share a device until one of them successfully selects a target or
+ * starts emulating one: from then on its session is exclusive, others wait
+ * until the owner deselects the target, puts the device to idle, disconnects
+ * or leaves the device unused for longer than the idle timeout.
+ */
+
+// For struct ucred
+#define _GNU_SOURCE
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+#include <nfc/nfc.h>
+
+#include "libnfc/drivers/nfcd.h"
+#include "nfc-utils.h"
+
+#define MAX_DEVICE_COUNT 16
+
+// Default time (in s) after which an unused reservation is given up
+#define NFCD_DEFAULT_IDLE_TIMEOUT 10
+
+struct nfcd_device {
+  nfc_device *pnd;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  // Session the device is reserved to, if any
+  struct nfcd_session *pOwner;
+  // Whether the owner is running a request, and when it ended its last one
+  bool bOwnerBusy;
+  struct timespec tsOwnerLastUse;
+};
+
+struct nfcd_session {
+  int iSocket;
+  // Process which opened the session, the only one allowed to abort it
+  pid_t pidPeer;
+  int32_t iCookie;
+  struct nfcd_device *pDevice;
+  uint8_t *pbtShm;
+  uint32_t uiRxHead;
+  struct nfcd_session *pNext;
+};
+
+static struct nfcd_device aDevices[MAX_DEVICE_COUNT];
+static size_t szDevices;
+
+static struct nfcd_session *pSessions;
+static size_t szSessions;
+static int iIdleTimeout = NFCD_DEFAULT_IDLE_TIMEOUT;
+static pthread_mutex_t sessions_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sessions_cond = PTHREAD_COND_INITIALIZER;
+
+static volatile sig_atomic_t quitting = 0;
+
+static void
+stop_daemon(int sig)
+{
+  (void) sig;
+  quitting = 1;
+}
+
+static int
+write_all(int fd, const void *pData, size_t szData)
+{
+  const uint8_t *pbt = pData;
+  while (szData > 0) {
+    ssize_t res = send(fd, pbt, szData, MSG_NOSIGNAL);
+    if (res < 0) {
+      if (errno == EINTR)
+        continue;
+      return -1;
+    }
+    pbt += res;
+    szData -= res;
+  }
+  return 0;
+}
+
+static int
+read_all(int fd, void *pData, size_t szData)
+{
+  uint8_t *pbt = pData;
+  while (szData > 0) {
+    ssize_t res = recv(fd, pbt, szData, 0);
+    if (res < 0) {
+      if ((errno == EINTR) && !quitting)
+        continue;
+      return -1;
+    }
+    if (res == 0)
+      return -1;
+    pbt += res;
+    szData -= res;
+  }
+  return 0;
+}
+
+static int
+send_with_fd(int fd, const struct nfcd_response *pRes, int iFd)
+{
+  union {
+    struct cmsghdr hdr;
+    uint8_t abt[CMSG_SPACE(sizeof(int))];
+  } control;
+  struct iovec iov = { .iov_base = (void *)pRes, .iov_len = sizeof(*pRes) };
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  memset(&control, 0, sizeof(control));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.abt;
+  msg.msg_controllen = sizeof(control.abt);
+  struct cmsghdr *pcmsg = CMSG_FIRSTHDR(&msg);
+  pcmsg->cmsg_level = SOL_SOCKET;
+  pcmsg->cmsg_type = SCM_RIGHTS;
+  pcmsg->cmsg_len = CMSG_LEN(sizeof(int));
+  memcpy(CMSG_DATA(pcmsg), &iFd, sizeof(int));
+  ssize_t res = sendmsg(fd, &msg, MSG_NOSIGNAL);
+  if (res < 0)
+    return -1;
+  // Ancillary data went with the first byte, the rest is plain data
+  return write_all(fd, (const uint8_t *)pRes + res, sizeof(*pRes) - res);
+}
+
+// Create the shared memory segment of a new session
+static uint8_t *
+shm_create(int *piFd)
+{
+  static int iCounter = 0;
+  char acName[64];
+  int fd;
+  do {
+    snprintf(acName, sizeof(acName), "/nfcd-%ld-%d", (long) getpid(), __atomic_fetch_add(&iCounter, 1, __ATOMIC_RELAXED));
+    fd = shm_open(acName, O_RDWR | O_CREAT | O_EXCL, 0600);
+  } while ((fd < 0) && (errno == EEXIST));
+  if (fd < 0)
+    return NULL;
+  shm_unlink(acName);
+  if (ftruncate(fd, NFCD_SHM_SIZE) < 0) {
+    close(fd);
+    return NULL;
+  }
+  void *p = mmap(NULL, NFCD_SHM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED) {
+    close(fd);
+    return NULL;
+  }
+  *piFd = fd;
+  return p;
+}
+
+// Reserve room for an answer in the daemon ring
+static uint8_t *
+rx_reserve(struct nfcd_session *pSession, const size_t szData, struct nfcd_response *pRes)
+{
+  if (szData > NFCD_RING_SIZE)
+    return NULL;
+  if (pSession->uiRxHead + szData > NFCD_RING_SIZE)
+    pSession->uiRxHead = 0;
+  pRes->uiRxOffset = pSession->uiRxHead;
+  pSession->uiRxHead += szData;
+  return NFCD_RX_RING(pSession->pbtShm) + pRes->uiRxOffset;
+}
+
+// Operations which reserve the device to the session when they succeed
+static bool
+op_reserves_device(const nfcd_op op)
+{
+  switch (op) {
+    case NFCD_OP_INITIATOR_SELECT_PASSIVE_TARGET:
+    case NFCD_OP_INITIATOR_SELECT_PASSIVE_TARGETS:
+    case NFCD_OP_INITIATOR_POLL_TARGET:
+    case NFCD_OP_INITIATOR_SELECT_DEP_TARGET:
+    case NFCD_OP_INITIATOR_TARGET_REACTIVATE:
+    case NFCD_OP_TARGET_INIT:
+      return true;
+    default:
+      return false;
+  }
+}
+
+static bool
+op_releases_device(const nfcd_op op)
+{
+  return (op == NFCD_OP_INITIATOR_DESELECT_TARGET) || (op == NFCD_OP_IDLE);
+}
+
+// Whether the reservation of the device has not been used for iIdleTimeout
+static bool
+device_owner_idle(const struct nfcd_device *pDevice, const struct timespec *ptsNow)
+{
+  if (pDevice->bOwnerBusy || (iIdleTimeout <= 0))
+    return false;
+  return (ptsNow->tv_sec - pDevice->tsOwnerLastUse.tv_sec > iIdleTimeout) ||
+         ((ptsNow->tv_sec - pDevice->tsOwnerLastUse.tv_sec == iIdleTimeout) &&
+          (ptsNow->tv_nsec >= pDevice->tsOwnerLastUse.tv_nsec));
+}
+
+// Wait for the device to be free for the session: a request which may
+// reserve it claims it before running
+static void
+device_acquire(struct nfcd_session *pSession, const nfcd_op op)
+{
+  struct nfcd_device *pDevice = pSession->pDevice;
+  struct timespec ts;
+  pthread_mutex_lock(&pDevice->mutex);
+  while (pDevice->pOwner && (pDevice->pOwner != pSession) && !quitting) {
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    if (device_owner_idle(pDevice, &ts)) {
+      pDevice->pOwner = NULL;
+      break;
+    }
+    if (pDevice->bOwnerBusy || (iIdleTimeout <= 0)) {
+      pthread_cond_wait(&pDevice->cond, &pDevice->mutex);
+    } else {
+      ts = pDevice->tsOwnerLastUse;
+      ts.tv_sec += iIdleTimeout;
+      pthread_cond_timedwait(&pDevice->cond, &pDevice->mutex, &ts);
+    }
+  }
+  if (!pDevice->pOwner && op_reserves_device(op))
+    pDevice->pOwner = pSession;
+  if (pDevice->pOwner == pSession)
+    pDevice->bOwnerBusy = true;
+  pthread_mutex_unlock(&pDevice->mutex);
+}
+
+// Update the reservation of the device once a request has been run
+static void
+device_done(struct nfcd_session *pSession, const nfcd_op op, const int iRes)
+{
+  struct nfcd_device *pDevice = pSession->pDevice;
+  // Selections return the number of targets found, reactivation 0 and
+  // target init the size of the first frame on success
+  const bool bSelected = ((op == NFCD_OP_TARGET_INIT) || (op == NFCD_OP_INITIATOR_TARGET_REACTIVATE)) ? (iRes >= 0) : (iRes > 0);
+  pthread_mutex_lock(&pDevice->mutex);
+  if (op_releases_device(op) || (op_reserves_device(op) && !bSelected)) {
+    // No target left to talk to
+    if (pDevice->pOwner == pSession) {
+      pDevice->pOwner = NULL;
+      pDevice->bOwnerBusy = false;
+    }
+  }
+  if (pDevice->pOwner == pSession) {
+    pDevice->bOwnerBusy = false;
+    clock_gettime(CLOCK_MONOTONIC, &pDevice->tsOwnerLastUse);
+  }
+  pthread_cond_broadcast(&pDevice->cond);
+  pthread_mutex_unlock(&pDevice->mutex);
+}
+
+static void
+device_release(struct nfcd_session *pSession)
+{
+  struct nfcd_device *pDevice = pSession->pDevice;
+  pthread_mutex_lock(&pDevice->mutex);
+  if (pDevice->pOwner == pSession) {
+    pDevice->pOwner = NULL;
+    pDevice->bOwnerBusy = false;
+    pthread_cond_broadcast(&pDevice->cond);
+  }
+  pthread_mutex_unlock(&pDevice->mutex);
+}
+
+static int
+run_request(struct nfcd_session *pSession, const struct nfcd_request *pReq, struct nfcd_response *pRes)
+{
+  nfc_device *pnd = pSession->pDevice->pnd;
+  const uint8_t *pbtTx = NFCD_TX_RING(pSession->pbtShm) + pReq->uiTxOffset;
+  const size_t szTx = pReq->uiTxLen;
+  const size_t szRx = pReq->uiRxLen;
+  uint8_t *pbtRx = NULL;
+  nfc_target nt;
+  nfc_target *pnt = NULL;
+  uint32_t cycles;
+  int res;
+
+  if ((pReq->uiTxOffset > NFCD_RING_SIZE) || (szTx > NFCD_RING_SIZE - pReq->uiTxOffset))
+    return NFC_EINVARG;
+
+  switch (pReq->uiOp) {
+    case NFCD_OP_INITIATOR_INIT:
+      return nfc_initiator_init(pnd);
+    case NFCD_OP_INITIATOR_INIT_COLLISION:
+      return nfc_initiator_init_collision(pnd);
+    case NFCD_OP_INITIATOR_INIT_SECURE_ELEMENT:
+      return nfc_initiator_init_secure_element(pnd);
+    case NFCD_OP_INITIATOR_DESELECT_TARGET:
+      return nfc_initiator_deselect_target(pnd);
+    case NFCD_OP_IDLE:
+      return nfc_idle(pnd);
+
+    case NFCD_OP_INITIATOR_SELECT_PASSIVE_TARGET: {
+      const nfc_modulation nm = { .nmt = pReq->aiArgs[0], .nbr = pReq->aiArgs[1] };
+      res = nfc_initiator_select_passive_target(pnd, nm, szTx ? pbtTx : NULL, szTx, pReq->aiArgs[2] ? &nt : NULL);
+      if ((res > 0) && pReq->aiArgs[2])
+        memcpy(pRes->abtArg, &nt, sizeof(nt));
+      return res;
+    }
+    case NFCD_OP_INITIATOR_SELECT_PASSIVE_TARGETS: {
+      const nfc_modulation nm = { .nmt = pReq->aiArgs[0], .nbr = pReq->aiArgs[1] };
+      if (!(pbtRx = rx_reserve(pSession, szRx, pRes)))
+        return NFC_EINVARG;
+      res = nfc_initiator_select_passive_targets(pnd, nm, szTx ? pbtTx : NULL, szTx, (nfc_target *)pbtRx, szRx / sizeof(nfc_target));
+      pRes->uiRxLen = (res > 0) ? res * sizeof(nfc_target) : 0;
+      return res;
+    }
+    case NFCD_OP_INITIATOR_POLL_TARGET: {
+      nfc_modulation anm[NFCD_ARG_SIZE / sizeof(nfc_modulation)];
+      const size_t szModulations = pReq->aiArgs[0];
+      if (szModulations > sizeof(anm) / sizeof(anm[0]))
+        return NFC_EINVARG;
+      memcpy(anm, pReq->abtArg, szModulations * sizeof(nfc_modulation));
+      res = nfc_initiator_poll_target(pnd, anm, szModulations, pReq->aiArgs[1], pReq->aiArgs[2], pReq->aiArgs[3] ? &nt : NULL);
+      if ((res > 0) && pReq->aiArgs[3])
+        memcpy(pRes->abtArg, &nt, sizeof(nt));
+      return res;
+    }
+    case NFCD_OP_INITIATOR_SELECT_DEP_TARGET: {
+      nfc_dep_info ndi;
+      memcpy(&ndi, pReq->abtArg, sizeof(ndi));
+      res = nfc_initiator_select_dep_target(pnd, pReq->aiArgs[0], pReq->aiArgs[1], pReq->aiArgs[2] ? &ndi : NULL, pReq->aiArgs[3] ? &nt : NULL, pReq->iTimeout);
+      if ((res > 0) && pReq->aiArgs[3])
+        memcpy(pRes->abtArg, &nt, sizeof(nt));
+      return res;
+    }
+
+    case NFCD_OP_INITIATOR_TRANSCEIVE_BYTES:
+    case NFCD_OP_INITIATOR_TRANSCEIVE_BYTES_TARGET:
+    case NFCD_OP_INITIATOR_TRANSCEIVE_BYTES_TIMED:
+    case NFCD_OP_TARGET_RECEIVE_BYTES:
+      if (szRx && !(pbtRx = rx_reserve(pSession, szRx, pRes)))
+        return NFC_EINVARG;
+      if (pReq->uiOp == NFCD_OP_INITIATOR_TRANSCEIVE_BYTES) {
+        res = nfc_initiator_transceive_bytes(pnd, pbtTx, szTx, pbtRx, szRx, pReq->iTimeout);
+      } else if (pReq->uiOp == NFCD_OP_INITIATOR_TRANSCEIVE_BYTES_TARGET) {
+        res = nfc_initiator_transceive_bytes_target(pnd, pReq->aiArgs[0], pbtTx, szTx, pbtRx, szRx, pReq->iTimeout);
+      } else if (pReq->uiOp == NFCD_OP_INITIATOR_TRANSCEIVE_BYTES_TIMED) {
+        cycles = pReq->aiArgs[1];
+        res = nfc_initiator_transceive_bytes_timed(pnd, pbtTx, szTx, pbtRx, szRx, &cycles);
+        pRes->uiCycles = cycles;
+      } else {
+        res = nfc_target_receive_bytes(pnd, pbtRx, szRx, pReq->iTimeout);
+      }
+      pRes->uiRxLen = (res > 0) ? res : 0;
+      return res;
+    case NFCD_OP_TARGET_SEND_BYTES:
+      return nfc_target_send_bytes(pnd, pbtTx, szTx, pReq->iTimeout);
+    case NFCD_OP_TARGET_SEND_BYTES_CHAINED:
+      return nfc_target_send_bytes_chained(pnd, pbtTx, szTx, pReq->iTimeout);
+
+    case NFCD_OP_INITIATOR_TRANSCEIVE_BITS:
+    case NFCD_OP_INITIATOR_TRANSCEIVE_BITS_TIMED:
+    case NFCD_OP_TARGET_SEND_BITS:
+    case NFCD_OP_TARGET_RECEIVE_BITS: {
+      // Parity bytes follow the data: right after it in our client ring,
+      // szRx bytes after its start in our own ring
+      if ((pReq->aiArgs[0] < 0) || (pReq->aiArgs[0] > 8 * NFCD_BITS_FRAME_MAX))
+        return NFC_EINVARG;
+      const size_t szTxBits = pReq->aiArgs[0];
+      const size_t szTxBytes = (szTxBits + 7) / 8;
+      const uint8_t *pbtTxPar = pReq->aiArgs[1] ? pbtTx + szTxBytes : NULL;
+      uint8_t *pbtRxPar = NULL;
+      if ((szTxBytes + (pbtTxPar ? szTxBytes : 0) > szTx) || (szRx > NFCD_BITS_FRAME_MAX))
+        return NFC_EINVARG;
+      if (szRx) {
+        if (!(pbtRx = rx_reserve(pSession, 2 * szRx, pRes)))
+          return NFC_EINVARG;
+        pbtRxPar = pReq->aiArgs[2] ? pbtRx + szRx : NULL;
+      }
+      if (pReq->uiOp == NFCD_OP_INITIATOR_TRANSCEIVE_BITS) {
+        res = nfc_initiator_transceive_bits(pnd, pbtTx, szTxBits, pbtTxPar, pbtRx, szRx, pbtRxPar);
+      } else if (pReq->uiOp == NFCD_OP_INITIATOR_TRANSCEIVE_BITS_TIMED) {
+        cycles = pReq->aiArgs[3];
+        res = nfc_initiator_transceive_bits_timed(pnd, pbtTx, szTxBits, pbtTxPar, pbtRx, szRx, pbtRxPar, &cycles);
+        pRes->uiCycles = cycles;
+      } else if (pReq->uiOp == NFCD_OP_TARGET_SEND_BITS) {
+        return nfc_target_send_bits(pnd, pbtTx, szTxBits, pbtTxPar);
+      } else {
+        res = nfc_target_receive_bits(pnd, pbtRx, szRx, pbtRxPar);
+      }
+      pRes->uiRxLen = (res > 0) ? (res + 7) / 8 : 0;
+      return res;
+    }
+
+    case NFCD_OP_INITIATOR_TARGET_IS_PRESENT:
+    case NFCD_OP_INITIATOR_TARGET_UPGRADE_BIT_RATE:
+    case NFCD_OP_INITIATOR_TARGET_REACTIVATE:
+      if (pReq->aiArgs[0]) {
+        memcpy(&nt, pReq->abtArg, sizeof(nt));
+        pnt = &nt;
+      }
+      if (pReq->uiOp == NFCD_OP_INITIATOR_TARGET_IS_PRESENT) {
+        return nfc_initiator_target_is_present(pnd, pnt);
+      } else if (pReq->uiOp == NFCD_OP_INITIATOR_TARGET_UPGRADE_BIT_RATE) {
+        res = nfc_initiator_target_upgrade_bit_rate(pnd, pnt);
+      } else {
+        res = nfc_initiator_reactivate_target(pnd, pnt);
+      }
+      if (pnt)
+        memcpy(pRes->abtArg, pnt, sizeof(*pnt));
+      return res;
+
+    case NFCD_OP_TARGET_INIT:
+      if (!(pbtRx = rx_reserve(pSession, szRx, pRes)))
+        return NFC_EINVARG;
+      memcpy(&nt, pReq->abtArg, sizeof(nt));
+      res = nfc_target_init(pnd, &nt, pbtRx, szRx, pReq->iTimeout);
+      memcpy(pRes->abtArg, &nt, sizeof(nt));
+      pRes->uiRxLen = (res > 0) ? res : 0;
+      return res;
+
+    case NFCD_OP_SET_PROPERTY_BOOL:
+      return nfc_device_set_property_bool(pnd, pReq->aiArgs[0], pReq->aiArgs[1]);
+    case NFCD_OP_SET_PROPERTY_INT:
+      return nfc_device_set_property_int(pnd, pReq->aiArgs[0], pReq->aiArgs[1]);
+
+    case NFCD_OP_GET_SUPPORTED_MODULATION: {
+      const nfc_modulation_type *pnmt;
+      size_t n = 0;
+      if ((res = nfc_device_get_supported_modulation(pnd, pReq->aiArgs[0], &pnmt)) < 0)
+        return res;
+      // The list stays 0-terminated as abtArg is zeroed
+      while (pnmt[n] && ((n + 1) * sizeof(*pnmt) < NFCD_ARG_SIZE))
+        n++;
+      memcpy(pRes->abtArg, pnmt, n * sizeof(*pnmt));
+      return res;
+    }
+    case NFCD_OP_GET_SUPPORTED_BAUD_RATE: {
+      const nfc_baud_rate *pnbr;
+      size_t n = 0;
+      if (pReq->aiArgs[0] == N_TARGET) {
+        res = nfc_device_get_supported_baud_rate_target_mode(pnd, pReq->aiArgs[1], &pnbr);
+      } else {
+        res = nfc_device_get_supported_baud_rate(pnd, pReq->aiArgs[1], &pnbr);
+      }
+      if (res < 0)
+        return res;
+      while (pnbr[n] && ((n + 1) * sizeof(*pnbr) < NFCD_ARG_SIZE))
+        n++;
+      memcpy(pRes->abtArg, pnbr, n * sizeof(*pnbr));
+      return res;
+    }
+    case NFCD_OP_GET_INFORMATION_ABOUT: {
+      char *buf = NULL;
+      if ((res = nfc_device_get_information_about(pnd, &buf)) < 0)
+        return res;
+      size_t szBuf = strlen(buf) + 1;
+      if ((szBuf > szRx) || !(pbtRx = rx_reserve(pSession, szBuf, pRes))) {
+        nfc_free(buf);
+        return NFC_EOVFLOW;
+      }
+      memcpy(pbtRx, buf, szBuf);
+      pRes->uiRxLen = szBuf;
+      nfc_free(buf);
+      return res;
+    }
+    default:
+      return NFC_EINVARG;
+  }
+}
+
+static void
+session_serve(struct nfcd_session *pSession)
+{
+  struct nfcd_request req;
+  struct nfcd_response res;
+  while (!quitting && (read_all(pSession->iSocket, &req, sizeof(req)) == 0)) {
+    device_acquire(pSession, req.uiOp);
+    if (quitting)
+      break;
+    memset(&res, 0, sizeof(res));
+    res.iRes = run_request(pSession, &req, &res);
+    res.iLastError = nfc_device_get_last_error(pSession->pDevice->pnd);
+    device_done(pSession, req.uiOp, res.iRes);
+    if (write_all(pSession->iSocket, &res, sizeof(res)) < 0)
+      break;
+  }
+  device_release(pSession);
+}
+
+// Identify the process at the other end of a client connection
+static pid_t
+peer_pid(const int iSocket)
+{
+#ifdef SO_PEERCRED
+  struct ucred cred;
+  socklen_t szCred = sizeof(cred);
+  if (getsockopt(iSocket, SOL_SOCKET, SO_PEERCRED, &cred, &szCred) == 0)
+    return cred.pid;
+#else
+  (void) iSocket;
+#endif
+  return 0;
+}
+
+// Draw a session cookie other clients cannot guess
+static int32_t
+cookie_new(void)
+{
+  uint32_t ui = 0;
+  int fd = open("/dev/urandom", O_RDONLY);
+  if (fd >= 0) {
+    if (read(fd, &ui, sizeof(ui)) != sizeof(ui))
+      ui = 0;
+    close(fd);
+  }
+  // Cookies are positive, negative answers being errors
+  return (int32_t)(ui & 0x7fffffff);
+}
+
+static int
+session_open(struct nfcd_session *pSession, const struct nfcd_request *pReq)
+{
+  struct nfcd_response res;
+  int iShm;
+  memset(&res, 0, sizeof(res));
+  if ((pReq->aiArgs[0] != NFCD_PROTOCOL_VERSION) || (pReq->aiArgs[2] != sizeof(nfc_target)) ||
+      (pReq->aiArgs[1] < 0) || ((size_t) pReq->aiArgs[1] >= szDevices)) {
+    res.iRes = NFC_EINVARG;
+    write_all(pSession->iSocket, &res, sizeof(res));
+    return -1;
+  }
+  if (!(pSession->pbtShm = shm_create(&iShm))) {
+    res.iRes = NFC_ESOFT;
+    write_all(pSession->iSocket, &res, sizeof(res));
+    return -1;
+  }
+  int32_t iCookie;
+  if ((iCookie = cookie_new()) == 0) {
+    close(iShm);
+    res.iRes = NFC_ESOFT;
+    write_all(pSession->iSocket, &res, sizeof(res));
+    return -1;
+  }
+
+  // The session is listed since accept(), session_abort() may look at it
+  pthread_mutex_lock(&sessions_mutex);
+  pSession->pDevice = &aDevices[pReq->aiArgs[1]];
+  pSession->iCookie = iCookie;
+  pthread_mutex_unlock(&sessions_mutex);
+
+  res.iRes = pSession->iCookie;
+  snprintf((char *)res.abtArg, NFCD_ARG_SIZE, "%s", nfc_device_get_name(pSession->pDevice->pnd));
+  int ret = send_with_fd(pSession->iSocket, &res, iShm);
+  close(iShm);
+  return ret;
+}
+
+// Only the process which opened the session may abort it
+static void
+session_abort(const int32_t iCookie, const pid_t pidPeer)
+{
+  pthread_mutex_lock(&sessions_mutex);
+  for (struct nfcd_session *pSession = pSessions; pSession; pSession = pSession->pNext) {
+    if (pSession->pDevice && (pSession->iCookie == iCookie) && (pSession->pidPeer == pidPeer)) {
+      nfc_abort_command(pSession->pDevice->pnd);
+      break;
+    }
+  }
+  pthread_mutex_unlock(&sessions_mutex);
+}
+
+static void *
+session_thread(void *arg)
+{
+  struct nfcd_session *pSession = arg;
+  struct nfcd_request req;
+  struct nfcd_response res;
+
+  if (read_all(pSession->iSocket, &req, sizeof(req)) == 0) {
+    switch (req.uiOp) {
+      case NFCD_OP_LIST:
+        memset(&res, 0, sizeof(res));
+        res.iRes = szDevices;
+        write_all(pSession->iSocket, &res, sizeof(res));
+        break;
+      case NFCD_OP_ABORT:
+        session_abort(req.aiArgs[0], pSession->pidPeer);
+        memset(&res, 0, sizeof(res));
+        write_all(pSession->iSocket, &res, sizeof(res));
+        break;
+      case NFCD_OP_OPEN:
+        if (session_open(pSession, &req) == 0)
+          session_serve(pSession);
+        break;
+      default:
+        break;
+    }
+  }
+
+  pthread_mutex_lock(&sessions_mutex);
+  for (struct nfcd_session **ppSession = &pSessions; *ppSession; ppSession = &(*ppSession)->pNext) {
+    if (*ppSession == pSession) {
+      *ppSession = pSession->pNext;
+      break;
+    }
+  }
+  close(pSession->iSocket);
+  pSession->iSocket = -1;
+  szSessions--;
+  pthread_cond_broadcast(&sessions_cond);
+  pthread_mutex_unlock(&sessions_mutex);
+
+  if (pSession->pbtShm)
+    munmap(pSession->pbtShm, NFCD_SHM_SIZE);
+  free(pSession);
+  return NULL;
+}
+
+static void
+print_usage(const char *progname)
+{
+  printf("Usage: %s [-h] [-s SOCKET] [-t SECONDS] [CONNSTRING...]\n", progname);
+  printf("Options:\n");
+  printf("\t-h\tPrint this help message.\n");
+  printf("\t-s\tListen on SOCKET instead of %s.\n", NFCD_DEFAULT_SOCKET);
+  printf("\t-t\tGive a reserved device back to other clients after SECONDS without use (default: %d, 0: never).\n", NFCD_DEFAULT_IDLE_TIMEOUT);
+  printf("Without CONNSTRING, all devices found by libnfc are shared.\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+  const char *pcSocketPath = NFCD_DEFAULT_SOCKET;
+  int ch;
+
+  while ((ch = getopt(argc, argv, "hs:t:")) != -1) {
+    switch (ch) {
+      case 's':
+        pcSocketPath = optarg;
+        break;
+      case 't':
+        iIdleTimeout = atoi(optarg);
+        break;
+      case 'h':
+        print_usage(argv[0]);
+        exit(EXIT_SUCCESS);
+      default:
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+  }
+
+  nfc_context *context;
+  nfc_init(&context);
+  if (context == NULL) {
+    ERR("Unable to init libnfc (malloc)");
+    exit(EXIT_FAILURE);
+  }
+
+  nfc_connstring connstrings[MAX_DEVICE_COUNT];
+  size_t szConnstrings = 0;
+  if (optind < argc) {
+    for (int i = optind; (i < argc) && (szConnstrings < MAX_DEVICE_COUNT); i++) {
+      snprintf(connstrings[szConnstrings++], sizeof(nfc_connstring), "%s", argv[i]);
+    }
+  } else {
+    nfc_connstring acFound[MAX_DEVICE_COUNT];
+    size_t szFound = nfc_list_devices(context, acFound, MAX_DEVICE_COUNT);
+    for (size_t i = 0; i < szFound; i++) {
+      // Do not serve back what another daemon (or a former instance) shares
+      if (strncmp(acFound[i], NFCD_DRIVER_NAME ":", strlen(NFCD_DRIVER_NAME) + 1) != 0)
+        memcpy(connstrings[szConnstrings++], acFound[i], sizeof(nfc_connstring));
+    }
+  }
+  for (size_t i = 0; i < szConnstrings; i++) {
+    nfc_device *pnd = nfc_open(context, connstrings[i]);
+    if (pnd == NULL) {
+      ERR("Unable to open NFC device: %s", connstrings[i]);
+      continue;
+    }
+    aDevices[szDevices].pnd = pnd;
+    pthread_mutex_init(&aDevices[szDevices].mutex, NULL);
+    // Idle reservations are measured on the monotonic clock
+    pthread_condattr_t ca;
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    pthread_cond_init(&aDevices[szDevices].cond, &ca);
+    pthread_condattr_destroy(&ca);
+    aDevices[szDevices].pOwner = NULL;
+    aDevices[szDevices].bOwnerBusy = false;
+    printf("Sharing device %zu: %s\n", szDevices, nfc_device_get_name(pnd));
+    szDevices++;
+  }
+  if (szDevices == 0) {
+    ERR("No NFC device to share");
+    nfc_exit(context);
+    exit(EXIT_FAILURE);
+  }
+
+  struct sockaddr_un sun;
+  int iListen = socket(AF_UNIX, SOCK_STREAM, 0);
+  if ((iListen < 0) || (strlen(pcSocketPath) >= sizeof(sun.sun_path))) {
+    ERR("Unable to create socket %s", pcSocketPath);
+    exit(EXIT_FAILURE);
+  }
+  memset(&sun, 0, sizeof(sun));
+  sun.sun_family = AF_UNIX;
+  strcpy(sun.sun_path, pcSocketPath);
+  unlink(pcSocketPath);
+  if ((bind(iListen, (struct sockaddr *)&sun, sizeof(sun)) < 0) || (listen(iListen, 16) < 0)) {
+    ERR("Unable to listen on %s: %s", pcSocketPath, strerror(errno));
+    exit(EXIT_FAILURE);
+  }
+
+  // No SA_RESTART, so that accept() returns on signals
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = stop_daemon;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+
+  printf("Listening on %s\n", pcSocketPath);
+  while (!quitting) {
+    int fd = accept(iListen, NULL, NULL);
+    if (fd < 0)
+      continue;
+    struct nfcd_session *pSession = calloc(1, sizeof(struct nfcd_session));
+    if (!pSession) {
+      close(fd);
+      continue;
+    }
+    pSession->iSocket = fd;
+    pSession->pidPeer = peer_pid(fd);
+    // Listed before its first read, so that the shutdown below reaches it
+    pthread_mutex_lock(&sessions_mutex);
+    pSession->pNext = pSessions;
+    pSessions = pSession;
+    szSessions++;
+    pthread_mutex_unlock(&sessions_mutex);
+    // Session threads inherit a mask keeping the signals for this thread
+    sigset_t ss, ssOld;
+    sigemptyset(&ss);
+    sigaddset(&ss, SIGINT);
+    sigaddset(&ss, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &ss, &ssOld);
+    pthread_t thread;
+    int iRes = pthread_create(&thread, NULL, session_thread, pSession);
+    pthread_sigmask(SIG_SETMASK, &ssOld, NULL);
+    if (iRes != 0) {
+      pthread_mutex_lock(&sessions_mutex);
+      pSessions = pSession->pNext;
+      szSessions--;
+      pthread_mutex_unlock(&sessions_mutex);
+      close(fd);
+      free(pSession);
+      continue;
+    }
+    pthread_detach(thread);
+  }
+
+  printf("Stopping...\n");
+  close(iListen);
+  unlink(pcSocketPath);
+
+  // Kick every session out of whatever it waits for, then wait for them
+  for (size_t i = 0; i < szDevices; i++) {
+    pthread_mutex_lock(&aDevices[i].mutex);
+    pthread_cond_broadcast(&aDevices[i].cond);
+    pthread_mutex_unlock(&aDevices[i].mutex);
+    nfc_abort_command(aDevices[i].pnd);
+  }
+  pthread_mutex_lock(&sessions_mutex);
+  for (struct nfcd_session *pSession = pSessions; pSession; pSession = pSession->pNext)
+    shutdown(pSession->iSocket, SHUT_RDWR);
+  while (szSessions > 0)
+    pthread_cond_wait(&sessions_cond, &sessions_mutex);
+  pthread_mutex_unlock(&sessions_mutex);
+
+  for (size_t i = 0; i < szDevices; i++) {
+    nfc_close(aDevices[i].pnd);
+    pthread_mutex_destroy(&aDevices[i].mutex);
+    pthread_cond_destroy(&aDevices[i].cond);
+  }
+  nfc_exit(context);
+  exit(EXIT_SUCCESS);
+}